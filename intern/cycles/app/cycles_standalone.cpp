@@ -26,7 +26,9 @@
 #include "util_args.h"
 #include "util_foreach.h"
 #include "util_function.h"
+#include "util_guarded_allocator.h"
 #include "util_logging.h"
+#include "util_map.h"
 #include "util_path.h"
 #include "util_progress.h"
 #include "util_string.h"
@@ -51,6 +53,9 @@ struct Options {
 	SessionParams session_params;
 	bool quiet;
 	bool show_help, interactive, pause;
+	bool benchmark;
+	int seed;
+	double scene_load_time;
 } options;
 
 static void session_print(const string& str)
@@ -117,11 +122,19 @@ static void session_init()
 
 static void scene_init()
 {
+	scoped_timer load_timer(&options.scene_load_time);
+
 	options.scene = new Scene(options.scene_params, options.session_params.device);
 
 	/* Read XML */
 	xml_read_file(options.scene, options.filepath.c_str());
 
+	/* Fixed seed, so benchmark runs are reproducible */
+	if(options.benchmark) {
+		options.scene->integrator->seed = options.seed;
+		options.scene->integrator->tag_update(options.scene);
+	}
+
 	/* Camera width/height override? */
 	if(!(options.width == 0 || options.height == 0)) {
 		options.scene->camera->width = options.width;
@@ -153,6 +166,78 @@ static void session_exit()
 	}
 }
 
+static string json_escape(const string& str)
+{
+	string result;
+
+	foreach(char c, str) {
+		if(c == '"' || c == '\\')
+			result += '\\';
+		result += c;
+	}
+
+	return result;
+}
+
+static void benchmark_print(double render_time)
+{
+	Session *session = options.session;
+	map<string, double> phase_times = session->progress.get_phase_times();
+	phase_times["scene_load"] = options.scene_load_time;
+
+	uint64_t pixel_samples = (uint64_t)options.width * options.height * session->params.samples;
+	double path_trace_time = phase_times["path_trace"];
+	double samples_per_second = (path_trace_time > 0.0)? pixel_samples / path_trace_time: 0.0;
+
+	printf("{\n");
+	printf("  \"scene\": \"%s\",\n", json_escape(options.filepath).c_str());
+	printf("  \"device\": \"%s\",\n", json_escape(session->params.device.description).c_str());
+	printf("  \"version\": \"%s\",\n", CYCLES_VERSION_STRING);
+	printf("  \"width\": %d,\n", options.width);
+	printf("  \"height\": %d,\n", options.height);
+	printf("  \"samples\": %d,\n", session->params.samples);
+	printf("  \"seed\": %d,\n", options.seed);
+	printf("  \"threads\": %d,\n", session->params.threads);
+	printf("  \"phases\": {\n");
+
+	bool first = true;
+	for(map<string, double>::iterator it = phase_times.begin(); it != phase_times.end(); it++) {
+		printf("%s    \"%s\": %f", (first)? "": ",\n", it->first.c_str(), it->second);
+		first = false;
+	}
+
+	printf("\n  },\n");
+	printf("  \"render_time\": %f,\n", render_time);
+	printf("  \"pixel_samples\": %llu,\n", (unsigned long long)pixel_samples);
+	printf("  \"pixel_samples_per_second\": %f,\n", samples_per_second);
+	printf("  \"device_memory_peak\": %llu,\n", (unsigned long long)session->stats.mem_peak);
+	printf("  \"host_memory_peak\": %llu\n", (unsigned long long)util_guarded_get_mem_peak());
+	printf("}\n");
+}
+
+static void benchmark_run()
+{
+	scoped_timer render_timer;
+
+	session_init();
+	options.session->wait();
+
+	if(!options.session_params.output_path.empty())
+		options.session->write_output();
+
+	double render_time = time_dt() - render_timer.get_start();
+
+	if(options.session->progress.get_error()) {
+		fprintf(stderr, "Benchmark failed: %s\n",
+		        options.session->progress.get_error_message().c_str());
+		session_exit();
+		exit(EXIT_FAILURE);
+	}
+
+	benchmark_print(render_time);
+	session_exit();
+}
+
 #ifdef WITH_CYCLES_STANDALONE_GUI
 static void display_info(Progress& progress)
 {
@@ -330,6 +415,9 @@ static void options_parse(int argc, const char **argv)
 	options.filepath = "";
 	options.session = NULL;
 	options.quiet = false;
+	options.benchmark = false;
+	options.seed = 0;
+	options.scene_load_time = 0.0;
 
 	/* device names */
 	string device_names = "";
@@ -366,6 +454,8 @@ static void options_parse(int argc, const char **argv)
 #endif
 		"--background", &options.session_params.background, "Render in background, without user interface",
 		"--quiet", &options.quiet, "In background mode, don't print progress messages",
+		"--benchmark", &options.benchmark, "Render in background and print timing statistics as JSON",
+		"--seed %d", &options.seed, "Integrator seed to use in benchmark mode",
 		"--samples %d", &options.session_params.samples, "Number of samples to render",
 		"--output %s", &options.session_params.output_path, "File path to write output image",
 		"--threads %d", &options.session_params.threads, "CPU Rendering Threads",
@@ -424,8 +514,20 @@ static void options_parse(int argc, const char **argv)
 	options.session_params.background = true;
 #endif
 
-	/* Use progressive rendering */
-	options.session_params.progressive = true;
+	if(options.benchmark) {
+		/* Render tiles with all samples like a final render, and keep
+		 * stdout free for the statistics. */
+		options.session_params.background = true;
+		options.session_params.progressive = false;
+		options.quiet = true;
+
+		if(options.session_params.samples == INT_MAX)
+			options.session_params.samples = 16;
+	}
+	else {
+		/* Use progressive rendering */
+		options.session_params.progressive = true;
+	}
 
 	/* find matching device */
 	DeviceType device_type = Device::type_from_string(devicename.c_str());
@@ -482,6 +584,11 @@ int main(int argc, const char **argv)
 	path_init();
 	options_parse(argc, argv);
 
+	if(options.benchmark) {
+		benchmark_run();
+		return 0;
+	}
+
 #ifdef WITH_CYCLES_STANDALONE_GUI
 	if(options.session_params.background) {
 #endif
@@ -290,6 +290,13 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 min=0.0, max=1.0,
                 default=0.01,
                 )
+        cls.use_light_tree = BoolProperty(
+                name="Light Tree",
+                description="Pick lights based on their estimated contribution to the shading point, "
+                            "instead of their area only (faster convergence with many lights, "
+                            "not used when sampling all lights)",
+                default=False,
+                )
 
         cls.caustics_reflective = BoolProperty(
                 name="Reflective Caustics",
@@ -409,6 +416,20 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 min=0, max=16,
                 default=12,
                 )
+        cls.offscreen_dicing_scale = FloatProperty(
+                name="Offscreen Scale",
+                description="Multiplier for dicing rate of geometry outside of the camera view, "
+                            "the dicing rate of objects is gradually increased the further they are outside the view",
+                min=1.0, soft_max=25.0,
+                default=1.0,
+                )
+        cls.max_micropolygons = FloatProperty(
+                name="Max Micropolygons",
+                description="Maximum number of micropolygons created by adaptive subdivision, in millions, "
+                            "the dicing rate is increased to stay within this budget (0 for unlimited)",
+                min=0.0, soft_max=500.0,
+                default=0.0,
+                )
 
         cls.film_exposure = FloatProperty(
                 name="Exposure",
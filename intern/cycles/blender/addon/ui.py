@@ -175,6 +175,7 @@ class CyclesRender_PT_sampling(CyclesButtonsPanel, Panel):
         sub.prop(cscene, "sample_clamp_direct")
         sub.prop(cscene, "sample_clamp_indirect")
         sub.prop(cscene, "light_sampling_threshold")
+        sub.prop(cscene, "use_light_tree")
 
         if cscene.progressive == 'PATH' or use_branched_path(context) is False:
             col = split.column()
@@ -246,6 +247,8 @@ class CyclesRender_PT_geometry(CyclesButtonsPanel, Panel):
             sub.prop(cscene, "preview_dicing_rate", text="Preview")
             sub.separator()
             sub.prop(cscene, "max_subdivisions")
+            sub.prop(cscene, "offscreen_dicing_scale")
+            sub.prop(cscene, "max_micropolygons")
         else:
             row = layout.row()
             row.label("Volume Sampling:")
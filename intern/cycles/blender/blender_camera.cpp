@@ -31,6 +31,8 @@ struct BlenderCamera {
 	float nearclip;
 	float farclip;
 
+	float offscreen_dicing_scale;
+
 	CameraType type;
 	float ortho_scale;
 
@@ -104,6 +106,7 @@ static void blender_camera_init(BlenderCamera *bcam,
 	bcam->pano_viewplane.top = 1.0f;
 	bcam->viewport_camera_border.right = 1.0f;
 	bcam->viewport_camera_border.top = 1.0f;
+	bcam->offscreen_dicing_scale = 1.0f;
 
 	/* render resolution */
 	bcam->full_width = render_resolution_x(b_render);
@@ -403,6 +406,9 @@ static void blender_camera_sync(Camera *cam, BlenderCamera *bcam, int width, int
 	cam->nearclip = bcam->nearclip;
 	cam->farclip = bcam->farclip;
 
+	/* adaptive subdivision */
+	cam->offscreen_dicing_scale = bcam->offscreen_dicing_scale;
+
 	/* type */
 	cam->type = bcam->type;
 
@@ -501,6 +507,7 @@ void BlenderSync::sync_camera(BL::RenderSettings& b_render,
 		                                     Camera::ROLLING_SHUTTER_NUM_TYPES,
 		                                     Camera::ROLLING_SHUTTER_NONE);
 	bcam.rolling_shutter_duration = RNA_float_get(&cscene, "rolling_shutter_duration");
+	bcam.offscreen_dicing_scale = RNA_float_get(&cscene, "offscreen_dicing_scale");
 
 	/* border */
 	if(b_render.use_border()) {
@@ -811,6 +818,10 @@ void BlenderSync::sync_view(BL::SpaceView3D& b_v3d,
 	                      b_v3d,
 	                      b_rv3d,
 	                      width, height);
+
+	PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
+	bcam.offscreen_dicing_scale = RNA_float_get(&cscene, "offscreen_dicing_scale");
+
 	blender_camera_sync(scene->camera, &bcam, width, height, "");
 }
 
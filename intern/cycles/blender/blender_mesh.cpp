@@ -30,6 +30,7 @@
 #include "util_foreach.h"
 #include "util_logging.h"
 #include "util_math.h"
+#include "util_md5.h"
 
 #include "mikktspace.h"
 
@@ -826,6 +827,35 @@ static void sync_mesh_fluid_motion(BL::Object& b_ob, Scene *scene, Mesh *mesh)
 	}
 }
 
+/* Hash of the mesh as synced from Blender. Attributes generated on device
+ * update are skipped, subdivision meshes are tessellated on device update so
+ * there's no meaningful hash for them. */
+static string mesh_geometry_hash(Mesh *mesh)
+{
+	if(mesh->subdivision_type != Mesh::SUBDIVISION_NONE)
+		return "";
+
+	MD5Hash md5;
+	mesh->hash(md5);
+	md5.append((const uint8_t*)&mesh->geometry_flags, sizeof(mesh->geometry_flags));
+
+	AttributeSet *attribute_sets[2] = {&mesh->attributes, &mesh->curve_attributes};
+
+	for(int i = 0; i < 2; i++) {
+		foreach(Attribute& attr, attribute_sets[i]->attributes) {
+			if(attr.std == ATTR_STD_FACE_NORMAL || attr.std == ATTR_STD_POSITION_UNDISPLACED)
+				continue;
+
+			md5.append((const uint8_t*)attr.name.c_str(), attr.name.size());
+			md5.append((const uint8_t*)&attr.element, sizeof(attr.element));
+			if(attr.buffer.size())
+				md5.append((const uint8_t*)&attr.buffer[0], attr.buffer.size());
+		}
+	}
+
+	return md5.get_hex();
+}
+
 Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
                              bool object_updated,
                              bool hide_tris)
@@ -909,6 +939,13 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 	array<float3> oldcurve_keys = mesh->curve_keys;
 	array<float> oldcurve_radius = mesh->curve_radius;
 
+	/* persistent data renders sync deforming meshes on every frame, remember
+	 * the old geometry to skip the device update when nothing changed. meshes
+	 * with the object transform applied are in world space and never match */
+	string oldhash;
+	if(scene->params.persistent_data && !mesh->need_update && !mesh->transform_applied)
+		oldhash = mesh_geometry_hash(mesh);
+
 	mesh->clear();
 	mesh->used_shaders = used_shaders;
 	mesh->name = ustring(b_ob_data.name().c_str());
@@ -969,6 +1006,17 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 	/* fluid motion */
 	sync_mesh_fluid_motion(b_ob, scene, mesh);
 
+	if(!oldhash.empty() && mesh_geometry_hash(mesh) == oldhash) {
+		/* restore data generated on device update, the device copy of the
+		 * mesh stays valid so it doesn't need to be tagged */
+		mesh->add_face_normals();
+		mesh->add_vertex_normals();
+		if(mesh->need_attribute(scene, ATTR_STD_POSITION_UNDISPLACED))
+			mesh->add_undisplaced();
+
+		return mesh;
+	}
+
 	/* tag update */
 	bool rebuild = false;
 
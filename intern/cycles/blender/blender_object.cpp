@@ -100,12 +100,16 @@ void BlenderSync::sync_light(BL::Object& b_parent,
 	/* test if we need to sync */
 	Light *light;
 	ObjectKey key(b_parent, persistent_id, b_ob);
+	bool is_new = (light_map.find(key) == NULL);
 
 	if(!light_map.sync(&light, b_ob, b_parent, key)) {
 		if(light->is_portal)
 			*use_portal = true;
 		return;
 	}
+
+	/* keep a copy to skip the update if nothing changed */
+	Light prevlight = *light;
 	
 	BL::Lamp b_lamp(b_ob.data());
 
@@ -191,7 +195,8 @@ void BlenderSync::sync_light(BL::Object& b_parent,
 	light->use_scatter = (visibility & PATH_RAY_VOLUME_SCATTER) != 0;
 
 	/* tag */
-	light->tag_update(scene);
+	if(is_new || !light->equals(prevlight))
+		light->tag_update(scene);
 }
 
 void BlenderSync::sync_background_light(bool use_portal)
@@ -287,10 +292,16 @@ Object *BlenderSync::sync_object(BL::Object& b_parent,
 				}
 			}
 
+			/* motion may change while the object transform stays the
+			 * same, which is not tagged by object sync */
 			if(motion_time == -1.0f) {
+				if(object->motion.pre != tfm)
+					object->tag_update(scene);
 				object->motion.pre = tfm;
 			}
 			else if(motion_time == 1.0f) {
+				if(object->motion.post != tfm)
+					object->tag_update(scene);
 				object->motion.post = tfm;
 			}
 
@@ -305,8 +316,17 @@ Object *BlenderSync::sync_object(BL::Object& b_parent,
 	/* test if we need to sync */
 	bool object_updated = false;
 
-	if(object_map.sync(&object, b_ob, b_parent, key))
+	if(object_map.sync(&object, b_ob, b_parent, key)) {
+		object_updated = true;
+	}
+	else if(tfm != object->tfm) {
+		/* Transform changed without the object being tagged, happens on frame
+		 * change of persistent data renders where depsgraph flags are already
+		 * cleared. Sync the mesh again in case the old transform was applied
+		 * to it, after that only the object transform needs updating. */
+		object->transform_animated = true;
 		object_updated = true;
+	}
 	
 	bool use_holdout = (layer_flag & render_layer.holdout_layer) != 0;
 	
@@ -346,13 +366,27 @@ Object *BlenderSync::sync_object(BL::Object& b_parent,
 	/* object sync
 	 * transform comparison should not be needed, but duplis don't work perfect
 	 * in the depsgraph and may not signal changes, so this is a workaround */
-	if(object_updated || (object->mesh && object->mesh->need_update) || tfm != object->tfm) {
+	bool object_resync = false;
+
+	if(!(object_updated || (object->mesh && object->mesh->need_update) || tfm != object->tfm)) {
+		/* on frame change of persistent data renders any property may be
+		 * animated, sync them all and only update if something changed */
+		object_resync = frame_recalc;
+	}
+
+	if(object_updated || object_resync || (object->mesh && object->mesh->need_update) || tfm != object->tfm) {
+		Object prevobject = *object;
+
 		object->name = b_ob.name().c_str();
 		object->pass_id = b_ob.pass_index();
 		object->tfm = tfm;
-		object->motion.pre = transform_empty();
-		object->motion.post = transform_empty();
-		object->use_motion = false;
+
+		/* motion is compared and tagged by motion sync */
+		if(!object_resync) {
+			object->motion.pre = transform_empty();
+			object->motion.post = transform_empty();
+			object->use_motion = false;
+		}
 
 		/* motion blur */
 		if(scene->need_motion() == Scene::MOTION_BLUR && object->mesh) {
@@ -395,7 +429,8 @@ Object *BlenderSync::sync_object(BL::Object& b_parent,
 			object->dupli_uv = make_float2(0.0f, 0.0f);
 		}
 
-		object->tag_update(scene);
+		if(!object_resync || !object->equals(prevobject))
+			object->tag_update(scene);
 	}
 
 	return object;
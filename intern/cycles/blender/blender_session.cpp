@@ -68,6 +68,7 @@ BlenderSession::BlenderSession(BL::RenderEngine& b_engine,
 	background = true;
 	last_redraw_time = 0.0;
 	start_resize_time = 0.0;
+	sync_time = 0.0;
 }
 
 BlenderSession::BlenderSession(BL::RenderEngine& b_engine,
@@ -93,6 +94,7 @@ BlenderSession::BlenderSession(BL::RenderEngine& b_engine,
 	background = false;
 	last_redraw_time = 0.0;
 	start_resize_time = 0.0;
+	sync_time = 0.0;
 }
 
 BlenderSession::~BlenderSession()
@@ -189,7 +191,7 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 		 * them rather than trying to distinguish which settings need to be updated
 		 */
 
-		delete session;
+		free_session();
 
 		create_session();
 
@@ -197,7 +199,6 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 	}
 
 	session->progress.reset();
-	scene->reset();
 
 	session->tile_manager.set_tile_order(session_params.tile_order);
 
@@ -206,8 +207,15 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 	 */
 	session->stats.mem_peak = session->stats.mem_used;
 
-	/* sync object should be re-created */
-	sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress, is_cpu);
+	if(sync) {
+		/* scene was kept from the previous render, only update what changed */
+		sync->reset(b_data, b_scene);
+		sync->sync_recalc_frame();
+	}
+	else {
+		scene->reset();
+		sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress, is_cpu);
+	}
 
 	/* for final render we will do full data sync per render layer, only
 	 * do some basic syncing here, no objects or materials for speed */
@@ -456,6 +464,8 @@ void BlenderSession::render()
 	SessionParams session_params = BlenderSync::get_session_params(b_engine, b_userpref, b_scene, background);
 	BufferParams buffer_params = BlenderSync::get_buffer_params(b_render, b_v3d, b_rv3d, scene->camera, width, height);
 
+	sync_time = 0.0;
+
 	/* render each layer */
 	BL::RenderSettings r = b_scene.render();
 	BL::RenderSettings::layers_iterator b_layer_iter;
@@ -511,6 +521,8 @@ void BlenderSession::render()
 			b_engine.active_view_set(b_rview_name.c_str());
 
 			/* update scene */
+			double sync_start = time_dt();
+
 			BL::Object b_camera_override(b_engine.camera_override());
 			sync->sync_camera(b_render, b_camera_override, width, height, b_rview_name.c_str());
 			sync->sync_data(b_render,
@@ -520,6 +532,8 @@ void BlenderSession::render()
 			                &python_thread_state,
 			                b_rlay_name.c_str());
 
+			sync_time += time_dt() - sync_start;
+
 			/* Make sure all views have different noise patterns. - hardcoded value just to make it random */
 			if(view_index != 0) {
 				scene->integrator->seed += hash_int_2d(scene->integrator->seed, hash_int(view_index * 0xdeadbeef));
@@ -561,19 +575,22 @@ void BlenderSession::render()
 	session->progress.get_time(total_time, render_time);
 	VLOG(1) << "Total render time: " << total_time;
 	VLOG(1) << "Render time (without synchronization): " << render_time;
+	VLOG(1) << "Synchronization time: " << sync_time;
 
 	/* clear callback */
 	session->write_render_tile_cb = function_null;
 	session->update_render_tile_cb = function_null;
 
-	/* free all memory used (host and device), so we wouldn't leave render
-	 * engine with extra memory allocated
+	/* with persistent data the scene is kept on the device for the next
+	 * frame, otherwise free all memory used (host and device), so we wouldn't
+	 * leave render engine with extra memory allocated
 	 */
+	if(!scene->params.persistent_data) {
+		session->device_free();
 
-	session->device_free();
-
-	delete sync;
-	sync = NULL;
+		delete sync;
+		sync = NULL;
+	}
 }
 
 static void populate_bake_data(BakeData *data, const
@@ -984,6 +1001,11 @@ void BlenderSession::update_status_progress()
 
 	timestatus += string_printf("Mem:%.2fM, Peak:%.2fM", (double)mem_used, (double)mem_peak);
 
+	if(sync_time > 0.0) {
+		BLI_timecode_string_from_time_simple(time_str, sizeof(time_str), sync_time);
+		timestatus += " | Sync:" + string(time_str);
+	}
+
 	if(status.size() > 0)
 		status = " | " + status;
 	if(substatus.size() > 0)
@@ -117,6 +117,9 @@ public:
 	int width, height;
 	double start_resize_time;
 
+	/* time spent synchronizing the scene for the current frame */
+	double sync_time;
+
 	void *python_thread_state;
 
 	/* Global state which is common for all render sessions created from Blender.
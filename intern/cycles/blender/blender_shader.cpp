@@ -27,6 +27,8 @@
 #include "blender_util.h"
 
 #include "util_debug.h"
+#include "util_foreach.h"
+#include "util_md5.h"
 #include "util_string.h"
 
 CCL_NAMESPACE_BEGIN
@@ -1196,12 +1198,57 @@ void BlenderSync::sync_materials(bool update_all)
 			shader->volume_interpolation_method = get_volume_interpolation(cmat);
 			shader->displacement_method = (experimental) ? get_displacement_method(cmat) : DISPLACE_BUMP;
 
-			shader->set_graph(graph);
-			shader->tag_update(scene);
+			sync_shader_graph(shader, graph);
 		}
 	}
 }
 
+/* Graph */
+
+static string shader_graph_hash(Shader *shader, ShaderGraph *graph)
+{
+	MD5Hash md5;
+	shader->hash(md5);
+	md5.append((const uint8_t*)&shader->pass_id, sizeof(shader->pass_id));
+
+	foreach(ShaderNode *node, graph->nodes) {
+		node->hash(md5);
+
+		foreach(ShaderInput *input, node->inputs) {
+			if(input->link) {
+				ustring name = input->link->name();
+				md5.append((const uint8_t*)&input->link->parent->id, sizeof(int));
+				md5.append((const uint8_t*)name.c_str(), name.size());
+			}
+		}
+	}
+
+	return md5.get_hex();
+}
+
+bool BlenderSync::sync_shader_graph(Shader *shader, ShaderGraph *graph)
+{
+	/* persistent data renders sync all shaders again on frame change, skip
+	 * the ones that didn't change to avoid recompiling them and updating
+	 * the lights and meshes using them */
+	if(scene->params.persistent_data) {
+		string hash = shader_graph_hash(shader, graph);
+		map<Shader*, string>::iterator it = shader_graph_hashes.find(shader);
+
+		if(it != shader_graph_hashes.end() && it->second == hash) {
+			delete graph;
+			return false;
+		}
+
+		shader_graph_hashes[shader] = hash;
+	}
+
+	shader->set_graph(graph);
+	shader->tag_update(scene);
+
+	return true;
+}
+
 /* Sync World */
 
 void BlenderSync::sync_world(bool update_all)
@@ -1264,9 +1311,8 @@ void BlenderSync::sync_world(bool update_all)
 			background->ao_distance = FLT_MAX;
 		}
 
-		shader->set_graph(graph);
-		shader->tag_update(scene);
-		background->tag_update(scene);
+		if(sync_shader_graph(shader, graph))
+			background->tag_update(scene);
 	}
 
 	PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
@@ -1330,8 +1376,7 @@ void BlenderSync::sync_lamps(bool update_all)
 				graph->connect(emission->output("Emission"), out->input("Surface"));
 			}
 
-			shader->set_graph(graph);
-			shader->tag_update(scene);
+			sync_shader_graph(shader, graph);
 		}
 	}
 }
@@ -1347,6 +1392,10 @@ void BlenderSync::sync_shaders()
 		auto_refresh_update = image_manager->set_animation_frame_update(frame);
 	}
 
+	/* all graphs are replaced, forget their hashes */
+	if(auto_refresh_update)
+		shader_graph_hashes.clear();
+
 	shader_map.pre_sync();
 
 	sync_world(auto_refresh_update);
@@ -1355,6 +1404,20 @@ void BlenderSync::sync_shaders()
 
 	/* false = don't delete unused shaders, not supported */
 	shader_map.post_sync(false);
+
+	/* remove hashes of shaders that were freed, a new shader allocated
+	 * at the same address must not match the old graph */
+	if(!shader_graph_hashes.empty()) {
+		set<Shader*> shaders(scene->shaders.begin(), scene->shaders.end());
+		map<Shader*, string>::iterator it = shader_graph_hashes.begin();
+
+		while(it != shader_graph_hashes.end()) {
+			if(shaders.find(it->first) == shaders.end())
+				shader_graph_hashes.erase(it++);
+			else
+				++it;
+		}
+	}
 }
 
 CCL_NAMESPACE_END
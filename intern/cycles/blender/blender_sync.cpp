@@ -59,6 +59,7 @@ BlenderSync::BlenderSync(BL::RenderEngine& b_engine,
   particle_system_map(&scene->particle_systems),
   world_map(NULL),
   world_recalc(false),
+  frame_recalc(false),
   scene(scene),
   preview(preview),
   experimental(false),
@@ -76,6 +77,14 @@ BlenderSync::~BlenderSync()
 {
 }
 
+void BlenderSync::reset(BL::BlendData& b_data, BL::Scene& b_scene)
+{
+	/* update data and scene pointers, they may change between renders of
+	 * a persistent data session, for example after undo */
+	this->b_data = b_data;
+	this->b_scene = b_scene;
+}
+
 /* Sync */
 
 bool BlenderSync::sync_recalc()
@@ -122,6 +131,12 @@ bool BlenderSync::sync_recalc()
 			max_subdivisions = updated_max_subdivisions;
 			dicing_prop_changed = true;
 		}
+
+		float updated_offscreen_dicing_scale = RNA_float_get(&cscene, "offscreen_dicing_scale");
+
+		if(scene->camera->offscreen_dicing_scale != updated_offscreen_dicing_scale) {
+			dicing_prop_changed = true;
+		}
 	}
 
 	BL::BlendData::objects_iterator b_ob;
@@ -190,6 +205,46 @@ bool BlenderSync::sync_recalc()
 	return recalc;
 }
 
+void BlenderSync::sync_recalc_frame()
+{
+	/* depsgraph recalc flags are already cleared when a final render of a
+	 * new frame starts, so for persistent data renders tag everything that
+	 * may be animated. syncing then compares the new data with the old one
+	 * and only updates what actually changed.
+	 *
+	 * this includes meshes without modifiers, their data may have been
+	 * edited between renders (edit mode, frame change handlers) and the
+	 * recalc flags of those edits are cleared as well. unchanged meshes
+	 * are detected by their geometry hash and not updated on the device. */
+	BL::BlendData::materials_iterator b_mat;
+
+	for(b_data.materials.begin(b_mat); b_mat != b_data.materials.end(); ++b_mat)
+		shader_map.set_recalc(*b_mat);
+
+	BL::BlendData::lamps_iterator b_lamp;
+
+	for(b_data.lamps.begin(b_lamp); b_lamp != b_data.lamps.end(); ++b_lamp)
+		shader_map.set_recalc(*b_lamp);
+
+	world_recalc = true;
+	frame_recalc = true;
+
+	BL::BlendData::objects_iterator b_ob;
+
+	for(b_data.objects.begin(b_ob); b_ob != b_data.objects.end(); ++b_ob) {
+		if(object_is_mesh(*b_ob)) {
+			BL::ID key = BKE_object_is_modified(*b_ob)? *b_ob: b_ob->data();
+			mesh_map.set_recalc(key);
+		}
+		else if(object_is_light(*b_ob)) {
+			light_map.set_recalc(*b_ob);
+		}
+
+		if(b_ob->particle_systems.length())
+			particle_system_map.set_recalc(*b_ob);
+	}
+}
+
 void BlenderSync::sync_data(BL::RenderSettings& b_render,
                             BL::SpaceView3D& b_v3d,
                             BL::Object& b_override,
@@ -219,6 +274,9 @@ void BlenderSync::sync_data(BL::RenderSettings& b_render,
 	            python_thread_state);
 
 	mesh_synced.clear();
+
+	/* all objects were synced for the new frame */
+	frame_recalc = false;
 }
 
 /* Integrator */
@@ -294,6 +352,7 @@ void BlenderSync::sync_integrator()
 	integrator->sample_all_lights_direct = get_boolean(cscene, "sample_all_lights_direct");
 	integrator->sample_all_lights_indirect = get_boolean(cscene, "sample_all_lights_indirect");
 	integrator->light_sampling_threshold = get_float(cscene, "light_sampling_threshold");
+	integrator->use_light_tree = get_boolean(cscene, "use_light_tree");
 
 	int diffuse_samples = get_int(cscene, "diffuse_samples");
 	int glossy_samples = get_int(cscene, "glossy_samples");
@@ -324,6 +383,9 @@ void BlenderSync::sync_integrator()
 
 	if(integrator->modified(previntegrator))
 		integrator->tag_update(scene);
+
+	if(integrator->use_light_tree_sampling() != previntegrator.use_light_tree_sampling())
+		scene->light_manager->tag_update(scene);
 }
 
 /* Film */
@@ -519,6 +581,8 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 		params.texture_limit = 0;
 	}
 
+	params.max_micropolygons = (size_t)(RNA_float_get(&cscene, "max_micropolygons") * 1000000.0f);
+
 #if !(defined(__GNUC__) && (defined(i386) || defined(_M_IX86)))
 	if(is_cpu) {
 		params.use_qbvh = DebugFlags().cpu.qbvh && system_cpu_support_sse2();
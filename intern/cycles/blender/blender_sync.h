@@ -58,8 +58,11 @@ public:
 	            bool is_cpu);
 	~BlenderSync();
 
+	void reset(BL::BlendData& b_data, BL::Scene& b_scene);
+
 	/* sync */
 	bool sync_recalc();
+	void sync_recalc_frame();
 	void sync_data(BL::RenderSettings& b_render,
 	               BL::SpaceView3D& b_v3d,
 	               BL::Object& b_override,
@@ -110,6 +113,7 @@ private:
 	void sync_curve_settings();
 
 	void sync_nodes(Shader *shader, BL::ShaderNodeTree& b_ntree);
+	bool sync_shader_graph(Shader *shader, ShaderGraph *graph);
 	Mesh *sync_mesh(BL::Object& b_ob, bool object_updated, bool hide_tris);
 	void sync_curves(Mesh *mesh,
 	                 BL::Mesh& b_mesh,
@@ -166,8 +170,11 @@ private:
 	set<Mesh*> mesh_synced;
 	set<Mesh*> mesh_motion_synced;
 	set<float> motion_times;
+	map<Shader*, string> shader_graph_hashes;
 	void *world_map;
 	bool world_recalc;
+	/* all objects are synced again, animated properties are not tagged */
+	bool frame_recalc;
 
 	Scene *scene;
 	bool preview;
@@ -240,8 +240,12 @@ Device *Device::create(DeviceInfo& info, Stats &stats, bool background)
 #endif
 #ifdef WITH_NETWORK
 		case DEVICE_NETWORK:
-			device = device_network_create(info, stats, "127.0.0.1");
+		{
+			/* comma separated list of servers as host[:port] */
+			const char *servers = getenv("CYCLES_NETWORK_SERVERS");
+			device = device_network_create(info, stats, (servers)? servers: "127.0.0.1");
 			break;
+		}
 #endif
 #ifdef WITH_OPENCL
 		case DEVICE_OPENCL:
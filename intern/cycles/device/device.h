@@ -281,8 +281,8 @@ public:
 		const DeviceDrawParams &draw_params);
 
 #ifdef WITH_NETWORK
-	/* networking */
-	void server_run();
+	/* networking, port zero uses the default port */
+	void server_run(int port = 0, size_t cache_size = 0);
 #endif
 
 	/* multi device */
@@ -28,6 +28,7 @@ CCL_NAMESPACE_BEGIN
 typedef map<device_ptr, device_ptr> PtrMap;
 typedef vector<uint8_t> DataVector;
 typedef map<device_ptr, DataVector> DataMap;
+typedef map<device_ptr, uint64_t> HashMap;
 
 /* tile list */
 typedef vector<RenderTile> TileList;
@@ -41,30 +42,54 @@ static TileList::iterator tile_list_find(TileList& tile_list, RenderTile& tile)
 	return tile_list.end();
 }
 
-class NetworkDevice : public Device
+/* Connection to a single render server, given as host[:port]. */
+class NetworkConnection
 {
 public:
-	boost::asio::io_service io_service;
+	string address;
 	tcp::socket socket;
-	device_ptr mem_counter;
-	DeviceTask the_task; /* todo: handle multiple tasks */
-
 	thread_mutex rpc_lock;
+	NetworkError error_func;
 
-	virtual bool show_samples() const
+	NetworkConnection(boost::asio::io_service& io_service, const string& address_)
+	: address(address_), socket(io_service)
 	{
-		return false;
-	}
+		string host = address;
+		string port = string_printf("%d", SERVER_PORT);
+		size_t port_pos;
+
+		if(address.size() && address[0] == '[') {
+			/* IPv6 address, as [address] or [address]:port */
+			size_t host_end = address.find(']');
+
+			if(host_end == string::npos ||
+			   (host_end + 1 != address.size() && address[host_end + 1] != ':'))
+			{
+				error_func.network_error("Invalid server address " + address);
+				return;
+			}
 
-	NetworkDevice(DeviceInfo& info, Stats &stats, const char *address)
-	: Device(info, stats, true), socket(io_service)
-	{
-		error_func = NetworkError();
-		stringstream portstr;
-		portstr << SERVER_PORT;
+			host = address.substr(1, host_end - 1);
+			port_pos = (host_end + 1 != address.size())? host_end + 1: string::npos;
+		}
+		else {
+			port_pos = address.find(':');
+
+			/* a port can't be told apart from the last part of an IPv6 address */
+			if(port_pos != string::npos && address.find(':', port_pos + 1) != string::npos) {
+				error_func.network_error("IPv6 server address " + address + " must be given as [address]:port");
+				return;
+			}
+
+			if(port_pos != string::npos)
+				host = address.substr(0, port_pos);
+		}
+
+		if(port_pos != string::npos)
+			port = address.substr(port_pos + 1);
 
 		tcp::resolver resolver(io_service);
-		tcp::resolver::query query(address, portstr.str());
+		tcp::resolver::query query(host, port);
 		tcp::resolver::iterator endpoint_iterator = resolver.resolve(query);
 		tcp::resolver::iterator end;
 
@@ -75,49 +100,125 @@ public:
 			socket.connect(*endpoint_iterator++, error);
 		}
 
-		if(error)
+		if(error) {
 			error_func.network_error(error.message());
+		}
+		else {
+			/* most RPCs are small and wait for a reply */
+			socket.set_option(tcp::no_delay(true));
+		}
+	}
+};
+
+/* Device rendering on one or more servers. Scene data is sent to all of
+ * them, and each server pulls tiles from the session as its threads become
+ * idle, so faster servers end up rendering more tiles. */
+
+class NetworkDevice : public Device
+{
+public:
+	boost::asio::io_service io_service;
+	vector<NetworkConnection*> connections;
+	device_ptr mem_counter;
+	DeviceTask the_task; /* todo: handle multiple tasks */
+	vector<NetworkConnection*> task_connections;
+
+	/* Render buffers which got their tiles copied back as they were
+	 * released. The host memory is the only complete copy of these, since
+	 * each server only has the tiles it rendered, until it's uploaded to
+	 * the server again. */
+	struct HostBuffer {
+		device_memory *mem;
+		/* servers that have the same data as the host memory */
+		set<NetworkConnection*> uploaded;
+	};
+
+	thread_mutex host_buffers_mutex;
+	map<device_ptr, HostBuffer> host_buffers;
+
+	virtual bool show_samples() const
+	{
+		return false;
+	}
+
+	NetworkDevice(DeviceInfo& info, Stats &stats, const char *address)
+	: Device(info, stats, true)
+	{
+		vector<string> addresses;
+		string_split(addresses, address, ", ");
+
+		foreach(string& server_address, addresses) {
+			VLOG(1) << "Connecting to render server " << server_address;
+			connections.push_back(new NetworkConnection(io_service, server_address));
+		}
 
 		mem_counter = 0;
 	}
 
 	~NetworkDevice()
 	{
-		RPCSend snd(socket, &error_func, "stop");
-		snd.write();
+		foreach(NetworkConnection *conn, connections) {
+			RPCSend snd(conn->socket, &conn->error_func, "stop");
+			snd.write();
+
+			delete conn;
+		}
 	}
 
-	void mem_alloc(device_memory& mem, MemoryType type)
+	const string& error_message()
 	{
-		thread_scoped_lock lock(rpc_lock);
+		foreach(NetworkConnection *conn, connections) {
+			if(conn->error_func.have_error()) {
+				error_msg = conn->address + ": " + conn->error_func.error_message();
+				break;
+			}
+		}
+
+		return error_msg;
+	}
 
+	void mem_alloc(device_memory& mem, MemoryType type)
+	{
 		mem.device_pointer = ++mem_counter;
 
-		RPCSend snd(socket, &error_func, "mem_alloc");
+		foreach(NetworkConnection *conn, connections) {
+			thread_scoped_lock lock(conn->rpc_lock);
 
-		snd.add(mem);
-		snd.add(type);
-		snd.write();
+			RPCSend snd(conn->socket, &conn->error_func, "mem_alloc");
+
+			snd.add(mem);
+			snd.add(type);
+			snd.write();
+		}
 	}
 
 	void mem_copy_to(device_memory& mem)
 	{
-		thread_scoped_lock lock(rpc_lock);
+		host_buffer_remove(mem);
 
-		RPCSend snd(socket, &error_func, "mem_copy_to");
+		RPCBuffer buffer((void*)mem.data_pointer, mem.memory_size(), true);
 
-		snd.add(mem);
-		snd.write();
-		snd.write_buffer((void*)mem.data_pointer, mem.memory_size());
+		foreach(NetworkConnection *conn, connections)
+			mem_copy_to(conn, mem, buffer);
 	}
 
 	void mem_copy_from(device_memory& mem, int y, int w, int h, int elem)
 	{
-		thread_scoped_lock lock(rpc_lock);
+		{
+			thread_scoped_lock host_lock(host_buffers_mutex);
+
+			/* already complete on the host */
+			if(host_buffers.find(mem.device_pointer) != host_buffers.end())
+				return;
+		}
 
-		size_t data_size = mem.memory_size();
+		NetworkConnection *conn = connections[0];
+		thread_scoped_lock lock(conn->rpc_lock);
 
-		RPCSend snd(socket, &error_func, "mem_copy_from");
+		size_t offset, size;
+		network_mem_copy_range(mem, y, w, h, elem, &offset, &size);
+
+		RPCSend snd(conn->socket, &conn->error_func, "mem_copy_from");
 
 		snd.add(mem);
 		snd.add(y);
@@ -126,29 +227,40 @@ public:
 		snd.add(elem);
 		snd.write();
 
-		RPCReceive rcv(socket, &error_func);
-		rcv.read_buffer((void*)mem.data_pointer, data_size);
+		RPCReceive rcv(conn->socket, &conn->error_func);
+		rcv.read_buffer((uint8_t*)mem.data_pointer + offset, size);
 	}
 
 	void mem_zero(device_memory& mem)
 	{
-		thread_scoped_lock lock(rpc_lock);
+		host_buffer_remove(mem);
 
-		RPCSend snd(socket, &error_func, "mem_zero");
+		if(mem.data_pointer)
+			memset((void*)mem.data_pointer, 0, mem.memory_size());
 
-		snd.add(mem);
-		snd.write();
+		foreach(NetworkConnection *conn, connections) {
+			thread_scoped_lock lock(conn->rpc_lock);
+
+			RPCSend snd(conn->socket, &conn->error_func, "mem_zero");
+
+			snd.add(mem);
+			snd.write();
+		}
 	}
 
 	void mem_free(device_memory& mem)
 	{
 		if(mem.device_pointer) {
-			thread_scoped_lock lock(rpc_lock);
+			host_buffer_remove(mem);
 
-			RPCSend snd(socket, &error_func, "mem_free");
+			foreach(NetworkConnection *conn, connections) {
+				thread_scoped_lock lock(conn->rpc_lock);
 
-			snd.add(mem);
-			snd.write();
+				RPCSend snd(conn->socket, &conn->error_func, "mem_free");
+
+				snd.add(mem);
+				snd.write();
+			}
 
 			mem.device_pointer = 0;
 		}
@@ -156,16 +268,19 @@ public:
 
 	void const_copy_to(const char *name, void *host, size_t size)
 	{
-		thread_scoped_lock lock(rpc_lock);
+		string name_string(name);
+		RPCBuffer buffer(host, size, true);
 
-		RPCSend snd(socket, &error_func, "const_copy_to");
+		foreach(NetworkConnection *conn, connections) {
+			thread_scoped_lock lock(conn->rpc_lock);
 
-		string name_string(name);
+			RPCSend snd(conn->socket, &conn->error_func, "const_copy_to");
 
-		snd.add(name_string);
-		snd.add(size);
-		snd.write();
-		snd.write_buffer(host, size);
+			snd.add(name_string);
+			snd.add(size);
+			snd.write();
+			snd.write_buffer(buffer);
+		}
 	}
 
 	void tex_alloc(const char *name,
@@ -177,31 +292,43 @@ public:
 		        << string_human_readable_number(mem.memory_size()) << " bytes. ("
 		        << string_human_readable_size(mem.memory_size()) << ")";
 
-		thread_scoped_lock lock(rpc_lock);
-
 		mem.device_pointer = ++mem_counter;
 
-		RPCSend snd(socket, &error_func, "tex_alloc");
-
 		string name_string(name);
+		RPCBuffer buffer((void*)mem.data_pointer, mem.memory_size(), true);
+		uint64_t hash = network_buffer_hash((void*)mem.data_pointer, mem.memory_size());
 
-		snd.add(name_string);
-		snd.add(mem);
-		snd.add(interpolation);
-		snd.add(extension);
-		snd.write();
-		snd.write_buffer((void*)mem.data_pointer, mem.memory_size());
+		foreach(NetworkConnection *conn, connections) {
+			thread_scoped_lock lock(conn->rpc_lock);
+
+			RPCSend snd(conn->socket, &conn->error_func, "tex_alloc");
+
+			snd.add(name_string);
+			snd.add(mem);
+			snd.add(interpolation);
+			snd.add(extension);
+			snd.add(hash);
+			snd.write();
+
+			/* only send the data if the server doesn't have it cached */
+			RPCReceive rcv(conn->socket, &conn->error_func);
+
+			if(rcv.name == "tex_alloc_data")
+				snd.write_buffer(buffer);
+		}
 	}
 
 	void tex_free(device_memory& mem)
 	{
 		if(mem.device_pointer) {
-			thread_scoped_lock lock(rpc_lock);
+			foreach(NetworkConnection *conn, connections) {
+				thread_scoped_lock lock(conn->rpc_lock);
 
-			RPCSend snd(socket, &error_func, "tex_free");
+				RPCSend snd(conn->socket, &conn->error_func, "tex_free");
 
-			snd.add(mem);
-			snd.write();
+				snd.add(mem);
+				snd.write();
+			}
 
 			mem.device_pointer = 0;
 		}
@@ -209,56 +336,94 @@ public:
 
 	bool load_kernels(const DeviceRequestedFeatures& requested_features)
 	{
-		if(error_func.have_error())
-			return false;
+		bool result = true;
 
-		thread_scoped_lock lock(rpc_lock);
+		foreach(NetworkConnection *conn, connections) {
+			if(conn->error_func.have_error())
+				return false;
 
-		RPCSend snd(socket, &error_func, "load_kernels");
-		snd.add(requested_features.experimental);
-		snd.add(requested_features.max_closure);
-		snd.add(requested_features.max_nodes_group);
-		snd.add(requested_features.nodes_features);
-		snd.write();
+			thread_scoped_lock lock(conn->rpc_lock);
 
-		bool result;
-		RPCReceive rcv(socket, &error_func);
-		rcv.read(result);
+			RPCSend snd(conn->socket, &conn->error_func, "load_kernels");
+			snd.add(requested_features.experimental);
+			snd.add(requested_features.max_closure);
+			snd.add(requested_features.max_nodes_group);
+			snd.add(requested_features.nodes_features);
+			snd.write();
+
+			bool conn_result;
+			RPCReceive rcv(conn->socket, &conn->error_func);
+			rcv.read(conn_result);
+
+			result = result && conn_result;
+		}
 
 		return result;
 	}
 
 	void task_add(DeviceTask& task)
 	{
-		thread_scoped_lock lock(rpc_lock);
-
 		the_task = task;
+		task_connections.clear();
 
-		RPCSend snd(socket, &error_func, "task_add");
-		snd.add(task);
-		snd.write();
+		if(task.type == DeviceTask::PATH_TRACE)
+			task_connections = connections;
+		else /* the other tasks are not split, run them on the first server */
+			task_connections.push_back(connections[0]);
+
+		/* with multiple servers each only has its own tiles of the buffer */
+		if(connections.size() > 1)
+			host_buffer_upload(task.buffer, task_connections);
+
+		foreach(NetworkConnection *conn, task_connections) {
+			thread_scoped_lock lock(conn->rpc_lock);
+
+			RPCSend snd(conn->socket, &conn->error_func, "task_add");
+			snd.add(task);
+			snd.write();
+		}
 	}
 
 	void task_wait()
 	{
-		thread_scoped_lock lock(rpc_lock);
+		if(task_connections.size() == 1) {
+			task_wait(task_connections[0]);
+			return;
+		}
+
+		/* serve tiles to all servers at the same time */
+		vector<thread*> threads;
 
-		RPCSend snd(socket, &error_func, "task_wait");
+		foreach(NetworkConnection *conn, task_connections) {
+			threads.push_back(new thread(function_bind(
+				(void (NetworkDevice::*)(NetworkConnection*))&NetworkDevice::task_wait, this, conn)));
+		}
+
+		foreach(thread *t, threads) {
+			t->join();
+			delete t;
+		}
+	}
+
+	void task_wait(NetworkConnection *conn)
+	{
+		thread_scoped_lock lock(conn->rpc_lock);
+
+		RPCSend snd(conn->socket, &conn->error_func, "task_wait");
 		snd.write();
 
 		lock.unlock();
 
 		TileList the_tiles;
 
-		/* todo: run this threaded for connecting to multiple clients */
 		for(;;) {
-			if(error_func.have_error())
+			if(conn->error_func.have_error())
 				break;
 
 			RenderTile tile;
 
 			lock.lock();
-			RPCReceive rcv(socket, &error_func);
+			RPCReceive rcv(conn->socket, &conn->error_func);
 
 			if(rcv.name == "acquire_tile") {
 				lock.unlock();
@@ -268,14 +433,14 @@ public:
 					the_tiles.push_back(tile);
 
 					lock.lock();
-					RPCSend snd(socket, &error_func, "acquire_tile");
+					RPCSend snd(conn->socket, &conn->error_func, "acquire_tile");
 					snd.add(tile);
 					snd.write();
 					lock.unlock();
 				}
 				else {
 					lock.lock();
-					RPCSend snd(socket, &error_func, "acquire_tile_none");
+					RPCSend snd(conn->socket, &conn->error_func, "acquire_tile_none");
 					snd.write();
 					lock.unlock();
 				}
@@ -292,10 +457,17 @@ public:
 
 				assert(tile.buffers != NULL);
 
+				/* a single server has the whole buffer, it's read with mem_copy_from */
+				if(connections.size() > 1)
+					tile_copy_from(conn, tile);
+
+				if(the_task.update_progress_sample)
+					the_task.update_progress_sample(tile.w*tile.h*tile.num_samples, tile.sample);
+
 				the_task.release_tile(tile);
 
 				lock.lock();
-				RPCSend snd(socket, &error_func, "release_tile");
+				RPCSend snd(conn->socket, &conn->error_func, "release_tile");
 				snd.write();
 				lock.unlock();
 			}
@@ -310,9 +482,11 @@ public:
 
 	void task_cancel()
 	{
-		thread_scoped_lock lock(rpc_lock);
-		RPCSend snd(socket, &error_func, "task_cancel");
-		snd.write();
+		foreach(NetworkConnection *conn, connections) {
+			thread_scoped_lock lock(conn->rpc_lock);
+			RPCSend snd(conn->socket, &conn->error_func, "task_cancel");
+			snd.write();
+		}
 	}
 
 	int get_split_task_count(DeviceTask& task)
@@ -320,8 +494,100 @@ public:
 		return 1;
 	}
 
-private:
-	NetworkError error_func;
+protected:
+	void mem_copy_to(NetworkConnection *conn, device_memory& mem, RPCBuffer& buffer)
+	{
+		thread_scoped_lock lock(conn->rpc_lock);
+
+		RPCSend snd(conn->socket, &conn->error_func, "mem_copy_to");
+
+		snd.add(mem);
+		snd.write();
+		snd.write_buffer(buffer);
+	}
+
+	/* Copy the pixels of a finished tile from the server that rendered it
+	 * into the host memory of its render buffers. */
+	void tile_copy_from(NetworkConnection *conn, RenderTile& tile)
+	{
+		device_memory& mem = tile.buffers->buffer;
+
+		if(!mem.device_pointer)
+			return;
+
+		int index = tile.offset + tile.x + tile.y*tile.stride;
+		int elem = tile.buffers->params.get_passes_size()*sizeof(float);
+
+		vector<uint8_t> pixels((size_t)tile.w*tile.h*elem);
+
+		{
+			thread_scoped_lock lock(conn->rpc_lock);
+
+			RPCSend snd(conn->socket, &conn->error_func, "tile_copy_from");
+
+			snd.add(mem);
+			snd.add(index);
+			snd.add(tile.w);
+			snd.add(tile.h);
+			snd.add(tile.stride);
+			snd.add(elem);
+			snd.write();
+
+			RPCReceive rcv(conn->socket, &conn->error_func);
+			rcv.read_buffer(&pixels[0], pixels.size());
+		}
+
+		size_t row_size = (size_t)tile.w*elem;
+
+		for(int y = 0; y < tile.h; y++) {
+			memcpy((uint8_t*)mem.data_pointer + (size_t)(index + y*tile.stride)*elem,
+			       &pixels[y*row_size],
+			       row_size);
+		}
+
+		/* every server, including this one, misses the other servers' tiles */
+		thread_scoped_lock host_lock(host_buffers_mutex);
+		HostBuffer& host_buffer = host_buffers[mem.device_pointer];
+		host_buffer.mem = &mem;
+		host_buffer.uploaded.clear();
+	}
+
+	/* Send render buffers which are only complete on the host back to
+	 * those of the given servers which don't have the latest tiles yet. */
+	void host_buffer_upload(device_ptr buffer, const vector<NetworkConnection*>& conns)
+	{
+		device_memory *mem;
+		vector<NetworkConnection*> stale_conns;
+
+		{
+			thread_scoped_lock host_lock(host_buffers_mutex);
+			map<device_ptr, HostBuffer>::iterator it = host_buffers.find(buffer);
+
+			if(it == host_buffers.end())
+				return;
+
+			mem = it->second.mem;
+
+			foreach(NetworkConnection *conn, conns) {
+				if(it->second.uploaded.insert(conn).second)
+					stale_conns.push_back(conn);
+			}
+		}
+
+		if(stale_conns.empty())
+			return;
+
+		RPCBuffer data((void*)mem->data_pointer, mem->memory_size(), true);
+
+		foreach(NetworkConnection *conn, stale_conns)
+			mem_copy_to(conn, *mem, data);
+	}
+
+	void host_buffer_remove(device_memory& mem)
+	{
+		thread_scoped_lock host_lock(host_buffers_mutex);
+		host_buffers.erase(mem.device_pointer);
+	}
 };
 
 Device *device_network_create(DeviceInfo& info, Stats &stats, const char *address)
@@ -343,6 +609,107 @@ void device_network_info(vector<DeviceInfo>& devices)
 	devices.push_back(info);
 }
 
+/* Scene data kept by the server between connections, so rendering the
+ * next frame only needs buffers which changed to be sent. Textures use the
+ * cached buffers directly, they're not stored a second time. Least recently
+ * used buffers no texture uses anymore are discarded when going over the
+ * maximum size. */
+
+class ServerCache {
+public:
+	explicit ServerCache(size_t max_size_)
+	: size(0), max_size(max_size_), counter(0)
+	{
+	}
+
+	/* cached buffer with the given hash, name and size, NULL if there is
+	 * none. the name and size guard against hash collisions */
+	DataVector *acquire(uint64_t hash, const string& name, size_t data_size)
+	{
+		CacheMap::iterator it = entries.find(hash);
+
+		if(it == entries.end() || it->second.name != name || it->second.data.size() != data_size)
+			return NULL;
+
+		it->second.users++;
+		it->second.last_used = ++counter;
+
+		return &it->second.data;
+	}
+
+	/* new buffer for the caller to fill, NULL if it can't be cached */
+	DataVector *insert(uint64_t hash, const string& name, size_t data_size)
+	{
+		if(data_size > max_size || entries.find(hash) != entries.end())
+			return NULL;
+
+		Entry& entry = entries[hash];
+		entry.name = name;
+		entry.data.resize(data_size);
+		entry.users = 1;
+		entry.last_used = ++counter;
+
+		size += data_size;
+		remove_unused();
+
+		return &entry.data;
+	}
+
+	void release(uint64_t hash)
+	{
+		CacheMap::iterator it = entries.find(hash);
+
+		if(it != entries.end() && it->second.users > 0)
+			it->second.users--;
+
+		remove_unused();
+	}
+
+	/* drop a buffer that could not be filled */
+	void discard(uint64_t hash)
+	{
+		CacheMap::iterator it = entries.find(hash);
+
+		if(it != entries.end()) {
+			size -= it->second.data.size();
+			entries.erase(it);
+		}
+	}
+
+protected:
+	void remove_unused()
+	{
+		while(size > max_size) {
+			CacheMap::iterator oldest = entries.end();
+
+			for(CacheMap::iterator it = entries.begin(); it != entries.end(); ++it)
+				if(it->second.users == 0 && (oldest == entries.end() || it->second.last_used < oldest->second.last_used))
+					oldest = it;
+
+			/* everything left is in use */
+			if(oldest == entries.end())
+				break;
+
+			size -= oldest->second.data.size();
+			entries.erase(oldest);
+		}
+	}
+
+	struct Entry {
+		string name;
+		DataVector data;
+		/* number of textures using the buffer */
+		int users;
+		uint64_t last_used;
+	};
+
+	typedef map<uint64_t, Entry> CacheMap;
+
+	CacheMap entries;
+	size_t size, max_size;
+	uint64_t counter;
+};
+
 class DeviceServer {
 public:
 	thread_mutex rpc_lock;
@@ -353,12 +720,24 @@ public:
 
 	bool have_error() { return error_func.have_error(); }
 
-	DeviceServer(Device *device_, tcp::socket& socket_)
-	: device(device_), socket(socket_), stop(false), blocked_waiting(false)
+	DeviceServer(Device *device_, tcp::socket& socket_, ServerCache& cache_)
+	: device(device_), socket(socket_), cache(cache_), stop(false), blocked_waiting(false)
 	{
 		error_func = NetworkError();
 	}
 
+	~DeviceServer()
+	{
+		/* textures the client didn't free, after an error their data may
+		 * not have been received completely */
+		for(HashMap::iterator it = tex_hashes.begin(); it != tex_hashes.end(); ++it) {
+			if(have_error())
+				cache.discard(it->second);
+			else
+				cache.release(it->second);
+		}
+	}
+
 	void listen()
 	{
 		/* receive remote function calls */
@@ -444,10 +823,10 @@ protected:
 		assert(irev != ptr_imap.end());
 		ptr_imap.erase(irev);
 
-		/* erase the data vector */
+		/* erase the data vector, cached textures don't have one */
 		DataMap::iterator idata = mem_data.find(client_pointer);
-		assert(idata != mem_data.end());
-		mem_data.erase(idata);
+		if(idata != mem_data.end())
+			mem_data.erase(idata);
 
 		return result;
 	}
@@ -529,11 +908,48 @@ protected:
 
 			device->mem_copy_from(mem, y, w, h, elem);
 
-			size_t data_size = mem.memory_size();
+			size_t offset, size;
+			network_mem_copy_range(mem, y, w, h, elem, &offset, &size);
 
 			RPCSend snd(socket, &error_func, "mem_copy_from");
 			snd.write();
-			snd.write_buffer((uint8_t*)mem.data_pointer, data_size);
+			snd.write_buffer((uint8_t*)mem.data_pointer + offset, size);
+			lock.unlock();
+		}
+		else if(rcv.name == "tile_copy_from") {
+			network_device_memory mem;
+			int index, w, h, stride, elem;
+
+			rcv.read(mem);
+			rcv.read(index);
+			rcv.read(w);
+			rcv.read(h);
+			rcv.read(stride);
+			rcv.read(elem);
+
+			device_ptr client_pointer = mem.device_pointer;
+			mem.device_pointer = device_ptr_from_client_pointer(client_pointer);
+
+			DataVector &data_v = data_vector_find(client_pointer);
+
+			mem.data_pointer = (device_ptr)&(data_v[0]);
+
+			/* copy the rows covered by the tile from the device */
+			device->mem_copy_from(mem, index/stride, stride, h, elem);
+
+			/* pack the tile pixels */
+			size_t row_size = (size_t)w*elem;
+			DataVector pixels(row_size*h);
+
+			for(int y = 0; y < h; y++) {
+				memcpy(&pixels[y*row_size],
+				       (uint8_t*)mem.data_pointer + (size_t)(index + y*stride)*elem,
+				       row_size);
+			}
+
+			RPCSend snd(socket, &error_func, "tile_copy_from");
+			snd.write();
+			snd.write_buffer(&pixels[0], pixels.size());
 			lock.unlock();
 		}
 		else if(rcv.name == "mem_zero") {
@@ -583,25 +999,47 @@ protected:
 			InterpolationType interpolation;
 			ExtensionType extension_type;
 			device_ptr client_pointer;
+			uint64_t hash;
 
 			rcv.read(name);
 			rcv.read(mem);
 			rcv.read(interpolation);
 			rcv.read(extension_type);
-			lock.unlock();
+			rcv.read(hash);
 
 			client_pointer = mem.device_pointer;
 
 			size_t data_size = mem.memory_size();
 
-			DataVector &data_v = data_vector_insert(client_pointer, data_size);
+			/* ask for the data only if it's not in the cache */
+			DataVector *data_v = cache.acquire(hash, name, data_size);
+			bool cached = (data_v != NULL);
+
+			if(!cached)
+				data_v = cache.insert(hash, name, data_size);
+
+			if(data_v)
+				tex_hashes[client_pointer] = hash;
+			else
+				data_v = &data_vector_insert(client_pointer, data_size);
 
 			if(data_size)
-				mem.data_pointer = (device_ptr)&(data_v[0]);
+				mem.data_pointer = (device_ptr)&((*data_v)[0]);
 			else
 				mem.data_pointer = 0;
 
-			rcv.read_buffer((uint8_t*)mem.data_pointer, data_size);
+			if(cached) {
+				RPCSend snd(socket, &error_func, "tex_alloc_cached");
+				snd.write();
+				lock.unlock();
+			}
+			else {
+				RPCSend snd(socket, &error_func, "tex_alloc_data");
+				snd.write();
+
+				rcv.read_buffer((uint8_t*)mem.data_pointer, data_size);
+				lock.unlock();
+			}
 
 			device->tex_alloc(name.c_str(), mem, interpolation, extension_type);
 
@@ -619,6 +1057,13 @@ protected:
 			mem.device_pointer = device_ptr_from_client_pointer_erase(client_pointer);
 
 			device->tex_free(mem);
+
+			/* cached data stays around for the next client */
+			HashMap::iterator it = tex_hashes.find(client_pointer);
+			if(it != tex_hashes.end()) {
+				cache.release(it->second);
+				tex_hashes.erase(it);
+			}
 		}
 		else if(rcv.name == "load_kernels") {
 			DeviceRequestedFeatures requested_features;
@@ -804,11 +1249,14 @@ protected:
 	/* properties */
 	Device *device;
 	tcp::socket& socket;
+	ServerCache& cache;
 
 	/* mapping of remote to local pointer */
 	PtrMap ptr_map;
 	PtrMap ptr_imap;
 	DataMap mem_data;
+	/* cache entries used by textures */
+	HashMap tex_hashes;
 
 	struct AcquireEntry {
 		string name;
@@ -827,24 +1275,31 @@ private:
 
 };
 
-void Device::server_run()
+void Device::server_run(int port, size_t cache_size)
 {
+	if(port == 0)
+		port = SERVER_PORT;
+
 	try {
 		/* starts thread that responds to discovery requests */
-		ServerDiscovery discovery;
+		ServerDiscovery discovery(false, port);
+
+		/* scene data persists between clients */
+		ServerCache cache(cache_size);
 
 		for(;;) {
 			/* accept connection */
 			boost::asio::io_service io_service;
-			tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), SERVER_PORT));
+			tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), port));
 
 			tcp::socket socket(io_service);
 			acceptor.accept(socket);
+			socket.set_option(tcp::no_delay(true));
 
 			string remote_address = socket.remote_endpoint().address().to_string();
 			printf("Connected to remote client at: %s\n", remote_address.c_str());
 
-			DeviceServer server(this, socket);
+			DeviceServer server(this, socket, cache);
 			server.listen();
 
 			printf("Disconnected.\n");
@@ -33,11 +33,15 @@
 #include <sstream>
 #include <deque>
 
+#include <zlib.h>
+
 #include "buffers.h"
 
 #include "util_foreach.h"
 #include "util_list.h"
+#include "util_logging.h"
 #include "util_map.h"
+#include "util_set.h"
 #include "util_string.h"
 
 CCL_NAMESPACE_BEGIN
@@ -55,6 +59,14 @@ static const int DISCOVER_PORT = 5121;
 static const string DISCOVER_REQUEST_MSG = "REQUEST_RENDER_SERVER_IP";
 static const string DISCOVER_REPLY_MSG = "REPLY_RENDER_SERVER_IP";
 
+/* Wire protocol identification, bump the version on any change in the
+ * order or contents of RPCs. */
+static const uint32_t PROTOCOL_MAGIC = 0x4e594343; /* "CCYN" */
+static const uint32_t PROTOCOL_VERSION = 2;
+
+/* Buffers smaller than this are not worth compressing. */
+static const size_t COMPRESS_MIN_SIZE = 4096;
+
 #if 0
 typedef boost::archive::text_oarchive o_archive;
 typedef boost::archive::text_iarchive i_archive;
@@ -74,6 +86,44 @@ public:
 	vector<char> local_data;
 };
 
+/* Byte range of device memory transferred by mem_copy_from, matching the
+ * row based copies of the other devices. */
+static inline void network_mem_copy_range(device_memory& mem, int y, int w, int h, int elem,
+                                          size_t *offset, size_t *size)
+{
+	size_t mem_size = mem.memory_size();
+
+	*offset = (size_t)elem*y*w;
+	*size = (size_t)elem*w*h;
+
+	if(*offset > mem_size)
+		*offset = mem_size;
+	if(*size > mem_size - *offset)
+		*size = mem_size - *offset;
+}
+
+/* Content hash of a buffer, used to find scene data cached on servers. */
+static inline uint64_t network_buffer_hash(const void *data, size_t size)
+{
+	/* FNV-1a over 64 bit words, with the tail and size mixed in. */
+	const uint64_t prime = 0x100000001b3ULL;
+	uint64_t hash = 0xcbf29ce484222325ULL ^ size;
+
+	const uint8_t *bytes = (const uint8_t*)data;
+	size_t num_words = size/sizeof(uint64_t);
+
+	for(size_t i = 0; i < num_words; i++) {
+		uint64_t word;
+		memcpy(&word, bytes + i*sizeof(uint64_t), sizeof(uint64_t));
+		hash = (hash ^ word) * prime;
+	}
+
+	for(size_t i = num_words*sizeof(uint64_t); i < size; i++)
+		hash = (hash ^ bytes[i]) * prime;
+
+	return hash;
+}
+
 /* Common netowrk error function / object for both DeviceNetwork and DeviceServer*/
 class NetworkError {
 public:
@@ -93,11 +143,87 @@ public:
 		return true ? error_count > 0 : false;
 	}
 
+	const string& error_message() {
+		return error;
+	}
+
 private:
 	string error;
 	int error_count;
 };
 
+/* Fixed size binary headers. Both ends are expected to have the same byte
+ * order, like the binary archives. */
+
+struct RPCHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t archive_size;
+};
+
+/* Compressed size is zero for buffers sent as is. */
+struct RPCBufferHeader {
+	uint64_t size;
+	uint64_t compressed_size;
+};
+
+/* Buffer data sent along with an RPC. Memory is sent straight from the
+ * given pointer unless compression is requested and pays off. Compression
+ * happens once on first use, so the same buffer can be sent to multiple
+ * servers. */
+
+class RPCBuffer {
+public:
+	RPCBuffer(const void *data_, size_t size_, bool compress_)
+	: data(data_), compress(compress_), prepared(false)
+	{
+		header.size = size_;
+		header.compressed_size = 0;
+	}
+
+	void prepare()
+	{
+		if(prepared)
+			return;
+
+		prepared = true;
+
+		/* zlib sizes are 32 bit on some platforms */
+		if(!compress || header.size < COMPRESS_MIN_SIZE || header.size > 0x7fffffff)
+			return;
+
+		uLongf compressed_size = compressBound(header.size);
+		compressed.resize(compressed_size);
+
+		if(compress2(&compressed[0], &compressed_size, (const Bytef*)data, header.size, 1) == Z_OK &&
+		   compressed_size < header.size)
+		{
+			compressed.resize(compressed_size);
+			header.compressed_size = compressed_size;
+		}
+		else {
+			vector<uint8_t>().swap(compressed);
+		}
+	}
+
+	const void *send_data() const
+	{
+		return (header.compressed_size)? (const void*)&compressed[0]: data;
+	}
+
+	size_t send_size() const
+	{
+		return (header.compressed_size)? header.compressed_size: header.size;
+	}
+
+	RPCBufferHeader header;
+
+protected:
+	const void *data;
+	bool compress;
+	bool prepared;
+	vector<uint8_t> compressed;
+};
 
 /* Remote procedure call Send */
 
@@ -108,7 +234,7 @@ public:
 	{
 		archive & name_;
 		error_func = e;
-		fprintf(stderr, "rpc send %s\n", name.c_str());
+		VLOG(4) << "RPC send " << name;
 	}
 
 	~RPCSend()
@@ -147,47 +273,55 @@ public:
 
 	void write()
 	{
-		boost::system::error_code error;
-
 		/* get string from stream */
 		string archive_str = archive_stream.str();
 
-		/* first send fixed size header with size of following data */
-		ostringstream header_stream;
-		header_stream << setw(8) << hex << archive_str.size();
-		string header_str = header_stream.str();
-
-		boost::asio::write(socket,
-			boost::asio::buffer(header_str),
-			boost::asio::transfer_all(), error);
+		/* fixed size header with size of following data, sent together
+		 * with the data in a single write */
+		RPCHeader header;
+		header.magic = PROTOCOL_MAGIC;
+		header.version = PROTOCOL_VERSION;
+		header.archive_size = archive_str.size();
 
-		if(error.value())
-			error_func->network_error(error.message());
+		boost::array<boost::asio::const_buffer, 2> buffers = {{
+			boost::asio::buffer(&header, sizeof(header)),
+			boost::asio::buffer(archive_str)
+		}};
 
-		/* then send actual data */
-		boost::asio::write(socket,
-			boost::asio::buffer(archive_str),
-			boost::asio::transfer_all(), error);
-		
-		if(error.value())
-			error_func->network_error(error.message());
+		write_buffers(buffers);
 
 		sent = true;
 	}
 
-	void write_buffer(void *buffer, size_t size)
+	void write_buffer(RPCBuffer& buffer)
+	{
+		buffer.prepare();
+
+		boost::array<boost::asio::const_buffer, 2> buffers = {{
+			boost::asio::buffer(&buffer.header, sizeof(buffer.header)),
+			boost::asio::buffer(buffer.send_data(), buffer.send_size())
+		}};
+
+		write_buffers(buffers);
+	}
+
+	void write_buffer(void *data, size_t size)
+	{
+		RPCBuffer buffer(data, size, false);
+		write_buffer(buffer);
+	}
+
+protected:
+	template<typename Buffers> void write_buffers(const Buffers& buffers)
 	{
 		boost::system::error_code error;
 
-		boost::asio::write(socket,
-			boost::asio::buffer(buffer, size),
-			boost::asio::transfer_all(), error);
-		
+		boost::asio::write(socket, buffers, boost::asio::transfer_all(), error);
+
 		if(error.value())
 			error_func->network_error(error.message());
 	}
 
-protected:
 	string name;
 	tcp::socket& socket;
 	ostringstream archive_stream;
@@ -205,23 +339,18 @@ public:
 	{
 		error_func = e;
 		/* read head with fixed size */
-		vector<char> header(8);
+		RPCHeader header;
 		boost::system::error_code error;
-		size_t len = boost::asio::read(socket, boost::asio::buffer(header), error);
+		size_t len = boost::asio::read(socket, boost::asio::buffer(&header, sizeof(header)), error);
 
 		if(error.value()) {
 			error_func->network_error(error.message());
 		}
 
 		/* verify if we got something */
-		if(len == header.size()) {
-			/* decode header */
-			string header_str(&header[0], header.size());
-			istringstream header_stream(header_str);
-
-			size_t data_size;
-
-			if((header_stream >> hex >> data_size)) {
+		if(len == sizeof(header)) {
+			if(header.magic == PROTOCOL_MAGIC && header.version == PROTOCOL_VERSION) {
+				size_t data_size = header.archive_size;
 
 				vector<char> data(data_size);
 				size_t len = boost::asio::read(socket, boost::asio::buffer(data), error);
@@ -237,14 +366,15 @@ public:
 					archive = new i_archive(*archive_stream);
 
 					*archive & name;
-					fprintf(stderr, "rpc receive %s\n", name.c_str());
+					VLOG(4) << "RPC receive " << name;
 				}
 				else {
 					error_func->network_error("Network receive error: data size doesn't match header");
 				}
 			}
 			else {
-				error_func->network_error("Network receive error: can't decode data size from header");
+				error_func->network_error("Network receive error: protocol mismatch, "
+				                          "client and server versions differ");
 			}
 		}
 		else {
@@ -273,15 +403,34 @@ public:
 
 	void read_buffer(void *buffer, size_t size)
 	{
-		boost::system::error_code error;
-		size_t len = boost::asio::read(socket, boost::asio::buffer(buffer, size), error);
+		RPCBufferHeader header;
 
-		if(error.value()) {
-			error_func->network_error(error.message());
+		if(!read_raw(&header, sizeof(header)))
+			return;
+
+		if(header.size != size) {
+			error_func->network_error("Network receive error: buffer size doesn't match expected size");
+			return;
+		}
+
+		if(header.compressed_size == 0) {
+			/* read straight into the destination */
+			read_raw(buffer, size);
+			return;
 		}
 
-		if(len != size)
-			cout << "Network receive error: buffer size doesn't match expected size\n";
+		vector<uint8_t> compressed(header.compressed_size);
+
+		if(!read_raw(&compressed[0], compressed.size()))
+			return;
+
+		uLongf uncompressed_size = size;
+
+		if(uncompress((Bytef*)buffer, &uncompressed_size, &compressed[0], compressed.size()) != Z_OK ||
+		   uncompressed_size != size)
+		{
+			error_func->network_error("Network receive error: failed to decompress buffer");
+		}
 	}
 
 	void read(DeviceTask& task)
@@ -311,6 +460,24 @@ public:
 	string name;
 
 protected:
+	bool read_raw(void *buffer, size_t size)
+	{
+		boost::system::error_code error;
+		size_t len = boost::asio::read(socket, boost::asio::buffer(buffer, size), error);
+
+		if(error.value()) {
+			error_func->network_error(error.message());
+			return false;
+		}
+
+		if(len != size) {
+			error_func->network_error("Network receive error: incomplete buffer");
+			return false;
+		}
+
+		return true;
+	}
+
 	tcp::socket& socket;
 	string archive_str;
 	istringstream *archive_stream;
@@ -322,8 +489,10 @@ protected:
 
 class ServerDiscovery {
 public:
-	explicit ServerDiscovery(bool discover = false)
-	: listen_socket(io_service), collect_servers(false)
+	/* Servers reply with the port they accept connections on, so multiple
+	 * servers can run on the same host. */
+	explicit ServerDiscovery(bool discover = false, int server_port_ = SERVER_PORT)
+	: listen_socket(io_service), server_port(server_port_), collect_servers(false)
 	{
 		/* setup listen socket */
 		listen_endpoint.address(boost::asio::ip::address_v4::any());
@@ -384,8 +553,12 @@ private:
 
 			/* handle incoming message */
 			if(collect_servers) {
-				if(msg == DISCOVER_REPLY_MSG) {
+				if(string_startswith(msg, DISCOVER_REPLY_MSG.c_str())) {
 					string address = receive_endpoint.address().to_string();
+					string port = msg.substr(DISCOVER_REPLY_MSG.size());
+
+					if(!port.empty())
+						address += ":" + port.substr(1);
 
 					mutex.lock();
 
@@ -402,7 +575,7 @@ private:
 			else {
 				/* reply to request */
 				if(msg == DISCOVER_REQUEST_MSG)
-					broadcast_message(DISCOVER_REPLY_MSG);
+					broadcast_message(string_printf("%s %d", DISCOVER_REPLY_MSG.c_str(), server_port));
 			}
 		}
 
@@ -438,6 +611,7 @@ private:
 	boost::asio::io_service io_service;
 	boost::asio::ip::udp::endpoint listen_endpoint;
 	boost::asio::ip::udp::socket listen_socket;
+	int server_port;
 
 	/* threading */
 	boost::thread *thread;
@@ -18,6 +18,7 @@
 #include "node_type.h"
 
 #include "util_foreach.h"
+#include "util_md5.h"
 #include "util_param.h"
 #include "util_transform.h"
 
@@ -403,5 +404,62 @@ bool Node::equals(const Node& other) const
 	return true;
 }
 
+/* hash */
+
+template<typename T>
+static void array_hash(const Node *node, const SocketType& socket, MD5Hash& md5)
+{
+	const array<T>& a = *(const array<T>*)(((char*)node) + socket.struct_offset);
+	if(a.size()) {
+		md5.append((const uint8_t*)&a[0], a.size()*sizeof(T));
+	}
+}
+
+static void float3_array_hash(const Node *node, const SocketType& socket, MD5Hash& md5)
+{
+	/* Skip the fourth component, it's padding and may be uninitialized. */
+	const array<float3>& a = *(const array<float3>*)(((char*)node) + socket.struct_offset);
+	for(size_t i = 0; i < a.size(); i++) {
+		md5.append((const uint8_t*)&a[i], sizeof(float)*3);
+	}
+}
+
+void Node::hash(MD5Hash& md5) const
+{
+	md5.append((const uint8_t*)type->name.c_str(), type->name.size());
+
+	foreach(const SocketType& socket, type->inputs) {
+		if(socket.is_array()) {
+			switch(socket.type) {
+				case SocketType::BOOLEAN_ARRAY: array_hash<bool>(this, socket, md5); break;
+				case SocketType::FLOAT_ARRAY: array_hash<float>(this, socket, md5); break;
+				case SocketType::INT_ARRAY: array_hash<int>(this, socket, md5); break;
+				case SocketType::COLOR_ARRAY: float3_array_hash(this, socket, md5); break;
+				case SocketType::VECTOR_ARRAY: float3_array_hash(this, socket, md5); break;
+				case SocketType::POINT_ARRAY: float3_array_hash(this, socket, md5); break;
+				case SocketType::NORMAL_ARRAY: float3_array_hash(this, socket, md5); break;
+				case SocketType::POINT2_ARRAY: array_hash<float2>(this, socket, md5); break;
+				case SocketType::STRING_ARRAY: array_hash<ustring>(this, socket, md5); break;
+				case SocketType::TRANSFORM_ARRAY: array_hash<Transform>(this, socket, md5); break;
+				case SocketType::NODE_ARRAY: array_hash<void*>(this, socket, md5); break;
+				default: assert(0); break;
+			}
+		}
+		else {
+			/* Strings are interned, so hashing the pointer is enough. Padding
+			 * of float3 values is skipped like for arrays. */
+			size_t size = socket.size();
+			if(socket.type == SocketType::COLOR ||
+			   socket.type == SocketType::VECTOR ||
+			   socket.type == SocketType::POINT ||
+			   socket.type == SocketType::NORMAL)
+			{
+				size = sizeof(float)*3;
+			}
+			md5.append(((const uint8_t*)this) + socket.struct_offset, size);
+		}
+	}
+}
+
 CCL_NAMESPACE_END
 
@@ -211,7 +211,18 @@ ccl_device_noinline float3 indirect_primitive_emission(KernelGlobals *kg, Shader
 	{
 		/* multiple importance sampling, get triangle light pdf,
 		 * and compute weight with respect to BSDF pdf */
-		float pdf = triangle_light_pdf(kg, ccl_fetch(sd, Ng), ccl_fetch(sd, I), t);
+		float pdf;
+
+		if(kernel_data.integrator.use_light_tree) {
+			/* selection probability depends on the point the ray came from */
+			float3 ray_P = ccl_fetch(sd, P) + ccl_fetch(sd, I)*t;
+			pdf = light_tree_triangle_pdf(kg, ray_P, ccl_fetch(sd, object), ccl_fetch(sd, prim),
+			                              ccl_fetch(sd, Ng), ccl_fetch(sd, I), t);
+		}
+		else {
+			pdf = triangle_light_pdf(kg, ccl_fetch(sd, Ng), ccl_fetch(sd, I), t);
+		}
+
 		float mis_weight = power_heuristic(bsdf_pdf, pdf);
 
 		return L*mis_weight;
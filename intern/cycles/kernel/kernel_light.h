@@ -848,6 +848,227 @@ ccl_device int light_distribution_sample(KernelGlobals *kg, float randt)
 	return clamp(first-1, 0, kernel_data.integrator.num_distribution-1);
 }
 
+/* Light Tree
+ *
+ * Hierarchy over triangles and lamps, traversed stochastically by picking
+ * a child proportional to an estimate of its contribution to the shading
+ * point. Distant and background lights are kept out of the tree and picked
+ * uniformly with probability light_tree_infinite_pdf.
+ *
+ * Nodes and emitters share the layout of their first three float4:
+ * bounding box minimum and energy, bounding box maximum and cone angle,
+ * cone axis. */
+
+ccl_device float light_tree_importance(float3 P, float4 data0, float4 data1, float4 data2)
+{
+	float energy = data0.w;
+
+	if(energy == 0.0f)
+		return 0.0f;
+
+	float3 bbox_min = make_float3(data0.x, data0.y, data0.z);
+	float3 bbox_max = make_float3(data1.x, data1.y, data1.z);
+	float3 centroid = 0.5f*(bbox_min + bbox_max);
+	float radius_sq = 0.25f*len_squared(bbox_max - bbox_min);
+	float dist_sq = len_squared(P - centroid);
+
+	/* Clamp distance to the bounding sphere, so nearby clusters don't get
+	 * an arbitrarily high importance. */
+	float importance = energy/max(max(dist_sq, radius_sq), 1e-12f);
+
+	float theta_o = data1.w;
+
+	if(theta_o < M_PI_F && dist_sq > radius_sq) {
+		/* Smallest angle between the cone and a direction from any point
+		 * in the bounding sphere towards P. */
+		float3 axis = make_float3(data2.x, data2.y, data2.z);
+		float3 I = (P - centroid)/sqrtf(dist_sq);
+		float theta = safe_acosf(dot(axis, I));
+		float theta_u = safe_asinf(sqrtf(radius_sq/dist_sq));
+		float theta_min = theta - theta_o - theta_u;
+
+		if(theta_min >= M_PI_2_F)
+			return 0.0f;
+		else if(theta_min > 0.0f)
+			importance *= cosf(theta_min);
+	}
+
+	return importance;
+}
+
+ccl_device float light_tree_node_importance(KernelGlobals *kg, float3 P, int node)
+{
+	int offset = node*LIGHT_TREE_NODE_SIZE;
+	return light_tree_importance(P,
+	                             kernel_tex_fetch(__light_tree_nodes, offset + 0),
+	                             kernel_tex_fetch(__light_tree_nodes, offset + 1),
+	                             kernel_tex_fetch(__light_tree_nodes, offset + 2));
+}
+
+ccl_device float light_tree_emitter_importance(KernelGlobals *kg, float3 P, int emitter)
+{
+	int offset = emitter*LIGHT_TREE_EMITTER_SIZE;
+	return light_tree_importance(P,
+	                             kernel_tex_fetch(__light_tree_emitters, offset + 0),
+	                             kernel_tex_fetch(__light_tree_emitters, offset + 1),
+	                             kernel_tex_fetch(__light_tree_emitters, offset + 2));
+}
+
+/* Pick an emitter from the tree, returns -1 if nothing contributes to P. */
+ccl_device int light_tree_sample(KernelGlobals *kg, float3 P, float randt, float *pdf)
+{
+	int node = 0;
+	*pdf = 1.0f;
+
+	for(;;) {
+		float4 data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+		int num_emitters = __float_as_int(data3.x);
+
+		if(num_emitters != 0) {
+			/* Leaf, pick emitter proportional to its own importance. */
+			int first_emitter = __float_as_int(data3.y);
+			float total = 0.0f;
+
+			for(int i = 0; i < num_emitters; i++)
+				total += light_tree_emitter_importance(kg, P, first_emitter + i);
+
+			if(total == 0.0f)
+				return -1;
+
+			randt *= total;
+
+			int emitter = -1;
+			float importance = 0.0f;
+
+			for(int i = 0; i < num_emitters; i++) {
+				float emitter_importance = light_tree_emitter_importance(kg, P, first_emitter + i);
+
+				if(emitter_importance > 0.0f) {
+					/* Keep last non-zero one to be robust against float rounding. */
+					emitter = first_emitter + i;
+					importance = emitter_importance;
+
+					if(randt < emitter_importance)
+						break;
+
+					randt -= emitter_importance;
+				}
+			}
+
+			*pdf *= importance/total;
+			return emitter;
+		}
+
+		int left = node + 1;
+		int right = __float_as_int(data3.y);
+		float importance_left = light_tree_node_importance(kg, P, left);
+		float importance_right = light_tree_node_importance(kg, P, right);
+		float total = importance_left + importance_right;
+
+		if(total == 0.0f)
+			return -1;
+
+		/* Reuse the random number for the next level. */
+		float prob_left = importance_left/total;
+
+		if(randt < prob_left) {
+			node = left;
+			randt = randt/prob_left;
+			*pdf *= prob_left;
+		}
+		else {
+			node = right;
+			randt = (randt - prob_left)/(1.0f - prob_left);
+			*pdf *= 1.0f - prob_left;
+		}
+	}
+}
+
+/* Probability of light_tree_sample() picking the given emitter from P. */
+ccl_device float light_tree_emitter_pdf(KernelGlobals *kg, float3 P, int emitter)
+{
+	float4 edata2 = kernel_tex_fetch(__light_tree_emitters, emitter*LIGHT_TREE_EMITTER_SIZE + 2);
+	uint bit_trail = __float_as_uint(edata2.w);
+	int node = 0;
+	float pdf = 1.0f;
+
+	for(;;) {
+		float4 data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+		int num_emitters = __float_as_int(data3.x);
+
+		if(num_emitters != 0) {
+			int first_emitter = __float_as_int(data3.y);
+			float total = 0.0f;
+
+			for(int i = 0; i < num_emitters; i++)
+				total += light_tree_emitter_importance(kg, P, first_emitter + i);
+
+			if(total == 0.0f)
+				return 0.0f;
+
+			return pdf*light_tree_emitter_importance(kg, P, emitter)/total;
+		}
+
+		int left = node + 1;
+		int right = __float_as_int(data3.y);
+		float importance_left = light_tree_node_importance(kg, P, left);
+		float importance_right = light_tree_node_importance(kg, P, right);
+		float total = importance_left + importance_right;
+
+		if(total == 0.0f)
+			return 0.0f;
+
+		if(bit_trail & 1) {
+			node = right;
+			pdf *= importance_right/total;
+		}
+		else {
+			node = left;
+			pdf *= importance_left/total;
+		}
+
+		bit_trail >>= 1;
+	}
+}
+
+/* Emitter index of a triangle, or -1 if it is not in the tree.
+ *
+ * The map starts with a (table offset, triangle offset) pair per object,
+ * followed by per triangle emitter indices of all objects usable as light. */
+ccl_device int light_tree_triangle_emitter(KernelGlobals *kg, int object, int prim)
+{
+	uint table_offset = kernel_tex_fetch(__light_tree_emitter_map, object*2 + 0);
+
+	if(table_offset == 0)
+		return -1;
+
+	uint tri_offset = kernel_tex_fetch(__light_tree_emitter_map, object*2 + 1);
+	return (int)kernel_tex_fetch(__light_tree_emitter_map, table_offset + prim - tri_offset);
+}
+
+/* Same as triangle_light_pdf(), but for selection through the light tree
+ * from the point P the ray was traced from. */
+ccl_device float light_tree_triangle_pdf(KernelGlobals *kg,
+	float3 P, int object, int prim, const float3 Ng, const float3 I, float t)
+{
+	int emitter = light_tree_triangle_emitter(kg, object, prim);
+
+	if(emitter == -1)
+		return 0.0f;
+
+	float cos_pi = fabsf(dot(Ng, I));
+
+	if(cos_pi == 0.0f)
+		return 0.0f;
+
+	float4 edata3 = kernel_tex_fetch(__light_tree_emitters, emitter*LIGHT_TREE_EMITTER_SIZE + 3);
+	float inv_area = edata3.x;
+	float pdf = light_tree_emitter_pdf(kg, P, emitter)*
+	            (1.0f - kernel_data.integrator.light_tree_infinite_pdf)*inv_area;
+
+	return t*t*pdf/cos_pi;
+}
+
 /* Generic Light */
 
 ccl_device bool light_select_reached_max_bounces(KernelGlobals *kg, int index, int bounce)
@@ -856,6 +1077,85 @@ ccl_device bool light_select_reached_max_bounces(KernelGlobals *kg, int index, i
 	return (bounce > __float_as_int(data4.x));
 }
 
+ccl_device bool light_tree_light_sample(KernelGlobals *kg,
+                                        float randt,
+                                        float randu,
+                                        float randv,
+                                        float time,
+                                        float3 P,
+                                        int bounce,
+                                        LightSample *ls)
+{
+	int num_emitters = kernel_data.integrator.light_tree_num_emitters;
+	int num_infinite = kernel_data.integrator.light_tree_num_infinite;
+	float infinite_pdf = kernel_data.integrator.light_tree_infinite_pdf;
+	float pdf_select;
+	int emitter;
+
+	if(randt < infinite_pdf) {
+		/* Distant and background lights, stored after the tree emitters. */
+		int index = min(float_to_int(randt/infinite_pdf*num_infinite), num_infinite - 1);
+		emitter = num_emitters + index;
+		pdf_select = infinite_pdf/num_infinite;
+	}
+	else {
+		randt = (randt - infinite_pdf)/(1.0f - infinite_pdf);
+		emitter = light_tree_sample(kg, P, randt, &pdf_select);
+
+		if(emitter == -1) {
+			/* Equiangular volume sampling reads the position even when
+			 * no light was sampled, it skips distances of FLT_MAX. */
+			ls->t = FLT_MAX;
+			ls->pdf = 0.0f;
+			return false;
+		}
+
+		pdf_select *= 1.0f - infinite_pdf;
+	}
+
+	float4 edata3 = kernel_tex_fetch(__light_tree_emitters, emitter*LIGHT_TREE_EMITTER_SIZE + 3);
+	int prim = __float_as_int(edata3.y);
+
+	if(prim >= 0) {
+		int object = __float_as_int(edata3.w);
+		int shader_flag = __float_as_int(edata3.z);
+		float inv_area = edata3.x;
+
+		triangle_light_sample(kg, prim, object, randu, randv, time, ls);
+		/* compute incoming direction, distance and pdf */
+		ls->D = normalize_len(ls->P - P, &ls->t);
+
+		float cos_pi = fabsf(dot(ls->Ng, ls->D));
+
+		if(cos_pi == 0.0f)
+			return false;
+
+		ls->pdf = ls->t*ls->t*pdf_select*inv_area/cos_pi;
+		ls->shader |= shader_flag;
+		return (ls->pdf > 0.0f);
+	}
+	else {
+		int lamp = -prim-1;
+
+		if(UNLIKELY(light_select_reached_max_bounces(kg, lamp, bounce))) {
+			return false;
+		}
+
+		if(!lamp_light_sample(kg, lamp, randu, randv, P, ls)) {
+			return false;
+		}
+
+		/* lamp_light_sample() accounts for the selection probability of
+		 * infinite lights through pdf_lights, replace it for lamps that
+		 * were picked from the tree. */
+		if(emitter < num_emitters) {
+			ls->eval_fac *= kernel_data.integrator.pdf_lights/pdf_select;
+		}
+
+		return true;
+	}
+}
+
 ccl_device_noinline bool light_sample(KernelGlobals *kg,
                                       float randt,
                                       float randu,
@@ -865,6 +1165,10 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
                                       int bounce,
                                       LightSample *ls)
 {
+	if(kernel_data.integrator.use_light_tree) {
+		return light_tree_light_sample(kg, randt, randu, randv, time, P, bounce, ls);
+	}
+
 	/* sample index */
 	int index = light_distribution_sample(kg, randt);
 
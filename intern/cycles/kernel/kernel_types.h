@@ -38,6 +38,8 @@ CCL_NAMESPACE_BEGIN
 #define OBJECT_SIZE 		12
 #define OBJECT_VECTOR_SIZE	6
 #define LIGHT_SIZE		11
+#define LIGHT_TREE_NODE_SIZE	4
+#define LIGHT_TREE_EMITTER_SIZE	4
 #define FILTER_TABLE_SIZE	1024
 #define RAMP_TABLE_SIZE		256
 #define SHUTTER_TABLE_SIZE		256
@@ -1134,6 +1136,12 @@ typedef struct KernelIntegrator {
 	int num_portals;
 	int portal_offset;
 
+	/* light tree */
+	int use_light_tree;
+	int light_tree_num_emitters;
+	int light_tree_num_infinite;
+	float light_tree_infinite_pdf;
+
 	/* bounces */
 	int min_bounce;
 	int max_bounce;
@@ -118,6 +118,8 @@ NODE_DEFINE(Camera)
 	SOCKET_FLOAT(nearclip, "Near Clip", 1e-5f);
 	SOCKET_FLOAT(farclip, "Far Clip", 1e5f);
 
+	SOCKET_FLOAT(offscreen_dicing_scale, "Offscreen Dicing Scale", 1.0f);
+
 	SOCKET_FLOAT(viewplane.left, "Viewplane Left", 0);
 	SOCKET_FLOAT(viewplane.right, "Viewplane Right", 0);
 	SOCKET_FLOAT(viewplane.bottom, "Viewplane Bottom", 0);
@@ -162,6 +164,9 @@ Camera::Camera()
 	dx = make_float3(0.0f, 0.0f, 0.0f);
 	dy = make_float3(0.0f, 0.0f, 0.0f);
 
+	dicing_frustum_min = make_float2(-1.0f, -1.0f);
+	dicing_frustum_max = make_float2(1.0f, 1.0f);
+
 	need_update = true;
 	need_device_update = true;
 	need_flags_update = true;
@@ -273,6 +278,21 @@ void Camera::update()
 	full_dx = transform_direction(&cameratoworld, full_dx);
 	full_dy = transform_direction(&cameratoworld, full_dy);
 
+	/* frustum extents in camera space for dicing, at unit depth for
+	 * perspective cameras so they can be scaled by the depth of a point */
+	if(type != CAMERA_PANORAMA) {
+		float3 corner0 = transform_perspective(&rastertocamera, make_float3(0.0f, 0.0f, 0.0f));
+		float3 corner1 = transform_perspective(&rastertocamera, make_float3(width, height, 0.0f));
+
+		if(type == CAMERA_PERSPECTIVE) {
+			corner0 /= corner0.z;
+			corner1 /= corner1.z;
+		}
+
+		dicing_frustum_min = make_float2(min(corner0.x, corner1.x), min(corner0.y, corner1.y));
+		dicing_frustum_max = make_float2(max(corner0.x, corner1.x), max(corner0.y, corner1.y));
+	}
+
 	/* TODO(sergey): Support other types of camera. */
 	if(type == CAMERA_PERSPECTIVE) {
 		/* TODO(sergey): Move to an utility function and de-duplicate with
@@ -581,8 +601,10 @@ BoundBox Camera::viewplane_bounds_get()
 
 float Camera::world_to_raster_size(float3 P)
 {
+	float res = 1.0f;
+
 	if(type == CAMERA_ORTHOGRAPHIC) {
-		return min(len(full_dx), len(full_dy));
+		res = min(len(full_dx), len(full_dy));
 	}
 	else if(type == CAMERA_PERSPECTIVE) {
 		/* Calculate as if point is directly ahead of the camera. */
@@ -597,14 +619,38 @@ float Camera::world_to_raster_size(float3 P)
 		/* dPdx */
 		float dist = len(transform_point(&worldtocamera, P));
 		float3 D = normalize(Ddiff);
-		return len(dist*dDdx - dot(dist*dDdx, D)*D);
+		res = len(dist*dDdx - dot(dist*dDdx, D)*D);
 	}
 	else {
 		// TODO(mai): implement for CAMERA_PANORAMA
 		assert(!"pixel width calculation for panoramic projection not implemented yet");
+		return res;
+	}
+
+	/* Points outside of the view frustum or clipping range are diced coarser,
+	 * ramping up to the offscreen scale at one frustum size away from it. */
+	if(offscreen_dicing_scale > 1.0f) {
+		float3 Pcamera = transform_point(&worldtocamera, P);
+		float depth = clamp(Pcamera.z, nearclip, farclip);
+
+		float2 fmin = dicing_frustum_min;
+		float2 fmax = dicing_frustum_max;
+
+		if(type == CAMERA_PERSPECTIVE) {
+			fmin *= depth;
+			fmax *= depth;
+		}
+
+		float3 Pfrustum = make_float3(clamp(Pcamera.x, fmin.x, fmax.x),
+		                              clamp(Pcamera.y, fmin.y, fmax.y),
+		                              depth);
+		float frustum_size = max(fmax.x - fmin.x, fmax.y - fmin.y);
+		float dist = len(Pcamera - Pfrustum) / max(frustum_size, 1e-8f);
+
+		res *= 1.0f + min(dist, 1.0f) * (offscreen_dicing_scale - 1.0f);
 	}
 
-	return 1.0f;
+	return res;
 }
 
 CCL_NAMESPACE_END
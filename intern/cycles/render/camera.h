@@ -123,6 +123,9 @@ public:
 	float nearclip;
 	float farclip;
 
+	/* adaptive subdivision, scale of the dicing rate outside of the view */
+	float offscreen_dicing_scale;
+
 	/* screen */
 	int width, height;
 	int resolution;
@@ -163,6 +166,9 @@ public:
 	float3 full_dx;
 	float3 full_dy;
 
+	float2 dicing_frustum_min;
+	float2 dicing_frustum_max;
+
 	/* update */
 	bool need_update;
 	bool need_device_update;
@@ -68,6 +68,7 @@ public:
 	bool sample_all_lights_direct;
 	bool sample_all_lights_indirect;
 	float light_sampling_threshold;
+	bool use_light_tree;
 
 	enum Method {
 		BRANCHED_PATH = 0,
@@ -90,6 +91,9 @@ public:
 
 	bool modified(const Integrator& integrator);
 	void tag_update(Scene *scene);
+
+	/* Light tree is not used when the branched path integrator samples all lights. */
+	bool use_light_tree_sampling() const;
 };
 
 CCL_NAMESPACE_END
@@ -19,6 +19,7 @@
 #include "integrator.h"
 #include "film.h"
 #include "light.h"
+#include "light_tree.h"
 #include "mesh.h"
 #include "object.h"
 #include "scene.h"
@@ -611,6 +612,255 @@ void LightManager::device_update_background(Device *device,
 	device->tex_alloc("__light_background_conditional_cdf", dscene->light_background_conditional_cdf);
 }
 
+/* Rough estimate of emitted power per unit area, only used to guide light
+ * tree sampling. Shaders with varying emission are all treated alike. */
+static float light_tree_shader_energy(Shader *shader)
+{
+	float3 emission;
+
+	if(shader->is_constant_emission(&emission)) {
+		return max(average(emission), 0.0f);
+	}
+
+	return 1.0f;
+}
+
+void LightManager::device_update_light_tree(Device *device,
+                                            DeviceScene *dscene,
+                                            Scene *scene,
+                                            Progress& progress)
+{
+	KernelIntegrator *kintegrator = &dscene->data.integrator;
+
+	kintegrator->use_light_tree = false;
+	kintegrator->light_tree_num_emitters = 0;
+	kintegrator->light_tree_num_infinite = 0;
+	kintegrator->light_tree_infinite_pdf = 0.0f;
+
+	if(!kintegrator->use_direct_light || !scene->integrator->use_light_tree_sampling()) {
+		return;
+	}
+
+	progress.set_status("Updating Lights", "Building light tree");
+
+	double time_start = time_dt();
+
+	/* Distribution refers to lamps by their index among enabled lights. */
+	vector<Light*> lights;
+	foreach(Light *light, scene->lights) {
+		if(light->is_enabled) {
+			lights.push_back(light);
+		}
+	}
+
+	vector<LightTreeEmitter> emitters;
+	vector<int> infinite_lights;
+
+	const float4 *distribution = dscene->light_distribution.get_data();
+	int num_distribution = kintegrator->num_distribution;
+
+	emitters.reserve(num_distribution);
+
+	for(int i = 0; i < num_distribution; i++) {
+		int prim = __float_as_int(distribution[i].y);
+		LightTreeEmitter emitter;
+
+		emitter.bbox = BoundBox::empty;
+		emitter.inv_area = 0.0f;
+		emitter.prim = prim;
+		emitter.object = -1;
+		emitter.shader_flag = 0;
+		emitter.bit_trail = 0;
+
+		if(prim >= 0) {
+			int object_id = __float_as_int(distribution[i].w);
+			Object *object = scene->objects[object_id];
+			Mesh *mesh = object->mesh;
+			int tri = prim - mesh->tri_offset;
+
+			Mesh::Triangle t = mesh->get_triangle(tri);
+			float3 p1 = mesh->verts[t.v[0]];
+			float3 p2 = mesh->verts[t.v[1]];
+			float3 p3 = mesh->verts[t.v[2]];
+
+			if(!mesh->transform_applied) {
+				p1 = transform_point(&object->tfm, p1);
+				p2 = transform_point(&object->tfm, p2);
+				p3 = transform_point(&object->tfm, p3);
+			}
+
+			int shader_index = mesh->shader[tri];
+			Shader *shader = (shader_index < mesh->used_shaders.size())
+			                         ? mesh->used_shaders[shader_index]
+			                         : scene->default_surface;
+			float area = triangle_area(p1, p2, p3);
+
+			emitter.bbox.grow(p1);
+			emitter.bbox.grow(p2);
+			emitter.bbox.grow(p3);
+			/* Triangles emit from both sides. */
+			emitter.cone = LightTreeCone(safe_normalize(cross(p2 - p1, p3 - p1)), M_PI_F);
+			emitter.energy = area*light_tree_shader_energy(shader);
+			emitter.inv_area = (area > 0.0f) ? 1.0f/area : 0.0f;
+			emitter.object = object_id;
+			emitter.shader_flag = __float_as_int(distribution[i].z);
+		}
+		else {
+			int light_index = -prim-1;
+			Light *light = lights[light_index];
+
+			if(light->type == LIGHT_DISTANT || light->type == LIGHT_BACKGROUND) {
+				infinite_lights.push_back(light_index);
+				continue;
+			}
+
+			Shader *shader = (light->shader) ? light->shader : scene->default_light;
+			float3 dir = safe_normalize(light->dir);
+
+			if(light->type == LIGHT_AREA) {
+				float3 axisu = light->axisu*(light->sizeu*light->size);
+				float3 axisv = light->axisv*(light->sizev*light->size);
+
+				emitter.bbox.grow(light->co - 0.5f*axisu - 0.5f*axisv);
+				emitter.bbox.grow(light->co - 0.5f*axisu + 0.5f*axisv);
+				emitter.bbox.grow(light->co + 0.5f*axisu - 0.5f*axisv);
+				emitter.bbox.grow(light->co + 0.5f*axisu + 0.5f*axisv);
+				emitter.cone = LightTreeCone(dir, 0.0f);
+			}
+			else {
+				emitter.bbox.grow(light->co, light->size);
+
+				if(light->type == LIGHT_SPOT) {
+					emitter.cone = LightTreeCone(dir, 0.5f*light->spot_angle);
+				}
+			}
+
+			emitter.energy = light_tree_shader_energy(shader);
+		}
+
+		emitters.push_back(emitter);
+	}
+
+	if(progress.get_cancel()) return;
+
+	LightTree tree(emitters);
+
+	int num_emitters = emitters.size();
+	int num_infinite = infinite_lights.size();
+
+	/* Nodes */
+	if(tree.nodes.size()) {
+		float4 *nodes = dscene->light_tree_nodes.resize(tree.nodes.size()*LIGHT_TREE_NODE_SIZE);
+
+		for(size_t i = 0; i < tree.nodes.size(); i++) {
+			const LightTreeNode& node = tree.nodes[i];
+			int child_or_emitter = (node.is_leaf()) ? node.first_emitter : node.right_child;
+
+			nodes[i*LIGHT_TREE_NODE_SIZE + 0] = make_float4(node.bbox.min.x, node.bbox.min.y, node.bbox.min.z, node.energy);
+			nodes[i*LIGHT_TREE_NODE_SIZE + 1] = make_float4(node.bbox.max.x, node.bbox.max.y, node.bbox.max.z, node.cone.theta_o);
+			nodes[i*LIGHT_TREE_NODE_SIZE + 2] = make_float4(node.cone.axis.x, node.cone.axis.y, node.cone.axis.z, 0.0f);
+			nodes[i*LIGHT_TREE_NODE_SIZE + 3] = make_float4(__int_as_float(node.num_emitters), __int_as_float(child_or_emitter), 0.0f, 0.0f);
+		}
+
+		device->tex_alloc("__light_tree_nodes", dscene->light_tree_nodes);
+	}
+
+	/* Emitters, followed by the infinite lights. */
+	float4 *emitter_data = dscene->light_tree_emitters.resize((num_emitters + num_infinite)*LIGHT_TREE_EMITTER_SIZE);
+
+	for(int i = 0; i < num_emitters; i++) {
+		const LightTreeEmitter& emitter = emitters[i];
+
+		emitter_data[i*LIGHT_TREE_EMITTER_SIZE + 0] = make_float4(emitter.bbox.min.x, emitter.bbox.min.y, emitter.bbox.min.z, emitter.energy);
+		emitter_data[i*LIGHT_TREE_EMITTER_SIZE + 1] = make_float4(emitter.bbox.max.x, emitter.bbox.max.y, emitter.bbox.max.z, emitter.cone.theta_o);
+		emitter_data[i*LIGHT_TREE_EMITTER_SIZE + 2] = make_float4(emitter.cone.axis.x, emitter.cone.axis.y, emitter.cone.axis.z, __uint_as_float(emitter.bit_trail));
+		emitter_data[i*LIGHT_TREE_EMITTER_SIZE + 3] = make_float4(emitter.inv_area,
+		                                                          __int_as_float(emitter.prim),
+		                                                          __int_as_float(emitter.shader_flag),
+		                                                          __int_as_float(emitter.object));
+	}
+
+	for(int i = 0; i < num_infinite; i++) {
+		int offset = (num_emitters + i)*LIGHT_TREE_EMITTER_SIZE;
+
+		emitter_data[offset + 0] = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+		emitter_data[offset + 1] = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+		emitter_data[offset + 2] = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+		emitter_data[offset + 3] = make_float4(0.0f, __int_as_float(~infinite_lights[i]), 0.0f, __int_as_float(-1));
+	}
+
+	device->tex_alloc("__light_tree_emitters", dscene->light_tree_emitters);
+
+	/* Triangle to emitter map, for evaluating the pdf when a ray hits an
+	 * emissive triangle. */
+	size_t num_objects = scene->objects.size();
+	size_t map_size = 2*num_objects;
+
+	foreach(Object *object, scene->objects) {
+		if(object_usable_as_light(object)) {
+			map_size += object->mesh->num_triangles();
+		}
+	}
+
+	uint *emitter_map = dscene->light_tree_emitter_map.resize(map_size);
+	size_t table_offset = 2*num_objects;
+
+	for(size_t j = 0; j < num_objects; j++) {
+		Object *object = scene->objects[j];
+
+		if(!object_usable_as_light(object)) {
+			emitter_map[j*2 + 0] = 0;
+			emitter_map[j*2 + 1] = 0;
+			continue;
+		}
+
+		size_t mesh_num_triangles = object->mesh->num_triangles();
+
+		emitter_map[j*2 + 0] = table_offset;
+		emitter_map[j*2 + 1] = object->mesh->tri_offset;
+
+		for(size_t i = 0; i < mesh_num_triangles; i++) {
+			emitter_map[table_offset + i] = ~0;
+		}
+
+		table_offset += mesh_num_triangles;
+	}
+
+	for(int i = 0; i < num_emitters; i++) {
+		const LightTreeEmitter& emitter = emitters[i];
+
+		if(emitter.prim >= 0) {
+			Mesh *mesh = scene->objects[emitter.object]->mesh;
+			emitter_map[emitter_map[emitter.object*2] + emitter.prim - mesh->tri_offset] = i;
+		}
+	}
+
+	device->tex_alloc("__light_tree_emitter_map", dscene->light_tree_emitter_map);
+
+	/* Infinite lights are picked with a fixed probability, they use
+	 * pdf_lights for their selection probability like without the tree. */
+	float infinite_pdf = 0.0f;
+
+	if(num_infinite) {
+		infinite_pdf = (num_emitters) ? 0.5f : 1.0f;
+		kintegrator->pdf_lights = infinite_pdf/num_infinite;
+	}
+	else {
+		kintegrator->pdf_lights = 1.0f;
+	}
+	kintegrator->inv_pdf_lights = 1.0f/kintegrator->pdf_lights;
+
+	kintegrator->use_light_tree = true;
+	kintegrator->light_tree_num_emitters = num_emitters;
+	kintegrator->light_tree_num_infinite = num_infinite;
+	kintegrator->light_tree_infinite_pdf = infinite_pdf;
+
+	VLOG(1) << "Light tree built in " << time_dt() - time_start << " seconds: "
+	        << num_emitters << " emitters, "
+	        << tree.nodes.size() << " nodes, depth " << tree.depth() << ", "
+	        << num_infinite << " infinite lights.";
+}
+
 void LightManager::device_update_points(Device *device,
                                         DeviceScene *dscene,
                                         Scene *scene)
@@ -834,6 +1084,9 @@ void LightManager::device_update(Device *device, DeviceScene *dscene, Scene *sce
 	device_update_background(device, dscene, scene, progress);
 	if(progress.get_cancel()) return;
 
+	device_update_light_tree(device, dscene, scene, progress);
+	if(progress.get_cancel()) return;
+
 	if(use_light_visibility != scene->film->use_light_visibility) {
 		scene->film->use_light_visibility = use_light_visibility;
 		scene->film->tag_update(scene);
@@ -848,11 +1101,17 @@ void LightManager::device_free(Device *device, DeviceScene *dscene)
 	device->tex_free(dscene->light_data);
 	device->tex_free(dscene->light_background_marginal_cdf);
 	device->tex_free(dscene->light_background_conditional_cdf);
+	device->tex_free(dscene->light_tree_nodes);
+	device->tex_free(dscene->light_tree_emitters);
+	device->tex_free(dscene->light_tree_emitter_map);
 
 	dscene->light_distribution.clear();
 	dscene->light_data.clear();
 	dscene->light_background_marginal_cdf.clear();
 	dscene->light_background_conditional_cdf.clear();
+	dscene->light_tree_nodes.clear();
+	dscene->light_tree_emitters.clear();
+	dscene->light_tree_emitter_map.clear();
 }
 
 void LightManager::tag_update(Scene * /*scene*/)
@@ -114,6 +114,12 @@ protected:
 	                              DeviceScene *dscene,
 	                              Scene *scene,
 	                              Progress& progress);
+	/* Builds the light tree from the light distribution, so must run after
+	 * device_update_distribution(). */
+	void device_update_light_tree(Device *device,
+	                              DeviceScene *dscene,
+	                              Scene *scene,
+	                              Progress& progress);
 
 	/* Check whether light manager can use the object as a light-emissive. */
 	bool object_usable_as_light(Object *object);
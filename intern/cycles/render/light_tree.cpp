@@ -0,0 +1,244 @@
+/*
+ * Copyright 2011-2016 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "light_tree.h"
+
+#include "util_algorithm.h"
+#include "util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Cone */
+
+LightTreeCone LightTreeCone::merge(const LightTreeCone& a, const LightTreeCone& b)
+{
+	if(b.theta_o > a.theta_o) {
+		return merge(b, a);
+	}
+
+	float cos_theta_d = clamp(dot(a.axis, b.axis), -1.0f, 1.0f);
+	float theta_d = safe_acosf(cos_theta_d);
+
+	/* b is fully contained in a. */
+	if(min(theta_d + b.theta_o, M_PI_F) <= a.theta_o) {
+		return a;
+	}
+
+	float theta_o = 0.5f*(a.theta_o + theta_d + b.theta_o);
+	if(theta_o >= M_PI_F) {
+		return LightTreeCone(a.axis, M_PI_F);
+	}
+
+	/* Rotate the axis of a towards b, so the new cone just encloses both. */
+	float3 ortho = b.axis - a.axis*cos_theta_d;
+	float ortho_len = len(ortho);
+	if(ortho_len < 1e-6f) {
+		/* Opposite axes, any rotation works, be conservative. */
+		return LightTreeCone(a.axis, M_PI_F);
+	}
+
+	float theta_r = theta_o - a.theta_o;
+	float3 axis = a.axis*cosf(theta_r) + ortho*(sinf(theta_r)/ortho_len);
+
+	return LightTreeCone(normalize(axis), theta_o);
+}
+
+/* Tree */
+
+namespace {
+
+struct LightTreeBucketPredicate {
+	int axis;
+	int bucket;
+	float min;
+	float inv_extent;
+
+	bool operator()(const LightTreeEmitter& emitter) const
+	{
+		return light_tree_bucket(emitter.centroid()[axis], min, inv_extent) <= bucket;
+	}
+
+	static int light_tree_bucket(float value, float min, float inv_extent)
+	{
+		int b = (int)((value - min) * inv_extent * LightTree::num_buckets);
+		return clamp(b, 0, LightTree::num_buckets - 1);
+	}
+};
+
+}  /* namespace */
+
+LightTree::LightTree(vector<LightTreeEmitter>& emitters_)
+: emitters(emitters_), max_tree_depth(0)
+{
+	if(emitters.empty()) {
+		return;
+	}
+
+	nodes.reserve(2*emitters.size());
+	recursive_build(0, emitters.size(), 0, 0);
+}
+
+int LightTree::recursive_build(int start, int end, uint bit_trail, int depth)
+{
+	int node_index = nodes.size();
+	nodes.push_back(LightTreeNode());
+
+	BoundBox bbox = BoundBox::empty;
+	BoundBox centroid_bounds = BoundBox::empty;
+	LightTreeCone cone = emitters[start].cone;
+	float energy = 0.0f;
+
+	for(int i = start; i < end; i++) {
+		const LightTreeEmitter& emitter = emitters[i];
+
+		bbox.grow(emitter.bbox);
+		centroid_bounds.grow(emitter.centroid());
+		if(i != start) {
+			cone = LightTreeCone::merge(cone, emitter.cone);
+		}
+		energy += emitter.energy;
+	}
+
+	max_tree_depth = max(max_tree_depth, depth);
+
+	/* Every inner node consumes one bit of the trail. */
+	int split;
+	bool is_leaf = (end - start == 1) ||
+	               (depth >= max_depth) ||
+	               !find_split(start, end, centroid_bounds, &split);
+
+	int right_child = -1;
+
+	if(is_leaf) {
+		for(int i = start; i < end; i++) {
+			emitters[i].bit_trail = bit_trail;
+		}
+	}
+	else {
+		recursive_build(start, split, bit_trail, depth + 1);
+		right_child = recursive_build(split, end, bit_trail | (1u << depth), depth + 1);
+	}
+
+	/* Don't keep a reference across recursion, nodes might be reallocated. */
+	LightTreeNode& node = nodes[node_index];
+	node.bbox = bbox;
+	node.cone = cone;
+	node.energy = energy;
+	node.right_child = right_child;
+	node.first_emitter = (is_leaf) ? start : -1;
+	node.num_emitters = (is_leaf) ? end - start : 0;
+
+	return node_index;
+}
+
+/* Binned split minimizing the energy weighted surface area of the children. */
+bool LightTree::find_split(int start, int end, const BoundBox& centroid_bounds, int *r_split)
+{
+	float best_cost = FLT_MAX;
+	int best_axis = -1, best_bucket = -1;
+
+	for(int axis = 0; axis < 3; axis++) {
+		float min = centroid_bounds.min[axis];
+		float extent = centroid_bounds.max[axis] - min;
+
+		if(extent <= 0.0f) {
+			continue;
+		}
+
+		float inv_extent = 1.0f/extent;
+
+		BoundBox bucket_bbox[num_buckets];
+		float bucket_energy[num_buckets];
+		int bucket_count[num_buckets];
+
+		for(int b = 0; b < num_buckets; b++) {
+			bucket_bbox[b] = BoundBox::empty;
+			bucket_energy[b] = 0.0f;
+			bucket_count[b] = 0;
+		}
+
+		for(int i = start; i < end; i++) {
+			const LightTreeEmitter& emitter = emitters[i];
+			int b = LightTreeBucketPredicate::light_tree_bucket(emitter.centroid()[axis], min, inv_extent);
+
+			bucket_bbox[b].grow(emitter.bbox);
+			bucket_energy[b] += emitter.energy;
+			bucket_count[b]++;
+		}
+
+		/* Sweep from the right to get the cost of everything after a split. */
+		float right_cost[num_buckets];
+		int right_count[num_buckets];
+		BoundBox right_bbox = BoundBox::empty;
+		float right_energy = 0.0f;
+		int count = 0;
+
+		for(int b = num_buckets - 1; b > 0; b--) {
+			/* Growing by an empty box would make the bounds infinite. */
+			if(bucket_count[b]) {
+				right_bbox.grow(bucket_bbox[b]);
+				right_energy += bucket_energy[b];
+				count += bucket_count[b];
+			}
+
+			right_cost[b] = right_energy*right_bbox.safe_area();
+			right_count[b] = count;
+		}
+
+		BoundBox left_bbox = BoundBox::empty;
+		float left_energy = 0.0f;
+		count = 0;
+
+		for(int b = 0; b < num_buckets - 1; b++) {
+			if(bucket_count[b]) {
+				left_bbox.grow(bucket_bbox[b]);
+				left_energy += bucket_energy[b];
+				count += bucket_count[b];
+			}
+
+			if(count == 0 || right_count[b + 1] == 0) {
+				continue;
+			}
+
+			float cost = left_energy*left_bbox.safe_area() + right_cost[b + 1];
+
+			if(cost < best_cost) {
+				best_cost = cost;
+				best_axis = axis;
+				best_bucket = b;
+			}
+		}
+	}
+
+	if(best_axis == -1) {
+		return false;
+	}
+
+	LightTreeBucketPredicate predicate;
+	predicate.axis = best_axis;
+	predicate.bucket = best_bucket;
+	predicate.min = centroid_bounds.min[best_axis];
+	predicate.inv_extent = 1.0f/(centroid_bounds.max[best_axis] - predicate.min);
+
+	vector<LightTreeEmitter>::iterator middle =
+	        std::partition(emitters.begin() + start, emitters.begin() + end, predicate);
+
+	*r_split = middle - emitters.begin();
+
+	return (*r_split != start && *r_split != end);
+}
+
+CCL_NAMESPACE_END
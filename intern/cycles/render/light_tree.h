@@ -0,0 +1,106 @@
+/*
+ * Copyright 2011-2016 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "util_boundbox.h"
+#include "util_types.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Orientation bounds of a set of emitters: the normals of all emitters lie
+ * within theta_o of the axis. Emission itself is assumed to fall off to zero
+ * at pi/2 from the normal. */
+
+struct LightTreeCone {
+	float3 axis;
+	float theta_o;
+
+	LightTreeCone()
+	: axis(make_float3(0.0f, 0.0f, 1.0f)), theta_o(M_PI_F)
+	{
+	}
+
+	LightTreeCone(const float3& axis_, float theta_o_)
+	: axis(axis_), theta_o(theta_o_)
+	{
+	}
+
+	static LightTreeCone merge(const LightTreeCone& a, const LightTreeCone& b);
+};
+
+/* Single triangle or lamp as seen by the light tree. */
+
+struct LightTreeEmitter {
+	BoundBox bbox;
+	LightTreeCone cone;
+	float energy;
+	/* Inverse area, only used by triangles. */
+	float inv_area;
+	/* Same encoding as the light distribution: triangle index, or the
+	 * bitwise negated light index for lamps. */
+	int prim;
+	int object;
+	int shader_flag;
+	/* Path from the root to the leaf containing this emitter, one bit per
+	 * level, least significant bit first. Zero means left child. */
+	uint bit_trail;
+
+	float3 centroid() const { return bbox.center(); }
+};
+
+struct LightTreeNode {
+	BoundBox bbox;
+	LightTreeCone cone;
+	float energy;
+	/* Inner nodes store their left child directly after themselves. */
+	int right_child;
+	int first_emitter;
+	/* Zero for inner nodes. */
+	int num_emitters;
+
+	bool is_leaf() const { return num_emitters != 0; }
+};
+
+/* Bounding volume hierarchy over emitters, used for importance sampling
+ * lights depending on the shading point. Building reorders the emitters
+ * so that each leaf references a contiguous range. */
+
+class LightTree {
+public:
+	/* Bit trails are stored in 32 bits. */
+	static const int max_depth = 32;
+	static const int num_buckets = 12;
+
+	vector<LightTreeNode> nodes;
+
+	LightTree(vector<LightTreeEmitter>& emitters);
+
+	int depth() const { return max_tree_depth; }
+
+protected:
+	vector<LightTreeEmitter>& emitters;
+	int max_tree_depth;
+
+	int recursive_build(int start, int end, uint bit_trail, int depth);
+	bool find_split(int start, int end, const BoundBox& centroid_bounds, int *r_split);
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __LIGHT_TREE_H__ */
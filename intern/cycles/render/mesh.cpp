@@ -1124,6 +1124,8 @@ MeshManager::MeshManager()
 	bvh = NULL;
 	need_update = true;
 	need_flags_update = true;
+	peak_subd_triangles = 0;
+	device_state.valid = false;
 }
 
 MeshManager::~MeshManager()
@@ -1977,42 +1979,38 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 		}
 	}
 
-	/* Tessellate meshes that are using subdivision */
-	size_t total_tess_needed = 0;
-	foreach(Mesh *mesh, scene->meshes) {
-		if(mesh->need_update &&
-		   mesh->subdivision_type != Mesh::SUBDIVISION_NONE &&
-		   mesh->num_subd_verts == 0 &&
-		   mesh->subd_params)
-		{
-			total_tess_needed++;
-		}
-	}
-
-	size_t i = 0;
-	foreach(Mesh *mesh, scene->meshes) {
-		if(mesh->need_update &&
-		   mesh->subdivision_type != Mesh::SUBDIVISION_NONE &&
-		   mesh->num_subd_verts == 0 &&
-		   mesh->subd_params)
-		{
-			string msg = "Tessellating ";
-			if(mesh->name == "")
-				msg += string_printf("%u/%u", (uint)(i+1), (uint)total_tess_needed);
-			else
-				msg += string_printf("%s %u/%u", mesh->name.c_str(), (uint)(i+1), (uint)total_tess_needed);
+#ifdef __OBJECT_MOTION__
+	Scene::MotionType need_motion = scene->need_motion(device->info.advanced_shading);
+	bool motion_blur = need_motion == Scene::MOTION_BLUR;
+#else
+	bool motion_blur = false;
+#endif
 
-			progress.set_status("Updating Mesh", msg);
+	/* Only objects changed, mesh arrays on the device are still valid. */
+	if(device_state_matches(scene)) {
+		VLOG(1) << "Mesh data unchanged, only updating BVH.";
 
-			DiagSplit dsplit(*mesh->subd_params);
-			mesh->tessellate(&dsplit);
+		scoped_timer bvh_timer;
 
-			i++;
+		device_free_bvh(device, dscene);
+		scene->object_manager->device_update_patch_map_offsets(device, dscene, scene);
 
-			if(progress.get_cancel()) return;
+		foreach(Object *object, scene->objects) {
+			object->compute_bounds(motion_blur);
 		}
+
+		device_update_bvh(device, dscene, scene, progress);
+		progress.add_phase_time("bvh_build", bvh_timer);
+		if(progress.get_cancel()) return;
+
+		need_update = false;
+		return;
 	}
 
+	/* Tessellate meshes that are using subdivision */
+	tessellate(scene, progress);
+	if(progress.get_cancel()) return;
+
 	/* Update images needed for true displacement. */
 	bool true_displacement_used = false;
 	bool old_need_object_flags_update = false;
@@ -2073,6 +2071,8 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	}
 
 	/* Update bvh. */
+	scoped_timer bvh_timer;
+
 	size_t num_bvh = 0;
 	foreach(Mesh *mesh, scene->meshes) {
 		if(mesh->need_update && mesh->need_build_bvh()) {
@@ -2082,7 +2082,7 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 
 	TaskPool pool;
 
-	i = 0;
+	size_t i = 0;
 	foreach(Mesh *mesh, scene->meshes) {
 		if(mesh->need_update) {
 			pool.push(function_bind(&Mesh::compute_bvh,
@@ -2107,13 +2107,6 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 		shader->need_update_attributes = false;
 	}
 
-#ifdef __OBJECT_MOTION__
-	Scene::MotionType need_motion = scene->need_motion(device->info.advanced_shading);
-	bool motion_blur = need_motion == Scene::MOTION_BLUR;
-#else
-	bool motion_blur = false;
-#endif
-
 	/* Update objects. */
 	vector<Object *> volume_objects;
 	foreach(Object *object, scene->objects) {
@@ -2123,11 +2116,14 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	if(progress.get_cancel()) return;
 
 	device_update_bvh(device, dscene, scene, progress);
+	progress.add_phase_time("bvh_build", bvh_timer);
 	if(progress.get_cancel()) return;
 
 	device_update_mesh(device, dscene, scene, false, progress);
 	if(progress.get_cancel()) return;
 
+	device_state_store(scene);
+
 	need_update = false;
 
 	if(true_displacement_used) {
@@ -2141,7 +2137,189 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	}
 }
 
-void MeshManager::device_free(Device *device, DeviceScene *dscene)
+void MeshManager::tessellate(Scene *scene, Progress& progress)
+{
+	vector<Mesh*> tess_meshes;
+	size_t num_subd_triangles = 0;
+
+	foreach(Mesh *mesh, scene->meshes) {
+		if(mesh->subdivision_type == Mesh::SUBDIVISION_NONE || !mesh->subd_params)
+			continue;
+
+		if(mesh->need_update && mesh->num_subd_verts == 0)
+			tess_meshes.push_back(mesh);
+		else
+			num_subd_triangles += mesh->num_triangles();
+	}
+
+	if(tess_meshes.empty())
+		return;
+
+	subd_instance_transforms(scene, tess_meshes);
+
+	float dicing_scale = subd_budget_scale(scene, tess_meshes, num_subd_triangles, progress);
+	if(progress.get_cancel()) return;
+
+	for(size_t i = 0; i < tess_meshes.size(); i++) {
+		Mesh *mesh = tess_meshes[i];
+
+		string msg = "Tessellating ";
+		if(mesh->name == "")
+			msg += string_printf("%u/%u", (uint)(i+1), (uint)tess_meshes.size());
+		else
+			msg += string_printf("%s %u/%u", mesh->name.c_str(), (uint)(i+1), (uint)tess_meshes.size());
+
+		progress.set_status("Updating Mesh", msg);
+
+		SubdParams params = *mesh->subd_params;
+		params.dicing_rate *= dicing_scale;
+
+		DiagSplit dsplit(params);
+		mesh->tessellate(&dsplit);
+
+		num_subd_triangles += dsplit.num_triangles;
+
+		if(progress.get_cancel()) return;
+	}
+
+	peak_subd_triangles = max(peak_subd_triangles, num_subd_triangles);
+
+	VLOG(1) << "Tessellated " << tess_meshes.size() << " meshes, "
+	        << num_subd_triangles << " subdivision triangles in scene, peak "
+	        << peak_subd_triangles << ".";
+}
+
+/* Meshes shared by multiple objects are tessellated once, dice them for the
+ * instance closest to the camera so none of them ends up too coarse. */
+void MeshManager::subd_instance_transforms(Scene *scene, const vector<Mesh*>& meshes)
+{
+	set<Mesh*> tess_meshes(meshes.begin(), meshes.end());
+	map<Mesh*, float> closest_dist;
+
+	float3 camera_P = transform_get_column(&scene->camera->matrix, 3);
+
+	foreach(Object *object, scene->objects) {
+		Mesh *mesh = object->mesh;
+
+		if(tess_meshes.find(mesh) == tess_meshes.end() || !mesh->subd_params->camera)
+			continue;
+
+		float dist = len(transform_get_column(&object->tfm, 3) - camera_P);
+
+		if(closest_dist.find(mesh) == closest_dist.end() || dist < closest_dist[mesh]) {
+			closest_dist[mesh] = dist;
+			mesh->subd_params->objecttoworld = object->tfm;
+		}
+	}
+}
+
+/* Increase the dicing rate of all meshes to be tessellated until the estimated
+ * number of triangles fits in the scene budget. */
+float MeshManager::subd_budget_scale(Scene *scene,
+                                     const vector<Mesh*>& meshes,
+                                     size_t num_fixed_triangles,
+                                     Progress& progress)
+{
+	size_t budget = scene->params.max_micropolygons;
+
+	if(budget == 0)
+		return 1.0f;
+
+	/* already tessellated meshes count towards the budget */
+	budget = (num_fixed_triangles < budget)? budget - num_fixed_triangles: 1;
+
+	progress.set_status("Updating Mesh", "Estimating tessellation");
+
+	float scale = 1.0f;
+
+	/* patches are built once, only the dicing changes between passes */
+	vector<SubdPatchData*> patch_data(meshes.size(), NULL);
+
+	for(int iteration = 0; iteration < 4; iteration++) {
+		size_t num_triangles = 0;
+
+		for(size_t i = 0; i < meshes.size(); i++) {
+			Mesh *mesh = meshes[i];
+
+			if(!patch_data[i])
+				patch_data[i] = mesh->subd_patch_data_create();
+
+			SubdParams params = *mesh->subd_params;
+			params.dicing_rate *= scale;
+
+			DiagSplit dsplit(params);
+			dsplit.estimate_only = true;
+			mesh->tessellate(&dsplit, patch_data[i]);
+
+			num_triangles += dsplit.num_triangles;
+
+			if(progress.get_cancel()) break;
+		}
+
+		if(progress.get_cancel() || num_triangles <= budget)
+			break;
+
+		VLOG(1) << "Estimated " << num_triangles << " subdivision triangles exceed budget of "
+		        << budget << ", increasing dicing rate.";
+
+		/* number of triangles falls off roughly with the square of the
+		 * dicing rate, overshoot a bit since patches can't get coarser
+		 * than their minimum tessellation */
+		scale *= sqrtf((float)num_triangles / (float)budget) * 1.05f;
+	}
+
+	for(size_t i = 0; i < meshes.size(); i++)
+		meshes[i]->subd_patch_data_free(patch_data[i]);
+
+	return scale;
+}
+
+void MeshManager::device_state_store(Scene *scene)
+{
+	device_state.meshes = scene->meshes;
+	device_state.shaders = scene->shaders;
+
+	device_state.object_meshes.clear();
+	foreach(Object *object, scene->objects) {
+		device_state.object_meshes.push_back(object->mesh);
+	}
+
+	device_state.global_attributes = AttributeRequestSet();
+	scene->need_global_attributes(device_state.global_attributes);
+
+	device_state.valid = true;
+}
+
+bool MeshManager::device_state_matches(Scene *scene)
+{
+	/* OSL attribute maps also store object names, always rebuild. */
+	if(!device_state.valid || scene->shader_manager->use_osl())
+		return false;
+
+	foreach(Mesh *mesh, scene->meshes) {
+		if(mesh->need_update)
+			return false;
+	}
+
+	if(scene->meshes != device_state.meshes ||
+	   scene->shaders != device_state.shaders ||
+	   scene->objects.size() != device_state.object_meshes.size())
+	{
+		return false;
+	}
+
+	for(size_t i = 0; i < scene->objects.size(); i++) {
+		if(scene->objects[i]->mesh != device_state.object_meshes[i])
+			return false;
+	}
+
+	AttributeRequestSet global_attributes;
+	scene->need_global_attributes(global_attributes);
+
+	return !global_attributes.modified(device_state.global_attributes);
+}
+
+void MeshManager::device_free_bvh(Device *device, DeviceScene *dscene)
 {
 	device->tex_free(dscene->bvh_nodes);
 	device->tex_free(dscene->bvh_leaf_nodes);
@@ -2152,6 +2330,24 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 	device->tex_free(dscene->prim_visibility);
 	device->tex_free(dscene->prim_index);
 	device->tex_free(dscene->prim_object);
+
+	dscene->bvh_nodes.clear();
+	dscene->bvh_leaf_nodes.clear();
+	dscene->object_node.clear();
+	dscene->prim_tri_verts.clear();
+	dscene->prim_tri_index.clear();
+	dscene->prim_type.clear();
+	dscene->prim_visibility.clear();
+	dscene->prim_index.clear();
+	dscene->prim_object.clear();
+}
+
+void MeshManager::device_free(Device *device, DeviceScene *dscene)
+{
+	device_state.valid = false;
+
+	device_free_bvh(device, dscene);
+
 	device->tex_free(dscene->tri_shader);
 	device->tex_free(dscene->tri_vnormal);
 	device->tex_free(dscene->tri_vindex);
@@ -2165,14 +2361,6 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 	device->tex_free(dscene->attributes_float3);
 	device->tex_free(dscene->attributes_uchar4);
 
-	dscene->bvh_nodes.clear();
-	dscene->object_node.clear();
-	dscene->prim_tri_verts.clear();
-	dscene->prim_tri_index.clear();
-	dscene->prim_type.clear();
-	dscene->prim_visibility.clear();
-	dscene->prim_index.clear();
-	dscene->prim_object.clear();
 	dscene->tri_shader.clear();
 	dscene->tri_vnormal.clear();
 	dscene->tri_vindex.clear();
@@ -42,6 +42,7 @@ class SceneParams;
 class AttributeRequest;
 struct SubdParams;
 class DiagSplit;
+class SubdPatchData;
 struct PackedPatchTable;
 
 /* Mesh */
@@ -308,7 +309,12 @@ public:
 	/* Check if the mesh should be treated as instanced. */
 	bool is_instanced() const;
 
-	void tessellate(DiagSplit *split);
+	/* Patch data is built for each tessellation, unless it's created once
+	 * and passed in to tessellate multiple times with different splits. */
+	SubdPatchData *subd_patch_data_create();
+	void subd_patch_data_free(SubdPatchData *patch_data);
+
+	void tessellate(DiagSplit *split, SubdPatchData *patch_data = NULL);
 };
 
 /* Mesh Manager */
@@ -320,6 +326,9 @@ public:
 	bool need_update;
 	bool need_flags_update;
 
+	/* highest number of triangles created by adaptive subdivision */
+	size_t peak_subd_triangles;
+
 	MeshManager();
 	~MeshManager();
 
@@ -337,6 +346,30 @@ public:
 	void tag_update(Scene *scene);
 
 protected:
+	/* Scene state the packed mesh arrays on the device were created from.
+	 * When it still matches and no mesh changed, only the BVH needs to be
+	 * rebuilt, as is the case when only object transforms are animated. */
+	struct DeviceState {
+		vector<Mesh*> meshes;
+		vector<Mesh*> object_meshes;
+		vector<Shader*> shaders;
+		AttributeRequestSet global_attributes;
+		bool valid;
+	} device_state;
+
+	void device_state_store(Scene *scene);
+	bool device_state_matches(Scene *scene);
+
+	void device_free_bvh(Device *device, DeviceScene *dscene);
+
+	/* Adaptive subdivision. */
+	void tessellate(Scene *scene, Progress& progress);
+	void subd_instance_transforms(Scene *scene, const vector<Mesh*>& meshes);
+	float subd_budget_scale(Scene *scene,
+	                        const vector<Mesh*>& meshes,
+	                        size_t num_fixed_triangles,
+	                        Progress& progress);
+
 	/* Calculate verts/triangles/curves offsets in global arrays. */
 	void mesh_calc_offset(Scene *scene);
 
@@ -335,15 +335,23 @@ struct OsdPatch : Patch {
 
 #endif
 
-void Mesh::tessellate(DiagSplit *split)
-{
+/* data to evaluate the patches of a mesh, independent of the dicing */
+
+class SubdPatchData {
+public:
 #ifdef WITH_OPENSUBDIV
 	OsdData osd_data;
-	bool need_packed_patch_table = false;
+#endif
+};
 
+SubdPatchData *Mesh::subd_patch_data_create()
+{
+	SubdPatchData *patch_data = new SubdPatchData();
+
+#ifdef WITH_OPENSUBDIV
 	if(subdivision_type == SUBDIVISION_CATMULL_CLARK) {
 		if(subd_faces.size()) {
-			osd_data.build_from_mesh(this);
+			patch_data->osd_data.build_from_mesh(this);
 		}
 	}
 	else
@@ -360,6 +368,28 @@ void Mesh::tessellate(DiagSplit *split)
 		}
 	}
 
+	return patch_data;
+}
+
+void Mesh::subd_patch_data_free(SubdPatchData *patch_data)
+{
+	delete patch_data;
+}
+
+void Mesh::tessellate(DiagSplit *split, SubdPatchData *patch_data)
+{
+	SubdPatchData *own_patch_data = NULL;
+
+	if(!patch_data) {
+		own_patch_data = subd_patch_data_create();
+		patch_data = own_patch_data;
+	}
+
+#ifdef WITH_OPENSUBDIV
+	OsdData& osd_data = patch_data->osd_data;
+	bool need_packed_patch_table = false;
+#endif
+
 	int num_faces = subd_faces.size();
 
 	Attribute *attr_vN = subd_attributes.find(ATTR_STD_VERTEX_NORMAL);
@@ -505,6 +535,12 @@ void Mesh::tessellate(DiagSplit *split)
 		}
 	}
 
+	/* only counted triangles, no geometry was added */
+	if(split->estimate_only) {
+		subd_patch_data_free(own_patch_data);
+		return;
+	}
+
 	/* interpolate center points for attributes */
 	foreach(Attribute& attr, subd_attributes.attributes) {
 #ifdef WITH_OPENSUBDIV
@@ -606,6 +642,8 @@ void Mesh::tessellate(DiagSplit *split)
 		patch_table->pack(osd_data.patch_table);
 	}
 #endif
+
+	subd_patch_data_free(own_patch_data);
 }
 
 CCL_NAMESPACE_END
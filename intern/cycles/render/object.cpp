@@ -62,6 +62,7 @@ Object::Object()
 	motion.mid = transform_empty();
 	motion.post = transform_empty();
 	use_motion = false;
+	transform_animated = false;
 }
 
 Object::~Object()
@@ -708,7 +709,7 @@ void ObjectManager::apply_static_transforms(DeviceScene *dscene, Scene *scene, u
 		if((mesh_users[object->mesh] == 1 && !object->mesh->has_surface_bssrdf) &&
 		   !object->mesh->has_true_displacement() && object->mesh->subdivision_type == Mesh::SUBDIVISION_NONE)
 		{
-			if(!(motion_blur && object->use_motion)) {
+			if(!(motion_blur && object->use_motion) && !object->transform_animated) {
 				if(!object->mesh->transform_applied) {
 					object->apply_transform(apply_to_motion);
 					object->mesh->transform_applied = true;
@@ -54,6 +54,11 @@ public:
 	bool hide_on_missing_motion;
 	bool use_holdout;
 
+	/* Transform changed between renders without the object being tagged,
+	 * it is then not applied to the mesh so only the transform needs to be
+	 * updated on following frames. */
+	bool transform_animated;
+
 	float3 dupli_generated;
 	float2 dupli_uv;
 
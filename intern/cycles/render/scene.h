@@ -97,6 +97,9 @@ public:
 	device_vector<float4> light_data;
 	device_vector<float2> light_background_marginal_cdf;
 	device_vector<float2> light_background_conditional_cdf;
+	device_vector<float4> light_tree_nodes;
+	device_vector<float4> light_tree_emitters;
+	device_vector<uint> light_tree_emitter_map;
 
 	/* particles */
 	device_vector<float4> particles;
@@ -147,6 +150,8 @@ public:
 	bool use_qbvh;
 	bool persistent_data;
 	int texture_limit;
+	/* budget on triangles created by adaptive subdivision, 0 for unlimited */
+	size_t max_micropolygons;
 
 	SceneParams()
 	{
@@ -158,6 +163,7 @@ public:
 		use_qbvh = false;
 		persistent_data = false;
 		texture_limit = 0;
+		max_micropolygons = 0;
 	}
 
 	bool modified(const SceneParams& params)
@@ -168,7 +174,8 @@ public:
 		&& num_bvh_time_steps == params.num_bvh_time_steps
 		&& use_qbvh == params.use_qbvh
 		&& persistent_data == params.persistent_data
-		&& texture_limit == params.texture_limit); }
+		&& texture_limit == params.texture_limit
+		&& max_micropolygons == params.max_micropolygons); }
 };
 
 /* Scene */
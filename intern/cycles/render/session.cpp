@@ -78,6 +78,7 @@ Session::Session(const SessionParams& params_)
 	gpu_need_tonemap = false;
 	pause = false;
 	kernels_loaded = false;
+	output_written = false;
 
 	/* TODO(sergey): Check if it's indeed optimal value for the split kernel. */
 	max_closure_global = 1;
@@ -101,16 +102,8 @@ Session::~Session()
 		wait();
 	}
 
-	if(!params.output_path.empty()) {
-		/* tonemap and write out image if requested */
-		delete display;
-
-		display = new DisplayBuffer(device, false);
-		display->reset(device, buffers->params);
-		tonemap(params.samples);
-
-		progress.set_status("Writing Image", params.output_path);
-		display->write(device, params.output_path);
+	if(!params.output_path.empty() && !output_written) {
+		write_output();
 	}
 
 	/* clean up */
@@ -125,6 +118,26 @@ Session::~Session()
 	TaskScheduler::exit();
 }
 
+void Session::write_output()
+{
+	/* tonemap and write out image */
+	delete display;
+
+	display = new DisplayBuffer(device, false);
+	display->reset(device, buffers->params);
+
+	scoped_timer film_timer;
+	tonemap(params.samples);
+	progress.add_phase_time("film_convert", film_timer);
+
+	scoped_timer write_timer;
+	progress.set_status("Writing Image", params.output_path);
+	display->write(device, params.output_path);
+	progress.add_phase_time("write_image", write_timer);
+
+	output_written = true;
+}
+
 void Session::start()
 {
 	session_thread = new thread(function_bind(&Session::run, this));
@@ -267,9 +280,11 @@ void Session::run_gpu()
 			update_status_time();
 
 			/* path trace */
+			scoped_timer path_trace_timer;
 			path_trace();
 
 			device->task_wait();
+			progress.add_phase_time("path_trace", path_trace_timer);
 
 			if(!device->error_message().empty())
 				progress.set_cancel(device->error_message());
@@ -492,6 +507,7 @@ void Session::run_cpu()
 		/* advance to next tile */
 		bool no_tiles = !tile_manager.next();
 		bool need_tonemap = false;
+		double path_trace_time = 0.0;
 
 		if(params.background) {
 			/* if no work left and in background mode, we can stop immediately */
@@ -555,6 +571,7 @@ void Session::run_cpu()
 			update_status_time();
 
 			/* path trace */
+			path_trace_time = time_dt();
 			path_trace();
 
 			/* update status and timing */
@@ -569,6 +586,9 @@ void Session::run_cpu()
 
 		device->task_wait();
 
+		if(!no_tiles)
+			progress.add_phase_time("path_trace", time_dt() - path_trace_time);
+
 		{
 			thread_scoped_lock reset_lock(delayed_reset.mutex);
 			thread_scoped_lock buffers_lock(buffers_mutex);
@@ -652,7 +672,12 @@ void Session::load_kernels()
 
 		DeviceRequestedFeatures requested_features = get_requested_device_features();
 		VLOG(2) << "Requested features:\n" << requested_features;
-		if(!device->load_kernels(requested_features)) {
+
+		scoped_timer kernel_timer;
+		bool kernels_ok = device->load_kernels(requested_features);
+		progress.add_phase_time("kernel_load", kernel_timer);
+
+		if(!kernels_ok) {
 			string message = device->error_message();
 			if(message.empty())
 				message = "Failed loading render kernel, see console for errors";
@@ -815,7 +840,14 @@ void Session::update_scene()
 	/* update scene */
 	if(scene->need_update()) {
 		progress.set_status("Updating Scene");
+
+		scoped_timer update_timer;
+		double bvh_time = progress.get_phase_time("bvh_build");
 		MEM_GUARDED_CALL(&progress, scene->device_update, device, progress);
+
+		/* BVH build is timed as its own phase inside the scene update */
+		bvh_time = progress.get_phase_time("bvh_build") - bvh_time;
+		progress.add_phase_time("scene_update", time_dt() - update_timer.get_start() - bvh_time);
 	}
 }
 
@@ -143,6 +143,10 @@ public:
 	void update_scene();
 	void load_kernels();
 
+	/* Tonemap and write the result to params.output_path. Done on destruction
+	 * if it wasn't done explicitly before. */
+	void write_output();
+
 	void device_free();
 
 	/* Returns the rendering progress or 0 if no progress can be determined
@@ -195,6 +199,7 @@ protected:
 	thread_mutex display_mutex;
 
 	bool kernels_loaded;
+	bool output_written;
 
 	double reset_time;
 
@@ -349,5 +349,18 @@ void QuadDice::dice(SubPatch& sub, EdgeFactors& ef)
 	assert(vert_offset == params.mesh->verts.size());
 }
 
+size_t QuadDice::num_triangles(const EdgeFactors& ef)
+{
+	int Mu = max(max(ef.tu0, ef.tu1), 2);
+	int Mv = max(max(ef.tv0, ef.tv1), 2);
+
+	/* inner grid, and the sides stitched to it */
+	size_t num = 2*(Mu - 2)*(Mv - 2);
+	num += ef.tu0 + ef.tu1 + 2*(Mu - 2);
+	num += ef.tv0 + ef.tv1 + 2*(Mv - 2);
+
+	return num;
+}
+
 CCL_NAMESPACE_END
 
@@ -130,6 +130,9 @@ public:
 	float scale_factor(SubPatch& sub, EdgeFactors& ef, int Mu, int Mv);
 
 	void dice(SubPatch& sub, EdgeFactors& ef);
+
+	/* number of triangles dice() creates for the given edge factors */
+	static size_t num_triangles(const EdgeFactors& ef);
 };
 
 CCL_NAMESPACE_END
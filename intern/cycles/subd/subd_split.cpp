@@ -32,6 +32,8 @@ CCL_NAMESPACE_BEGIN
 DiagSplit::DiagSplit(const SubdParams& params_)
 : params(params_)
 {
+	estimate_only = false;
+	num_triangles = 0;
 }
 
 void DiagSplit::dispatch(QuadDice::SubPatch& sub, QuadDice::EdgeFactors& ef)
@@ -240,10 +242,7 @@ void DiagSplit::split_quad(Patch *patch, QuadDice::SubPatch *subpatch)
 
 	split(sub_split, ef_split);
 
-	QuadDice dice(params);
-
-	for(size_t i = 0; i < subpatches_quad.size(); i++) {
-		QuadDice::SubPatch& sub = subpatches_quad[i];
+	for(size_t i = 0; i < edgefactors_quad.size(); i++) {
 		QuadDice::EdgeFactors& ef = edgefactors_quad[i];
 
 		ef.tu0 = max(ef.tu0, 1);
@@ -251,7 +250,15 @@ void DiagSplit::split_quad(Patch *patch, QuadDice::SubPatch *subpatch)
 		ef.tv0 = max(ef.tv0, 1);
 		ef.tv1 = max(ef.tv1, 1);
 
-		dice.dice(sub, ef);
+		num_triangles += QuadDice::num_triangles(ef);
+	}
+
+	if(!estimate_only) {
+		QuadDice dice(params);
+
+		for(size_t i = 0; i < subpatches_quad.size(); i++) {
+			dice.dice(subpatches_quad[i], edgefactors_quad[i]);
+		}
 	}
 
 	subpatches_quad.clear();
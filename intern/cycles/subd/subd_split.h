@@ -41,6 +41,10 @@ public:
 
 	SubdParams params;
 
+	/* only count triangles without dicing, to estimate tessellation size */
+	bool estimate_only;
+	size_t num_triangles;
+
 	explicit DiagSplit(const SubdParams& params);
 
 	float3 to_world(Patch *patch, float2 uv);
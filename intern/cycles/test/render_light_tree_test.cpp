@@ -0,0 +1,132 @@
+/*
+ * Copyright 2011-2016 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "render/light_tree.h"
+#include "util/util_math.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+LightTreeEmitter point_emitter(float3 co, float energy)
+{
+	LightTreeEmitter emitter;
+	emitter.bbox = BoundBox(co);
+	emitter.energy = energy;
+	emitter.inv_area = 0.0f;
+	emitter.prim = 0;
+	emitter.object = -1;
+	emitter.shader_flag = 0;
+	emitter.bit_trail = 0;
+	return emitter;
+}
+
+/* Follow the bit trail of every emitter and check it ends in the leaf that
+ * references it. */
+void check_bit_trails(const LightTree& tree, const vector<LightTreeEmitter>& emitters)
+{
+	for(size_t i = 0; i < emitters.size(); i++) {
+		uint bit_trail = emitters[i].bit_trail;
+		int node = 0;
+
+		while(!tree.nodes[node].is_leaf()) {
+			node = (bit_trail & 1) ? tree.nodes[node].right_child : node + 1;
+			bit_trail >>= 1;
+		}
+
+		const LightTreeNode& leaf = tree.nodes[node];
+		EXPECT_LE(leaf.first_emitter, (int)i);
+		EXPECT_GT(leaf.first_emitter + leaf.num_emitters, (int)i);
+	}
+}
+
+}  /* namespace */
+
+TEST(render_light_tree, cone_merge)
+{
+	LightTreeCone a(make_float3(0.0f, 0.0f, 1.0f), 0.0f);
+	LightTreeCone b(make_float3(1.0f, 0.0f, 0.0f), 0.0f);
+
+	LightTreeCone ab = LightTreeCone::merge(a, b);
+	EXPECT_NEAR(ab.theta_o, M_PI_4_F, 1e-5f);
+	EXPECT_NEAR(dot(ab.axis, a.axis), cosf(M_PI_4_F), 1e-5f);
+	EXPECT_NEAR(dot(ab.axis, b.axis), cosf(M_PI_4_F), 1e-5f);
+
+	/* Contained cone doesn't change the bounds. */
+	LightTreeCone wide(make_float3(0.0f, 0.0f, 1.0f), M_PI_2_F);
+	LightTreeCone merged = LightTreeCone::merge(wide, a);
+	EXPECT_EQ(merged.theta_o, wide.theta_o);
+
+	/* Opposite directions cover the whole sphere. */
+	LightTreeCone c(make_float3(0.0f, 0.0f, -1.0f), 0.0f);
+	EXPECT_EQ(LightTreeCone::merge(a, c).theta_o, M_PI_F);
+}
+
+TEST(render_light_tree, build)
+{
+	vector<LightTreeEmitter> emitters;
+
+	for(int z = 0; z < 8; z++) {
+		for(int y = 0; y < 8; y++) {
+			for(int x = 0; x < 8; x++) {
+				float3 co = make_float3((float)x, (float)y, (float)z);
+				emitters.push_back(point_emitter(co, 1.0f + x));
+			}
+		}
+	}
+
+	LightTree tree(emitters);
+
+	ASSERT_FALSE(tree.nodes.empty());
+	EXPECT_EQ(emitters.size(), 512);
+	EXPECT_FLOAT_EQ(tree.nodes[0].energy, 8*8*(1+2+3+4+5+6+7+8));
+	EXPECT_EQ(tree.nodes[0].bbox.min.x, 0.0f);
+	EXPECT_EQ(tree.nodes[0].bbox.max.z, 7.0f);
+
+	/* Distinct positions end up in a leaf each. */
+	int num_leafs = 0;
+	for(size_t i = 0; i < tree.nodes.size(); i++) {
+		if(tree.nodes[i].is_leaf()) {
+			EXPECT_EQ(tree.nodes[i].num_emitters, 1);
+			num_leafs++;
+		}
+	}
+	EXPECT_EQ(num_leafs, 512);
+
+	check_bit_trails(tree, emitters);
+}
+
+TEST(render_light_tree, coincident)
+{
+	/* Emitters which can't be split share a leaf. */
+	vector<LightTreeEmitter> emitters;
+
+	for(int i = 0; i < 5; i++) {
+		emitters.push_back(point_emitter(make_float3(1.0f, 2.0f, 3.0f), 1.0f));
+	}
+	emitters.push_back(point_emitter(make_float3(5.0f, 2.0f, 3.0f), 1.0f));
+
+	LightTree tree(emitters);
+
+	EXPECT_EQ(tree.nodes.size(), 3);
+	EXPECT_EQ(tree.depth(), 1);
+	check_bit_trails(tree, emitters);
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2011-2016 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "render/attribute.h"
+#include "render/camera.h"
+#include "render/mesh.h"
+#include "subd/subd_dice.h"
+#include "subd/subd_split.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Unit quad and a pentagon next to it, with linear subdivision. */
+void build_subd_mesh(Mesh *mesh)
+{
+	mesh->subdivision_type = Mesh::SUBDIVISION_LINEAR;
+
+	mesh->reserve_mesh(9, 0);
+	mesh->add_vertex(make_float3(0.0f, 0.0f, 0.0f));
+	mesh->add_vertex(make_float3(1.0f, 0.0f, 0.0f));
+	mesh->add_vertex(make_float3(1.0f, 1.0f, 0.0f));
+	mesh->add_vertex(make_float3(0.0f, 1.0f, 0.0f));
+	mesh->add_vertex(make_float3(2.0f, 0.0f, 0.0f));
+	mesh->add_vertex(make_float3(2.5f, 0.5f, 0.0f));
+	mesh->add_vertex(make_float3(2.0f, 1.0f, 0.0f));
+
+	mesh->reserve_subd_faces(2, 1, 9);
+
+	int quad[4] = {0, 1, 2, 3};
+	mesh->add_subd_face(quad, 4, 0, true);
+
+	int ngon[5] = {1, 4, 5, 6, 2};
+	mesh->add_subd_face(ngon, 5, 0, true);
+
+	Attribute *attr_vN = mesh->subd_attributes.add(ATTR_STD_VERTEX_NORMAL);
+	float3 *vN = attr_vN->data_float3();
+
+	for(size_t i = 0; i < mesh->verts.size(); i++) {
+		vN[i] = make_float3(0.0f, 0.0f, 1.0f);
+	}
+}
+
+}  /* namespace */
+
+TEST(subd_split, estimate)
+{
+	Mesh mesh;
+	build_subd_mesh(&mesh);
+
+	SubdParams params(&mesh);
+	params.dicing_rate = 0.1f;
+
+	DiagSplit estimate(params);
+	estimate.estimate_only = true;
+	mesh.tessellate(&estimate);
+
+	/* Estimating doesn't create any geometry. */
+	EXPECT_EQ(mesh.num_triangles(), 0);
+	EXPECT_EQ(mesh.num_subd_verts, 0);
+	EXPECT_GT(estimate.num_triangles, 0);
+
+	DiagSplit split(params);
+	mesh.tessellate(&split);
+
+	EXPECT_EQ(split.num_triangles, estimate.num_triangles);
+	EXPECT_EQ(mesh.num_triangles(), split.num_triangles);
+}
+
+TEST(subd_split, dicing_rate)
+{
+	Mesh mesh;
+	build_subd_mesh(&mesh);
+
+	SubdParams params(&mesh);
+	params.dicing_rate = 0.1f;
+
+	DiagSplit fine(params);
+	fine.estimate_only = true;
+	mesh.tessellate(&fine);
+
+	params.dicing_rate = 0.2f;
+
+	DiagSplit coarse(params);
+	coarse.estimate_only = true;
+	mesh.tessellate(&coarse);
+
+	/* Doubling the dicing rate roughly quarters the triangle count. */
+	EXPECT_LT(coarse.num_triangles, fine.num_triangles / 2);
+}
+
+TEST(subd_split, offscreen_dicing)
+{
+	Camera cam;
+	cam.full_width = cam.width;
+	cam.full_height = cam.height;
+	cam.update();
+
+	float3 P_visible = make_float3(0.0f, 0.0f, 10.0f);
+	float3 P_offscreen = make_float3(0.0f, 100.0f, 10.0f);
+	float3 P_behind = make_float3(0.0f, 0.0f, -10.0f);
+
+	float visible = cam.world_to_raster_size(P_visible);
+	float offscreen = cam.world_to_raster_size(P_offscreen);
+	float behind = cam.world_to_raster_size(P_behind);
+
+	cam.offscreen_dicing_scale = 4.0f;
+
+	/* Points in view are not affected. */
+	EXPECT_FLOAT_EQ(cam.world_to_raster_size(P_visible), visible);
+
+	/* Points far outside of the view get the full scale. */
+	EXPECT_FLOAT_EQ(cam.world_to_raster_size(P_offscreen), offscreen*4.0f);
+	EXPECT_FLOAT_EQ(cam.world_to_raster_size(P_behind), behind*4.0f);
+}
+
+CCL_NAMESPACE_END
@@ -24,6 +24,7 @@
  * except for the constructor/destructor are thread safe. */
 
 #include "util_function.h"
+#include "util_map.h"
 #include "util_string.h"
 #include "util_time.h"
 #include "util_thread.h"
@@ -86,6 +87,7 @@ public:
 		cancel_message = "";
 		error = false;
 		error_message = "";
+		phase_times.clear();
 	}
 
 	/* cancel */
@@ -171,6 +173,36 @@ public:
 		render_time_ = time_dt() - render_start_time;
 	}
 
+	/* Accumulated time spent in named phases of the render, like scene
+	 * update or path tracing. Used for benchmarking. Phase times are
+	 * exclusive, a phase nested in another is not counted in its parent. */
+	void add_phase_time(const string& phase, double time)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		phase_times[phase] += time;
+	}
+
+	void add_phase_time(const string& phase, const scoped_timer &start_timer)
+	{
+		add_phase_time(phase, time_dt() - start_timer.get_start());
+	}
+
+	double get_phase_time(const string& phase)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		map<string, double>::iterator it = phase_times.find(phase);
+		return (it != phase_times.end())? it->second: 0.0;
+	}
+
+	map<string, double> get_phase_times()
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		return phase_times;
+	}
+
 	void reset_sample()
 	{
 		thread_scoped_lock lock(progress_mutex);
@@ -322,6 +354,8 @@ protected:
 
 	double start_time, render_start_time;
 
+	map<string, double> phase_times;
+
 	string status;
 	string substatus;
 
@@ -89,6 +89,15 @@ void RB_dworld_set_solver_iterations(rbDynamicsWorld *world, int num_solver_iter
 /* Split Impulse */
 void RB_dworld_set_split_impulse(rbDynamicsWorld *world, int split_impulse);
 
+/* Parallel Island Solving */
+typedef void (*rbParallelRangeFunc)(void *userdata, const int index);
+/* Must call func(userdata, i) for all 0 <= i < tot, these calls may run concurrently */
+typedef void (*rbParallelRangeRunner)(int tot, void *userdata, rbParallelRangeFunc func);
+
+/* Solve simulation islands on up to num_threads threads, islands are solved serially when runner is NULL
+ * or num_threads is 1. Results don't depend on the number of threads. */
+void RB_dworld_set_parallel(rbDynamicsWorld *world, rbParallelRangeRunner runner, int num_threads);
+
 /* Simulation ----------------------- */
 
 /* Step the simulation by the desired amount (in seconds) with extra controls on substep sizes and maximum substeps */
@@ -73,8 +73,291 @@ subject to the following restrictions:
 #include "BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h"
 #include "BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.h"
 
+#include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
+
+/* Island Solving ------------------- */
+
+/* same as btGetConstraintIslandId(), which isn't exported */
+static inline int rb_constraint_island_id(const btTypedConstraint *con)
+{
+	const btCollisionObject &ob0 = con->getRigidBodyA();
+	const btCollisionObject &ob1 = con->getRigidBodyB();
+
+	return (ob0.getIslandTag() >= 0) ? ob0.getIslandTag() : ob1.getIslandTag();
+}
+
+struct rbConstraintIslandPredicate {
+	inline bool operator() (const btTypedConstraint *lhs, const btTypedConstraint *rhs) const
+	{
+		return rb_constraint_island_id(lhs) < rb_constraint_island_id(rhs);
+	}
+};
+
+/* Range of the gathered bodies, manifolds and constraints solved together by one solver */
+struct rbIslandGroup {
+	int body_start, num_bodies;
+	int manifold_start, num_manifolds;
+	int constraint_start, num_constraints;
+	int task;
+};
+
+struct rbIslandGroupOrder {
+	int cost, group;
+};
+
+struct rbIslandGroupCostPredicate {
+	inline bool operator() (const rbIslandGroupOrder &lhs, const rbIslandGroupOrder &rhs) const
+	{
+		return (lhs.cost != rhs.cost) ? (lhs.cost > rhs.cost) : (lhs.group < rhs.group);
+	}
+};
+
+/* Discrete world which solves the awake simulation islands as independent groups, each task
+ * using its own solver so they can run concurrently. Islands touching a kinematic body are
+ * merged into one group, because the solver stores temporary state in those bodies. Each
+ * island is solved with its constraints and contacts in the same order as the serial world,
+ * so results don't depend on the number of threads. */
+class rbParallelDynamicsWorld : public btDiscreteDynamicsWorld {
+public:
+	rbParallelRangeRunner m_runner;
+	int m_numThreads;
+
+	rbParallelDynamicsWorld(btDispatcher *dispatcher, btBroadphaseInterface *pairCache,
+	                        btConstraintSolver *constraintSolver, btCollisionConfiguration *collisionConfiguration)
+	    : btDiscreteDynamicsWorld(dispatcher, pairCache, constraintSolver, collisionConfiguration),
+	      m_runner(NULL),
+	      m_numThreads(1),
+	      m_solverInfoPtr(NULL),
+	      m_groupOpen(false)
+	{
+	}
+
+	virtual ~rbParallelDynamicsWorld()
+	{
+		for (int i = 0; i < m_solvers.size(); i++) {
+			delete m_solvers[i];
+		}
+	}
+
+	virtual void solveConstraints(btContactSolverInfo &solverInfo)
+	{
+		if (m_runner) {
+			solveIslands(solverInfo);
+		}
+		else {
+			btDiscreteDynamicsWorld::solveConstraints(solverInfo);
+		}
+	}
+
+	void addIsland(btCollisionObject **bodies, int numBodies, btPersistentManifold **manifolds, int numManifolds,
+	               int islandId)
+	{
+		int constraint_start = 0, numConstraints = 0;
+		bool is_kinematic = false;
+		int i;
+
+		if (islandId < 0) {
+			numConstraints = m_sortedConstraints.size();
+		}
+		else {
+			/* constraints are sorted by island, find the range of this one */
+			int lo = 0, hi = m_sortedConstraints.size();
+			while (lo < hi) {
+				int mid = (lo + hi) / 2;
+				if (rb_constraint_island_id(m_sortedConstraints[mid]) < islandId)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			constraint_start = lo;
+			while (lo < m_sortedConstraints.size() && rb_constraint_island_id(m_sortedConstraints[lo]) == islandId)
+				lo++;
+			numConstraints = lo - constraint_start;
+		}
+
+		for (i = 0; i < numManifolds && !is_kinematic; i++) {
+			is_kinematic = manifolds[i]->getBody0()->isKinematicObject() ||
+			               manifolds[i]->getBody1()->isKinematicObject();
+		}
+		for (i = 0; i < numConstraints && !is_kinematic; i++) {
+			const btTypedConstraint *con = m_sortedConstraints[constraint_start + i];
+			is_kinematic = con->getRigidBodyA().isKinematicObject() || con->getRigidBodyB().isKinematicObject();
+		}
+
+		if (is_kinematic) {
+			for (i = 0; i < numBodies; i++)
+				m_kinematicBodies.push_back(bodies[i]);
+			for (i = 0; i < numManifolds; i++)
+				m_kinematicManifolds.push_back(manifolds[i]);
+			for (i = 0; i < numConstraints; i++)
+				m_kinematicConstraints.push_back(m_sortedConstraints[constraint_start + i]);
+		}
+		else {
+			if (!m_groupOpen) {
+				openGroup();
+			}
+
+			rbIslandGroup &group = m_groups[m_groups.size() - 1];
+
+			for (i = 0; i < numBodies; i++)
+				m_groupBodies.push_back(bodies[i]);
+			for (i = 0; i < numManifolds; i++)
+				m_groupManifolds.push_back(manifolds[i]);
+			for (i = 0; i < numConstraints; i++)
+				m_groupConstraints.push_back(m_sortedConstraints[constraint_start + i]);
+
+			group.num_bodies += numBodies;
+			group.num_manifolds += numManifolds;
+			group.num_constraints += numConstraints;
+
+			/* batch small islands like the serial world does, to amortize solver setup */
+			if (group.num_manifolds + group.num_constraints > m_solverInfoPtr->m_minimumSolverBatchSize) {
+				m_groupOpen = false;
+			}
+		}
+	}
+
+	void solveTask(int task)
+	{
+		btConstraintSolver *solver = m_solvers[task];
+
+		for (int g = 0; g < m_groups.size(); g++) {
+			const rbIslandGroup &group = m_groups[g];
+
+			if (group.task != task)
+				continue;
+
+			solver->solveGroup(group.num_bodies ? &m_groupBodies[group.body_start] : NULL, group.num_bodies,
+			                   group.num_manifolds ? &m_groupManifolds[group.manifold_start] : NULL, group.num_manifolds,
+			                   group.num_constraints ? &m_groupConstraints[group.constraint_start] : NULL, group.num_constraints,
+			                   *m_solverInfoPtr, m_debugDrawer, getDispatcher());
+		}
+	}
+
+private:
+	struct IslandCallback : public btSimulationIslandManager::IslandCallback {
+		rbParallelDynamicsWorld *m_world;
+
+		virtual void processIsland(btCollisionObject **bodies, int numBodies, btPersistentManifold **manifolds,
+		                           int numManifolds, int islandId)
+		{
+			m_world->addIsland(bodies, numBodies, manifolds, numManifolds, islandId);
+		}
+	};
+
+	btAlignedObjectArray<btConstraintSolver *> m_solvers;
+	btAlignedObjectArray<rbIslandGroup> m_groups;
+	btAlignedObjectArray<rbIslandGroupOrder> m_groupOrder;
+	btAlignedObjectArray<btCollisionObject *> m_groupBodies, m_kinematicBodies;
+	btAlignedObjectArray<btPersistentManifold *> m_groupManifolds, m_kinematicManifolds;
+	btAlignedObjectArray<btTypedConstraint *> m_groupConstraints, m_kinematicConstraints;
+	btContactSolverInfo *m_solverInfoPtr;
+	bool m_groupOpen;
+
+	void openGroup()
+	{
+		rbIslandGroup &group = m_groups.expandNonInitializing();
+
+		group.body_start = m_groupBodies.size();
+		group.manifold_start = m_groupManifolds.size();
+		group.constraint_start = m_groupConstraints.size();
+		group.num_bodies = group.num_manifolds = group.num_constraints = 0;
+		group.task = 0;
+		m_groupOpen = true;
+	}
+
+	static void solve_task_cb(void *userdata, const int index)
+	{
+		((rbParallelDynamicsWorld *)userdata)->solveTask(index);
+	}
+
+	void solveIslands(btContactSolverInfo &solverInfo)
+	{
+		IslandCallback callback;
+		int i, num_tasks;
+
+		m_sortedConstraints.resize(m_constraints.size());
+		for (i = 0; i < m_sortedConstraints.size(); i++) {
+			m_sortedConstraints[i] = m_constraints[i];
+		}
+		m_sortedConstraints.quickSort(rbConstraintIslandPredicate());
+
+		m_solverInfoPtr = &solverInfo;
+		m_groups.resize(0);
+		m_groupBodies.resize(0);
+		m_groupManifolds.resize(0);
+		m_groupConstraints.resize(0);
+		m_kinematicBodies.resize(0);
+		m_kinematicManifolds.resize(0);
+		m_kinematicConstraints.resize(0);
+		m_groupOpen = false;
+
+		callback.m_world = this;
+		m_islandManager->buildAndProcessIslands(getDispatcher(), getCollisionWorld(), &callback);
+
+		if (m_kinematicBodies.size() || m_kinematicManifolds.size() || m_kinematicConstraints.size()) {
+			openGroup();
+
+			rbIslandGroup &group = m_groups[m_groups.size() - 1];
+			group.num_bodies = m_kinematicBodies.size();
+			group.num_manifolds = m_kinematicManifolds.size();
+			group.num_constraints = m_kinematicConstraints.size();
+
+			for (i = 0; i < m_kinematicBodies.size(); i++)
+				m_groupBodies.push_back(m_kinematicBodies[i]);
+			for (i = 0; i < m_kinematicManifolds.size(); i++)
+				m_groupManifolds.push_back(m_kinematicManifolds[i]);
+			for (i = 0; i < m_kinematicConstraints.size(); i++)
+				m_groupConstraints.push_back(m_kinematicConstraints[i]);
+		}
+
+		if (m_groups.size() == 0) {
+			return;
+		}
+
+#ifdef BT_NO_PROFILE
+		num_tasks = btMin(btMax(m_numThreads, 1), m_groups.size());
+#else
+		/* Bullet's profiler isn't thread safe, only the bundled library is built without it */
+		num_tasks = 1;
+#endif
+		while (m_solvers.size() < num_tasks) {
+			m_solvers.push_back(new btSequentialImpulseConstraintSolver());
+		}
+
+		/* largest groups first, each to the least loaded task */
+		if (num_tasks > 1) {
+			btAlignedObjectArray<int> task_cost;
+			task_cost.resize(num_tasks, 0);
+
+			m_groupOrder.resize(m_groups.size());
+			for (i = 0; i < m_groups.size(); i++) {
+				const rbIslandGroup &group = m_groups[i];
+				m_groupOrder[i].cost = group.num_bodies + group.num_manifolds + group.num_constraints;
+				m_groupOrder[i].group = i;
+			}
+			m_groupOrder.quickSort(rbIslandGroupCostPredicate());
+
+			for (i = 0; i < m_groupOrder.size(); i++) {
+				int task = 0;
+				for (int t = 1; t < num_tasks; t++) {
+					if (task_cost[t] < task_cost[task])
+						task = t;
+				}
+				m_groups[m_groupOrder[i].group].task = task;
+				task_cost[task] += m_groupOrder[i].cost;
+			}
+
+			m_runner(num_tasks, this, solve_task_cb);
+		}
+		else {
+			solveTask(0);
+		}
+	}
+};
+
 struct rbDynamicsWorld {
-	btDiscreteDynamicsWorld *dynamicsWorld;
+	rbParallelDynamicsWorld *dynamicsWorld;
 	btDefaultCollisionConfiguration *collisionConfiguration;
 	btDispatcher *dispatcher;
 	btBroadphaseInterface *pairCache;
@@ -160,7 +443,7 @@ rbDynamicsWorld *RB_dworld_new(const float gravity[3])
 	world->constraintSolver = new btSequentialImpulseConstraintSolver();
 
 	/* world */
-	world->dynamicsWorld = new btDiscreteDynamicsWorld(world->dispatcher,
+	world->dynamicsWorld = new rbParallelDynamicsWorld(world->dispatcher,
 	                                                   world->pairCache,
 	                                                   world->constraintSolver,
 	                                                   world->collisionConfiguration);
@@ -211,6 +494,13 @@ void RB_dworld_set_split_impulse(rbDynamicsWorld *world, int split_impulse)
 	info.m_splitImpulse = split_impulse;
 }
 
+/* Parallel Island Solving */
+void RB_dworld_set_parallel(rbDynamicsWorld *world, rbParallelRangeRunner runner, int num_threads)
+{
+	world->dynamicsWorld->m_runner = runner;
+	world->dynamicsWorld->m_numThreads = num_threads;
+}
+
 /* Simulation ----------------------- */
 
 void RB_dworld_step_simulation(rbDynamicsWorld *world, float timeStep, int maxSubSteps, float timeSubStep)
@@ -0,0 +1,126 @@
+/** \file smoke/intern/BLOCK_MASK.cpp
+ *  \ingroup smoke
+ */
+//////////////////////////////////////////////////////////////////////
+// This file is part of Wavelet Turbulence.
+//
+// Wavelet Turbulence is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Wavelet Turbulence is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Wavelet Turbulence.  If not, see <http://www.gnu.org/licenses/>.
+//
+// BLOCK_MASK.cpp: implementation of the BLOCK_MASK class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "BLOCK_MASK.h"
+
+#include <cmath>
+#include <cstring>
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+BLOCK_MASK::BLOCK_MASK(int xRes, int yRes, int zRes) :
+	_xRes(xRes), _yRes(yRes), _zRes(zRes)
+{
+	_xBlocks = (xRes + BLOCK_SIZE - 1) >> BLOCK_SHIFT;
+	_yBlocks = (yRes + BLOCK_SIZE - 1) >> BLOCK_SHIFT;
+	_zBlocks = (zRes + BLOCK_SIZE - 1) >> BLOCK_SHIFT;
+
+	_active = new unsigned char[numBlocks()];
+	_temp = new unsigned char[numBlocks()];
+
+	fill();
+}
+
+BLOCK_MASK::~BLOCK_MASK()
+{
+	delete[] _active;
+	delete[] _temp;
+}
+
+void BLOCK_MASK::clear()
+{
+	memset(_active, 0, sizeof(unsigned char) * numBlocks());
+}
+
+void BLOCK_MASK::fill()
+{
+	memset(_active, 1, sizeof(unsigned char) * numBlocks());
+}
+
+int BLOCK_MASK::numActive() const
+{
+	int count = 0;
+	for (int i = 0; i < numBlocks(); i++)
+		count += _active[i];
+	return count;
+}
+
+void BLOCK_MASK::activate(const float *field, float threshold)
+{
+	const int slabSize = _xRes * _yRes;
+
+	// threads own whole block layers, so no two of them write the same flag
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int zBlock = 0; zBlock < _zBlocks; zBlock++)
+	{
+		const int zBegin = zBlock << BLOCK_SHIFT;
+		const int zEnd = (zBegin + BLOCK_SIZE < _zRes) ? zBegin + BLOCK_SIZE : _zRes;
+
+		for (int z = zBegin; z < zEnd; z++)
+			for (int y = 0; y < _yRes; y++)
+			{
+				unsigned char *blocks = _active + ((size_t)zBlock * _yBlocks + (y >> BLOCK_SHIFT)) * _xBlocks;
+				const float *cells = field + (size_t)z * slabSize + (size_t)y * _xRes;
+
+				for (int x = 0; x < _xRes; x++)
+					if (fabsf(cells[x]) > threshold)
+						blocks[x >> BLOCK_SHIFT] = 1;
+			}
+	}
+}
+
+// separable box filter, one pass per axis
+void BLOCK_MASK::dilate(int radius)
+{
+	if (radius <= 0)
+		return;
+
+	const int res[3] = {_xBlocks, _yBlocks, _zBlocks};
+	const int stride[3] = {1, _xBlocks, _xBlocks * _yBlocks};
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		memcpy(_temp, _active, sizeof(unsigned char) * numBlocks());
+
+		for (int z = 0; z < _zBlocks; z++)
+			for (int y = 0; y < _yBlocks; y++)
+				for (int x = 0; x < _xBlocks; x++)
+				{
+					const int pos[3] = {x, y, z};
+					const size_t index = (size_t)z * stride[2] + y * stride[1] + x;
+
+					if (!_temp[index])
+						continue;
+
+					const int begin = (pos[axis] - radius < 0) ? 0 : pos[axis] - radius;
+					const int end = (pos[axis] + radius >= res[axis]) ? res[axis] - 1 : pos[axis] + radius;
+
+					for (int i = begin; i <= end; i++)
+						_active[index + (i - pos[axis]) * stride[axis]] = 1;
+				}
+	}
+}
@@ -0,0 +1,70 @@
+/** \file smoke/intern/BLOCK_MASK.h
+ *  \ingroup smoke
+ */
+//////////////////////////////////////////////////////////////////////
+// This file is part of Wavelet Turbulence.
+//
+// Wavelet Turbulence is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Wavelet Turbulence is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Wavelet Turbulence.  If not, see <http://www.gnu.org/licenses/>.
+//
+// BLOCK_MASK.h: marks which 8x8x8 bricks of a grid contain anything, so
+// the per cell loops can skip the empty parts of the domain.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef BLOCK_MASK_H
+#define BLOCK_MASK_H
+
+#include <cstddef>
+
+class BLOCK_MASK
+{
+public:
+	enum {
+		BLOCK_SHIFT = 3,
+		BLOCK_SIZE = 1 << BLOCK_SHIFT,
+	};
+
+	BLOCK_MASK(int xRes, int yRes, int zRes);
+	virtual ~BLOCK_MASK();
+
+	// mark every block inactive / active
+	void clear();
+	void fill();
+
+	// activate blocks containing a cell with an absolute value above threshold
+	void activate(const float *field, float threshold);
+
+	// grow the active region by radius blocks in every direction
+	void dilate(int radius);
+
+	int numActive() const;
+	int numBlocks() const { return _xBlocks * _yBlocks * _zBlocks; }
+
+	// active flags of the blocks overlapping cell row (y, z), indexed by x >> BLOCK_SHIFT
+	const unsigned char *row(int y, int z) const {
+		return _active + ((size_t)(z >> BLOCK_SHIFT) * _yBlocks + (y >> BLOCK_SHIFT)) * _xBlocks;
+	}
+
+	bool isActive(int x, int y, int z) const {
+		return row(y, z)[x >> BLOCK_SHIFT] != 0;
+	}
+
+private:
+	int _xRes, _yRes, _zRes;
+	int _xBlocks, _yBlocks, _zBlocks;
+	unsigned char *_active;
+	unsigned char *_temp;
+};
+
+#endif
@@ -51,6 +51,7 @@ FLUID_3D::FLUID_3D(int *res, float dx, float dtdef, int init_heat, int init_fire
 	_dt = dtdef;	// just in case. set in step from a RNA factor
 
 	_iterations = 100;
+	_pressureSolver = NULL;
 	_tempAmb = 0; 
 	_heatDiffusion = 1e-3;
 	_totalTime = 0.0f;
@@ -93,6 +94,7 @@ FLUID_3D::FLUID_3D(int *res, float dx, float dtdef, int init_heat, int init_fire
 	_density      = new float[_totalCells];
 	_densityOld   = new float[_totalCells];
 	_obstacles    = new unsigned char[_totalCells]; // set 0 at end of step
+	_blocks       = new BLOCK_MASK(_xRes, _yRes, _zRes);
 
 	// For threaded version:
 	_xVelocityTemp = new float[_totalCells];
@@ -260,6 +262,7 @@ void FLUID_3D::setBorderObstacles()
 
 FLUID_3D::~FLUID_3D()
 {
+	if (_blocks) delete _blocks;
 	if (_xVelocity) delete[] _xVelocity;
 	if (_yVelocity) delete[] _yVelocity;
 	if (_zVelocity) delete[] _zVelocity;
@@ -307,7 +310,8 @@ FLUID_3D::~FLUID_3D()
 
 // init direct access functions from blender
 void FLUID_3D::initBlenderRNA(float *alpha, float *beta, float *dt_factor, float *vorticity, int *borderCollision, float *burning_rate,
-							  float *flame_smoke, float *flame_smoke_color, float *flame_vorticity, float *flame_ignition_temp, float *flame_max_temp)
+							  float *flame_smoke, float *flame_smoke_color, float *flame_vorticity, float *flame_ignition_temp, float *flame_max_temp,
+							  char *pressure_solver)
 {
 	_alpha = alpha;
 	_beta = beta;
@@ -320,6 +324,7 @@ void FLUID_3D::initBlenderRNA(float *alpha, float *beta, float *dt_factor, float
 	_flame_vorticity = flame_vorticity;
 	_ignition_temp = flame_ignition_temp;
 	_max_temp = flame_max_temp;
+	_pressureSolver = pressure_solver;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -368,9 +373,7 @@ void FLUID_3D::step(float dt, float gravity[3])
 	wipeBoundariesSL(0, _zRes);
 
 #if PARALLEL==1
-	#pragma omp parallel
-	{
-	#pragma omp for schedule(static,1)
+	#pragma omp parallel for schedule(static,1)
 	for (int i=0; i<stepParts; i++)
 	{
 		int zBegin = (int)((float)i*partSize + 0.5f);
@@ -383,10 +386,6 @@ void FLUID_3D::step(float dt, float gravity[3])
 
 #if PARALLEL==1
 	}	// end of parallel
-	#pragma omp barrier
-
-	#pragma omp single
-	{
 #endif
 	/*
 	* addForce() changed Temp values to preserve thread safety
@@ -398,35 +397,38 @@ void FLUID_3D::step(float dt, float gravity[3])
 	SWAP_POINTERS(_xVelocity, _xVelocityTemp);
 	SWAP_POINTERS(_yVelocity, _yVelocityTemp);
 	SWAP_POINTERS(_zVelocity, _zVelocityTemp);
-#if PARALLEL==1
-	}	// end of single
-
-	#pragma omp barrier
 
-	#pragma omp for
-	for (int i=0; i<2; i++)
+#if PARALLEL==1
+	/*
+	* The multigrid solver threads its own loops, inside of a parallel
+	* region those would run serialized, so only overlap projection and
+	* heat diffusion for the single threaded CG solver.
+	*/
+	if (!useMultigrid())
 	{
-		if (i==0)
+		#pragma omp parallel sections
 		{
-#endif
-			project();
-#if PARALLEL==1
+			#pragma omp section
+			{
+				project();
+			}
+			#pragma omp section
+			{
+				if (_heat) {
+					diffuseHeat();
+				}
+			}
 		}
-		else if (i==1)
-		{
+	}
+	else
 #endif
-			if (_heat) {
-				diffuseHeat();
-			}
-#if PARALLEL==1
+	{
+		project();
+		if (_heat) {
+			diffuseHeat();
 		}
 	}
 
-	#pragma omp barrier
-
-	#pragma omp single
-	{
-#endif
 	/*
 	* For thread safety use "Old" to read
 	* "current" values but still allow changing values.
@@ -444,14 +446,14 @@ void FLUID_3D::step(float dt, float gravity[3])
 	SWAP_POINTERS(_color_g, _color_gOld);
 	SWAP_POINTERS(_color_b, _color_bOld);
 
+	// advection of the smoke fields is skipped where there is none
+	updateActiveBlocks();
+
 	advectMacCormackBegin(0, _zRes);
 
 #if PARALLEL==1
-	}	// end of single
-
-	#pragma omp barrier
-
-
+	#pragma omp parallel
+	{
 	#pragma omp for schedule(static,1)
 	for (int i=0; i<stepParts; i++)
 	{
@@ -515,6 +517,42 @@ void FLUID_3D::step(float dt, float gravity[3])
 }
 
 
+//////////////////////////////////////////////////////////////////////
+// find the blocks which contain smoke or that smoke can be advected
+// into during this step
+//////////////////////////////////////////////////////////////////////
+void FLUID_3D::updateActiveBlocks()
+{
+	// heat isn't included, the implicit diffusion spreads it over the
+	// whole domain so it is always advected everywhere
+	float *fields[] = {
+		_densityOld,
+		_fuelOld,
+		_reactOld,
+		_color_rOld,
+		_color_gOld,
+		_color_bOld,
+	};
+
+	_blocks->clear();
+
+	for (int i = 0; i < (int)(sizeof(fields) / sizeof(*fields)); i++)
+		if (fields[i])
+			_blocks->activate(fields[i], 0.0f);
+
+	float maxVelMag = 0.0f;
+	for (size_t i = 0; i < _totalCells; i++) {
+		const float velMag = _xVelocityOld[i] * _xVelocityOld[i] +
+		                     _yVelocityOld[i] * _yVelocityOld[i] +
+		                     _zVelocityOld[i] * _zVelocityOld[i];
+		if (velMag > maxVelMag) maxVelMag = velMag;
+	}
+
+	// MacCormack traces forward and back and interpolates one cell further
+	const float maxDistance = sqrtf(maxVelMag) * _dt / _dx;
+	_blocks->dilate((int)ceilf((2.0f * maxDistance + 2.0f) / BLOCK_MASK::BLOCK_SIZE));
+}
+
 // Set border collision model from RNA setting
 
 void FLUID_3D::setBorderCollisions() {
@@ -997,7 +1035,10 @@ void FLUID_3D::project()
 	fixObstacleCompression(_divergence);
 
 	// solve Poisson equation
-	solvePressurePre(_pressure, _divergence, _obstacles);
+	if (useMultigrid())
+		solvePressureMG(_pressure, _divergence, _obstacles);
+	else
+		solvePressurePre(_pressure, _divergence, _obstacles);
 
 	setObstaclePressure(_pressure, 0, _zRes);
 
@@ -1651,18 +1692,18 @@ void FLUID_3D::advectMacCormackEnd1(int zBegin, int zEnd)
 
 	// advectFieldMacCormack1(dt, xVelocity, yVelocity, zVelocity, oldField, newField, res)
 
-	advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _densityOld, _densityTemp, res, zBegin, zEnd);
+	advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _densityOld, _densityTemp, res, zBegin, zEnd, _blocks);
 	if (_heat) {
 		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _heatOld, _heatTemp, res, zBegin, zEnd);
 	}
 	if (_fuel) {
-		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _fuelOld, _fuelTemp, res, zBegin, zEnd);
-		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _reactOld, _reactTemp, res, zBegin, zEnd);
+		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _fuelOld, _fuelTemp, res, zBegin, zEnd, _blocks);
+		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _reactOld, _reactTemp, res, zBegin, zEnd, _blocks);
 	}
 	if (_color_r) {
-		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_rOld, _color_rTemp, res, zBegin, zEnd);
-		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_gOld, _color_gTemp, res, zBegin, zEnd);
-		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_bOld, _color_bTemp, res, zBegin, zEnd);
+		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_rOld, _color_rTemp, res, zBegin, zEnd, _blocks);
+		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_gOld, _color_gTemp, res, zBegin, zEnd, _blocks);
+		advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_bOld, _color_bTemp, res, zBegin, zEnd, _blocks);
 	}
 	advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _xVelocityOld, _xVelocity, res, zBegin, zEnd);
 	advectFieldMacCormack1(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _yVelocityOld, _yVelocity, res, zBegin, zEnd);
@@ -1685,18 +1726,18 @@ void FLUID_3D::advectMacCormackEnd2(int zBegin, int zEnd)
 	// advectFieldMacCormack2(dt, xVelocity, yVelocity, zVelocity, oldField, newField, tempfield, temp, res, obstacles)
 
 	/* finish advection */
-	advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _densityOld, _density, _densityTemp, t1, res, _obstacles, zBegin, zEnd);
+	advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _densityOld, _density, _densityTemp, t1, res, _obstacles, zBegin, zEnd, _blocks);
 	if (_heat) {
 		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _heatOld, _heat, _heatTemp, t1, res, _obstacles, zBegin, zEnd);
 	}
 	if (_fuel) {
-		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _fuelOld, _fuel, _fuelTemp, t1, res, _obstacles, zBegin, zEnd);
-		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _reactOld, _react, _reactTemp, t1, res, _obstacles, zBegin, zEnd);
+		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _fuelOld, _fuel, _fuelTemp, t1, res, _obstacles, zBegin, zEnd, _blocks);
+		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _reactOld, _react, _reactTemp, t1, res, _obstacles, zBegin, zEnd, _blocks);
 	}
 	if (_color_r) {
-		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_rOld, _color_r, _color_rTemp, t1, res, _obstacles, zBegin, zEnd);
-		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_gOld, _color_g, _color_gTemp, t1, res, _obstacles, zBegin, zEnd);
-		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_bOld, _color_b, _color_bTemp, t1, res, _obstacles, zBegin, zEnd);
+		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_rOld, _color_r, _color_rTemp, t1, res, _obstacles, zBegin, zEnd, _blocks);
+		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_gOld, _color_g, _color_gTemp, t1, res, _obstacles, zBegin, zEnd, _blocks);
+		advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _color_bOld, _color_b, _color_bTemp, t1, res, _obstacles, zBegin, zEnd, _blocks);
 	}
 	advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _xVelocityOld, _xVelocityTemp, _xVelocity, t1, res, _obstacles, zBegin, zEnd);
 	advectFieldMacCormack2(dt0, _xVelocityOld, _yVelocityOld, _zVelocityOld, _yVelocityOld, _yVelocityTemp, _yVelocity, t1, res, _obstacles, zBegin, zEnd);
@@ -35,6 +35,7 @@
 #include <cmath>
 #include <cstring>
 #include <iostream>
+#include "BLOCK_MASK.h"
 #include "OBSTACLE.h"
 // #include "WTURBULENCE.h"
 #include "VEC3.h"
@@ -55,7 +56,8 @@ struct FLUID_3D
 		void initColors(float init_r, float init_g, float init_b);
 
 		void initBlenderRNA(float *alpha, float *beta, float *dt_factor, float *vorticity, int *border_colli, float *burning_rate,
-							float *flame_smoke, float *flame_smoke_color, float *flame_vorticity, float *ignition_temp, float *max_temp);
+							float *flame_smoke, float *flame_smoke_color, float *flame_vorticity, float *ignition_temp, float *max_temp,
+							char *pressure_solver);
 		
 		// create & allocate vector noise advection 
 		void initVectorNoise(int amplify);
@@ -113,6 +115,11 @@ struct FLUID_3D
 		unsigned char*  _obstacles; /* only used (useful) for static obstacles like domain boundaries */
 		unsigned char*  _obstaclesAnim;
 
+		// bricks smoke can reach in this step, the smoke fields are only
+		// advected inside of them
+		BLOCK_MASK* _blocks;
+		void updateActiveBlocks();
+
 		// Required for proper threading:
 		float* _xVelocityTemp;
 		float* _yVelocityTemp;
@@ -144,6 +151,13 @@ struct FLUID_3D
 		// CG fields
 		int _iterations;
 
+		// pressure solvers, same values as SM_PRESSURE_SOLVER_* in DNA_smoke_types.h
+		enum {
+			PRESSURE_SOLVER_CG = 0,
+			PRESSURE_SOLVER_MULTIGRID = 1,
+		};
+		char *_pressureSolver; // RNA pointer
+
 		// simulation constants
 		float _dt;
 		float *_dtFactor;
@@ -187,6 +201,8 @@ struct FLUID_3D
 		void diffuseColor();
 		void solvePressure(float* field, float* b, unsigned char* skip);
 		void solvePressurePre(float* field, float* b, unsigned char* skip);
+		void solvePressureMG(float* field, float* b, unsigned char* skip);
+		bool useMultigrid() const { return _pressureSolver && *_pressureSolver == PRESSURE_SOLVER_MULTIGRID; }
 		void solveHeat(float* field, float* b, unsigned char* skip);
 		void solveDiffusion(float* field, float* b, float* factor);
 
@@ -237,12 +253,14 @@ struct FLUID_3D
 		
 
 		// static advection functions, also used by WTURBULENCE
+		// cells in inactive blocks are set to zero instead of being advected
 		static void advectFieldSemiLagrange(const float dt, const float* velx, const float* vely,  const float* velz,
-				float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd);
+				float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd, const BLOCK_MASK *blocks = NULL);
 		static void advectFieldMacCormack1(const float dt, const float* xVelocity, const float* yVelocity, const float* zVelocity, 
-				float* oldField, float* tempResult, Vec3Int res, int zBegin, int zEnd);
+				float* oldField, float* tempResult, Vec3Int res, int zBegin, int zEnd, const BLOCK_MASK *blocks = NULL);
 		static void advectFieldMacCormack2(const float dt, const float* xVelocity, const float* yVelocity, const float* zVelocity, 
-				float* oldField, float* newField, float* tempResult, float* temp1,Vec3Int res, const unsigned char* obstacles, int zBegin, int zEnd);
+				float* oldField, float* newField, float* tempResult, float* temp1,Vec3Int res, const unsigned char* obstacles, int zBegin, int zEnd,
+				const BLOCK_MASK *blocks = NULL);
 
 
 		// temp ones for testing
@@ -253,9 +271,10 @@ struct FLUID_3D
 
 		// maccormack helper functions
 		static void clampExtrema(const float dt, const float* xVelocity, const float* yVelocity,  const float* zVelocity,
-				float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd);
+				float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd, const BLOCK_MASK *blocks);
 		static void clampOutsideRays(const float dt, const float* xVelocity, const float* yVelocity,  const float* zVelocity,
-				float* oldField, float* newField, Vec3Int res, const unsigned char* obstacles, const float *oldAdvection, int zBegin, int zEnd);
+				float* oldField, float* newField, Vec3Int res, const unsigned char* obstacles, const float *oldAdvection, int zBegin, int zEnd,
+				const BLOCK_MASK *blocks);
 
 
 
@@ -28,6 +28,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "FLUID_3D.h"
+#include "MULTIGRID.h"
 #include <cstring>
 #define SOLVER_ACCURACY 1e-06
 
@@ -326,3 +327,196 @@ void FLUID_3D::solvePressurePre(float* field, float* b, unsigned char* skip)
 	if (_direction) delete[] _direction;
 	if (_q)       delete[] _q;
 }
+
+//////////////////////////////////////////////////////////////////////
+// q = A * d for the pressure Poisson stencil, returns d . q
+//////////////////////////////////////////////////////////////////////
+static float applyPoisson(float *q, const float *d, const unsigned char *skip,
+                          int xRes, int yRes, int zRes)
+{
+	const int slabSize = xRes * yRes;
+	float dq = 0.0f;
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static) reduction(+:dq)
+#endif
+	for (int z = 1; z < zRes - 1; z++)
+		for (int y = 1; y < yRes - 1; y++)
+		{
+			size_t index = (size_t)z * slabSize + y * xRes + 1;
+
+			for (int x = 1; x < xRes - 1; x++, index++)
+			{
+				if (skip[index])
+				{
+					q[index] = 0.0f;
+					continue;
+				}
+
+				float Acenter = 0.0f;
+				float sum = 0.0f;
+				if (!skip[index + 1]) { Acenter += 1.0f; sum += d[index + 1]; }
+				if (!skip[index - 1]) { Acenter += 1.0f; sum += d[index - 1]; }
+				if (!skip[index + xRes]) { Acenter += 1.0f; sum += d[index + xRes]; }
+				if (!skip[index - xRes]) { Acenter += 1.0f; sum += d[index - xRes]; }
+				if (!skip[index + slabSize]) { Acenter += 1.0f; sum += d[index + slabSize]; }
+				if (!skip[index - slabSize]) { Acenter += 1.0f; sum += d[index - slabSize]; }
+
+				q[index] = Acenter * d[index] - sum;
+				dq += d[index] * q[index];
+			}
+		}
+
+	return dq;
+}
+
+//////////////////////////////////////////////////////////////////////
+// solve the pressure Poisson equation with multigrid preconditioned CG
+// same system and stopping criterion as solvePressurePre(), but every
+// iteration does a V-cycle instead of the diagonal preconditioner so
+// far fewer iterations are needed on large domains
+//////////////////////////////////////////////////////////////////////
+void FLUID_3D::solvePressureMG(float* field, float* b, unsigned char* skip)
+{
+	const int xRes = _xRes, yRes = _yRes, zRes = _zRes;
+	const int slabSize = _slabSize;
+	float *_q, *_h, *_residual, *_direction, *_maxRSlab;
+
+	// i = 0
+	int i = 0;
+
+	_residual     = new float[_totalCells]; // set 0
+	_direction    = new float[_totalCells]; // set 0
+	_q            = new float[_totalCells]; // set 0
+	_h            = new float[_totalCells]; // set 0
+	_maxRSlab     = new float[_zRes];
+
+	memset(_residual, 0, sizeof(float)*_totalCells);
+	memset(_q, 0, sizeof(float)*_totalCells);
+	memset(_direction, 0, sizeof(float)*_totalCells);
+	memset(_h, 0, sizeof(float)*_totalCells);
+
+	// obstacles change every step, so is the hierarchy
+	MULTIGRID multigrid(_xRes, _yRes, _zRes, skip);
+
+	// r = b - Ax
+	applyPoisson(_q, field, skip, xRes, yRes, zRes);
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int z = 1; z < zRes - 1; z++)
+		for (int y = 1; y < yRes - 1; y++)
+		{
+			size_t index = (size_t)z * slabSize + y * xRes + 1;
+
+			for (int x = 1; x < xRes - 1; x++, index++)
+				_residual[index] = skip[index] ? 0.0f : b[index] - _q[index];
+		}
+
+	// p = M^-1 * r
+	multigrid.vcycle(_h, _residual);
+
+	float deltaNew = 0.0f;
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static) reduction(+:deltaNew)
+#endif
+	for (int z = 1; z < zRes - 1; z++)
+		for (int y = 1; y < yRes - 1; y++)
+		{
+			size_t index = (size_t)z * slabSize + y * xRes + 1;
+
+			for (int x = 1; x < xRes - 1; x++, index++)
+			{
+				_direction[index] = _h[index];
+				deltaNew += _residual[index] * _h[index];
+			}
+		}
+
+	const float eps  = SOLVER_ACCURACY;
+	float maxR = 2.0f * eps;
+	while ((i < _iterations) && (maxR > 0.001f * eps))
+	{
+		// q = Ad
+		float alpha = applyPoisson(_q, _direction, skip, xRes, yRes, zRes);
+
+		if (fabs(alpha) > 0.0f)
+			alpha = deltaNew / alpha;
+
+		// x = x + alpha * d, r = r - alpha * q
+#if PARALLEL==1
+		#pragma omp parallel for schedule(static)
+#endif
+		for (int z = 1; z < zRes - 1; z++)
+			for (int y = 1; y < yRes - 1; y++)
+			{
+				size_t index = (size_t)z * slabSize + y * xRes + 1;
+
+				for (int x = 1; x < xRes - 1; x++, index++)
+				{
+					field[index] += alpha * _direction[index];
+					_residual[index] -= alpha * _q[index];
+				}
+			}
+
+		// h = M^-1 * r
+		multigrid.vcycle(_h, _residual);
+
+		float deltaOld = deltaNew;
+		deltaNew = 0.0f;
+
+		// max reductions aren't available in all OpenMP versions, use one value per slab
+#if PARALLEL==1
+		#pragma omp parallel for schedule(static) reduction(+:deltaNew)
+#endif
+		for (int z = 1; z < zRes - 1; z++)
+		{
+			float slabMaxR = 0.0f;
+
+			for (int y = 1; y < yRes - 1; y++)
+			{
+				size_t index = (size_t)z * slabSize + y * xRes + 1;
+
+				for (int x = 1; x < xRes - 1; x++, index++)
+				{
+					float tmp = _residual[index] * _h[index];
+					deltaNew += tmp;
+					slabMaxR = (tmp > slabMaxR) ? tmp : slabMaxR;
+				}
+			}
+
+			_maxRSlab[z] = slabMaxR;
+		}
+
+		maxR = 0.0f;
+		for (int z = 1; z < zRes - 1; z++)
+			maxR = (_maxRSlab[z] > maxR) ? _maxRSlab[z] : maxR;
+
+		// beta = deltaNew / deltaOld
+		float beta = deltaNew / deltaOld;
+
+		// d = h + beta * d
+#if PARALLEL==1
+		#pragma omp parallel for schedule(static)
+#endif
+		for (int z = 1; z < zRes - 1; z++)
+			for (int y = 1; y < yRes - 1; y++)
+			{
+				size_t index = (size_t)z * slabSize + y * xRes + 1;
+
+				for (int x = 1; x < xRes - 1; x++, index++)
+					_direction[index] = _h[index] + beta * _direction[index];
+			}
+
+		// i = i + 1
+		i++;
+	}
+	// cout << i << " iterations converged to " << sqrt(maxR) << endl;
+
+	delete[] _maxRSlab;
+	delete[] _h;
+	delete[] _residual;
+	delete[] _direction;
+	delete[] _q;
+}
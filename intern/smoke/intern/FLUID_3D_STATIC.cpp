@@ -297,7 +297,7 @@ void FLUID_3D::copyBorderZ(float* field, Vec3Int res, int zBegin, int zEnd)
 // advect field with the semi lagrangian method
 //////////////////////////////////////////////////////////////////////
 void FLUID_3D::advectFieldSemiLagrange(const float dt, const float* velx, const float* vely,  const float* velz,
-		float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd)
+		float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd, const BLOCK_MASK *blocks)
 {
 	const int xres = res[0];
 	const int yres = res[1];
@@ -307,9 +307,17 @@ void FLUID_3D::advectFieldSemiLagrange(const float dt, const float* velx, const
 
 	for (int z = zBegin; z < zEnd; z++)
 		for (int y = 0; y < yres; y++)
+		{
+			const unsigned char *rowBlocks = (blocks) ? blocks->row(y, z) : NULL;
+
 			for (int x = 0; x < xres; x++)
 			{
 				const int index = x + y * xres + z * xres*yres;
+
+				if (rowBlocks && !rowBlocks[x >> BLOCK_MASK::BLOCK_SHIFT]) {
+					newField[index] = 0.0f;
+					continue;
+				}
 				
         // backtrace
 				float xTrace = x - dt * velx[index];
@@ -360,6 +368,7 @@ void FLUID_3D::advectFieldSemiLagrange(const float dt, const float* velx, const
 							s1 * (t0 * oldField[i101] +
 								t1 * oldField[i111]));
 			}
+		}
 }
 
 
@@ -369,7 +378,7 @@ void FLUID_3D::advectFieldSemiLagrange(const float dt, const float* velx, const
 // comments are the pseudocode from selle's paper
 //////////////////////////////////////////////////////////////////////
 void FLUID_3D::advectFieldMacCormack1(const float dt, const float* xVelocity, const float* yVelocity, const float* zVelocity, 
-				float* oldField, float* tempResult, Vec3Int res, int zBegin, int zEnd)
+				float* oldField, float* tempResult, Vec3Int res, int zBegin, int zEnd, const BLOCK_MASK *blocks)
 {
 	/*const int sx= res[0];
 	const int sy= res[1];
@@ -384,13 +393,14 @@ void FLUID_3D::advectFieldMacCormack1(const float dt, const float* xVelocity, co
 
 
 	// phiHatN1 = A(phiN)
-	advectFieldSemiLagrange(  dt, xVelocity, yVelocity, zVelocity, phiN, phiN1, res, zBegin, zEnd);		// uses wide data from old field and velocities (both are whole)
+	advectFieldSemiLagrange(  dt, xVelocity, yVelocity, zVelocity, phiN, phiN1, res, zBegin, zEnd, blocks);		// uses wide data from old field and velocities (both are whole)
 }
 
 
 
 void FLUID_3D::advectFieldMacCormack2(const float dt, const float* xVelocity, const float* yVelocity, const float* zVelocity, 
-				float* oldField, float* newField, float* tempResult, float* temp1, Vec3Int res, const unsigned char* obstacles, int zBegin, int zEnd)
+				float* oldField, float* newField, float* tempResult, float* temp1, Vec3Int res, const unsigned char* obstacles, int zBegin, int zEnd,
+				const BLOCK_MASK *blocks)
 {
 	float* phiHatN  = tempResult;
 	float* t1  = temp1;
@@ -403,26 +413,33 @@ void FLUID_3D::advectFieldMacCormack2(const float dt, const float* xVelocity, co
 
 
 	// phiHatN = A^R(phiHatN1)
-	advectFieldSemiLagrange( -1.0f*dt, xVelocity, yVelocity, zVelocity, phiHatN, t1, res, zBegin, zEnd);		// uses wide data from old field and velocities (both are whole)
+	advectFieldSemiLagrange( -1.0f*dt, xVelocity, yVelocity, zVelocity, phiHatN, t1, res, zBegin, zEnd, blocks);		// uses wide data from old field and velocities (both are whole)
 
 	// phiN1 = phiHatN1 + (phiN - phiHatN) / 2
 	const int border = 0; 
 	for (int z = zBegin+border; z < zEnd-border; z++)
-		for (int y = border; y < sy-border; y++)
+		for (int y = border; y < sy-border; y++) {
+			const unsigned char *rowBlocks = (blocks) ? blocks->row(y, z) : NULL;
+
 			for (int x = border; x < sx-border; x++) {
 				int index = x + y * sx + z * sx*sy;
+				if (rowBlocks && !rowBlocks[x >> BLOCK_MASK::BLOCK_SHIFT]) {
+					phiN1[index] = 0.0f;
+					continue;
+				}
 				phiN1[index] = phiHatN[index] + (phiN[index] - t1[index]) * 0.50f;
 				//phiN1[index] = phiHatN1[index]; // debug, correction off
 			}
+		}
 	copyBorderX(phiN1, res, zBegin, zEnd);
 	copyBorderY(phiN1, res, zBegin, zEnd);
 	copyBorderZ(phiN1, res, zBegin, zEnd);
 
 	// clamp any newly created extrema
-	clampExtrema(dt, xVelocity, yVelocity, zVelocity, oldField, newField, res, zBegin, zEnd);		// uses wide data from old field and velocities (both are whole)
+	clampExtrema(dt, xVelocity, yVelocity, zVelocity, oldField, newField, res, zBegin, zEnd, blocks);		// uses wide data from old field and velocities (both are whole)
 
 	// if the error estimate was bad, revert to first order
-	clampOutsideRays(dt, xVelocity, yVelocity, zVelocity, oldField, newField, res, obstacles, phiHatN, zBegin, zEnd);	// phiHatN is only used at cells within thread range, so its ok
+	clampOutsideRays(dt, xVelocity, yVelocity, zVelocity, oldField, newField, res, obstacles, phiHatN, zBegin, zEnd, blocks);	// phiHatN is only used at cells within thread range, so its ok
 
 } 
 
@@ -431,7 +448,7 @@ void FLUID_3D::advectFieldMacCormack2(const float dt, const float* xVelocity, co
 // Clamp the extrema generated by the BFECC error correction
 //////////////////////////////////////////////////////////////////////
 void FLUID_3D::clampExtrema(const float dt, const float* velx, const float* vely,  const float* velz,
-		float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd)
+		float* oldField, float* newField, Vec3Int res, int zBegin, int zEnd, const BLOCK_MASK *blocks)
 {
 	const int xres= res[0];
 	const int yres= res[1];
@@ -447,8 +464,15 @@ void FLUID_3D::clampExtrema(const float dt, const float* velx, const float* vely
 
 	for (int z = zBegin+bb; z < zEnd-bt; z++)
 		for (int y = 1; y < yres-1; y++)
+		{
+			const unsigned char *rowBlocks = (blocks) ? blocks->row(y, z) : NULL;
+
 			for (int x = 1; x < xres-1; x++)
 			{
+				// nothing to clamp, newField is zero
+				if (rowBlocks && !rowBlocks[x >> BLOCK_MASK::BLOCK_SHIFT])
+					continue;
+
 				const int index = x + y * xres+ z * xres*yres;
 				// backtrace
 				float xTrace = x - dt * velx[index];
@@ -507,6 +531,7 @@ void FLUID_3D::clampExtrema(const float dt, const float* velx, const float* vely
 				newField[index] = (newField[index] > maxField) ? maxField : newField[index];
 				newField[index] = (newField[index] < minField) ? minField : newField[index];
 			}
+		}
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -515,7 +540,8 @@ void FLUID_3D::clampExtrema(const float dt, const float* velx, const float* vely
 // incorrect
 //////////////////////////////////////////////////////////////////////
 void FLUID_3D::clampOutsideRays(const float dt, const float* velx, const float* vely,  const float* velz,
-				float* oldField, float* newField, Vec3Int res, const unsigned char* obstacles, const float *oldAdvection, int zBegin, int zEnd)
+				float* oldField, float* newField, Vec3Int res, const unsigned char* obstacles, const float *oldAdvection, int zBegin, int zEnd,
+				const BLOCK_MASK *blocks)
 {
 	const int sx= res[0];
 	const int sy= res[1];
@@ -530,8 +556,14 @@ void FLUID_3D::clampOutsideRays(const float dt, const float* velx, const float*
 
 	for (int z = zBegin+bb; z < zEnd-bt; z++)
 		for (int y = 1; y < sy-1; y++)
+		{
+			const unsigned char *rowBlocks = (blocks) ? blocks->row(y, z) : NULL;
+
 			for (int x = 1; x < sx-1; x++)
 			{
+				if (rowBlocks && !rowBlocks[x >> BLOCK_MASK::BLOCK_SHIFT])
+					continue;
+
 				const int index = x + y * sx+ z * slabSize;
 				// backtrace
 				float xBackward = x + dt * velx[index];
@@ -643,4 +675,5 @@ void FLUID_3D::clampOutsideRays(const float dt, const float* velx, const float*
 									t1 * oldField[i111])); 
 				}
 			} // xyz
+		}
 }
@@ -0,0 +1,401 @@
+/** \file smoke/intern/MULTIGRID.cpp
+ *  \ingroup smoke
+ */
+//////////////////////////////////////////////////////////////////////
+// This file is part of Wavelet Turbulence.
+//
+// Wavelet Turbulence is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Wavelet Turbulence is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Wavelet Turbulence.  If not, see <http://www.gnu.org/licenses/>.
+//
+// MULTIGRID.cpp: cell centered multigrid with piecewise constant
+// prolongation, averaging restriction and red-black Gauss-Seidel
+// smoothing. Every level is split into z slabs for threading, cells of
+// one color only depend on cells of the other color so the slabs can be
+// relaxed in parallel.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "MULTIGRID.h"
+
+#include <cstring>
+
+// stop coarsening once the largest interior dimension is this small
+#define MG_COARSEST_RES 4
+// red-black sweeps before and after the coarse grid correction
+#define MG_SMOOTH_SWEEPS 2
+// red-black sweeps used to solve the coarsest level
+#define MG_COARSEST_SWEEPS 16
+// operator scale between two levels, the variational (Galerkin) coarse
+// operator of piecewise constant prolongation is half the coarse Laplacian
+#define MG_COARSE_SCALE 0.5f
+// levels smaller than this aren't worth the threading overhead
+#define MG_PARALLEL_MIN_CELLS 32768
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+MULTIGRID::MULTIGRID(int xRes, int yRes, int zRes, const unsigned char *skip)
+{
+	const size_t totalCells = (size_t)xRes * yRes * zRes;
+	unsigned char *flags = new unsigned char[totalCells];
+
+	size_t index = 0;
+	for (int z = 0; z < zRes; z++)
+		for (int y = 0; y < yRes; y++)
+			for (int x = 0; x < xRes; x++, index++)
+			{
+				const bool border = (x == 0 || y == 0 || z == 0 ||
+				                     x == xRes - 1 || y == yRes - 1 || z == zRes - 1);
+
+				if (skip[index])
+					flags[index] = CELL_SOLID;
+				else if (border)
+					flags[index] = CELL_DIRICHLET;
+				else
+					flags[index] = CELL_FLUID;
+			}
+
+	addLevel(xRes, yRes, zRes, flags, 1.0f);
+
+	while (true) {
+		const LEVEL &fine = _levels.back();
+		const int maxRes = (fine.xRes > fine.yRes) ? fine.xRes : fine.yRes;
+
+		if (((maxRes > fine.zRes) ? maxRes : fine.zRes) - 2 <= MG_COARSEST_RES)
+			break;
+
+		// coarse cell i covers the fine cells 2i-1 and 2i, both grids keep a one cell border
+		const int cxRes = (fine.xRes - 1) / 2 + 2;
+		const int cyRes = (fine.yRes - 1) / 2 + 2;
+		const int czRes = (fine.zRes - 1) / 2 + 2;
+
+		unsigned char *coarseFlags = coarsenFlags(fine, flags, cxRes, cyRes, czRes);
+		const float scale = fine.scale * MG_COARSE_SCALE;
+
+		delete[] flags;
+		flags = coarseFlags;
+
+		addLevel(cxRes, cyRes, czRes, flags, scale);
+	}
+
+	delete[] flags;
+}
+
+MULTIGRID::~MULTIGRID()
+{
+	for (size_t l = 0; l < _levels.size(); l++) {
+		LEVEL &level = _levels[l];
+
+		delete[] level.invDiag;
+		delete[] level.residual;
+		if (l > 0) {
+			delete[] level.x;
+			delete[] level.b;
+		}
+	}
+}
+
+void MULTIGRID::addLevel(int xRes, int yRes, int zRes, unsigned char *flags, float scale)
+{
+	LEVEL level;
+
+	level.xRes = xRes;
+	level.yRes = yRes;
+	level.zRes = zRes;
+	level.slabSize = xRes * yRes;
+	level.totalCells = (size_t)xRes * yRes * zRes;
+	level.scale = scale;
+
+	level.invDiag = new float[level.totalCells];
+	level.residual = new float[level.totalCells];
+	memset(level.invDiag, 0, sizeof(float) * level.totalCells);
+	memset(level.residual, 0, sizeof(float) * level.totalCells);
+
+	// the finest level works on the arrays passed to vcycle()
+	if (_levels.empty()) {
+		level.x = NULL;
+		level.b = NULL;
+	}
+	else {
+		level.x = new float[level.totalCells];
+		level.b = new float[level.totalCells];
+		memset(level.x, 0, sizeof(float) * level.totalCells);
+		memset(level.b, 0, sizeof(float) * level.totalCells);
+	}
+
+	const int slabSize = level.slabSize;
+
+	for (int z = 1; z < zRes - 1; z++)
+		for (int y = 1; y < yRes - 1; y++)
+		{
+			size_t index = (size_t)z * slabSize + y * xRes + 1;
+
+			for (int x = 1; x < xRes - 1; x++, index++)
+			{
+				if (flags[index] != CELL_FLUID)
+					continue;
+
+				// solid neighbours don't couple, dirichlet ones only add to the diagonal
+				int diag = 0;
+				if (flags[index + 1] != CELL_SOLID) diag++;
+				if (flags[index - 1] != CELL_SOLID) diag++;
+				if (flags[index + xRes] != CELL_SOLID) diag++;
+				if (flags[index - xRes] != CELL_SOLID) diag++;
+				if (flags[index + slabSize] != CELL_SOLID) diag++;
+				if (flags[index - slabSize] != CELL_SOLID) diag++;
+
+				level.invDiag[index] = (diag > 0) ? 1.0f / diag : 0.0f;
+			}
+		}
+
+	_levels.push_back(level);
+}
+
+static inline void mg_child_range(int i, int coarseRes, int fineRes, int *r_begin, int *r_end)
+{
+	if (i == 0) {
+		*r_begin = *r_end = 0;
+	}
+	else if (i == coarseRes - 1) {
+		*r_begin = *r_end = fineRes - 1;
+	}
+	else {
+		*r_begin = 2 * i - 1;
+		*r_end = (2 * i < fineRes - 1) ? 2 * i : 2 * i - 1;
+	}
+}
+
+// coarse cells are fluid if any of their children is, otherwise they keep
+// a dirichlet condition if any child has one
+unsigned char *MULTIGRID::coarsenFlags(const LEVEL &fine, const unsigned char *fineFlags, int xRes, int yRes, int zRes)
+{
+	unsigned char *flags = new unsigned char[(size_t)xRes * yRes * zRes];
+
+	size_t index = 0;
+	for (int z = 0; z < zRes; z++)
+	{
+		int z0, z1;
+		mg_child_range(z, zRes, fine.zRes, &z0, &z1);
+
+		for (int y = 0; y < yRes; y++)
+		{
+			int y0, y1;
+			mg_child_range(y, yRes, fine.yRes, &y0, &y1);
+
+			for (int x = 0; x < xRes; x++, index++)
+			{
+				int x0, x1;
+				mg_child_range(x, xRes, fine.xRes, &x0, &x1);
+
+				unsigned char flag = CELL_SOLID;
+
+				for (int fz = z0; fz <= z1; fz++)
+					for (int fy = y0; fy <= y1; fy++)
+						for (int fx = x0; fx <= x1; fx++)
+						{
+							const unsigned char child = fineFlags[(size_t)fz * fine.slabSize + fy * fine.xRes + fx];
+
+							if (child == CELL_FLUID)
+								flag = CELL_FLUID;
+							else if (child == CELL_DIRICHLET && flag == CELL_SOLID)
+								flag = CELL_DIRICHLET;
+						}
+
+				flags[index] = flag;
+			}
+		}
+	}
+
+	return flags;
+}
+
+//////////////////////////////////////////////////////////////////////
+// V-cycle
+//////////////////////////////////////////////////////////////////////
+
+// one Gauss-Seidel sweep over the cells with (x + y + z) % 2 == color,
+// non fluid cells have a zero inverse diagonal and stay at zero
+void MULTIGRID::smooth(LEVEL &level, int color)
+{
+	const int xRes = level.xRes;
+	const int slabSize = level.slabSize;
+	const float invScale = 1.0f / level.scale;
+	const float *invDiag = level.invDiag;
+	const float *b = level.b;
+	float *x = level.x;
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static) if (level.totalCells > MG_PARALLEL_MIN_CELLS)
+#endif
+	for (int z = 1; z < level.zRes - 1; z++)
+		for (int y = 1; y < level.yRes - 1; y++)
+		{
+			const int xBegin = 1 + ((1 + y + z + color) & 1);
+			size_t index = (size_t)z * slabSize + y * xRes + xBegin;
+
+			for (int i = xBegin; i < xRes - 1; i += 2, index += 2)
+			{
+				x[index] = (b[index] * invScale +
+				            x[index - 1] + x[index + 1] +
+				            x[index - xRes] + x[index + xRes] +
+				            x[index - slabSize] + x[index + slabSize]) * invDiag[index];
+			}
+		}
+}
+
+void MULTIGRID::computeResidual(LEVEL &level)
+{
+	const int xRes = level.xRes;
+	const int slabSize = level.slabSize;
+	const float scale = level.scale;
+	const float *invDiag = level.invDiag;
+	const float *b = level.b;
+	const float *x = level.x;
+	float *residual = level.residual;
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static) if (level.totalCells > MG_PARALLEL_MIN_CELLS)
+#endif
+	for (int z = 1; z < level.zRes - 1; z++)
+		for (int y = 1; y < level.yRes - 1; y++)
+		{
+			size_t index = (size_t)z * slabSize + y * xRes + 1;
+
+			for (int i = 1; i < xRes - 1; i++, index++)
+			{
+				if (invDiag[index] == 0.0f) {
+					residual[index] = 0.0f;
+					continue;
+				}
+
+				const float Ax = x[index] / invDiag[index] -
+				                 (x[index - 1] + x[index + 1] +
+				                  x[index - xRes] + x[index + xRes] +
+				                  x[index - slabSize] + x[index + slabSize]);
+
+				residual[index] = b[index] - scale * Ax;
+			}
+		}
+}
+
+void MULTIGRID::restrictResidual(const LEVEL &fine, LEVEL &coarse)
+{
+	const int xRes = coarse.xRes;
+	const int yRes = coarse.yRes;
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static) if (fine.totalCells > MG_PARALLEL_MIN_CELLS)
+#endif
+	for (int z = 1; z < coarse.zRes - 1; z++)
+	{
+		int z0, z1;
+		mg_child_range(z, coarse.zRes, fine.zRes, &z0, &z1);
+
+		for (int y = 1; y < yRes - 1; y++)
+		{
+			int y0, y1;
+			mg_child_range(y, yRes, fine.yRes, &y0, &y1);
+
+			size_t index = (size_t)z * coarse.slabSize + y * xRes + 1;
+
+			for (int x = 1; x < xRes - 1; x++, index++)
+			{
+				int x0, x1;
+				mg_child_range(x, xRes, fine.xRes, &x0, &x1);
+
+				float sum = 0.0f;
+
+				for (int fz = z0; fz <= z1; fz++)
+					for (int fy = y0; fy <= y1; fy++)
+						for (int fx = x0; fx <= x1; fx++)
+							sum += fine.residual[(size_t)fz * fine.slabSize + fy * fine.xRes + fx];
+
+				coarse.b[index] = 0.125f * sum;
+			}
+		}
+	}
+}
+
+void MULTIGRID::prolongate(const LEVEL &coarse, LEVEL &fine)
+{
+	const int xRes = fine.xRes;
+
+#if PARALLEL==1
+	#pragma omp parallel for schedule(static) if (fine.totalCells > MG_PARALLEL_MIN_CELLS)
+#endif
+	for (int z = 1; z < fine.zRes - 1; z++)
+		for (int y = 1; y < fine.yRes - 1; y++)
+		{
+			const size_t coarseRow = (size_t)((z + 1) / 2) * coarse.slabSize + ((y + 1) / 2) * coarse.xRes;
+			size_t index = (size_t)z * fine.slabSize + y * xRes + 1;
+
+			for (int x = 1; x < xRes - 1; x++, index++)
+			{
+				if (fine.invDiag[index] != 0.0f)
+					fine.x[index] += coarse.x[coarseRow + (x + 1) / 2];
+			}
+		}
+}
+
+// Pre- and post-smoothing visit the colors in opposite order and the
+// coarsest level is relaxed with a palindromic sweep sequence, this keeps
+// the V-cycle symmetric so it can precondition conjugate gradients.
+void MULTIGRID::vcycleLevel(int l)
+{
+	LEVEL &level = _levels[l];
+
+	memset(level.x, 0, sizeof(float) * level.totalCells);
+
+	if (l == (int)_levels.size() - 1) {
+		for (int i = 0; i < MG_COARSEST_SWEEPS; i++) {
+			smooth(level, 0);
+			smooth(level, 1);
+		}
+		for (int i = 0; i < MG_COARSEST_SWEEPS; i++) {
+			smooth(level, 1);
+			smooth(level, 0);
+		}
+		return;
+	}
+
+	for (int i = 0; i < MG_SMOOTH_SWEEPS; i++) {
+		smooth(level, 0);
+		smooth(level, 1);
+	}
+
+	computeResidual(level);
+	restrictResidual(level, _levels[l + 1]);
+
+	vcycleLevel(l + 1);
+
+	prolongate(_levels[l + 1], level);
+
+	for (int i = 0; i < MG_SMOOTH_SWEEPS; i++) {
+		smooth(level, 1);
+		smooth(level, 0);
+	}
+}
+
+void MULTIGRID::vcycle(float *z, const float *r)
+{
+	LEVEL &finest = _levels[0];
+
+	finest.x = z;
+	finest.b = const_cast<float *>(r);
+
+	vcycleLevel(0);
+
+	finest.x = NULL;
+	finest.b = NULL;
+}
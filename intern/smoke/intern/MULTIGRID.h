@@ -0,0 +1,76 @@
+/** \file smoke/intern/MULTIGRID.h
+ *  \ingroup smoke
+ */
+//////////////////////////////////////////////////////////////////////
+// This file is part of Wavelet Turbulence.
+//
+// Wavelet Turbulence is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Wavelet Turbulence is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Wavelet Turbulence.  If not, see <http://www.gnu.org/licenses/>.
+//
+// MULTIGRID.h: geometric multigrid V-cycle for the pressure Poisson
+// equation, used as preconditioner by FLUID_3D::solvePressureMG().
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef MULTIGRID_H
+#define MULTIGRID_H
+
+#include <cstddef>
+#include <vector>
+
+class MULTIGRID
+{
+public:
+	// skip is the obstacle field of the finest grid, cells with a non zero
+	// value are not part of the system. Non skipped cells on the domain
+	// border are treated as zero pressure cells, same as in solvePressurePre()
+	MULTIGRID(int xRes, int yRes, int zRes, const unsigned char *skip);
+	virtual ~MULTIGRID();
+
+	// z = M^-1 * r, one symmetric V-cycle starting from a zero guess
+	void vcycle(float *z, const float *r);
+
+	int levels() const { return (int)_levels.size(); }
+
+private:
+	struct LEVEL {
+		int xRes, yRes, zRes;
+		int slabSize;
+		size_t totalCells;
+		float scale;      // operator scaling relative to the finest grid
+		float *invDiag;   // 1 / number of non solid neighbours, 0 if not fluid
+		float *x;         // solution, not allocated on the finest grid
+		float *b;         // right hand side, not allocated on the finest grid
+		float *residual;
+	};
+
+	enum {
+		CELL_SOLID = 0,
+		CELL_FLUID = 1,
+		CELL_DIRICHLET = 2,
+	};
+
+	void addLevel(int xRes, int yRes, int zRes, unsigned char *flags, float scale);
+	unsigned char *coarsenFlags(const LEVEL &fine, const unsigned char *fineFlags, int xRes, int yRes, int zRes);
+
+	void smooth(LEVEL &level, int color);
+	void computeResidual(LEVEL &level);
+	void restrictResidual(const LEVEL &fine, LEVEL &coarse);
+	void prolongate(const LEVEL &coarse, LEVEL &fine);
+
+	void vcycleLevel(int l);
+
+	std::vector<LEVEL> _levels;
+};
+
+#endif
@@ -94,6 +94,8 @@ WTURBULENCE::WTURBULENCE(int xResSm, int yResSm, int zResSm, int amplify, int no
 		_densityBigOld[i] = 0.;
 	}
 
+	_blocksBig = new BLOCK_MASK(_xResBig, _yResBig, _zResBig);
+
 	/* fire */
 	_flameBig = _fuelBig = _fuelBigOld = NULL;
 	_reactBig = _reactBigOld = NULL;
@@ -193,6 +195,8 @@ WTURBULENCE::~WTURBULENCE() {
   if (_color_bBig) delete[] _color_bBig;
   if (_color_bBigOld) delete[] _color_bBigOld;
 
+  delete _blocksBig;
+
   delete[] _tcU;
   delete[] _tcV;
   delete[] _tcW;
@@ -201,6 +205,42 @@ WTURBULENCE::~WTURBULENCE() {
   delete[] _noiseTile;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Find the blocks of the big grid that contain smoke or that smoke
+// can be advected into during this step
+//////////////////////////////////////////////////////////////////////
+void WTURBULENCE::updateActiveBlocks(float dt, float* xvel, float* yvel, float* zvel)
+{
+	float maxVelMag = 0.0f;
+	for (int i = 0; i < _totalCellsSm; i++) {
+		const float velMag = xvel[i] * xvel[i] + yvel[i] * yvel[i] + zvel[i] * zvel[i];
+		if (velMag > maxVelMag) maxVelMag = velMag;
+	}
+
+	// the noise is scaled by the energy of the coarse velocity, this is a
+	// generous bound for how far it can move the smoke
+	const float maxDistance = sqrtf(maxVelMag) * (1.0f + 2.0f * (*_strength)) * dt;
+
+	// MacCormack traces forward and back and interpolates one cell further,
+	// once per substep (see the substepping in stepTurbulenceFull)
+	int substeps = (int)(maxDistance / 5.0f);
+	substeps = (substeps < 1) ? 1 : ((substeps > 25) ? 25 : substeps);
+	const int radius = (int)ceilf((2.0f * maxDistance + 2.0f * substeps) / BLOCK_MASK::BLOCK_SIZE);
+
+	_blocksBig->clear();
+	_blocksBig->activate(_densityBig, 0.0f);
+	if (_fuelBig) {
+		_blocksBig->activate(_fuelBig, 0.0f);
+		_blocksBig->activate(_reactBig, 0.0f);
+	}
+	if (_color_rBig) {
+		_blocksBig->activate(_color_rBig, 0.0f);
+		_blocksBig->activate(_color_gBig, 0.0f);
+		_blocksBig->activate(_color_bBig, 0.0f);
+	}
+	_blocksBig->dilate(radius);
+}
+
 //////////////////////////////////////////////////////////////////////
 // Change noise type
 //
@@ -843,6 +883,8 @@ void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, floa
 
 	memset(_tcTemp, 0, sizeof(float)*_totalCellsSm);
 
+	// advection is skipped for blocks the smoke can't reach
+	updateActiveBlocks(dt, xvel, yvel, zvel);
 
 	// prepare textures
 	advectTextureCoordinates(dtOrg, xvel,yvel,zvel, tempDensityBig, tempBig);
@@ -1012,7 +1054,8 @@ void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, floa
       bigUy[index] = vel[1];
       bigUz[index] = vel[2];
 
-      // compute the velocity magnitude for substepping later
+      // compute the velocity magnitude for substepping later, this
+      // includes the cells advection skips so the substeps don't change
       const float velMag = bigUx[index] * bigUx[index] + 
                            bigUy[index] * bigUy[index] + 
                            bigUz[index] * bigUz[index];
@@ -1096,20 +1139,20 @@ void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, floa
 		int zEnd = (int)((float)(i+1)*partSize + 0.5f);
 #endif
 		FLUID_3D::advectFieldMacCormack1(dtSubdiv, bigUx, bigUy, bigUz, 
-		    _densityBigOld, tempDensityBig, _resBig, zBegin, zEnd);
+		    _densityBigOld, tempDensityBig, _resBig, zBegin, zEnd, _blocksBig);
 		if (_fuelBig) {
 			FLUID_3D::advectFieldMacCormack1(dtSubdiv, bigUx, bigUy, bigUz, 
-				_fuelBigOld, tempFuelBig, _resBig, zBegin, zEnd);
+				_fuelBigOld, tempFuelBig, _resBig, zBegin, zEnd, _blocksBig);
 			FLUID_3D::advectFieldMacCormack1(dtSubdiv, bigUx, bigUy, bigUz, 
-				_reactBigOld, tempReactBig, _resBig, zBegin, zEnd);
+				_reactBigOld, tempReactBig, _resBig, zBegin, zEnd, _blocksBig);
 		}
 		if (_color_rBig) {
 			FLUID_3D::advectFieldMacCormack1(dtSubdiv, bigUx, bigUy, bigUz, 
-				_color_rBigOld, tempColor_rBig, _resBig, zBegin, zEnd);
+				_color_rBigOld, tempColor_rBig, _resBig, zBegin, zEnd, _blocksBig);
 			FLUID_3D::advectFieldMacCormack1(dtSubdiv, bigUx, bigUy, bigUz, 
-				_color_gBigOld, tempColor_gBig, _resBig, zBegin, zEnd);
+				_color_gBigOld, tempColor_gBig, _resBig, zBegin, zEnd, _blocksBig);
 			FLUID_3D::advectFieldMacCormack1(dtSubdiv, bigUx, bigUy, bigUz, 
-				_color_bBigOld, tempColor_bBig, _resBig, zBegin, zEnd);
+				_color_bBigOld, tempColor_bBig, _resBig, zBegin, zEnd, _blocksBig);
 		}
 #if PARALLEL==1
 	}
@@ -1123,20 +1166,20 @@ void WTURBULENCE::stepTurbulenceFull(float dtOrg, float* xvel, float* yvel, floa
 		int zEnd = (int)((float)(i+1)*partSize + 0.5f);
 #endif
 		FLUID_3D::advectFieldMacCormack2(dtSubdiv, bigUx, bigUy, bigUz, 
-		    _densityBigOld, _densityBig, tempDensityBig, tempBig, _resBig, NULL, zBegin, zEnd);
+		    _densityBigOld, _densityBig, tempDensityBig, tempBig, _resBig, NULL, zBegin, zEnd, _blocksBig);
 		if (_fuelBig) {
 			FLUID_3D::advectFieldMacCormack2(dtSubdiv, bigUx, bigUy, bigUz, 
-				_fuelBigOld, _fuelBig, tempFuelBig, tempBig, _resBig, NULL, zBegin, zEnd);
+				_fuelBigOld, _fuelBig, tempFuelBig, tempBig, _resBig, NULL, zBegin, zEnd, _blocksBig);
 			FLUID_3D::advectFieldMacCormack2(dtSubdiv, bigUx, bigUy, bigUz, 
-				_reactBigOld, _reactBig, tempReactBig, tempBig, _resBig, NULL, zBegin, zEnd);
+				_reactBigOld, _reactBig, tempReactBig, tempBig, _resBig, NULL, zBegin, zEnd, _blocksBig);
 		}
 		if (_color_rBig) {
 			FLUID_3D::advectFieldMacCormack2(dtSubdiv, bigUx, bigUy, bigUz, 
-				_color_rBigOld, _color_rBig, tempColor_rBig, tempBig, _resBig, NULL, zBegin, zEnd);
+				_color_rBigOld, _color_rBig, tempColor_rBig, tempBig, _resBig, NULL, zBegin, zEnd, _blocksBig);
 			FLUID_3D::advectFieldMacCormack2(dtSubdiv, bigUx, bigUy, bigUz, 
-				_color_gBigOld, _color_gBig, tempColor_gBig, tempBig, _resBig, NULL, zBegin, zEnd);
+				_color_gBigOld, _color_gBig, tempColor_gBig, tempBig, _resBig, NULL, zBegin, zEnd, _blocksBig);
 			FLUID_3D::advectFieldMacCormack2(dtSubdiv, bigUx, bigUy, bigUz, 
-				_color_bBigOld, _color_bBig, tempColor_bBig, tempBig, _resBig, NULL, zBegin, zEnd);
+				_color_bBigOld, _color_bBig, tempColor_bBig, tempBig, _resBig, NULL, zBegin, zEnd, _blocksBig);
 		}
 #if PARALLEL==1
 	}
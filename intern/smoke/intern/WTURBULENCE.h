@@ -25,6 +25,7 @@
 #ifndef WTURBULENCE_H
 #define WTURBULENCE_H
 
+#include "BLOCK_MASK.h"
 #include "VEC3.h"
 using namespace BasicVector;
 class SIMPLE_PARSER;
@@ -129,6 +130,10 @@ struct WTURBULENCE
 		float* _color_bBig;
 		float* _color_bBigOld;
 
+		// bricks of the big grid smoke can reach during this step
+		BLOCK_MASK* _blocksBig;
+		void updateActiveBlocks(float dt, float* xvel, float* yvel, float* zvel);
+
 		// texture coordinates for noise
 		float* _tcU;
 		float* _tcV;
@@ -311,6 +311,7 @@ class DATA_PT_modifiers(ModifierButtonsPanel, Panel):
             row.prop(md, "vertex_group_factor")
 
             col.prop(md, "use_collapse_triangulate")
+            col.prop(md, "use_collapse_parallel")
             row = col.split(percentage=0.75)
             row.prop(md, "use_symmetry")
             row.prop(md, "symmetry_axis", text="")
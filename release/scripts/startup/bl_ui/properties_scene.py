@@ -369,6 +369,7 @@ class SCENE_PT_rigid_body_world(SceneButtonsPanel, Panel):
             col = split.column()
             col.prop(rbw, "steps_per_second", text="Steps Per Second")
             col.prop(rbw, "solver_iterations", text="Solver Iterations")
+            col.prop(rbw, "threads")
 
 
 class SCENE_PT_rigid_body_cache(SceneButtonsPanel, Panel):
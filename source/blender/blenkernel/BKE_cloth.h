@@ -97,7 +97,10 @@ typedef struct Cloth {
 	struct MVertTri		*tri;
 	struct Implicit_Data	*implicit; 		/* our implicit solver connects to this pointer */
 	struct EdgeSet	 	*edgeset; 		/* used for selfcollisions */
-	int last_frame, pad4;
+	struct BVHTreeOverlap	*selfpairs;		/* self-collision pairs, reused between steps */
+	float (*selfpairs_co)[3];			/* vertex positions the self-collision pairs were found at */
+	unsigned int		selfpairs_num;
+	int last_frame;
 } Cloth;
 
 /**
@@ -235,7 +238,6 @@ int cloth_uses_vgroup(struct ClothModifierData *clmd);
 
 // needed for collision.c
 void bvhtree_update_from_cloth(struct ClothModifierData *clmd, bool moving);
-void bvhselftree_update_from_cloth(struct ClothModifierData *clmd, bool moving);
 
 // needed for button_object.c
 void cloth_clear_cache (struct Object *ob, struct ClothModifierData *clmd, float framenr );
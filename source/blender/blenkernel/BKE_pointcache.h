@@ -53,6 +53,8 @@
 
 /* Add the blendfile name after blendcache_ */
 #define PTCACHE_EXT ".bphys"
+/* extension of single file caches, must not contain PTCACHE_EXT */
+#define PTCACHE_CONTAINER_EXT ".bphc"
 #define PTCACHE_PATH "blendcache_"
 
 /* File open options, for BKE_ptcache_file_open */
@@ -112,6 +114,16 @@ typedef struct PTCacheData {
 typedef struct PTCacheFile {
 	FILE *fp;
 
+	/* when set, data is read from this memory instead of fp */
+	const unsigned char *mem;
+	size_t mem_len, mem_pos;
+	/* mapping of the file mem points into, or an allocated copy of the data when map_len is zero */
+	void *map;
+	size_t map_len;
+
+	/* single file cache the frame is stored in */
+	struct PTCacheContainer *container;
+
 	int frame, old_format;
 	unsigned int totpoint, type;
 	unsigned int data_types, flag;
@@ -333,6 +345,9 @@ void BKE_ptcache_mem_to_disk(struct PTCacheID *pid);
 /* Convert disk cache to memory cache and vice versa. Clears the cache that was converted. */
 void BKE_ptcache_toggle_disk_cache(struct PTCacheID *pid);
 
+/* Convert per frame disk cache files to a single file cache and vice versa. */
+void BKE_ptcache_toggle_single_file(struct PTCacheID *pid);
+
 /* Rename all disk cache files with a new name. Doesn't touch the actual content of the files. */
 void BKE_ptcache_disk_cache_rename(struct PTCacheID *pid, const char *name_src, const char *name_dst);
 
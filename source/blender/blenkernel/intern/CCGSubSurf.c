@@ -1248,6 +1248,11 @@ int ccgSubSurf_getSimpleSubdiv(const CCGSubSurf *ss)
 	return ss->meshIFC.simpleSubdiv;
 }
 
+int ccgSubSurf_getAllocMask(const CCGSubSurf *ss)
+{
+	return ss->allocMask;
+}
+
 /* Vert accessors */
 
 CCGVertHDL ccgSubSurf_getVertVertHandle(CCGVert *v)
@@ -71,7 +71,10 @@ typedef enum {
 
 /***/
 
-#define CCG_OMP_LIMIT	1000000
+/* Minimum amount of work (in grid elements) before CCG passes are run threaded. */
+#define CCG_TASK_LIMIT	1000000
+/* Minimum number of elements in a pass before switching to dynamic scheduling. */
+#define CCG_TASK_DYNAMIC_LIMIT	1024
 
 /***/
 
@@ -125,6 +128,7 @@ int			ccgSubSurf_getEdgeLevelSize			(const CCGSubSurf *ss, int level);
 int			ccgSubSurf_getGridSize				(const CCGSubSurf *ss);
 int			ccgSubSurf_getGridLevelSize			(const CCGSubSurf *ss, int level);
 int			ccgSubSurf_getSimpleSubdiv			(const CCGSubSurf *ss);
+int			ccgSubSurf_getAllocMask				(const CCGSubSurf *ss);
 
 CCGVert*	ccgSubSurf_getVert					(CCGSubSurf *ss, CCGVertHDL v);
 CCGVertHDL	ccgSubSurf_getVertVertHandle		(CCGVert *v);
@@ -263,47 +263,6 @@ void bvhtree_update_from_cloth(ClothModifierData *clmd, bool moving)
 	}
 }
 
-void bvhselftree_update_from_cloth(ClothModifierData *clmd, bool moving)
-{	
-	unsigned int i = 0;
-	Cloth *cloth = clmd->clothObject;
-	BVHTree *bvhtree = cloth->bvhselftree;
-	ClothVertex *verts = cloth->verts;
-	const MVertTri *vt;
-	
-	if (!bvhtree)
-		return;
-
-	vt = cloth->tri;
-
-	/* update vertex position in bvh tree */
-	if (verts && vt) {
-		for (i = 0; i < cloth->mvert_num; i++, verts++) {
-			const float *co, *co_moving;
-			bool ret;
-
-			co = verts->txold;
-
-			/* copy new locations into array */
-			if (moving) {
-				/* update moving positions */
-				co_moving = verts->tx;
-				ret = BLI_bvhtree_update_node(bvhtree, i, co, co_moving, 1);
-			}
-			else {
-				ret = BLI_bvhtree_update_node(bvhtree, i, co, NULL, 1);
-			}
-
-			/* check if tree is already full */
-			if (ret == false) {
-				break;
-			}
-		}
-		
-		BLI_bvhtree_update_tree(bvhtree);
-	}
-}
-
 void cloth_clear_cache(Object *ob, ClothModifierData *clmd, float framenr)
 {
 	PTCacheID pid;
@@ -545,6 +504,12 @@ void cloth_free_modifier(ClothModifierData *clmd )
 		if ( cloth->bvhselftree )
 			BLI_bvhtree_free ( cloth->bvhselftree );
 
+		if (cloth->selfpairs)
+			MEM_freeN(cloth->selfpairs);
+
+		if (cloth->selfpairs_co)
+			MEM_freeN(cloth->selfpairs_co);
+
 		// we save our faces for collision objects
 		if (cloth->tri)
 			MEM_freeN(cloth->tri);
@@ -611,6 +576,12 @@ void cloth_free_modifier_extern(ClothModifierData *clmd )
 		if ( cloth->bvhselftree )
 			BLI_bvhtree_free ( cloth->bvhselftree );
 
+		if (cloth->selfpairs)
+			MEM_freeN(cloth->selfpairs);
+
+		if (cloth->selfpairs_co)
+			MEM_freeN(cloth->selfpairs_co);
+
 		// we save our faces for collision objects
 		if (cloth->tri)
 			MEM_freeN(cloth->tri);
@@ -44,6 +44,7 @@
 #include "BLI_blenlib.h"
 #include "BLI_math.h"
 #include "BLI_edgehash.h"
+#include "BLI_task.h"
 
 #include "BKE_cloth.h"
 #include "BKE_effect.h"
@@ -675,12 +676,210 @@ static int cloth_bvh_objcollisions_resolve ( ClothModifierData * clmd, Collision
 	return ret;
 }
 
+/* -------------------------------------------------------------------- */
+/* Cloth self-collisions */
+
+/* Leaves of the self-collision tree are inflated by its epsilon, so the pairs it returns
+ * stay a superset of all vertices within self-collision distance until some vertex has
+ * moved further than the remaining margin. Only then the tree is refitted and overlapped
+ * again, otherwise the pairs of the previous steps are reused. */
+static float cloth_selfcollision_margin(ClothModifierData *clmd)
+{
+	Cloth *cloth = clmd->clothObject;
+	float maxdist = 0.0f;
+	unsigned int i;
+
+	for (i = 0; i < cloth->mvert_num; i++) {
+		maxdist = max_ff(maxdist, clmd->coll_parms->selfepsilon * cloth->verts[i].avg_spring_len * 2.0f);
+	}
+
+	return BLI_bvhtree_get_epsilon(cloth->bvhselftree) - 0.5f * maxdist;
+}
+
+static bool cloth_selfcollision_pairs_valid(Cloth *cloth, const float margin)
+{
+	unsigned int i;
+
+	if (cloth->selfpairs_co == NULL || margin <= 0.0f)
+		return false;
+
+	for (i = 0; i < cloth->mvert_num; i++) {
+		const float *co = cloth->verts[i].tx, *co_pairs = cloth->selfpairs_co[i];
+
+		if ((fabsf(co[0] - co_pairs[0]) > margin) ||
+		    (fabsf(co[1] - co_pairs[1]) > margin) ||
+		    (fabsf(co[2] - co_pairs[2]) > margin))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* skip pairs which can never collide, so the narrowphase only sees candidates */
+static bool cloth_selfcollision_overlap_cb(void *userdata, int index_a, int index_b, int UNUSED(thread))
+{
+	ClothModifierData *clmd = userdata;
+	Cloth *cloth = clmd->clothObject;
+	const ClothVertex *verts = cloth->verts;
+
+	if (index_a >= index_b)
+		return false;
+
+	if (clmd->sim_parms->flags & CLOTH_SIMSETTINGS_FLAG_GOAL) {
+		if ((verts[index_a].flags & CLOTH_VERT_FLAG_PINNED) &&
+		    (verts[index_b].flags & CLOTH_VERT_FLAG_PINNED))
+		{
+			return false;
+		}
+	}
+
+	if ((verts[index_a].flags & CLOTH_VERT_FLAG_NOSELFCOLL) ||
+	    (verts[index_b].flags & CLOTH_VERT_FLAG_NOSELFCOLL))
+	{
+		return false;
+	}
+
+	return !BLI_edgeset_haskey(cloth->edgeset, index_a, index_b);
+}
+
+static void cloth_selfcollision_update_pairs(ClothModifierData *clmd)
+{
+	Cloth *cloth = clmd->clothObject;
+	BVHTree *bvhtree = cloth->bvhselftree;
+	unsigned int i;
+
+	if (cloth_selfcollision_pairs_valid(cloth, cloth_selfcollision_margin(clmd)))
+		return;
+
+	if (cloth->selfpairs_co == NULL) {
+		cloth->selfpairs_co = MEM_mallocN(sizeof(*cloth->selfpairs_co) * cloth->mvert_num, "cloth selfpairs co");
+	}
+
+	for (i = 0; i < cloth->mvert_num; i++) {
+		copy_v3_v3(cloth->selfpairs_co[i], cloth->verts[i].tx);
+		BLI_bvhtree_update_node(bvhtree, i, cloth->selfpairs_co[i], NULL, 1);
+	}
+	BLI_bvhtree_update_tree(bvhtree);
+
+	if (cloth->selfpairs) {
+		MEM_freeN(cloth->selfpairs);
+	}
+	cloth->selfpairs = BLI_bvhtree_overlap(bvhtree, bvhtree, &cloth->selfpairs_num,
+	                                       cloth_selfcollision_overlap_cb, clmd);
+}
+
+typedef struct SelfCollisionData {
+	ClothModifierData *clmd;
+	const BVHTreeOverlap *pairs;
+	float (*delta)[2][3];
+	bool *hit;
+} SelfCollisionData;
+
+static void cloth_selfcollision_pair_cb(void *userdata, const int index)
+{
+	SelfCollisionData *data = userdata;
+	ClothModifierData *clmd = data->clmd;
+	const ClothVertex *verts = clmd->clothObject->verts;
+	const unsigned int i = data->pairs[index].indexA;
+	const unsigned int j = data->pairs[index].indexB;
+	float (*delta)[3] = data->delta[index];
+	float temp[3];
+	float length, mindistance;
+
+	data->hit[index] = false;
+
+	mindistance = clmd->coll_parms->selfepsilon * (verts[i].avg_spring_len + verts[j].avg_spring_len);
+
+	sub_v3_v3v3(temp, verts[i].tx, verts[j].tx);
+
+	if ((fabsf(temp[0]) > mindistance) || (fabsf(temp[1]) > mindistance) || (fabsf(temp[2]) > mindistance))
+		return;
+
+	length = normalize_v3(temp);
+
+	if (length < mindistance) {
+		float correction = mindistance - length;
+
+		zero_v3(delta[0]);
+		zero_v3(delta[1]);
+
+		if (verts[i].flags & CLOTH_VERT_FLAG_PINNED) {
+			mul_v3_v3fl(delta[1], temp, -correction);
+		}
+		else if (verts[j].flags & CLOTH_VERT_FLAG_PINNED) {
+			mul_v3_v3fl(delta[0], temp, correction);
+		}
+		else {
+			mul_v3_v3fl(delta[0], temp, correction * 0.5f);
+			mul_v3_v3fl(delta[1], temp, correction * -0.5f);
+		}
+		data->hit[index] = true;
+	}
+}
+
+/* Corrections are computed for all pairs in parallel from the same positions, then averaged
+ * per vertex in pair order, so the result doesn't depend on the number of threads. */
+static bool cloth_selfcollision_resolve(ClothModifierData *clmd)
+{
+	Cloth *cloth = clmd->clothObject;
+	const unsigned int pairs_num = cloth->selfpairs_num;
+	SelfCollisionData data;
+	float (*accum)[3];
+	int *accum_num;
+	bool ret = false;
+	unsigned int k, i;
+
+	if (pairs_num == 0)
+		return false;
+
+	data.clmd = clmd;
+	data.pairs = cloth->selfpairs;
+	data.delta = MEM_mallocN(sizeof(*data.delta) * pairs_num, "cloth selfcollision delta");
+	data.hit = MEM_mallocN(sizeof(*data.hit) * pairs_num, "cloth selfcollision hit");
+
+	BLI_task_parallel_range(0, (int)pairs_num, &data, cloth_selfcollision_pair_cb, pairs_num > 1024);
+
+	accum = MEM_callocN(sizeof(*accum) * cloth->mvert_num, "cloth selfcollision accum");
+	accum_num = MEM_callocN(sizeof(*accum_num) * cloth->mvert_num, "cloth selfcollision accum num");
+
+	for (k = 0; k < pairs_num; k++) {
+		const unsigned int pair[2] = {data.pairs[k].indexA, data.pairs[k].indexB};
+		int n;
+
+		if (!data.hit[k])
+			continue;
+
+		for (n = 0; n < 2; n++) {
+			if (!is_zero_v3(data.delta[k][n])) {
+				add_v3_v3(accum[pair[n]], data.delta[k][n]);
+				accum_num[pair[n]]++;
+			}
+		}
+		ret = true;
+	}
+
+	for (i = 0; i < cloth->mvert_num; i++) {
+		if (accum_num[i]) {
+			madd_v3_v3fl(cloth->verts[i].tx, accum[i], 1.0f / (float)accum_num[i]);
+		}
+	}
+
+	MEM_freeN(data.delta);
+	MEM_freeN(data.hit);
+	MEM_freeN(accum);
+	MEM_freeN(accum_num);
+
+	return ret;
+}
+
 // cloth - object collisions
 int cloth_bvh_objcollision(Object *ob, ClothModifierData *clmd, float step, float dt )
 {
 	Cloth *cloth= clmd->clothObject;
 	BVHTree *cloth_bvh= cloth->bvhtree;
-	unsigned int i=0, /* numfaces = 0, */ /* UNUSED */ mvert_num = 0, k, l, j;
+	unsigned int i=0, /* numfaces = 0, */ /* UNUSED */ mvert_num = 0, l;
 	int rounds = 0; // result counts applied collisions; ic is for debug output;
 	ClothVertex *verts = NULL;
 	int ret = 0, ret2 = 0;
@@ -700,7 +899,6 @@ int cloth_bvh_objcollision(Object *ob, ClothModifierData *clmd, float step, floa
 
 	// update cloth bvh
 	bvhtree_update_from_cloth ( clmd, 1 ); // 0 means STATIC, 1 means MOVING (see later in this function)
-	bvhselftree_update_from_cloth ( clmd, 0 ); // 0 means STATIC, 1 means MOVING (see later in this function)
 	
 	collobjs = get_collisionobjects(clmd->scene, ob, clmd->coll_parms->group, &numcollobj, eModifierType_Collision);
 	
@@ -787,84 +985,13 @@ int cloth_bvh_objcollision(Object *ob, ClothModifierData *clmd, float step, floa
 		if ( clmd->coll_parms->flags & CLOTH_COLLSETTINGS_FLAG_SELF ) {
 			for (l = 0; l < (unsigned int)clmd->coll_parms->self_loop_count; l++) {
 				/* TODO: add coll quality rounds again */
-				BVHTreeOverlap *overlap = NULL;
-				unsigned int result = 0;
-	
-				// collisions = 1;
-				verts = cloth->verts; // needed for openMP
-	
-				/* numfaces = cloth->numfaces; */ /* UNUSED */
-				mvert_num = cloth->mvert_num;
-	
-				verts = cloth->verts;
-	
 				if ( cloth->bvhselftree ) {
-					// search for overlapping collision pairs
-					overlap = BLI_bvhtree_overlap(cloth->bvhselftree, cloth->bvhselftree, &result, NULL, NULL);
-	
-	// #pragma omp parallel for private(k, i, j) schedule(static)
-					for ( k = 0; k < result; k++ ) {
-						float temp[3];
-						float length = 0;
-						float mindistance;
-	
-						i = overlap[k].indexA;
-						j = overlap[k].indexB;
-	
-						mindistance = clmd->coll_parms->selfepsilon* ( cloth->verts[i].avg_spring_len + cloth->verts[j].avg_spring_len );
-	
-						if ( clmd->sim_parms->flags & CLOTH_SIMSETTINGS_FLAG_GOAL ) {
-							if ( ( cloth->verts [i].flags & CLOTH_VERT_FLAG_PINNED ) &&
-							     ( cloth->verts [j].flags & CLOTH_VERT_FLAG_PINNED ) )
-							{
-								continue;
-							}
-						}
-
-						if ((cloth->verts[i].flags & CLOTH_VERT_FLAG_NOSELFCOLL) ||
-						    (cloth->verts[j].flags & CLOTH_VERT_FLAG_NOSELFCOLL))
-						{
-							continue;
-						}
-	
-						sub_v3_v3v3(temp, verts[i].tx, verts[j].tx);
-	
-						if ( ( ABS ( temp[0] ) > mindistance ) || ( ABS ( temp[1] ) > mindistance ) || ( ABS ( temp[2] ) > mindistance ) ) continue;
-	
-						if (BLI_edgeset_haskey(cloth->edgeset, i, j)) {
-							continue;
-						}
-	
-						length = normalize_v3(temp );
-	
-						if ( length < mindistance ) {
-							float correction = mindistance - length;
-	
-							if ( cloth->verts [i].flags & CLOTH_VERT_FLAG_PINNED ) {
-								mul_v3_fl(temp, -correction);
-								VECADD ( verts[j].tx, verts[j].tx, temp );
-							}
-							else if ( cloth->verts [j].flags & CLOTH_VERT_FLAG_PINNED ) {
-								mul_v3_fl(temp, correction);
-								VECADD ( verts[i].tx, verts[i].tx, temp );
-							}
-							else {
-								mul_v3_fl(temp, correction * -0.5f);
-								VECADD ( verts[j].tx, verts[j].tx, temp );
-	
-								sub_v3_v3v3(verts[i].tx, verts[i].tx, temp);
-							}
-							ret = 1;
-							ret2 += ret;
-						}
-						else {
-							// check for approximated time collisions
-						}
+					cloth_selfcollision_update_pairs(clmd);
+
+					if (cloth_selfcollision_resolve(clmd)) {
+						ret = 1;
+						ret2 += ret;
 					}
-	
-					if ( overlap )
-						MEM_freeN ( overlap );
-	
 				}
 			}
 			////////////////////////////////////////////////////////////
@@ -2843,9 +2843,12 @@ void CustomData_bmesh_free_block_data(CustomData *data, void *block)
 		memset(block, 0, data->totsize);
 }
 
-static void CustomData_bmesh_alloc_block(CustomData *data, void **block)
+/**
+ * Allocate a block without initializing it (frees \a block first when set).
+ * \note Not thread safe, the data is allocated from the layer pool.
+ */
+void CustomData_bmesh_alloc_block(CustomData *data, void **block)
 {
-
 	if (*block)
 		CustomData_bmesh_free_block(data, block);
 
@@ -3678,6 +3678,15 @@ static void dynamicPaint_brushObjectCalculateVelocity(Scene *scene, Object *ob,
 	mul_v3_fl(brushVel->v, 1.0f / timescale);
 }
 
+/* Append surface points of a grid cell to a point list, returns the new list length.
+ * Brushes gather all cells they reach first, so their BVH/KD-tree queries run as a single
+ * parallel range instead of one small (often single threaded) range per cell. */
+static int grid_appendCellPoints(const VolumeGrid *grid, const int c_index, int *points, const int totpoints)
+{
+	memcpy(&points[totpoints], &grid->t_index[grid->s_pos[c_index]], sizeof(*points) * grid->s_num[c_index]);
+	return totpoints + grid->s_num[c_index];
+}
+
 typedef struct DynamicPaintPaintData {
 	const DynamicPaintSurface *surface;
 	const DynamicPaintBrushSettings *brush;
@@ -3685,7 +3694,7 @@ typedef struct DynamicPaintPaintData {
 	const BrushMaterials *bMats;
 	const Scene *scene;
 	const float timescale;
-	const int c_index;
+	const int *points;  /* surface point indices of all grid cells reached by the brush */
 
 	DerivedMesh *dm;
 	const MVert *mvert;
@@ -3714,7 +3723,6 @@ static void dynamic_paint_paint_mesh_cell_point_cb_ex(
 	const DynamicPaintSurface *surface = data->surface;
 	const PaintSurfaceData *sData = surface->data;
 	const PaintBakeData *bData = sData->bData;
-	VolumeGrid *grid = bData->grid;
 
 	const DynamicPaintBrushSettings *brush = data->brush;
 	Object *brushOb = data->brushOb;
@@ -3722,7 +3730,6 @@ static void dynamic_paint_paint_mesh_cell_point_cb_ex(
 
 	const Scene *scene = data->scene;
 	const float timescale = data->timescale;
-	const int c_index = data->c_index;
 
 	DerivedMesh *dm = data->dm;
 	const MVert *mvert = data->mvert;
@@ -3734,7 +3741,7 @@ static void dynamic_paint_paint_mesh_cell_point_cb_ex(
 
 	BVHTreeFromMesh *treeData = data->treeData;
 
-	const int index = grid->t_index[grid->s_pos[c_index] + id];
+	const int index = data->points[id];
 	const int samples = bData->s_num[index];
 	int ss;
 	float total_sample = (float)samples;
@@ -4106,6 +4113,8 @@ static int dynamicPaint_paintMesh(DynamicPaintSurface *surface,
 			if (bvhtree_from_mesh_looptri(&treeData, dm, 0.0f, 4, 8)) {
 				int c_index;
 				int total_cells = grid->dim[0] * grid->dim[1] * grid->dim[2];
+				int *points = MEM_mallocN(sizeof(*points) * sData->total_points, __func__);
+				int totpoints = 0;
 
 				/* loop through space partitioning grid */
 				for (c_index = 0; c_index < total_cells; c_index++) {
@@ -4115,20 +4124,23 @@ static int dynamicPaint_paintMesh(DynamicPaintSurface *surface,
 					{
 						continue;
 					}
-
-					/* loop through cell points and process brush */
-					DynamicPaintPaintData data = {
-					    .surface = surface,
-					    .brush = brush, .brushOb = brushOb, .bMats = bMats,
-					    .scene = scene, .timescale = timescale, .c_index = c_index,
-					    .dm = dm, .mvert = mvert, .mloop = mloop, .mlooptri = mlooptri,
-					    .brush_radius = brush_radius, .avg_brushNor = avg_brushNor, .brushVelocity = brushVelocity,
-					    .treeData = &treeData
-					};
-					BLI_task_parallel_range_ex(0, grid->s_num[c_index], &data, NULL, 0,
-					                           dynamic_paint_paint_mesh_cell_point_cb_ex,
-					                           grid->s_num[c_index] > 250, true);
+					totpoints = grid_appendCellPoints(grid, c_index, points, totpoints);
 				}
+
+				/* process brush for points of all intersecting cells at once */
+				DynamicPaintPaintData data = {
+				    .surface = surface,
+				    .brush = brush, .brushOb = brushOb, .bMats = bMats,
+				    .scene = scene, .timescale = timescale, .points = points,
+				    .dm = dm, .mvert = mvert, .mloop = mloop, .mlooptri = mlooptri,
+				    .brush_radius = brush_radius, .avg_brushNor = avg_brushNor, .brushVelocity = brushVelocity,
+				    .treeData = &treeData
+				};
+				BLI_task_parallel_range_ex(0, totpoints, &data, NULL, 0,
+				                           dynamic_paint_paint_mesh_cell_point_cb_ex,
+				                           totpoints > 250, true);
+
+				MEM_freeN(points);
 			}
 		}
 		/* free bvh tree */
@@ -4155,14 +4167,12 @@ static void dynamic_paint_paint_particle_cell_point_cb_ex(
 	const DynamicPaintSurface *surface = data->surface;
 	const PaintSurfaceData *sData = surface->data;
 	const PaintBakeData *bData = sData->bData;
-	VolumeGrid *grid = bData->grid;
 
 	const DynamicPaintBrushSettings *brush = data->brush;
 
 	const ParticleSystem *psys = data->psys;
 
 	const float timescale = data->timescale;
-	const int c_index = data->c_index;
 
 	KDTree *tree = data->treeData;
 
@@ -4171,7 +4181,7 @@ static void dynamic_paint_paint_particle_cell_point_cb_ex(
 	const float range = solidradius + smooth;
 	const float particle_timestep = 0.04f * psys->part->timetweak;
 
-	const int index = grid->t_index[grid->s_pos[c_index] + id];
+	const int index = data->points[id];
 	float disp_intersect = 0.0f;
 	float radius = 0.0f;
 	float strength = 0.0f;
@@ -4390,6 +4400,8 @@ static int dynamicPaint_paintParticles(DynamicPaintSurface *surface,
 	if (boundsIntersectDist(&grid->grid_bounds, &part_bb, range)) {
 		int c_index;
 		int total_cells = grid->dim[0] * grid->dim[1] * grid->dim[2];
+		int *points = MEM_mallocN(sizeof(*points) * sData->total_points, __func__);
+		int totpoints = 0;
 
 		/* balance tree	*/
 		BLI_kdtree_balance(tree);
@@ -4402,18 +4414,21 @@ static int dynamicPaint_paintParticles(DynamicPaintSurface *surface,
 			{
 				continue;
 			}
-
-			/* loop through cell points */
-			DynamicPaintPaintData data = {
-			    .surface = surface,
-			    .brush = brush, .psys = psys,
-			    .solidradius = solidradius, .timescale = timescale, .c_index = c_index,
-			    .treeData = tree,
-			};
-			BLI_task_parallel_range_ex(0, grid->s_num[c_index], &data, NULL, 0,
-			                           dynamic_paint_paint_particle_cell_point_cb_ex,
-			                           grid->s_num[c_index] > 250, true);
+			totpoints = grid_appendCellPoints(grid, c_index, points, totpoints);
 		}
+
+		/* loop through points of all intersecting cells */
+		DynamicPaintPaintData data = {
+		    .surface = surface,
+		    .brush = brush, .psys = psys,
+		    .solidradius = solidradius, .timescale = timescale, .points = points,
+		    .treeData = tree,
+		};
+		BLI_task_parallel_range_ex(0, totpoints, &data, NULL, 0,
+		                           dynamic_paint_paint_particle_cell_point_cb_ex,
+		                           totpoints > 250, true);
+
+		MEM_freeN(points);
 	}
 	BLI_end_threaded_malloc();
 	BLI_kdtree_free(tree);
@@ -4907,14 +4922,17 @@ static void dynamic_paint_effect_spread_cb(void *userdata, const int index)
 
 	const DynamicPaintSurface *surface = data->surface;
 	const PaintSurfaceData *sData = surface->data;
+	PaintPoint *pPoint = &((PaintPoint *)sData->type_data)[index];
+	const PaintPoint *prevPoint = data->prevPoint;
+
+	/* buffers are swapped, so every point starts from its previous state */
+	*pPoint = prevPoint[index];
 
 	if (sData->adj_data->flags[index] & ADJ_BORDER_PIXEL)
 		return;
 
 	const int numOfNeighs = sData->adj_data->n_num[index];
 	BakeAdjPoint *bNeighs = sData->bData->bNeighs;
-	PaintPoint *pPoint = &((PaintPoint *)sData->type_data)[index];
-	const PaintPoint *prevPoint = data->prevPoint;
 	const float eff_scale = data->eff_scale;
 
 	const int *n_index = sData->adj_data->n_index;
@@ -4952,14 +4970,17 @@ static void dynamic_paint_effect_shrink_cb(void *userdata, const int index)
 
 	const DynamicPaintSurface *surface = data->surface;
 	const PaintSurfaceData *sData = surface->data;
+	PaintPoint *pPoint = &((PaintPoint *)sData->type_data)[index];
+	const PaintPoint *prevPoint = data->prevPoint;
+
+	/* buffers are swapped, so every point starts from its previous state */
+	*pPoint = prevPoint[index];
 
 	if (sData->adj_data->flags[index] & ADJ_BORDER_PIXEL)
 		return;
 
 	const int numOfNeighs = sData->adj_data->n_num[index];
 	BakeAdjPoint *bNeighs = sData->bData->bNeighs;
-	PaintPoint *pPoint = &((PaintPoint *)sData->type_data)[index];
-	const PaintPoint *prevPoint = data->prevPoint;
 	const float eff_scale = data->eff_scale;
 	float totalAlpha = 0.0f;
 
@@ -5106,8 +5127,17 @@ static void dynamic_paint_effect_drip_cb(void *userdata, const int index)
 	}
 }
 
+/* Swap surface data with the scratch buffer, so the current state becomes the previous one.
+ * Passes using this write every point of the new state, which saves copying the whole surface. */
+static void *surface_swapPrevPoints(PaintSurfaceData *sData, void *prevPoint)
+{
+	void *curPoint = sData->type_data;
+	sData->type_data = prevPoint;
+	return curPoint;
+}
+
 static void dynamicPaint_doEffectStep(
-        DynamicPaintSurface *surface, float *force, PaintPoint *prevPoint, float timescale, float steps)
+        DynamicPaintSurface *surface, float *force, PaintPoint **prevPoint, float timescale, float steps)
 {
 	PaintSurfaceData *sData = surface->data;
 
@@ -5123,11 +5153,11 @@ static void dynamicPaint_doEffectStep(
 	if (surface->effect & MOD_DPAINT_EFFECT_DO_SPREAD) {
 		const float eff_scale = distance_scale * EFF_MOVEMENT_PER_FRAME * surface->spread_speed * timescale;
 
-		/* Copy current surface to the previous points array to read unmodified values	*/
-		memcpy(prevPoint, sData->type_data, sData->total_points * sizeof(struct PaintPoint));
+		/* Read unmodified values from the previous state */
+		*prevPoint = surface_swapPrevPoints(sData, *prevPoint);
 
 		DynamicPaintEffectData data = {
-			.surface = surface, .prevPoint = prevPoint, .eff_scale = eff_scale,
+			.surface = surface, .prevPoint = *prevPoint, .eff_scale = eff_scale,
 		};
 		BLI_task_parallel_range(
 		            0, sData->total_points, &data, dynamic_paint_effect_spread_cb, sData->total_points > 1000);
@@ -5139,11 +5169,11 @@ static void dynamicPaint_doEffectStep(
 	if (surface->effect & MOD_DPAINT_EFFECT_DO_SHRINK) {
 		const float eff_scale = distance_scale * EFF_MOVEMENT_PER_FRAME * surface->shrink_speed * timescale;
 
-		/* Copy current surface to the previous points array to read unmodified values	*/
-		memcpy(prevPoint, sData->type_data, sData->total_points * sizeof(struct PaintPoint));
+		/* Read unmodified values from the previous state */
+		*prevPoint = surface_swapPrevPoints(sData, *prevPoint);
 
 		DynamicPaintEffectData data = {
-			.surface = surface, .prevPoint = prevPoint, .eff_scale = eff_scale,
+			.surface = surface, .prevPoint = *prevPoint, .eff_scale = eff_scale,
 		};
 		BLI_task_parallel_range(
 		            0, sData->total_points, &data, dynamic_paint_effect_shrink_cb, sData->total_points > 1000);
@@ -5159,11 +5189,12 @@ static void dynamicPaint_doEffectStep(
 		const size_t point_locks_size = (sData->total_points / 8) + 1;
 		uint8_t *point_locks = MEM_callocN(sizeof(*point_locks) * point_locks_size, __func__);
 
-		/* Copy current surface to the previous points array to read unmodified values	*/
-		memcpy(prevPoint, sData->type_data, sData->total_points * sizeof(struct PaintPoint));
+		/* Copy current surface to the previous points array to read unmodified values,
+		 * dripping moves paint to neighbors so it can't write every point from the previous state */
+		memcpy(*prevPoint, sData->type_data, sData->total_points * sizeof(struct PaintPoint));
 
 		DynamicPaintEffectData data = {
-		    .surface = surface, .prevPoint = prevPoint,
+		    .surface = surface, .prevPoint = *prevPoint,
 		    .eff_scale = eff_scale, .force = force,
 		    .point_locks = point_locks,
 		};
@@ -5270,6 +5301,9 @@ static void dynamic_paint_wave_step_cb(void *userdata, const int index)
 	float force = 0.0f, avg_dist = 0.0f, avg_height = 0.0f, avg_n_height = 0.0f;
 	int numOfN = 0, numOfRN = 0;
 
+	/* buffers are swapped, so every point starts from its previous state */
+	*wPoint = prevPoint[index];
+
 	if (wPoint->state > 0)
 		return;
 
@@ -5343,15 +5377,14 @@ static void dynamic_paint_wave_step_cb(void *userdata, const int index)
 static void dynamicPaint_doWaveStep(DynamicPaintSurface *surface, float timescale)
 {
 	PaintSurfaceData *sData = surface->data;
-	BakeAdjPoint *bNeighs = sData->bData->bNeighs;
-	int index;
 	int steps, ss;
 	float dt, min_dist, damp_factor;
 	const float wave_speed = surface->wave_speed;
 	const float wave_max_slope = (surface->wave_smoothness >= 0.01f) ? (0.5f / surface->wave_smoothness) : 0.0f;
-	double average_dist = 0.0f;
 	const float canvas_size = getSurfaceDimension(sData);
 	const float wave_scale = CANVAS_REL_SIZE / canvas_size;
+	/* average neigh distance, already summed up along with the adjacency distances */
+	const double average_dist = sData->bData->average_dist * (double)wave_scale;
 
 	/* allocate memory */
 	PaintWavePoint *prevPoint = MEM_mallocN(
@@ -5359,17 +5392,6 @@ static void dynamicPaint_doWaveStep(DynamicPaintSurface *surface, float timescal
 	if (!prevPoint)
 		return;
 
-	/* calculate average neigh distance (single thread) */
-	for (index = 0; index < sData->total_points; index++) {
-		int i;
-		int numOfNeighs = sData->adj_data->n_num[index];
-
-		for (i = 0; i < numOfNeighs; i++) {
-			average_dist += (double)bNeighs[sData->adj_data->n_index[index] + i].dist;
-		}
-	}
-	average_dist  *= (double)wave_scale / sData->adj_data->total_targets;
-
 	/* determine number of required steps */
 	steps = (int)ceil((double)(WAVE_TIME_FAC * timescale * surface->wave_timescale) /
 	                  (average_dist / (double)wave_speed / 3));
@@ -5382,8 +5404,8 @@ static void dynamicPaint_doWaveStep(DynamicPaintSurface *surface, float timescal
 	damp_factor = pow((1.0f - surface->wave_damping), timescale * surface->wave_timescale);
 
 	for (ss = 0; ss < steps; ss++) {
-		/* copy previous frame data */
-		memcpy(prevPoint, sData->type_data, sData->total_points * sizeof(PaintWavePoint));
+		/* read previous frame data */
+		prevPoint = surface_swapPrevPoints(sData, prevPoint);
 
 		DynamicPaintEffectData data = {
 		    .surface = surface, .prevPoint = prevPoint,
@@ -5911,7 +5933,7 @@ static int dynamicPaint_doStep(Scene *scene, Object *ob, DynamicPaintSurface *su
 			/* Prepare effects and get number of required steps */
 			steps = dynamicPaint_prepareEffectStep(surface, scene, ob, &force, timescale);
 			for (s = 0; s < steps; s++) {
-				dynamicPaint_doEffectStep(surface, force, prevPoint, timescale, (float)steps);
+				dynamicPaint_doEffectStep(surface, force, &prevPoint, timescale, (float)steps);
 			}
 
 			/* Free temporary effect data	*/
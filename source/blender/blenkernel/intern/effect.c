@@ -976,6 +976,48 @@ static void do_physical_effector(EffectorCache *eff, EffectorData *efd, Effected
  * flags		= only used for softbody wind now
  * guide		= old speed of particle
  */
+/* all contributions of one effector to a point */
+static void do_effector_point(EffectorCache *eff, ListBase *colliders, EffectorWeights *weights, EffectedPoint *point,
+                              float *force, float *impulse, int *step)
+{
+	EffectorData efd;
+	int p = 0, tot = 1;
+
+	get_effector_tot(eff, &efd, point, &tot, &p, step);
+
+	for (; p<tot; p+=*step) {
+		if (get_effector_data(eff, &efd, point, 0)) {
+			efd.falloff= effector_falloff(eff, &efd, point, weights);
+			
+			if (efd.falloff > 0.0f)
+				efd.falloff *= eff_calc_visibility(colliders, eff, &efd, point);
+
+			if (efd.falloff <= 0.0f) {
+				/* don't do anything */
+			}
+			else if (eff->pd->forcefield == PFIELD_TEXTURE) {
+				do_texture_effector(eff, &efd, point, force);
+			}
+			else {
+				float temp1[3] = {0, 0, 0}, temp2[3];
+				copy_v3_v3(temp1, force);
+
+				do_physical_effector(eff, &efd, point, force);
+				
+				/* for softbody backward compatibility */
+				if (point->flag & PE_WIND_AS_SPEED && impulse) {
+					sub_v3_v3v3(temp2, force, temp1);
+					sub_v3_v3v3(impulse, impulse, temp2);
+				}
+			}
+		}
+		else if (eff->flag & PE_VELOCITY_TO_IMPULSE && impulse) {
+			/* special case for harmonic effector */
+			add_v3_v3v3(impulse, impulse, efd.vel);
+		}
+	}
+}
+
 void pdDoEffectors(ListBase *effectors, ListBase *colliders, EffectorWeights *weights, EffectedPoint *point, float *force, float *impulse)
 {
 /*
@@ -992,48 +1034,36 @@ void pdDoEffectors(ListBase *effectors, ListBase *colliders, EffectorWeights *we
  *     (is independent of other effectors)
  */
 	EffectorCache *eff;
-	EffectorData efd;
-	int p=0, tot = 1, step = 1;
+	int step = 1;
 
 	/* Cycle through collected objects, get total of (1/(gravity_strength * dist^gravity_power)) */
 	/* Check for min distance here? (yes would be cool to add that, ton) */
 	
 	if (effectors) for (eff = effectors->first; eff; eff=eff->next) {
 		/* object effectors were fully checked to be OK to evaluate! */
+		do_effector_point(eff, colliders, weights, point, force, impulse, &step);
+	}
+}
 
-		get_effector_tot(eff, &efd, point, &tot, &p, &step);
+/* Same as pdDoEffectors for an array of points. Every effector is applied to all
+ * points before moving on to the next, so its data stays in cache. The forces
+ * are summed in the same order as with pdDoEffectors. */
+void pdDoEffectorsArray(ListBase *effectors, ListBase *colliders, EffectorWeights *weights, EffectedPoint *points, int totpoint,
+                        float (*force)[3], float (*impulse)[3])
+{
+	EffectorCache *eff;
+	int step = 1, i;
 
-		for (; p<tot; p+=step) {
-			if (get_effector_data(eff, &efd, point, 0)) {
-				efd.falloff= effector_falloff(eff, &efd, point, weights);
-				
-				if (efd.falloff > 0.0f)
-					efd.falloff *= eff_calc_visibility(colliders, eff, &efd, point);
+	if (effectors) for (eff = effectors->first; eff; eff=eff->next) {
+		/* the step only depends on the effector */
+		int point_step = step;
 
-				if (efd.falloff <= 0.0f) {
-					/* don't do anything */
-				}
-				else if (eff->pd->forcefield == PFIELD_TEXTURE) {
-					do_texture_effector(eff, &efd, point, force);
-				}
-				else {
-					float temp1[3] = {0, 0, 0}, temp2[3];
-					copy_v3_v3(temp1, force);
-
-					do_physical_effector(eff, &efd, point, force);
-					
-					/* for softbody backward compatibility */
-					if (point->flag & PE_WIND_AS_SPEED && impulse) {
-						sub_v3_v3v3(temp2, force, temp1);
-						sub_v3_v3v3(impulse, impulse, temp2);
-					}
-				}
-			}
-			else if (eff->flag & PE_VELOCITY_TO_IMPULSE && impulse) {
-				/* special case for harmonic effector */
-				add_v3_v3v3(impulse, impulse, efd.vel);
-			}
+		for (i = 0; i < totpoint; i++) {
+			point_step = step;
+			do_effector_point(eff, colliders, weights, &points[i], force[i], impulse ? impulse[i] : NULL, &point_step);
 		}
+
+		step = point_step;
 	}
 }
 
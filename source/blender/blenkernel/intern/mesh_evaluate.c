@@ -49,6 +49,7 @@
 #include "BLI_alloca.h"
 #include "BLI_stack.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_customdata.h"
 #include "BKE_global.h"
@@ -606,11 +607,9 @@ void BKE_lnor_space_custom_normal_to_data(MLoopNorSpace *lnor_space, const float
 	}
 }
 
-#define LOOP_SPLIT_TASK_BLOCK_SIZE 1024
-
 typedef struct LoopSplitTaskData {
 	/* Specific to each instance (each task). */
-	MLoopNorSpace *lnor_space;  /* We have to create those outside of tasks, since afaik memarena is not threadsafe. */
+	MLoopNorSpace *lnor_space;  /* Taken from the thread's block of lnor spaces, see loop_split_lnor_space_create(). */
 	float (*lnor)[3];
 	const MLoop *ml_curr;
 	const MLoop *ml_prev;
@@ -630,10 +629,12 @@ typedef struct LoopSplitTaskDataCommon {
 	 * Note we do not need to protect it, though, since two different tasks will *always* affect different
 	 * elements in the arrays. */
 	MLoopNorSpaceArray *lnors_spacearr;
-	BLI_bitmap *sharp_verts;
 	float (*loopnors)[3];
 	short (*clnors_data)[2];
 
+	/* Protects the (not threadsafe) memarena of lnors_spacearr, see loop_split_lnor_space_create(). */
+	SpinLock lnor_spaces_lock;
+
 	/* Read-only. */
 	const MVert *mverts;
 	const MEdge *medges;
@@ -643,12 +644,25 @@ typedef struct LoopSplitTaskDataCommon {
 	const int *loop_to_poly;
 	const float (*polynors)[3];
 
+	/* Only used when computing lnor spacearr: vertices having at least one sharp edge,
+	 * and first loop (in polys order) of each vertex, which starts the fan of 'full smooth' vertices. */
+	const BLI_bitmap *sharp_verts;
+	const int *vert_fan_start;
+
 	int numPolys;
+} LoopSplitTaskDataCommon;
 
-	/* ***** Workers communication. ***** */
-	ThreadQueue *task_queue;
+/* Per-thread data of the split normals tasks. */
+typedef struct LoopSplitTaskDataTLS {
+	/* Temp edge vectors stack, only used when computing lnor spacearr, created on demand. */
+	BLI_Stack *edge_vectors;
+	/* Block of lnor spaces reserved by this thread, and how many of them are still unused. */
+	MLoopNorSpace *lnor_spaces;
+	int lnor_spaces_len;
+} LoopSplitTaskDataTLS;
 
-} LoopSplitTaskDataCommon;
+/* Number of lnor spaces a thread reserves at once. */
+#define LOOP_SPLIT_LNOR_SPACE_BLOCK_SIZE 256
 
 #define INDEX_UNSET INT_MIN
 #define INDEX_INVALID -1
@@ -955,190 +969,104 @@ static void loop_split_worker_do(
 	}
 }
 
-static void loop_split_worker(TaskPool * __restrict UNUSED(pool), void *taskdata, int UNUSED(threadid))
+/* Whether given loop starts a task, i.e. it is either a 'single' loop, or the first loop of a smooth fan.
+ * This only reads data computed before tasks are started, so it gives the same result in any thread and order. */
+BLI_INLINE bool loop_split_is_task(const LoopSplitTaskDataCommon *common_data, const MLoop *ml_curr, const int ml_curr_index)
 {
-	LoopSplitTaskDataCommon *common_data = taskdata;
-	LoopSplitTaskData *data_buff;
-
-	/* Temp edge vectors stack, only used when computing lnor spacearr. */
-	BLI_Stack *edge_vectors = common_data->lnors_spacearr ? BLI_stack_new(sizeof(float[3]), __func__) : NULL;
-
-#ifdef DEBUG_TIME
-	TIMEIT_START(loop_split_worker);
-#endif
-
-	while ((data_buff = BLI_thread_queue_pop(common_data->task_queue))) {
-		LoopSplitTaskData *data = data_buff;
-		int i;
+	const int *e2l_curr = common_data->edge_to_loops[ml_curr->e];
 
-		for (i = 0; i < LOOP_SPLIT_TASK_BLOCK_SIZE; i++, data++) {
-			/* A NULL ml_curr is used to tag ended data! */
-			if (data->ml_curr == NULL) {
-				break;
-			}
-			loop_split_worker_do(common_data, data, edge_vectors);
-		}
-
-		MEM_freeN(data_buff);
+	if (IS_EDGE_SHARP(e2l_curr)) {
+		return true;
 	}
 
-	if (edge_vectors) {
-		BLI_stack_free(edge_vectors);
+	/* A smooth edge. We skip it because it is either:
+	 * - in the middle of a 'smooth fan' already computed (or that will be as soon as we hit
+	 *   one of its ends, i.e. one of its two sharp edges), or...
+	 * - the related vertex is a "full smooth" one, in which case pre-populated normals from vertex
+	 *   are just fine, unless we need lnors spacearr, in which case its first loop handles the whole fan!
+	 */
+	return (common_data->lnors_spacearr &&
+	        !BLI_BITMAP_TEST_BOOL(common_data->sharp_verts, ml_curr->v) &&
+	        common_data->vert_fan_start[ml_curr->v] == ml_curr_index);
+}
+
+/* Lnor spaces are taken from blocks reserved by each thread, so the memarena lock is rarely waited for. */
+static MLoopNorSpace *loop_split_lnor_space_create(LoopSplitTaskDataCommon *common_data, LoopSplitTaskDataTLS *tls)
+{
+	if (tls->lnor_spaces_len == 0) {
+		BLI_spin_lock(&common_data->lnor_spaces_lock);
+		tls->lnor_spaces = BLI_memarena_calloc(
+		        common_data->lnors_spacearr->mem, sizeof(MLoopNorSpace) * LOOP_SPLIT_LNOR_SPACE_BLOCK_SIZE);
+		BLI_spin_unlock(&common_data->lnor_spaces_lock);
+		tls->lnor_spaces_len = LOOP_SPLIT_LNOR_SPACE_BLOCK_SIZE;
 	}
 
-#ifdef DEBUG_TIME
-	TIMEIT_END(loop_split_worker);
-#endif
+	tls->lnor_spaces_len--;
+	return tls->lnor_spaces++;
 }
 
-/* Note we use data_buff to detect whether we are in threaded context or not, in later case it is NULL. */
-static void loop_split_generator_do(LoopSplitTaskDataCommon *common_data, const bool threaded)
+static void loop_split_poly_cb(void *userdata, void *userdata_chunk, const int mp_index, const int UNUSED(thread_id))
 {
-	MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
-	BLI_bitmap *sharp_verts = common_data->sharp_verts;
-	float (*loopnors)[3] = common_data->loopnors;
+	LoopSplitTaskDataCommon *common_data = userdata;
+	LoopSplitTaskDataTLS *tls = userdata_chunk;
 
 	const MLoop *mloops = common_data->mloops;
-	const MPoly *mpolys = common_data->mpolys;
+	const MPoly *mp = &common_data->mpolys[mp_index];
 	const int (*edge_to_loops)[2] = common_data->edge_to_loops;
-	const int numPolys = common_data->numPolys;
-
-	const MPoly *mp;
-	int mp_index;
-
-	LoopSplitTaskData *data, *data_buff = NULL, data_mem;
-	int data_idx = 0;
-
-	/* Temp edge vectors stack, only used when computing lnor spacearr (and we are not multi-threading). */
-	BLI_Stack *edge_vectors = (lnors_spacearr && !data_buff) ? BLI_stack_new(sizeof(float[3]), __func__) : NULL;
-
-#ifdef DEBUG_TIME
-	TIMEIT_START(loop_split_generator);
-#endif
 
-	if (!threaded) {
-		memset(&data_mem, 0, sizeof(data_mem));
-		data = &data_mem;
-	}
-
-	/* We now know edges that can be smoothed (with their vector, and their two loops), and edges that will be hard!
-	 * Now, time to generate the normals.
-	 */
-	for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
-		const MLoop *ml_curr, *ml_prev;
-		float (*lnors)[3];
-		const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
-		int ml_curr_index = mp->loopstart;
-		int ml_prev_index = ml_last_index;
-
-		ml_curr = &mloops[ml_curr_index];
-		ml_prev = &mloops[ml_prev_index];
-		lnors = &loopnors[ml_curr_index];
-
-		for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++, lnors++) {
-			const int *e2l_curr = edge_to_loops[ml_curr->e];
-			const int *e2l_prev = edge_to_loops[ml_prev->e];
-
-			if (!IS_EDGE_SHARP(e2l_curr) && (!lnors_spacearr || BLI_BITMAP_TEST_BOOL(sharp_verts, ml_curr->v))) {
-				/* A smooth edge, and we are not generating lnor_spacearr, or the related vertex is sharp.
-				 * We skip it because it is either:
-				 * - in the middle of a 'smooth fan' already computed (or that will be as soon as we hit
-				 *   one of its ends, i.e. one of its two sharp edges), or...
-				 * - the related vertex is a "full smooth" one, in which case pre-populated normals from vertex
-				 *   are just fine (or it has already be handled in a previous loop in case of needed lnors spacearr)!
-				 */
-				/* printf("Skipping loop %d / edge %d / vert %d(%d)\n", ml_curr_index, ml_curr->e, ml_curr->v, sharp_verts[ml_curr->v]); */
-			}
-			else {
-				if (threaded) {
-					if (data_idx == 0) {
-						data_buff = MEM_callocN(sizeof(*data_buff) * LOOP_SPLIT_TASK_BLOCK_SIZE, __func__);
-					}
-					data = &data_buff[data_idx];
-				}
+	const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+	int ml_curr_index = mp->loopstart;
+	int ml_prev_index = ml_last_index;
 
-				if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
-					data->lnor = lnors;
-					data->ml_curr = ml_curr;
-					data->ml_prev = ml_prev;
-					data->ml_curr_index = ml_curr_index;
-#if 0  /* Not needed for 'single' loop. */
-					data->ml_prev_index = ml_prev_index;
-					data->e2l_prev = NULL;  /* Tag as 'single' task. */
-#endif
-					data->mp_index = mp_index;
-					if (lnors_spacearr) {
-						data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-					}
-				}
-				/* We *do not need* to check/tag loops as already computed!
-				 * Due to the fact a loop only links to one of its two edges, a same fan *will never be walked
-				 * more than once!*
-				 * Since we consider edges having neighbor polys with inverted (flipped) normals as sharp, we are sure
-				 * that no fan will be skipped, even only considering the case (sharp curr_edge, smooth prev_edge),
-				 * and not the alternative (smooth curr_edge, sharp prev_edge).
-				 * All this due/thanks to link between normals and loop ordering (i.e. winding).
-				 */
-				else {
-#if 0  /* Not needed for 'fan' loops. */
-					data->lnor = lnors;
-#endif
-					data->ml_curr = ml_curr;
-					data->ml_prev = ml_prev;
-					data->ml_curr_index = ml_curr_index;
-					data->ml_prev_index = ml_prev_index;
-					data->e2l_prev = e2l_prev;  /* Also tag as 'fan' task. */
-					data->mp_index = mp_index;
-					if (lnors_spacearr) {
-						data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-						/* Tag related vertex as sharp, to avoid fanning around it again (in case it was a smooth one).
-						 * This *has* to be done outside of workers tasks! */
-						BLI_BITMAP_ENABLE(sharp_verts, ml_curr->v);
-					}
-				}
+	for (; ml_curr_index <= ml_last_index; ml_prev_index = ml_curr_index++) {
+		const MLoop *ml_curr = &mloops[ml_curr_index];
+		const MLoop *ml_prev = &mloops[ml_prev_index];
+		LoopSplitTaskData data;
 
-				if (threaded) {
-					data_idx++;
-					if (data_idx == LOOP_SPLIT_TASK_BLOCK_SIZE) {
-						BLI_thread_queue_push(common_data->task_queue, data_buff);
-						data_idx = 0;
-					}
-				}
-				else {
-					loop_split_worker_do(common_data, data, edge_vectors);
-					memset(data, 0, sizeof(data_mem));
-				}
-			}
+		if (!loop_split_is_task(common_data, ml_curr, ml_curr_index)) {
+			continue;
+		}
 
-			ml_prev = ml_curr;
-			ml_prev_index = ml_curr_index;
+		memset(&data, 0, sizeof(data));
+		data.ml_curr = ml_curr;
+		data.ml_prev = ml_prev;
+		data.ml_curr_index = ml_curr_index;
+		data.mp_index = mp_index;
+		if (common_data->lnors_spacearr) {
+			data.lnor_space = loop_split_lnor_space_create(common_data, tls);
 		}
-	}
 
-	if (threaded) {
-		/* Last block of data... Since it is calloc'ed and we use first NULL item as stopper, everything is fine. */
-		if (LIKELY(data_idx)) {
-			BLI_thread_queue_push(common_data->task_queue, data_buff);
+		/* We *do not need* to check/tag loops as already computed!
+		 * Due to the fact a loop only links to one of its two edges, a same fan *will never be walked
+		 * more than once!*
+		 * Since we consider edges having neighbor polys with inverted (flipped) normals as sharp, we are sure
+		 * that no fan will be skipped, even only considering the case (sharp curr_edge, smooth prev_edge),
+		 * and not the alternative (smooth curr_edge, sharp prev_edge).
+		 * All this due/thanks to link between normals and loop ordering (i.e. winding).
+		 */
+		if (IS_EDGE_SHARP(edge_to_loops[ml_curr->e]) && IS_EDGE_SHARP(edge_to_loops[ml_prev->e])) {
+			data.lnor = &common_data->loopnors[ml_curr_index];
 		}
+		else {
+			data.ml_prev_index = ml_prev_index;
+			data.e2l_prev = edge_to_loops[ml_prev->e];  /* Also tag as 'fan' task. */
 
-		/* This will signal all other worker threads to wake up and finish! */
-		BLI_thread_queue_nowait(common_data->task_queue);
-	}
+			if (common_data->lnors_spacearr && tls->edge_vectors == NULL) {
+				tls->edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
+			}
+		}
 
-	if (edge_vectors) {
-		BLI_stack_free(edge_vectors);
+		loop_split_worker_do(common_data, &data, tls->edge_vectors);
 	}
-
-#ifdef DEBUG_TIME
-	TIMEIT_END(loop_split_generator);
-#endif
 }
 
-static void loop_split_generator(TaskPool * __restrict UNUSED(pool), void *taskdata, int UNUSED(threadid))
+static void loop_split_poly_finalize(void *UNUSED(userdata), void *userdata_chunk)
 {
-	LoopSplitTaskDataCommon *common_data = taskdata;
+	LoopSplitTaskDataTLS *tls = userdata_chunk;
 
-	loop_split_generator_do(common_data, true);
+	if (tls->edge_vectors) {
+		BLI_stack_free(tls->edge_vectors);
+	}
 }
 
 /**
@@ -1204,12 +1132,13 @@ void BKE_mesh_normals_loop_split(
 	MPoly *mp;
 	int mp_index, me_index;
 	bool check_angle = (split_angle < (float)M_PI);
-	int i;
 
 	BLI_bitmap *sharp_verts = NULL;
+	int *vert_fan_start = NULL;
 	MLoopNorSpaceArray _lnors_spacearr = {NULL};
 
 	LoopSplitTaskDataCommon common_data = {NULL};
+	LoopSplitTaskDataTLS tls = {NULL};
 
 #ifdef DEBUG_TIME
 	TIMEIT_START(BKE_mesh_normals_loop_split);
@@ -1232,6 +1161,8 @@ void BKE_mesh_normals_loop_split(
 	if (r_lnors_spacearr) {
 		BKE_lnor_spacearr_init(r_lnors_spacearr, numLoops);
 		sharp_verts = BLI_BITMAP_NEW((size_t)numVerts, __func__);
+		vert_fan_start = MEM_mallocN(sizeof(*vert_fan_start) * (size_t)numVerts, __func__);
+		copy_vn_i(vert_fan_start, numVerts, -1);
 	}
 
 	/* This first loop check which edges are actually smooth, and compute edge vectors. */
@@ -1253,6 +1184,10 @@ void BKE_mesh_normals_loop_split(
 			 */
 			normal_short_to_float_v3(r_loopnors[ml_curr_index], mverts[ml_curr->v].no);
 
+			if (vert_fan_start && vert_fan_start[ml_curr->v] == -1) {
+				vert_fan_start[ml_curr->v] = ml_curr_index;
+			}
+
 			/* Check whether current edge might be smooth or sharp */
 			if ((e2l[0] | e2l[1]) == 0) {
 				/* 'Empty' edge until now, set e2l[0] (and e2l[1] to INDEX_UNSET to tag it as unset). */
@@ -1309,37 +1244,25 @@ void BKE_mesh_normals_loop_split(
 	common_data.medges = medges;
 	common_data.mloops = mloops;
 	common_data.mpolys = mpolys;
-	common_data.sharp_verts = sharp_verts;
 	common_data.edge_to_loops = (const int(*)[2])edge_to_loops;
 	common_data.loop_to_poly = loop_to_poly;
 	common_data.polynors = polynors;
+	common_data.sharp_verts = sharp_verts;
+	common_data.vert_fan_start = vert_fan_start;
 	common_data.numPolys = numPolys;
 
-	if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
-		/* Not enough loops to be worth the whole threading overhead... */
-		loop_split_generator_do(&common_data, false);
+	if (r_lnors_spacearr) {
+		BLI_spin_init(&common_data.lnor_spaces_lock);
 	}
-	else {
-		TaskScheduler *task_scheduler;
-		TaskPool *task_pool;
-		int nbr_workers;
 
-		common_data.task_queue = BLI_thread_queue_init();
-
-		task_scheduler = BLI_task_scheduler_get();
-		task_pool = BLI_task_pool_create(task_scheduler, NULL);
-
-		nbr_workers = max_ii(2, BLI_task_scheduler_num_threads(task_scheduler));
-		for (i = 1; i < nbr_workers; i++) {
-			BLI_task_pool_push(task_pool, loop_split_worker, &common_data, false, TASK_PRIORITY_HIGH);
-		}
-		BLI_task_pool_push(task_pool, loop_split_generator, &common_data, false, TASK_PRIORITY_HIGH);
-		BLI_task_pool_work_and_wait(task_pool);
-
-		BLI_task_pool_free(task_pool);
-
-		BLI_thread_queue_free(common_data.task_queue);
-	}
+	/* We now know edges that can be smoothed (with their vector, and their two loops), and edges that will be hard!
+	 * Now, time to generate the normals, each smooth fan is walked only from its starting loop,
+	 * so polys can be processed fully in parallel.
+	 */
+	BLI_task_parallel_range_finalize(
+	        0, numPolys, &common_data, &tls, sizeof(tls),
+	        loop_split_poly_cb, loop_split_poly_finalize,
+	        (numPolys > BKE_MESH_OMP_LIMIT), true);
 
 	MEM_freeN(edge_to_loops);
 	if (!r_loop_to_poly) {
@@ -1348,6 +1271,8 @@ void BKE_mesh_normals_loop_split(
 
 	if (r_lnors_spacearr) {
 		MEM_freeN(sharp_verts);
+		MEM_freeN(vert_fan_start);
+		BLI_spin_end(&common_data.lnor_spaces_lock);
 		if (r_lnors_spacearr == &_lnors_spacearr) {
 			BKE_lnor_spacearr_free(r_lnors_spacearr);
 		}
@@ -38,6 +38,7 @@
 
 #include "DNA_scene_types.h"
 
+#include "BLI_listbase.h"
 #include "BLI_math.h"
 #include "BLI_path_util.h"
 #include "BLI_rand.h"
@@ -60,6 +61,36 @@
 
 #define GRAVITY  9.81f
 
+/* upper bound for the memory held by simulated frames kept around for scrubbing */
+#define OCEAN_FRAME_CACHE_MAX_BYTES (64 * 1024 * 1024)
+
+/* everything a simulated frame depends on, compared with memcmp so must be zero-initialized */
+typedef struct OceanFrameKey {
+	float t;
+	float scale;
+	float chop_amount;
+
+	float V, l, A, w, damp, alignment, depth;
+	float Lx, Lz;
+	int M, N;
+	int seed;
+
+	short do_disp_y;
+	short do_normals;
+	short do_chop;
+	short do_jacobian;
+} OceanFrameKey;
+
+/* result grids of one simulated frame, stored back to back in the order used by ocean_frame_grids() */
+typedef struct OceanFrame {
+	struct OceanFrame *next, *prev;
+
+	OceanFrameKey key;
+	double N_y;
+	size_t size;
+	double *data;
+} OceanFrame;
+
 typedef struct Ocean {
 	/* ********* input parameters to the sim ********* */
 	float _V;
@@ -91,6 +122,13 @@ typedef struct Ocean {
 	short _do_chop;
 	short _do_jacobian;
 
+	/* simulation inputs, t/scale/chop_amount are filled in per frame */
+	OceanFrameKey _key;
+
+	/* recently simulated frames, most recently used first */
+	ListBase _frames;
+	size_t _frames_size;
+
 	/* mutex for threaded texture access */
 	ThreadRWMutex oceanmutex;
 
@@ -143,6 +181,7 @@ typedef struct Ocean {
 
 	/* two dimensional float array */
 	float *_k;                      /* init w	sim r */
+	float *_omega;                  /* init w	sim r */
 } Ocean;
 
 
@@ -241,59 +280,12 @@ static void init_complex(fftw_complex cmpl, float real, float image)
 	cmpl[1] = image;
 }
 
-#if 0   /* unused */
-static void add_complex_f(fftw_complex res, fftw_complex cmpl, float f)
-{
-	res[0] = cmpl[0] + f;
-	res[1] = cmpl[1];
-}
-#endif
-
-static void add_comlex_c(fftw_complex res, fftw_complex cmpl1, fftw_complex cmpl2)
-{
-	res[0] = cmpl1[0] + cmpl2[0];
-	res[1] = cmpl1[1] + cmpl2[1];
-}
-
 static void mul_complex_f(fftw_complex res, fftw_complex cmpl, float f)
 {
 	res[0] = cmpl[0] * (double)f;
 	res[1] = cmpl[1] * (double)f;
 }
 
-static void mul_complex_c(fftw_complex res, fftw_complex cmpl1, fftw_complex cmpl2)
-{
-	fftwf_complex temp;
-	temp[0] = cmpl1[0] * cmpl2[0] - cmpl1[1] * cmpl2[1];
-	temp[1] = cmpl1[0] * cmpl2[1] + cmpl1[1] * cmpl2[0];
-	res[0] = temp[0];
-	res[1] = temp[1];
-}
-
-static float real_c(fftw_complex cmpl)
-{
-	return cmpl[0];
-}
-
-static float image_c(fftw_complex cmpl)
-{
-	return cmpl[1];
-}
-
-static void conj_complex(fftw_complex res, fftw_complex cmpl1)
-{
-	res[0] = cmpl1[0];
-	res[1] = -cmpl1[1];
-}
-
-static void exp_complex(fftw_complex res, fftw_complex cmpl)
-{
-	float r = expf(cmpl[0]);
-
-	res[0] = cosf(cmpl[1]) * r;
-	res[1] = sinf(cmpl[1]) * r;
-}
-
 float BKE_ocean_jminus_to_foam(float jminus, float coverage)
 {
 	float foam = jminus * -0.005f + coverage;
@@ -502,32 +494,125 @@ typedef struct OceanSimulateData {
 	float chop_amount;
 } OceanSimulateData;
 
-static void ocean_compute_htilda(void *userdata, const int i)
+/* Evaluates one row of the spectrum for every enabled component at once, so each row is
+ * only read from memory once and all FFT inputs are ready before any transform runs.
+ * The arithmetic mirrors the complex helpers above (including their float intermediates)
+ * so results are unchanged, but is spelled out so the inner loops stay vectorizable. */
+static void ocean_compute_spectrum(void *userdata, const int i)
 {
 	OceanSimulateData *osd = userdata;
 	const Ocean *o = osd->o;
-	const float scale = osd->scale;
+	/* note the <= _N/2 here, see the fftw doco about the mechanics of the complex->real fft storage */
+	const int row_len = 1 + o->_N / 2;
 	const float t = osd->t;
-
+	const double scale = osd->scale;
+	const double chop_amount = osd->chop_amount;
+	const float kx = o->_kx[i];
+
+	const float *k = &o->_k[i * row_len];
+	const float *kz = o->_kz;
+	const float *omega_k = &o->_omega[i * row_len];
+	fftw_complex *h0 = &o->_h0[i * o->_N];
+	fftw_complex *h0_minus = &o->_h0_minus[i * o->_N];
+	fftw_complex *htilda = &o->_htilda[i * row_len];
+	fftw_complex *fft_in;
 	int j;
 
-	/* note the <= _N/2 here, see the fftw doco about the mechanics of the complex->real fft storage */
-	for (j = 0; j <= o->_N / 2; ++j) {
-		fftw_complex exp_param1;
-		fftw_complex exp_param2;
-		fftw_complex conj_param;
-
-		init_complex(exp_param1, 0.0, omega(o->_k[i * (1 + o->_N / 2) + j], o->_depth) * t);
-		init_complex(exp_param2, 0.0, -omega(o->_k[i * (1 + o->_N / 2) + j], o->_depth) * t);
-		exp_complex(exp_param1, exp_param1);
-		exp_complex(exp_param2, exp_param2);
-		conj_complex(conj_param, o->_h0_minus[i * o->_N + j]);
-
-		mul_complex_c(exp_param1, o->_h0[i * o->_N + j], exp_param1);
-		mul_complex_c(exp_param2, conj_param, exp_param2);
-
-		add_comlex_c(o->_htilda[i * (1 + o->_N / 2) + j], exp_param1, exp_param2);
-		mul_complex_f(o->_fft_in[i * (1 + o->_N / 2) + j], o->_htilda[i * (1 + o->_N / 2) + j], scale);
+	fft_in = &o->_fft_in[i * row_len];
+	for (j = 0; j < row_len; ++j) {
+		/* h0 * exp(i w t) + conj(h0_minus) * exp(-i w t), both exponentials share sine and cosine */
+		const float wt = omega_k[j] * t;
+		const double c = cosf(wt);
+		const double s = sinf(wt);
+		const float a_re = h0[j][0] * c - h0[j][1] * s;
+		const float a_im = h0[j][0] * s + h0[j][1] * c;
+		const float b_re = h0_minus[j][0] * c - h0_minus[j][1] * s;
+		const float b_im = h0_minus[j][0] * s + h0_minus[j][1] * c;
+
+		htilda[j][0] = (double)a_re + (double)b_re;
+		htilda[j][1] = (double)a_im - (double)b_im;
+		fft_in[j][0] = htilda[j][0] * scale;
+		fft_in[j][1] = htilda[j][1] * scale;
+	}
+
+	if (o->_do_chop) {
+		/* -i * scale * chop_amount * htilda * k / |k| */
+		const float scale_chop = scale * chop_amount;
+
+		fft_in = &o->_fft_in_x[i * row_len];
+		for (j = 0; j < row_len; ++j) {
+			const float re = -(scale_chop * htilda[j][1]);
+			const float im = scale_chop * htilda[j][0];
+			const float f = (k[j] == 0.0f) ? 0.0f : kx / k[j];
+
+			fft_in[j][0] = (float)(re * (double)f);
+			fft_in[j][1] = (float)(im * (double)f);
+		}
+
+		fft_in = &o->_fft_in_z[i * row_len];
+		for (j = 0; j < row_len; ++j) {
+			const float re = -(scale_chop * htilda[j][1]);
+			const float im = scale_chop * htilda[j][0];
+			const float f = (k[j] == 0.0f) ? 0.0f : kz[j] / k[j];
+
+			fft_in[j][0] = (float)(re * (double)f);
+			fft_in[j][1] = (float)(im * (double)f);
+		}
+	}
+
+	if (o->_do_jacobian) {
+		/* -chop_amount * htilda * ka * kb / |k| */
+		fft_in = &o->_fft_in_jxx[i * row_len];
+		for (j = 0; j < row_len; ++j) {
+			const float re = -(chop_amount * htilda[j][0]);
+			const float im = -(chop_amount * htilda[j][1]);
+			const float f = (k[j] == 0.0f) ? 0.0f : kx * kx / k[j];
+
+			fft_in[j][0] = (float)(re * (double)f);
+			fft_in[j][1] = (float)(im * (double)f);
+		}
+
+		fft_in = &o->_fft_in_jzz[i * row_len];
+		for (j = 0; j < row_len; ++j) {
+			const float re = -(chop_amount * htilda[j][0]);
+			const float im = -(chop_amount * htilda[j][1]);
+			const float f = (k[j] == 0.0f) ? 0.0f : kz[j] * kz[j] / k[j];
+
+			fft_in[j][0] = (float)(re * (double)f);
+			fft_in[j][1] = (float)(im * (double)f);
+		}
+
+		fft_in = &o->_fft_in_jxz[i * row_len];
+		for (j = 0; j < row_len; ++j) {
+			const float re = -(chop_amount * htilda[j][0]);
+			const float im = -(chop_amount * htilda[j][1]);
+			const float f = (k[j] == 0.0f) ? 0.0f : kx * kz[j] / k[j];
+
+			fft_in[j][0] = (float)(re * (double)f);
+			fft_in[j][1] = (float)(im * (double)f);
+		}
+	}
+
+	if (o->_do_normals) {
+		/* -i * htilda * k */
+		fft_in = &o->_fft_in_nx[i * row_len];
+		for (j = 0; j < row_len; ++j) {
+			const float re = htilda[j][1];
+			const float im = -htilda[j][0];
+
+			fft_in[j][0] = (float)(re * (double)kx);
+			fft_in[j][1] = (float)(im * (double)kx);
+		}
+
+		/* XXX: indexes kz by row, kept as is since it defines the look of existing files */
+		fft_in = &o->_fft_in_nz[i * row_len];
+		for (j = 0; j < row_len; ++j) {
+			const float re = htilda[j][1];
+			const float im = -htilda[j][0];
+
+			fft_in[j][0] = (float)(re * (double)kz[i]);
+			fft_in[j][1] = (float)(im * (double)kz[i]);
+		}
 	}
 }
 
@@ -543,27 +628,7 @@ static void ocean_compute_displacement_x(TaskPool * __restrict pool, void *UNUSE
 {
 	OceanSimulateData *osd = BLI_task_pool_userdata(pool);
 	const Ocean *o = osd->o;
-	const float scale = osd->scale;
-	const float chop_amount = osd->chop_amount;
-	int i, j;
 
-	for (i = 0; i < o->_M; ++i) {
-		for (j = 0; j <= o->_N / 2; ++j) {
-			fftw_complex mul_param;
-			fftw_complex minus_i;
-
-			init_complex(minus_i, 0.0, -1.0);
-			init_complex(mul_param, -scale, 0);
-			mul_complex_f(mul_param, mul_param, chop_amount);
-			mul_complex_c(mul_param, mul_param, minus_i);
-			mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-			mul_complex_f(mul_param, mul_param,
-			              ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
-			               0.0f :
-			               o->_kx[i] / o->_k[i * (1 + o->_N / 2) + j]));
-			init_complex(o->_fft_in_x[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-		}
-	}
 	fftw_execute(o->_disp_x_plan);
 }
 
@@ -571,27 +636,7 @@ static void ocean_compute_displacement_z(TaskPool * __restrict pool, void *UNUSE
 {
 	OceanSimulateData *osd = BLI_task_pool_userdata(pool);
 	const Ocean *o = osd->o;
-	const float scale = osd->scale;
-	const float chop_amount = osd->chop_amount;
-	int i, j;
 
-	for (i = 0; i < o->_M; ++i) {
-		for (j = 0; j <= o->_N / 2; ++j) {
-			fftw_complex mul_param;
-			fftw_complex minus_i;
-
-			init_complex(minus_i, 0.0, -1.0);
-			init_complex(mul_param, -scale, 0);
-			mul_complex_f(mul_param, mul_param, chop_amount);
-			mul_complex_c(mul_param, mul_param, minus_i);
-			mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-			mul_complex_f(mul_param, mul_param,
-			              ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
-			               0.0f :
-			               o->_kz[j] / o->_k[i * (1 + o->_N / 2) + j]));
-			init_complex(o->_fft_in_z[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-		}
-	}
 	fftw_execute(o->_disp_z_plan);
 }
 
@@ -599,31 +644,13 @@ static void ocean_compute_jacobian_jxx(TaskPool * __restrict pool, void *UNUSED(
 {
 	OceanSimulateData *osd = BLI_task_pool_userdata(pool);
 	const Ocean *o = osd->o;
-	const float chop_amount = osd->chop_amount;
-	int i, j;
+	const int len = o->_M * o->_N;
+	int i;
 
-	for (i = 0; i < o->_M; ++i) {
-		for (j = 0; j <= o->_N / 2; ++j) {
-			fftw_complex mul_param;
-
-			/* init_complex(mul_param, -scale, 0); */
-			init_complex(mul_param, -1, 0);
-
-			mul_complex_f(mul_param, mul_param, chop_amount);
-			mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-			mul_complex_f(mul_param, mul_param,
-			              ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
-			               0.0f :
-			               o->_kx[i] * o->_kx[i] / o->_k[i * (1 + o->_N / 2) + j]));
-			init_complex(o->_fft_in_jxx[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-		}
-	}
 	fftw_execute(o->_Jxx_plan);
 
-	for (i = 0; i < o->_M; ++i) {
-		for (j = 0; j < o->_N; ++j) {
-			o->_Jxx[i * o->_N + j] += 1.0;
-		}
+	for (i = 0; i < len; ++i) {
+		o->_Jxx[i] += 1.0;
 	}
 }
 
@@ -631,31 +658,13 @@ static void ocean_compute_jacobian_jzz(TaskPool * __restrict pool, void *UNUSED(
 {
 	OceanSimulateData *osd = BLI_task_pool_userdata(pool);
 	const Ocean *o = osd->o;
-	const float chop_amount = osd->chop_amount;
-	int i, j;
+	const int len = o->_M * o->_N;
+	int i;
 
-	for (i = 0; i < o->_M; ++i) {
-		for (j = 0; j <= o->_N / 2; ++j) {
-			fftw_complex mul_param;
-
-			/* init_complex(mul_param, -scale, 0); */
-			init_complex(mul_param, -1, 0);
-
-			mul_complex_f(mul_param, mul_param, chop_amount);
-			mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-			mul_complex_f(mul_param, mul_param,
-			              ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
-			               0.0f :
-			               o->_kz[j] * o->_kz[j] / o->_k[i * (1 + o->_N / 2) + j]));
-			init_complex(o->_fft_in_jzz[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-		}
-	}
 	fftw_execute(o->_Jzz_plan);
 
-	for (i = 0; i < o->_M; ++i) {
-		for (j = 0; j < o->_N; ++j) {
-			o->_Jzz[i * o->_N + j] += 1.0;
-		}
+	for (i = 0; i < len; ++i) {
+		o->_Jzz[i] += 1.0;
 	}
 }
 
@@ -663,25 +672,7 @@ static void ocean_compute_jacobian_jxz(TaskPool * __restrict pool, void *UNUSED(
 {
 	OceanSimulateData *osd = BLI_task_pool_userdata(pool);
 	const Ocean *o = osd->o;
-	const float chop_amount = osd->chop_amount;
-	int i, j;
 
-	for (i = 0; i < o->_M; ++i) {
-		for (j = 0; j <= o->_N / 2; ++j) {
-			fftw_complex mul_param;
-
-			/* init_complex(mul_param, -scale, 0); */
-			init_complex(mul_param, -1, 0);
-
-			mul_complex_f(mul_param, mul_param, chop_amount);
-			mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-			mul_complex_f(mul_param, mul_param,
-			              ((o->_k[i * (1 + o->_N / 2) + j] == 0.0f) ?
-			               0.0f :
-			               o->_kx[i] * o->_kz[j] / o->_k[i * (1 + o->_N / 2) + j]));
-			init_complex(o->_fft_in_jxz[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-		}
-	}
 	fftw_execute(o->_Jxz_plan);
 }
 
@@ -689,18 +680,7 @@ static void ocean_compute_normal_x(TaskPool * __restrict pool, void *UNUSED(task
 {
 	OceanSimulateData *osd = BLI_task_pool_userdata(pool);
 	const Ocean *o = osd->o;
-	int i, j;
 
-	for (i = 0; i < o->_M; ++i) {
-		for (j = 0; j <= o->_N / 2; ++j) {
-			fftw_complex mul_param;
-
-			init_complex(mul_param, 0.0, -1.0);
-			mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-			mul_complex_f(mul_param, mul_param, o->_kx[i]);
-			init_complex(o->_fft_in_nx[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-		}
-	}
 	fftw_execute(o->_N_x_plan);
 }
 
@@ -708,30 +688,18 @@ static void ocean_compute_normal_z(TaskPool * __restrict pool, void *UNUSED(task
 {
 	OceanSimulateData *osd = BLI_task_pool_userdata(pool);
 	const Ocean *o = osd->o;
-	int i, j;
 
-	for (i = 0; i < o->_M; ++i) {
-		for (j = 0; j <= o->_N / 2; ++j) {
-			fftw_complex mul_param;
-
-			init_complex(mul_param, 0.0, -1.0);
-			mul_complex_c(mul_param, mul_param, o->_htilda[i * (1 + o->_N / 2) + j]);
-			mul_complex_f(mul_param, mul_param, o->_kz[i]);
-			init_complex(o->_fft_in_nz[i * (1 + o->_N / 2) + j], real_c(mul_param), image_c(mul_param));
-		}
-	}
 	fftw_execute(o->_N_z_plan);
 }
 
-void BKE_ocean_simulate(struct Ocean *o, float t, float scale, float chop_amount)
+/* caller must hold the write lock */
+static void ocean_simulate_compute(struct Ocean *o, float t, float scale, float chop_amount)
 {
 	TaskScheduler *scheduler = BLI_task_scheduler_get();
 	TaskPool *pool;
 
 	OceanSimulateData osd;
 
-	scale *= o->normalize_factor;
-
 	osd.o = o;
 	osd.t = t;
 	osd.scale = scale;
@@ -739,16 +707,10 @@ void BKE_ocean_simulate(struct Ocean *o, float t, float scale, float chop_amount
 
 	pool = BLI_task_pool_create(scheduler, &osd);
 
-	BLI_rw_mutex_lock(&o->oceanmutex, THREAD_LOCK_WRITE);
-
-	/* Note about multi-threading here: we have to run a first set of computations (htilda one) before we can run
-	 * all others, since they all depend on it.
-	 * So we make a first parallelized forloop run for htilda, and then pack all other computations into
-	 * a set of parallel tasks.
-	 * This is not optimal in all cases, but remains reasonably simple and should be OK most of the time. */
-
-	/* compute a new htilda */
-	BLI_task_parallel_range(0, o->_M, &osd, ocean_compute_htilda, o->_M > 16);
+	/* Note about multi-threading here: all transforms depend on htilda, so we first fill the inputs of every
+	 * component in a parallelized forloop over rows, and then run each FFT as its own task.
+	 * FFTW plans are not split further, the components are enough to keep a few cores busy. */
+	BLI_task_parallel_range(0, o->_M, &osd, ocean_compute_spectrum, o->_M > 16);
 
 	if (o->_do_disp_y) {
 		BLI_task_pool_push(pool, ocean_compute_displacement_y, NULL, false, TASK_PRIORITY_HIGH);
@@ -782,9 +744,138 @@ void BKE_ocean_simulate(struct Ocean *o, float t, float scale, float chop_amount
 
 	BLI_task_pool_work_and_wait(pool);
 
+	BLI_task_pool_free(pool);
+}
+
+/* -------------------------------------------------------------------- */
+/* Simulated frames
+ *
+ * Scrubbing the timeline re-evaluates the modifier for times already simulated,
+ * keep the most recent results around so those only cost a copy. */
+
+static int ocean_frame_grids(struct Ocean *o, double *r_grids[8])
+{
+	int num = 0;
+
+	if (o->_do_disp_y) {
+		r_grids[num++] = o->_disp_y;
+	}
+	if (o->_do_chop) {
+		r_grids[num++] = o->_disp_x;
+		r_grids[num++] = o->_disp_z;
+	}
+	if (o->_do_normals) {
+		r_grids[num++] = o->_N_x;
+		r_grids[num++] = o->_N_z;
+	}
+	if (o->_do_jacobian) {
+		r_grids[num++] = o->_Jxx;
+		r_grids[num++] = o->_Jzz;
+		r_grids[num++] = o->_Jxz;
+	}
+
+	return num;
+}
+
+static void ocean_frames_free(struct Ocean *o)
+{
+	BLI_freelistN(&o->_frames);
+	o->_frames_size = 0;
+}
+
+static bool ocean_frame_restore(struct Ocean *o)
+{
+	OceanFrame *frame;
+
+	for (frame = o->_frames.first; frame; frame = frame->next) {
+		if (memcmp(&frame->key, &o->_key, sizeof(OceanFrameKey)) == 0) {
+			double *grids[8];
+			const size_t grid_len = (size_t)o->_M * (size_t)o->_N;
+			const int num = ocean_frame_grids(o, grids);
+			int i;
+
+			for (i = 0; i < num; i++) {
+				memcpy(grids[i], frame->data + i * grid_len, sizeof(double) * grid_len);
+			}
+			o->_N_y = frame->N_y;
+
+			BLI_remlink(&o->_frames, frame);
+			BLI_addhead(&o->_frames, frame);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void ocean_frame_store(struct Ocean *o)
+{
+	double *grids[8];
+	const size_t grid_len = (size_t)o->_M * (size_t)o->_N;
+	const int num = ocean_frame_grids(o, grids);
+	const size_t size = sizeof(double) * grid_len * num;
+	OceanFrame *frame = NULL;
+	int i;
+
+	if (num == 0 || size > OCEAN_FRAME_CACHE_MAX_BYTES) {
+		return;
+	}
+
+	/* drop least recently used frames until the new one fits, recycling one of the same size
+	 * since touching freshly allocated memory costs about as much as the copy itself */
+	while (o->_frames_size + size > OCEAN_FRAME_CACHE_MAX_BYTES) {
+		OceanFrame *frame_lru = BLI_poptail(&o->_frames);
+		o->_frames_size -= frame_lru->size;
+
+		if (frame == NULL && frame_lru->size == size) {
+			frame = frame_lru;
+		}
+		else {
+			MEM_freeN(frame_lru);
+		}
+	}
+
+	if (frame == NULL) {
+		frame = MEM_mallocN(sizeof(OceanFrame) + size, "ocean frame");
+	}
+	frame->key = o->_key;
+	frame->N_y = o->_N_y;
+	frame->size = size;
+	frame->data = (double *)(frame + 1);
+
+	for (i = 0; i < num; i++) {
+		memcpy(frame->data + i * grid_len, grids[i], sizeof(double) * grid_len);
+	}
+
+	BLI_addhead(&o->_frames, frame);
+	o->_frames_size += size;
+}
+
+/* store_frame: add the result to the frame cache, baking visits every frame once and skips it */
+static void ocean_simulate(struct Ocean *o, float t, float scale, float chop_amount, const bool store_frame)
+{
+	scale *= o->normalize_factor;
+
+	BLI_rw_mutex_lock(&o->oceanmutex, THREAD_LOCK_WRITE);
+
+	o->_key.t = t;
+	o->_key.scale = scale;
+	o->_key.chop_amount = chop_amount;
+
+	if (!ocean_frame_restore(o)) {
+		ocean_simulate_compute(o, t, scale, chop_amount);
+
+		if (store_frame) {
+			ocean_frame_store(o);
+		}
+	}
+
 	BLI_rw_mutex_unlock(&o->oceanmutex);
+}
 
-	BLI_task_pool_free(pool);
+void BKE_ocean_simulate(struct Ocean *o, float t, float scale, float chop_amount)
+{
+	ocean_simulate(o, t, scale, chop_amount, true);
 }
 
 static void set_height_normalize_factor(struct Ocean *oc)
@@ -798,9 +889,10 @@ static void set_height_normalize_factor(struct Ocean *oc)
 
 	oc->normalize_factor = 1.0;
 
-	BKE_ocean_simulate(oc, 0.0, 1.0, 0);
+	/* not cached, the unscaled frame is never displayed */
+	BLI_rw_mutex_lock(&oc->oceanmutex, THREAD_LOCK_WRITE);
 
-	BLI_rw_mutex_lock(&oc->oceanmutex, THREAD_LOCK_READ);
+	ocean_simulate_compute(oc, 0.0, 1.0, 0);
 
 	for (i = 0; i < oc->_M; ++i) {
 		for (j = 0; j < oc->_N; ++j) {
@@ -859,7 +951,26 @@ void BKE_ocean_init(struct Ocean *o, int M, int N, float Lx, float Lz, float V,
 	o->_do_chop = do_chop;
 	o->_do_jacobian = do_jacobian;
 
+	memset(&o->_key, 0, sizeof(o->_key));
+	o->_key.V = V;
+	o->_key.l = l;
+	o->_key.A = A;
+	o->_key.w = w;
+	o->_key.damp = damp;
+	o->_key.alignment = alignment;
+	o->_key.depth = depth;
+	o->_key.Lx = Lx;
+	o->_key.Lz = Lz;
+	o->_key.M = M;
+	o->_key.N = N;
+	o->_key.seed = seed;
+	o->_key.do_disp_y = do_height_field;
+	o->_key.do_normals = do_normals;
+	o->_key.do_chop = do_chop;
+	o->_key.do_jacobian = do_jacobian;
+
 	o->_k = (float *) MEM_mallocN(M * (1 + N / 2) * sizeof(float), "ocean_k");
+	o->_omega = (float *) MEM_mallocN(M * (1 + N / 2) * sizeof(float), "ocean_omega");
 	o->_h0 = (fftw_complex *) MEM_mallocN(M * N * sizeof(fftw_complex), "ocean_h0");
 	o->_h0_minus = (fftw_complex *) MEM_mallocN(M * N * sizeof(fftw_complex), "ocean_h0_minus");
 	o->_kx = (float *) MEM_mallocN(o->_M * sizeof(float), "ocean_kx");
@@ -893,6 +1004,10 @@ void BKE_ocean_init(struct Ocean *o, int M, int N, float Lx, float Lz, float V,
 		for (j = 0; j <= o->_N / 2; ++j)
 			o->_k[i * (1 + o->_N / 2) + j] = sqrt(o->_kx[i] * o->_kx[i] + o->_kz[j] * o->_kz[j]);
 
+	/* the dispersion relation only depends on k, don't redo it every frame */
+	for (i = 0; i < o->_M * (1 + o->_N / 2); ++i)
+		o->_omega[i] = omega(o->_k[i], o->_depth);
+
 	/*srand(seed);*/
 	rng = BLI_rng_new(seed);
 
@@ -1019,6 +1134,7 @@ void BKE_ocean_free_data(struct Ocean *oc)
 	if (oc->_htilda) {
 		MEM_freeN(oc->_htilda);
 		MEM_freeN(oc->_k);
+		MEM_freeN(oc->_omega);
 		MEM_freeN(oc->_h0);
 		MEM_freeN(oc->_h0_minus);
 		MEM_freeN(oc->_kx);
@@ -1033,6 +1149,7 @@ void BKE_ocean_free(struct Ocean *oc)
 	if (!oc) return;
 
 	BKE_ocean_free_data(oc);
+	ocean_frames_free(oc);
 	BLI_rw_mutex_end(&oc->oceanmutex);
 
 	MEM_freeN(oc);
@@ -1287,7 +1404,7 @@ void BKE_ocean_bake(struct Ocean *o, struct OceanCache *och, void (*update_cb)(v
 		ibuf_disp = IMB_allocImBuf(res_x, res_y, 32, IB_rectfloat);
 		ibuf_normal = IMB_allocImBuf(res_x, res_y, 32, IB_rectfloat);
 
-		BKE_ocean_simulate(o, och->time[i], och->wave_scale, och->chop_amount);
+		ocean_simulate(o, och->time[i], och->wave_scale, och->chop_amount, false);
 
 		/* add new foam */
 		for (y = 0; y < res_y; y++) {
@@ -103,7 +103,7 @@
 
 #endif // WITH_MOD_FLUID
 
-static ThreadRWMutex psys_bvhtree_rwlock = BLI_RWLOCK_INITIALIZER;
+static ThreadRWMutex psys_sph_grid_rwlock = BLI_RWLOCK_INITIALIZER;
 
 /************************************************/
 /*			Reacting to system events			*/
@@ -1223,45 +1223,343 @@ void psys_get_pointcache_start_end(Scene *scene, ParticleSystem *psys, int *sfra
 }
 
 /************************************************/
-/*			Effectors							*/
+/*			SPH spatial hash					*/
 /************************************************/
-static void psys_update_particle_bvhtree(ParticleSystem *psys, float cfra)
+/* Uniform grid of the particles of a fluid system. This is used for the SPH
+ * neighbor searches instead of a BVH tree.
+ *
+ * Points are sorted by the Z-order curve index of their cell, so particles close
+ * in space are usually close in memory too. Cells are found through an open
+ * addressing hash of the same index. When the grid is built, each occupied cell
+ * gathers the point ranges of its 27 surrounding cells. A search from inside the
+ * cell, with a radius up to the cell size, then just walks these ranges. */
+
+#define SPH_GRID_BITS 21
+#define SPH_GRID_MASK ((1u << SPH_GRID_BITS) - 1u)
+#define SPH_GRID_KEY_EMPTY UINT64_MAX
+
+typedef struct SPHGridPoint {
+	float co[3];
+	int index;
+} SPHGridPoint;
+
+typedef struct SPHGridRange {
+	int start, end;
+} SPHGridRange;
+
+typedef struct SPHGridCell {
+	uint64_t key;
+	unsigned int co[3];				/* cell coordinates, wrapped to SPH_GRID_BITS */
+	int start, end;					/* points inside the cell */
+	int range_start, range_end;		/* point ranges of the surrounding cells */
+} SPHGridCell;
+
+typedef struct SPHGrid {
+	float cell_size, inv_cell_size;
+
+	SPHGridPoint *points;			/* sorted by cell */
+	int totpoint;
+
+	SPHGridCell *table;				/* hash table of the occupied cells */
+	unsigned int table_bits;
+	int *cells;						/* table slots of the cells, in point order */
+	int totcell;
+
+	SPHGridRange *ranges;			/* 27 per cell */
+} SPHGrid;
+
+/* interleave the low SPH_GRID_BITS bits of v with two zero bits each */
+BLI_INLINE uint64_t sph_grid_spread_bits(uint64_t v)
+{
+	v &= SPH_GRID_MASK;
+	v = (v | v << 32) & 0x1f00000000ffffull;
+	v = (v | v << 16) & 0x1f0000ff0000ffull;
+	v = (v | v << 8) & 0x100f00f00f00f00full;
+	v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+	v = (v | v << 2) & 0x1249249249249249ull;
+	return v;
+}
+
+BLI_INLINE uint64_t sph_grid_key(unsigned int x, unsigned int y, unsigned int z)
+{
+	return sph_grid_spread_bits(x) | (sph_grid_spread_bits(y) << 1) | (sph_grid_spread_bits(z) << 2);
+}
+
+BLI_INLINE int sph_grid_coord(const SPHGrid *grid, float f)
+{
+	/* keep the conversion defined for particles that flew off */
+	return (int)floorf(CLAMPIS(f * grid->inv_cell_size, -1e9f, 1e9f));
+}
+
+BLI_INLINE unsigned int sph_grid_slot(const SPHGrid *grid, uint64_t key)
+{
+	return (unsigned int)((key * 0x9E3779B97F4A7C15ull) >> (64 - grid->table_bits));
+}
+
+BLI_INLINE const SPHGridCell *sph_grid_cell_find(const SPHGrid *grid, uint64_t key)
+{
+	const unsigned int mask = (1u << grid->table_bits) - 1u;
+	unsigned int slot;
+
+	for (slot = sph_grid_slot(grid, key); grid->table[slot].key != SPH_GRID_KEY_EMPTY; slot = (slot + 1) & mask) {
+		if (grid->table[slot].key == key)
+			return &grid->table[slot];
+	}
+
+	return NULL;
+}
+
+typedef struct SPHGridSortItem {
+	uint64_t key;
+	SPHGridPoint point;
+} SPHGridSortItem;
+
+/* LSD radix sort on the cell key, skipping the bytes all keys have in common */
+static SPHGridSortItem *sph_grid_sort(SPHGridSortItem *items, SPHGridSortItem *temp, int totitem)
+{
+	int count[256];
+	int shift, i;
+
+	for (shift = 0; shift < 64; shift += 8) {
+		SPHGridSortItem *swap;
+		int offset = 0;
+
+		memset(count, 0, sizeof(count));
+		for (i = 0; i < totitem; i++)
+			count[(items[i].key >> shift) & 0xff]++;
+
+		if (totitem == 0 || count[(items[0].key >> shift) & 0xff] == totitem)
+			continue;
+
+		for (i = 0; i < 256; i++) {
+			const int tot = count[i];
+			count[i] = offset;
+			offset += tot;
+		}
+
+		for (i = 0; i < totitem; i++)
+			temp[count[(items[i].key >> shift) & 0xff]++] = items[i];
+
+		swap = items;
+		items = temp;
+		temp = swap;
+	}
+
+	return items;
+}
+
+/* gather the point ranges of the cells around a cell, merging ranges that follow each other */
+static void sph_grid_cell_ranges_cb(void *userdata, const int c)
+{
+	SPHGrid *grid = userdata;
+	SPHGridCell *cell = &grid->table[grid->cells[c]];
+	SPHGridRange *ranges = grid->ranges + c * 27;
+	int totrange = 0, i, j;
+	int dx, dy, dz;
+
+	for (dz = -1; dz <= 1; dz++) {
+		for (dy = -1; dy <= 1; dy++) {
+			for (dx = -1; dx <= 1; dx++) {
+				const SPHGridCell *ncell = sph_grid_cell_find(grid, sph_grid_key(
+				        cell->co[0] + dx, cell->co[1] + dy, cell->co[2] + dz));
+
+				if (ncell) {
+					/* insertion sort on the range start */
+					for (i = totrange; i > 0 && ranges[i - 1].start > ncell->start; i--)
+						ranges[i] = ranges[i - 1];
+					ranges[i].start = ncell->start;
+					ranges[i].end = ncell->end;
+					totrange++;
+				}
+			}
+		}
+	}
+
+	for (i = 1, j = 0; i < totrange; i++) {
+		if (ranges[j].end == ranges[i].start)
+			ranges[j].end = ranges[i].end;
+		else
+			ranges[++j] = ranges[i];
+	}
+
+	cell->range_start = c * 27;
+	cell->range_end = cell->range_start + (totrange ? j + 1 : 0);
+}
+
+static SPHGrid *sph_grid_build(ParticleSystem *psys, float cfra, float cell_size)
+{
+	SPHGrid *grid = MEM_callocN(sizeof(SPHGrid), "sph grid");
+	SPHGridSortItem *items, *temp, *sorted;
+	PARTICLE_P;
+	int totpoint = 0, i;
+
+	grid->cell_size = cell_size;
+	grid->inv_cell_size = 1.0f / cell_size;
+
+	LOOP_SHOWN_PARTICLES {
+		if (pa->alive == PARS_ALIVE)
+			totpoint++;
+	}
+
+	items = MEM_mallocN(sizeof(SPHGridSortItem) * max_ii(totpoint, 1), "sph grid sort items");
+	temp = MEM_mallocN(sizeof(SPHGridSortItem) * max_ii(totpoint, 1), "sph grid sort temp");
+
+	i = 0;
+	LOOP_SHOWN_PARTICLES {
+		if (pa->alive == PARS_ALIVE) {
+			SPHGridSortItem *item = &items[i++];
+
+			copy_v3_v3(item->point.co, (pa->state.time == cfra) ? pa->prev_state.co : pa->state.co);
+			item->point.index = p;
+			item->key = sph_grid_key(sph_grid_coord(grid, item->point.co[0]),
+			                         sph_grid_coord(grid, item->point.co[1]),
+			                         sph_grid_coord(grid, item->point.co[2]));
+		}
+	}
+
+	sorted = sph_grid_sort(items, temp, totpoint);
+
+	grid->totpoint = totpoint;
+	grid->points = MEM_mallocN(sizeof(SPHGridPoint) * max_ii(totpoint, 1), "sph grid points");
+	grid->cells = MEM_mallocN(sizeof(int) * max_ii(totpoint, 1), "sph grid cells");
+
+	/* table is kept at most half full, there are never more cells than points */
+	grid->table_bits = 1;
+	while ((1 << grid->table_bits) < 2 * totpoint)
+		grid->table_bits++;
+	grid->table = MEM_mallocN(sizeof(SPHGridCell) << grid->table_bits, "sph grid table");
+	for (i = 0; i < (1 << grid->table_bits); i++)
+		grid->table[i].key = SPH_GRID_KEY_EMPTY;
+
+	for (i = 0; i < totpoint; i++) {
+		grid->points[i] = sorted[i].point;
+
+		if (i == 0 || sorted[i].key != sorted[i - 1].key) {
+			const unsigned int mask = (1u << grid->table_bits) - 1u;
+			unsigned int slot = sph_grid_slot(grid, sorted[i].key);
+			SPHGridCell *cell;
+
+			while (grid->table[slot].key != SPH_GRID_KEY_EMPTY)
+				slot = (slot + 1) & mask;
+
+			cell = &grid->table[slot];
+			cell->key = sorted[i].key;
+			cell->co[0] = (unsigned int)sph_grid_coord(grid, sorted[i].point.co[0]) & SPH_GRID_MASK;
+			cell->co[1] = (unsigned int)sph_grid_coord(grid, sorted[i].point.co[1]) & SPH_GRID_MASK;
+			cell->co[2] = (unsigned int)sph_grid_coord(grid, sorted[i].point.co[2]) & SPH_GRID_MASK;
+			cell->start = i;
+
+			if (grid->totcell > 0)
+				grid->table[grid->cells[grid->totcell - 1]].end = i;
+			grid->cells[grid->totcell++] = (int)slot;
+		}
+	}
+	if (grid->totcell > 0)
+		grid->table[grid->cells[grid->totcell - 1]].end = totpoint;
+
+	MEM_freeN(items);
+	MEM_freeN(temp);
+
+	grid->ranges = MEM_mallocN(sizeof(SPHGridRange) * 27 * max_ii(grid->totcell, 1), "sph grid ranges");
+	BLI_task_parallel_range(0, grid->totcell, grid, sph_grid_cell_ranges_cb, grid->totcell > 1000);
+
+	return grid;
+}
+
+void psys_sph_grid_free(SPHGrid *grid)
+{
+	if (grid) {
+		MEM_freeN(grid->points);
+		MEM_freeN(grid->cells);
+		MEM_freeN(grid->table);
+		MEM_freeN(grid->ranges);
+		MEM_freeN(grid);
+	}
+}
+
+BLI_INLINE void sph_grid_points_query(
+        const SPHGrid *grid, int start, int end, const float co[3], float radius_sq,
+        BVHTree_RangeQuery callback, void *userdata)
+{
+	int i;
+
+	for (i = start; i < end; i++) {
+		const SPHGridPoint *point = &grid->points[i];
+		const float dist_sq = len_squared_v3v3(co, point->co);
+
+		/* same test as BLI_bvhtree_range_query */
+		if (dist_sq < radius_sq)
+			callback(userdata, point->index, point->co, dist_sq);
+	}
+}
+
+/* Call callback for all points closer than radius to co. Inlined, so the SPH
+ * callbacks passed in directly are inlined into the point loop as well. */
+BLI_INLINE void sph_grid_range_query(
+        const SPHGrid *grid, const float co[3], float radius,
+        BVHTree_RangeQuery callback, void *userdata)
+{
+	const float radius_sq = radius * radius;
+	int min[3], max[3], x, y, z, i;
+
+	if (radius <= grid->cell_size) {
+		const SPHGridCell *cell = sph_grid_cell_find(grid, sph_grid_key(
+		        sph_grid_coord(grid, co[0]), sph_grid_coord(grid, co[1]), sph_grid_coord(grid, co[2])));
+
+		if (cell) {
+			for (i = cell->range_start; i < cell->range_end; i++)
+				sph_grid_points_query(grid, grid->ranges[i].start, grid->ranges[i].end, co, radius_sq, callback, userdata);
+			return;
+		}
+	}
+
+	/* outside of the occupied cells or larger radius, look up all overlapping cells */
+	for (i = 0; i < 3; i++) {
+		min[i] = sph_grid_coord(grid, co[i] - radius);
+		max[i] = sph_grid_coord(grid, co[i] + radius);
+	}
+
+	if ((double)(max[0] - min[0] + 1) * (double)(max[1] - min[1] + 1) * (double)(max[2] - min[2] + 1) > (double)grid->totcell) {
+		sph_grid_points_query(grid, 0, grid->totpoint, co, radius_sq, callback, userdata);
+		return;
+	}
+
+	for (z = min[2]; z <= max[2]; z++) {
+		for (y = min[1]; y <= max[1]; y++) {
+			for (x = min[0]; x <= max[0]; x++) {
+				const SPHGridCell *cell = sph_grid_cell_find(grid, sph_grid_key(x, y, z));
+
+				if (cell)
+					sph_grid_points_query(grid, cell->start, cell->end, co, radius_sq, callback, userdata);
+			}
+		}
+	}
+}
+
+static void psys_update_particle_sph_grid(ParticleSystem *psys, float cfra, float cell_size)
 {
 	if (psys) {
-		PARTICLE_P;
-		int totpart = 0;
 		bool need_rebuild;
 
-		BLI_rw_mutex_lock(&psys_bvhtree_rwlock, THREAD_LOCK_READ);
-		need_rebuild = !psys->bvhtree || psys->bvhtree_frame != cfra;
-		BLI_rw_mutex_unlock(&psys_bvhtree_rwlock);
+		BLI_rw_mutex_lock(&psys_sph_grid_rwlock, THREAD_LOCK_READ);
+		need_rebuild = !psys->sph_grid || psys->sph_grid_frame != cfra;
+		BLI_rw_mutex_unlock(&psys_sph_grid_rwlock);
 		
 		if (need_rebuild) {
-			LOOP_SHOWN_PARTICLES {
-				totpart++;
-			}
-			
-			BLI_rw_mutex_lock(&psys_bvhtree_rwlock, THREAD_LOCK_WRITE);
-			
-			BLI_bvhtree_free(psys->bvhtree);
-			psys->bvhtree = BLI_bvhtree_new(totpart, 0.0, 4, 6);
-			
-			LOOP_SHOWN_PARTICLES {
-				if (pa->alive == PARS_ALIVE) {
-					if (pa->state.time == cfra)
-						BLI_bvhtree_insert(psys->bvhtree, p, pa->prev_state.co, 1);
-					else
-						BLI_bvhtree_insert(psys->bvhtree, p, pa->state.co, 1);
-				}
-			}
-			BLI_bvhtree_balance(psys->bvhtree);
+			BLI_rw_mutex_lock(&psys_sph_grid_rwlock, THREAD_LOCK_WRITE);
 			
-			psys->bvhtree_frame = cfra;
+			psys_sph_grid_free(psys->sph_grid);
+			psys->sph_grid = sph_grid_build(psys, cfra, cell_size);
+			psys->sph_grid_frame = cfra;
 			
-			BLI_rw_mutex_unlock(&psys_bvhtree_rwlock);
+			BLI_rw_mutex_unlock(&psys_sph_grid_rwlock);
 		}
 	}
 }
+
+/************************************************/
+/*			Effectors							*/
+/************************************************/
 void psys_update_particle_tree(ParticleSystem *psys, float cfra)
 {
 	if (psys) {
@@ -1299,138 +1597,165 @@ static void psys_update_effectors(ParticleSimulationData *sim)
 	precalc_guides(sim, sim->psys->effectors);
 }
 
-static void integrate_particle(ParticleSettings *part, ParticleData *pa, float dtime, float *external_acceleration,
-                               void (*force_func)(void *forcedata, ParticleKey *state, float *force, float *impulse),
-                               void *forcedata)
-{
-#define ZERO_F43 {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}}
-
+/* state of a particle during integration, between evaluations of its forces */
+typedef struct ParticleIntegrator {
 	ParticleKey states[5];
-	float force[3], acceleration[3], impulse[3], dx[4][3] = ZERO_F43, dv[4][3] = ZERO_F43, oldpos[3];
-	float pa_mass= (part->flag & PART_SIZEMASS ? part->mass * pa->size : part->mass);
-	int i, steps=1;
-	int integrator = part->integrator;
+	float dx[4][3], dv[4][3], oldpos[3];
+	float pa_mass;
+	int integrator, steps;
+} ParticleIntegrator;
+
+static void integrate_particle_init(ParticleSettings *part, ParticleData *pa, ParticleIntegrator *pint)
+{
+	int i;
 
-#undef ZERO_F43
+	pint->pa_mass = (part->flag & PART_SIZEMASS ? part->mass * pa->size : part->mass);
+	pint->integrator = part->integrator;
+	memset(pint->dx, 0, sizeof(pint->dx));
+	memset(pint->dv, 0, sizeof(pint->dv));
 
-	copy_v3_v3(oldpos, pa->state.co);
+	copy_v3_v3(pint->oldpos, pa->state.co);
 
 	/* Verlet integration behaves strangely with moving emitters, so do first step with euler. */
-	if (pa->prev_state.time < 0.f && integrator == PART_INT_VERLET)
-		integrator = PART_INT_EULER;
+	if (pa->prev_state.time < 0.f && pint->integrator == PART_INT_VERLET)
+		pint->integrator = PART_INT_EULER;
 
-	switch (integrator) {
+	switch (pint->integrator) {
 		case PART_INT_EULER:
-			steps=1;
+			pint->steps=1;
 			break;
 		case PART_INT_MIDPOINT:
-			steps=2;
+			pint->steps=2;
 			break;
 		case PART_INT_RK4:
-			steps=4;
+			pint->steps=4;
 			break;
-		case PART_INT_VERLET:
-			steps=1;
+		default:
+			pint->steps=1;
 			break;
 	}
 
-	for (i=0; i<steps; i++) {
-		copy_particle_key(states + i, &pa->state, 1);
+	for (i=0; i<pint->steps; i++) {
+		copy_particle_key(pint->states + i, &pa->state, 1);
 	}
 
-	states->time = 0.f;
-
-	for (i=0; i<steps; i++) {
-		zero_v3(force);
-		zero_v3(impulse);
+	pint->states->time = 0.f;
+}
 
-		force_func(forcedata, states+i, force, impulse);
+/* calculate the next state from the forces at pint->states[i] */
+static void integrate_particle_step(ParticleData *pa, ParticleIntegrator *pint, int i, float dtime,
+                                    float *external_acceleration, float force[3], float impulse[3])
+{
+	ParticleKey *states = pint->states;
+	float (*dx)[3] = pint->dx, (*dv)[3] = pint->dv, *oldpos = pint->oldpos;
+	float acceleration[3];
+	float pa_mass = pint->pa_mass;
+	int integrator = pint->integrator;
 
-		/* force to acceleration*/
-		mul_v3_v3fl(acceleration, force, 1.0f/pa_mass);
+	/* force to acceleration*/
+	mul_v3_v3fl(acceleration, force, 1.0f/pa_mass);
 
-		if (external_acceleration)
-			add_v3_v3(acceleration, external_acceleration);
-		
-		/* calculate next state */
-		add_v3_v3(states[i].vel, impulse);
+	if (external_acceleration)
+		add_v3_v3(acceleration, external_acceleration);
+	
+	/* calculate next state */
+	add_v3_v3(states[i].vel, impulse);
 
-		switch (integrator) {
-			case PART_INT_EULER:
-				madd_v3_v3v3fl(pa->state.co, states->co, states->vel, dtime);
+	switch (integrator) {
+		case PART_INT_EULER:
+			madd_v3_v3v3fl(pa->state.co, states->co, states->vel, dtime);
+			madd_v3_v3v3fl(pa->state.vel, states->vel, acceleration, dtime);
+			break;
+		case PART_INT_MIDPOINT:
+			if (i==0) {
+				madd_v3_v3v3fl(states[1].co, states->co, states->vel, dtime*0.5f);
+				madd_v3_v3v3fl(states[1].vel, states->vel, acceleration, dtime*0.5f);
+				states[1].time = dtime*0.5f;
+				/*fra=sim->psys->cfra+0.5f*dfra;*/
+			}
+			else {
+				madd_v3_v3v3fl(pa->state.co, states->co, states[1].vel, dtime);
 				madd_v3_v3v3fl(pa->state.vel, states->vel, acceleration, dtime);
-				break;
-			case PART_INT_MIDPOINT:
-				if (i==0) {
-					madd_v3_v3v3fl(states[1].co, states->co, states->vel, dtime*0.5f);
-					madd_v3_v3v3fl(states[1].vel, states->vel, acceleration, dtime*0.5f);
+			}
+			break;
+		case PART_INT_RK4:
+			switch (i) {
+				case 0:
+					copy_v3_v3(dx[0], states->vel);
+					mul_v3_fl(dx[0], dtime);
+					copy_v3_v3(dv[0], acceleration);
+					mul_v3_fl(dv[0], dtime);
+
+					madd_v3_v3v3fl(states[1].co, states->co, dx[0], 0.5f);
+					madd_v3_v3v3fl(states[1].vel, states->vel, dv[0], 0.5f);
 					states[1].time = dtime*0.5f;
 					/*fra=sim->psys->cfra+0.5f*dfra;*/
-				}
-				else {
-					madd_v3_v3v3fl(pa->state.co, states->co, states[1].vel, dtime);
-					madd_v3_v3v3fl(pa->state.vel, states->vel, acceleration, dtime);
-				}
-				break;
-			case PART_INT_RK4:
-				switch (i) {
-					case 0:
-						copy_v3_v3(dx[0], states->vel);
-						mul_v3_fl(dx[0], dtime);
-						copy_v3_v3(dv[0], acceleration);
-						mul_v3_fl(dv[0], dtime);
-
-						madd_v3_v3v3fl(states[1].co, states->co, dx[0], 0.5f);
-						madd_v3_v3v3fl(states[1].vel, states->vel, dv[0], 0.5f);
-						states[1].time = dtime*0.5f;
-						/*fra=sim->psys->cfra+0.5f*dfra;*/
-						break;
-					case 1:
-						madd_v3_v3v3fl(dx[1], states->vel, dv[0], 0.5f);
-						mul_v3_fl(dx[1], dtime);
-						copy_v3_v3(dv[1], acceleration);
-						mul_v3_fl(dv[1], dtime);
-
-						madd_v3_v3v3fl(states[2].co, states->co, dx[1], 0.5f);
-						madd_v3_v3v3fl(states[2].vel, states->vel, dv[1], 0.5f);
-						states[2].time = dtime*0.5f;
-						break;
-					case 2:
-						madd_v3_v3v3fl(dx[2], states->vel, dv[1], 0.5f);
-						mul_v3_fl(dx[2], dtime);
-						copy_v3_v3(dv[2], acceleration);
-						mul_v3_fl(dv[2], dtime);
-
-						add_v3_v3v3(states[3].co, states->co, dx[2]);
-						add_v3_v3v3(states[3].vel, states->vel, dv[2]);
-						states[3].time = dtime;
-						/*fra=cfra;*/
-						break;
-					case 3:
-						add_v3_v3v3(dx[3], states->vel, dv[2]);
-						mul_v3_fl(dx[3], dtime);
-						copy_v3_v3(dv[3], acceleration);
-						mul_v3_fl(dv[3], dtime);
-
-						madd_v3_v3v3fl(pa->state.co, states->co, dx[0], 1.0f/6.0f);
-						madd_v3_v3fl(pa->state.co, dx[1], 1.0f/3.0f);
-						madd_v3_v3fl(pa->state.co, dx[2], 1.0f/3.0f);
-						madd_v3_v3fl(pa->state.co, dx[3], 1.0f/6.0f);
-
-						madd_v3_v3v3fl(pa->state.vel, states->vel, dv[0], 1.0f/6.0f);
-						madd_v3_v3fl(pa->state.vel, dv[1], 1.0f/3.0f);
-						madd_v3_v3fl(pa->state.vel, dv[2], 1.0f/3.0f);
-						madd_v3_v3fl(pa->state.vel, dv[3], 1.0f/6.0f);
-				}
-				break;
-			case PART_INT_VERLET:   /* Verlet integration */
-				madd_v3_v3v3fl(pa->state.vel, pa->prev_state.vel, acceleration, dtime);
-				madd_v3_v3v3fl(pa->state.co, pa->prev_state.co, pa->state.vel, dtime);
+					break;
+				case 1:
+					madd_v3_v3v3fl(dx[1], states->vel, dv[0], 0.5f);
+					mul_v3_fl(dx[1], dtime);
+					copy_v3_v3(dv[1], acceleration);
+					mul_v3_fl(dv[1], dtime);
+
+					madd_v3_v3v3fl(states[2].co, states->co, dx[1], 0.5f);
+					madd_v3_v3v3fl(states[2].vel, states->vel, dv[1], 0.5f);
+					states[2].time = dtime*0.5f;
+					break;
+				case 2:
+					madd_v3_v3v3fl(dx[2], states->vel, dv[1], 0.5f);
+					mul_v3_fl(dx[2], dtime);
+					copy_v3_v3(dv[2], acceleration);
+					mul_v3_fl(dv[2], dtime);
+
+					add_v3_v3v3(states[3].co, states->co, dx[2]);
+					add_v3_v3v3(states[3].vel, states->vel, dv[2]);
+					states[3].time = dtime;
+					/*fra=cfra;*/
+					break;
+				case 3:
+					add_v3_v3v3(dx[3], states->vel, dv[2]);
+					mul_v3_fl(dx[3], dtime);
+					copy_v3_v3(dv[3], acceleration);
+					mul_v3_fl(dv[3], dtime);
+
+					madd_v3_v3v3fl(pa->state.co, states->co, dx[0], 1.0f/6.0f);
+					madd_v3_v3fl(pa->state.co, dx[1], 1.0f/3.0f);
+					madd_v3_v3fl(pa->state.co, dx[2], 1.0f/3.0f);
+					madd_v3_v3fl(pa->state.co, dx[3], 1.0f/6.0f);
+
+					madd_v3_v3v3fl(pa->state.vel, states->vel, dv[0], 1.0f/6.0f);
+					madd_v3_v3fl(pa->state.vel, dv[1], 1.0f/3.0f);
+					madd_v3_v3fl(pa->state.vel, dv[2], 1.0f/3.0f);
+					madd_v3_v3fl(pa->state.vel, dv[3], 1.0f/6.0f);
+			}
+			break;
+		case PART_INT_VERLET:   /* Verlet integration */
+			madd_v3_v3v3fl(pa->state.vel, pa->prev_state.vel, acceleration, dtime);
+			madd_v3_v3v3fl(pa->state.co, pa->prev_state.co, pa->state.vel, dtime);
 
-				sub_v3_v3v3(pa->state.vel, pa->state.co, oldpos);
-				mul_v3_fl(pa->state.vel, 1.0f/dtime);
-				break;
-		}
+			sub_v3_v3v3(pa->state.vel, pa->state.co, oldpos);
+			mul_v3_fl(pa->state.vel, 1.0f/dtime);
+			break;
+	}
+}
+
+static void integrate_particle(ParticleSettings *part, ParticleData *pa, float dtime, float *external_acceleration,
+                               void (*force_func)(void *forcedata, ParticleKey *state, float *force, float *impulse),
+                               void *forcedata)
+{
+	ParticleIntegrator pint;
+	float force[3], impulse[3];
+	int i;
+
+	integrate_particle_init(part, pa, &pint);
+
+	for (i=0; i<pint.steps; i++) {
+		zero_v3(force);
+		zero_v3(impulse);
+
+		force_func(forcedata, pint.states+i, force, impulse);
+
+		integrate_particle_step(pa, &pint, i, dtime, external_acceleration, force, impulse);
 	}
 }
 
@@ -1560,7 +1885,7 @@ typedef struct SPHRangeData {
 	int use_size;
 } SPHRangeData;
 
-static void sph_evaluate_func(BVHTree *tree, ParticleSystem **psys, float co[3], SPHRangeData *pfr, float interaction_radius, BVHTree_RangeQuery callback)
+BLI_INLINE void sph_evaluate_func(BVHTree *tree, ParticleSystem **psys, float co[3], SPHRangeData *pfr, float interaction_radius, BVHTree_RangeQuery callback)
 {
 	int i;
 
@@ -1576,11 +1901,12 @@ static void sph_evaluate_func(BVHTree *tree, ParticleSystem **psys, float co[3],
 			break;
 		}
 		else {
-			BLI_rw_mutex_lock(&psys_bvhtree_rwlock, THREAD_LOCK_READ);
+			BLI_rw_mutex_lock(&psys_sph_grid_rwlock, THREAD_LOCK_READ);
 			
-			BLI_bvhtree_range_query(psys[i]->bvhtree, co, interaction_radius, callback, pfr);
+			if (psys[i]->sph_grid)
+				sph_grid_range_query(psys[i]->sph_grid, co, interaction_radius, callback, pfr);
 			
-			BLI_rw_mutex_unlock(&psys_bvhtree_rwlock);
+			BLI_rw_mutex_unlock(&psys_sph_grid_rwlock);
 		}
 	}
 }
@@ -2035,95 +2361,140 @@ static void sph_integrate(ParticleSimulationData *sim, ParticleData *pa, float d
 /************************************************/
 /*			Basic physics						*/
 /************************************************/
-typedef struct EfData {
-	ParticleTexture ptex;
-	ParticleSimulationData *sim;
-	ParticleData *pa;
-} EfData;
-static void basic_force_cb(void *efdata_v, ParticleKey *state, float *force, float *impulse)
-{
-	EfData *efdata = (EfData *)efdata_v;
-	ParticleSimulationData *sim = efdata->sim;
-	ParticleSettings *part = sim->psys->part;
-	ParticleData *pa = efdata->pa;
-	EffectedPoint epoint;
+/* particles integrated together, effectors are evaluated for all of them at once */
+#define PSYS_DYNAMICS_BATCH 64
 
-	/* add effectors */
-	pd_point_from_particle(efdata->sim, efdata->pa, state, &epoint);
-	if (part->type != PART_HAIR || part->effector_weights->flag & EFF_WEIGHT_DO_HAIR)
-		pdDoEffectors(sim->psys->effectors, sim->colliders, part->effector_weights, &epoint, force, impulse);
+/* Random numbers of the dynamics step. These are seeded per particle and step instead of
+ * drawn from the global generator, so they don't depend on the order particles are
+ * handled in when stepping in parallel. Every particle gets 64 numbers per step. */
+#define PSYS_FRAND_BROWNIAN 0
+#define PSYS_FRAND_COLLISION 16
+
+static unsigned int psys_dynamics_seed(ParticleSystem *psys, int p, float cfra)
+{
+	unsigned int seed = (31415926u + (unsigned int)psys->seed) ^ ((unsigned int)(cfra * 1024.0f) * 2654435761u);
+	return seed + (unsigned int)p * 64u;
+}
 
-	mul_v3_fl(force, efdata->ptex.field);
-	mul_v3_fl(impulse, efdata->ptex.field);
+/* gathers all forces that effect particles and calculates a new state for the particles */
+static void basic_integrate_batch(ParticleSimulationData *sim, const int *index, int tot, float cfra)
+{
+	ParticleSystem *psys = sim->psys;
+	ParticleSettings *part = psys->part;
+	const float timestep = psys_get_timestep(sim);
+	/* normal gravity is too strong for hair so it's disabled by default */
+	const bool use_effectors = (part->type != PART_HAIR || part->effector_weights->flag & EFF_WEIGHT_DO_HAIR);
+	const bool use_gravity = psys_uses_gravity(sim) && use_effectors;
+	ParticleIntegrator pint[PSYS_DYNAMICS_BATCH];
+	ParticleTexture ptex[PSYS_DYNAMICS_BATCH];
+	EffectedPoint epoint[PSYS_DYNAMICS_BATCH];
+	float gravity[PSYS_DYNAMICS_BATCH][3];
+	float force[PSYS_DYNAMICS_BATCH][3], impulse[PSYS_DYNAMICS_BATCH][3];
+	float dtime[PSYS_DYNAMICS_BATCH];
+	int point_index[PSYS_DYNAMICS_BATCH];
+	int i, k, steps = 0;
+
+	BLI_assert(tot <= PSYS_DYNAMICS_BATCH);
+
+	for (k = 0; k < tot; k++) {
+		ParticleData *pa = psys->particles + index[k];
+
+		psys_get_texture(sim, pa, &ptex[k], PAMAP_PHYSICS, cfra);
+
+		dtime[k] = pa->state.time * timestep;
+
+		/* add global acceleration (gravitation) */
+		if (use_gravity) {
+			zero_v3(gravity[k]);
+			madd_v3_v3fl(gravity[k], sim->scene->physics_settings.gravity, part->effector_weights->global_gravity * ptex[k].gravity);
+		}
 
-	/* calculate air-particle interaction */
-	if (part->dragfac != 0.0f)
-		madd_v3_v3fl(force, state->vel, -part->dragfac * pa->size * pa->size * len_v3(state->vel));
+		/* maintain angular velocity */
+		copy_v3_v3(pa->state.ave, pa->prev_state.ave);
 
-	/* brownian force */
-	if (part->brownfac != 0.0f) {
-		force[0] += (BLI_frand()-0.5f) * part->brownfac;
-		force[1] += (BLI_frand()-0.5f) * part->brownfac;
-		force[2] += (BLI_frand()-0.5f) * part->brownfac;
+		integrate_particle_init(part, pa, &pint[k]);
+		steps = max_ii(steps, pint[k].steps);
 	}
 
-	if (part->flag & PART_ROT_DYN && epoint.ave)
-		copy_v3_v3(pa->state.ave, epoint.ave);
-}
-/* gathers all forces that effect particles and calculates a new state for the particle */
-static void basic_integrate(ParticleSimulationData *sim, int p, float dfra, float cfra)
-{
-	ParticleSettings *part = sim->psys->part;
-	ParticleData *pa = sim->psys->particles + p;
-	ParticleKey tkey;
-	float dtime=dfra*psys_get_timestep(sim), time;
-	float *gravity = NULL, gr[3];
-	EfData efdata;
+	for (i = 0; i < steps; i++) {
+		int totpoint = 0, n;
 
-	psys_get_texture(sim, pa, &efdata.ptex, PAMAP_PHYSICS, cfra);
+		for (k = 0; k < tot; k++) {
+			if (i < pint[k].steps) {
+				pd_point_from_particle(sim, psys->particles + index[k], pint[k].states + i, &epoint[totpoint]);
+				zero_v3(force[totpoint]);
+				zero_v3(impulse[totpoint]);
+				point_index[totpoint++] = k;
+			}
+		}
 
-	efdata.pa = pa;
-	efdata.sim = sim;
+		/* add effectors */
+		if (use_effectors)
+			pdDoEffectorsArray(psys->effectors, sim->colliders, part->effector_weights, epoint, totpoint, force, impulse);
 
-	/* add global acceleration (gravitation) */
-	if (psys_uses_gravity(sim) &&
-		/* normal gravity is too strong for hair so it's disabled by default */
-		(part->type != PART_HAIR || part->effector_weights->flag & EFF_WEIGHT_DO_HAIR))
-	{
-		zero_v3(gr);
-		madd_v3_v3fl(gr, sim->scene->physics_settings.gravity, part->effector_weights->global_gravity * efdata.ptex.gravity);
-		gravity = gr;
-	}
+		for (n = 0; n < totpoint; n++) {
+			ParticleData *pa = psys->particles + index[point_index[n]];
+			ParticleKey *state = pint[point_index[n]].states + i;
 
-	/* maintain angular velocity */
-	copy_v3_v3(pa->state.ave, pa->prev_state.ave);
+			k = point_index[n];
 
-	integrate_particle(part, pa, dtime, gravity, basic_force_cb, &efdata);
+			mul_v3_fl(force[n], ptex[k].field);
+			mul_v3_fl(impulse[n], ptex[k].field);
 
-	/* damp affects final velocity */
-	if (part->dampfac != 0.f)
-		mul_v3_fl(pa->state.vel, 1.f - part->dampfac * efdata.ptex.damp * 25.f * dtime);
+			/* calculate air-particle interaction */
+			if (part->dragfac != 0.0f)
+				madd_v3_v3fl(force[n], state->vel, -part->dragfac * pa->size * pa->size * len_v3(state->vel));
 
-	//copy_v3_v3(pa->state.ave, states->ave);
+			/* brownian force */
+			if (part->brownfac != 0.0f) {
+				const unsigned int seed = psys_dynamics_seed(psys, index[k], cfra) + PSYS_FRAND_BROWNIAN + i * 3;
 
-	/* finally we do guides */
-	time=(cfra-pa->time)/pa->lifetime;
-	CLAMP(time, 0.0f, 1.0f);
+				force[n][0] += (BLI_hash_frand(seed + 0) - 0.5f) * part->brownfac;
+				force[n][1] += (BLI_hash_frand(seed + 1) - 0.5f) * part->brownfac;
+				force[n][2] += (BLI_hash_frand(seed + 2) - 0.5f) * part->brownfac;
+			}
 
-	copy_v3_v3(tkey.co,pa->state.co);
-	copy_v3_v3(tkey.vel,pa->state.vel);
-	tkey.time=pa->state.time;
+			if (part->flag & PART_ROT_DYN && epoint[n].ave)
+				copy_v3_v3(pa->state.ave, epoint[n].ave);
 
-	if (part->type != PART_HAIR) {
-		if (do_guides(sim->psys->part, sim->psys->effectors, &tkey, p, time)) {
-			copy_v3_v3(pa->state.co,tkey.co);
-			/* guides don't produce valid velocity */
-			sub_v3_v3v3(pa->state.vel, tkey.co, pa->prev_state.co);
-			mul_v3_fl(pa->state.vel,1.0f/dtime);
-			pa->state.time=tkey.time;
+			integrate_particle_step(pa, &pint[k], i, dtime[k], use_gravity ? gravity[k] : NULL, force[n], impulse[n]);
+		}
+	}
+
+	for (k = 0; k < tot; k++) {
+		ParticleData *pa = psys->particles + index[k];
+		ParticleKey tkey;
+		float time;
+
+		/* damp affects final velocity */
+		if (part->dampfac != 0.f)
+			mul_v3_fl(pa->state.vel, 1.f - part->dampfac * ptex[k].damp * 25.f * dtime[k]);
+
+		//copy_v3_v3(pa->state.ave, states->ave);
+
+		/* finally we do guides */
+		time=(cfra-pa->time)/pa->lifetime;
+		CLAMP(time, 0.0f, 1.0f);
+
+		copy_v3_v3(tkey.co,pa->state.co);
+		copy_v3_v3(tkey.vel,pa->state.vel);
+		tkey.time=pa->state.time;
+
+		if (part->type != PART_HAIR) {
+			if (do_guides(sim->psys->part, sim->psys->effectors, &tkey, index[k], time)) {
+				copy_v3_v3(pa->state.co,tkey.co);
+				/* guides don't produce valid velocity */
+				sub_v3_v3v3(pa->state.vel, tkey.co, pa->prev_state.co);
+				mul_v3_fl(pa->state.vel,1.0f/dtime[k]);
+				pa->state.time=tkey.time;
+			}
 		}
 	}
 }
+static void basic_integrate(ParticleSimulationData *sim, int p, float cfra)
+{
+	basic_integrate_batch(sim, &p, 1, cfra);
+}
 static void basic_rotate(ParticleSettings *part, ParticleData *pa, float dfra, float timestep)
 {
 	float rotfac, rot1[4], rot2[4] = {1.0,0.0,0.0,0.0}, dtime=dfra*timestep, extrotfac;
@@ -2644,7 +3015,7 @@ static int collision_response(ParticleData *pa, ParticleCollision *col, BVHTreeR
 	float f = col->f + x * (1.0f - col->f);				/* time factor of collision between timestep */
 	float dt1 = (f - col->f) * col->total_time;			/* time since previous collision (in seconds) */
 	float dt2 = (1.0f - f) * col->total_time;			/* time left after collision (in seconds) */
-	int through = (BLI_frand() < pd->pdef_perm) ? 1 : 0; /* did particle pass through the collision surface? */
+	int through = (BLI_hash_frand(col->seed++) < pd->pdef_perm) ? 1 : 0; /* did particle pass through the collision surface? */
 
 	/* calculate exact collision location */
 	interp_v3_v3v3(co, col->co1, col->co2, x);
@@ -2669,8 +3040,8 @@ static int collision_response(ParticleData *pa, ParticleCollision *col, BVHTreeR
 		float v0_tan[3];/* tangential component of v0 */
 		float vc_tan[3];/* tangential component of collision surface velocity */
 		float v0_dot, vc_dot;
-		float damp = pd->pdef_damp + pd->pdef_rdamp * 2 * (BLI_frand() - 0.5f);
-		float frict = pd->pdef_frict + pd->pdef_rfrict * 2 * (BLI_frand() - 0.5f);
+		float damp = pd->pdef_damp + pd->pdef_rdamp * 2 * (BLI_hash_frand(col->seed++) - 0.5f);
+		float frict = pd->pdef_frict + pd->pdef_rfrict * 2 * (BLI_hash_frand(col->seed++) - 0.5f);
 		float distance, nor[3], dot;
 
 		CLAMP(damp,0.0f, 1.0f);
@@ -2851,6 +3222,7 @@ static void collision_check(ParticleSimulationData *sim, int p, float dfra, floa
 
 	col.cfra = cfra;
 	col.old_cfra = sim->psys->cfra;
+	col.seed = psys_dynamics_seed(sim->psys, p, cfra) + PSYS_FRAND_COLLISION;
 
 	/* get acceleration (from gravity, forcefields etc. to be re-applied in collision response) */
 	sub_v3_v3v3(col.acc, pa->state.vel, pa->prev_state.vel);
@@ -3381,7 +3753,7 @@ static void dynamics_step_sph_ddr_task_cb_ex(
 	}
 
 	/* do global forces & effectors */
-	basic_integrate(sim, p, pa->state.time, data->cfra);
+	basic_integrate(sim, p, data->cfra);
 
 	/* actual fluids calculations */
 	sph_integrate(sim, pa, pa->state.time, sphdata);
@@ -3411,7 +3783,7 @@ static void dynamics_step_sph_classical_basic_integrate_task_cb_ex(
 		return;
 	}
 
-	basic_integrate(sim, p, pa->state.time, data->cfra);
+	basic_integrate(sim, p, data->cfra);
 }
 
 static void dynamics_step_sph_classical_calc_density_task_cb_ex(
@@ -3463,6 +3835,58 @@ static void dynamics_step_sph_classical_integrate_task_cb_ex(
 	}
 }
 
+static void dynamics_step_newton_task_cb(void *userdata, const int batch)
+{
+	DynamicStepSolverTaskData *data = userdata;
+	ParticleSimulationData *sim = data->sim;
+	ParticleSystem *psys = sim->psys;
+	ParticleSettings *part = psys->part;
+	const int start = batch * PSYS_DYNAMICS_BATCH;
+	const int end = min_ii(start + PSYS_DYNAMICS_BATCH, psys->totpart);
+	int index[PSYS_DYNAMICS_BATCH];
+	int p, k, tot = 0;
+
+	for (p = start; p < end; p++) {
+		if (psys->particles[p].state.time > 0.0f)
+			index[tot++] = p;
+	}
+
+	if (tot == 0)
+		return;
+
+	/* do global forces & effectors */
+	basic_integrate_batch(sim, index, tot, data->cfra);
+
+	for (k = 0; k < tot; k++) {
+		ParticleData *pa = psys->particles + index[k];
+
+		/* deflection */
+		if (sim->colliders)
+			collision_check(sim, index[k], pa->state.time, data->cfra);
+
+		/* rotations */
+		basic_rotate(part, pa, pa->state.time, data->timestep);
+	}
+}
+
+/* Effector noise is drawn from a generator shared by all particles, and a
+ * particle system affecting itself reads the states other batches write. */
+static bool psys_effectors_use_threading(ParticleSystem *psys)
+{
+	EffectorCache *eff;
+
+	if (psys->effectors) {
+		for (eff = psys->effectors->first; eff; eff = eff->next) {
+			if (eff->pd && eff->pd->f_noise > 0.0f)
+				return false;
+			if (eff->psys == psys)
+				return false;
+		}
+	}
+
+	return true;
+}
+
 /* unbaked particles are calculated dynamically */
 static void dynamics_step(ParticleSimulationData *sim, float cfra)
 {
@@ -3531,11 +3955,15 @@ static void dynamics_step(ParticleSimulationData *sim, float cfra)
 		case PART_PHYS_FLUID:
 		{
 			ParticleTarget *pt = psys->targets.first;
-			psys_update_particle_bvhtree(psys, cfra);
+			SPHFluidSettings *fluid = part->fluid;
+			/* same as the interaction radius of the density passes */
+			float cell_size = fluid->radius * (fluid->flag & SPH_FAC_RADIUS ? 4.0f * part->size : 1.0f);
+
+			psys_update_particle_sph_grid(psys, cfra, cell_size);
 			
-			for (; pt; pt=pt->next) {  /* Updating others systems particle tree for fluid-fluid interaction */
+			for (; pt; pt=pt->next) {  /* Updating others systems particle grid for fluid-fluid interaction */
 				if (pt->ob)
-					psys_update_particle_bvhtree(BLI_findlink(&pt->ob->particlesystem, pt->psys-1), cfra);
+					psys_update_particle_sph_grid(BLI_findlink(&pt->ob->particlesystem, pt->psys-1), cfra, cell_size);
 			}
 			break;
 		}
@@ -3586,17 +4014,15 @@ static void dynamics_step(ParticleSimulationData *sim, float cfra)
 	switch (part->phystype) {
 		case PART_PHYS_NEWTON:
 		{
-			LOOP_DYNAMIC_PARTICLES {
-				/* do global forces & effectors */
-				basic_integrate(sim, p, pa->state.time, cfra);
-	
-				/* deflection */
-				if (sim->colliders)
-					collision_check(sim, p, pa->state.time, cfra);
+			DynamicStepSolverTaskData task_data = {
+			    .sim = sim, .cfra = cfra, .timestep = timestep, .dtime = dtime,
+			};
+			const int totbatch = (psys->totpart + PSYS_DYNAMICS_BATCH - 1) / PSYS_DYNAMICS_BATCH;
 
-				/* rotations */
-				basic_rotate(part, pa, pa->state.time, timestep);
-			}
+			/* particles are independent here, so batches can run in any order */
+			BLI_task_parallel_range(
+			        0, totbatch, &task_data, dynamics_step_newton_task_cb,
+			        psys->totpart > 100 && psys_effectors_use_threading(psys));
 			break;
 		}
 		case PART_PHYS_BOIDS:
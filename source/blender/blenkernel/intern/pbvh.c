@@ -55,8 +55,6 @@
 
 #define STACK_FIXED_DEPTH   100
 
-#define PBVH_THREADED_LIMIT 4
-
 typedef struct PBVHStack {
 	PBVHNode *node;
 	bool revisiting;
@@ -241,15 +239,15 @@ void pbvh_grow_nodes(PBVH *bvh, int totnode)
  * a negative value for additional vertices */
 static int map_insert_vert(PBVH *bvh, GHash *map,
                            unsigned int *face_verts,
-                           unsigned int *uniq_verts, int vertex)
+                           unsigned int *uniq_verts, int vertex,
+                           const unsigned int leaf_index)
 {
 	void *key, **value_p;
 
 	key = SET_INT_IN_POINTER(vertex);
 	if (!BLI_ghash_ensure_p(map, key, &value_p)) {
 		int value_i;
-		if (BLI_BITMAP_TEST(bvh->vert_bitmap, vertex) == 0) {
-			BLI_BITMAP_ENABLE(bvh->vert_bitmap, vertex);
+		if (bvh->vert_leaf_owner[vertex] == leaf_index) {
 			value_i = *uniq_verts;
 			(*uniq_verts)++;
 		}
@@ -266,7 +264,7 @@ static int map_insert_vert(PBVH *bvh, GHash *map,
 }
 
 /* Find vertices used by the faces in this node and update the draw buffers */
-static void build_mesh_leaf_node(PBVH *bvh, PBVHNode *node)
+static void build_mesh_leaf_node(PBVH *bvh, PBVHNode *node, const unsigned int leaf_index)
 {
 	bool has_visible = false;
 
@@ -286,7 +284,7 @@ static void build_mesh_leaf_node(PBVH *bvh, PBVHNode *node)
 		for (int j = 0; j < 3; ++j) {
 			face_vert_indices[i][j] =
 			        map_insert_vert(bvh, map, &node->face_verts,
-			                        &node->uniq_verts, bvh->mloop[lt->tri[j]].v);
+			                        &node->uniq_verts, bvh->mloop[lt->tri[j]].v, leaf_index);
 		}
 
 		if (!paint_is_face_hidden(lt, bvh->verts, bvh->mloop)) {
@@ -389,9 +387,8 @@ static void build_leaf(PBVH *bvh, int node_index, BBC *prim_bbc,
 	/* Still need vb for searches */
 	update_vb(bvh, &bvh->nodes[node_index], prim_bbc, offset, count);
 		
-	if (bvh->looptri)
-		build_mesh_leaf_node(bvh, bvh->nodes + node_index);
-	else {
+	/* Mesh leaves are filled once the whole tree is built, see pbvh_build_mesh_leaves(). */
+	if (!bvh->looptri) {
 		build_grid_leaf_node(bvh, bvh->nodes + node_index);
 	}
 }
@@ -514,6 +511,109 @@ static void pbvh_build(PBVH *bvh, BB *cb, BBC *prim_bbc, int totprim)
 	build_sub(bvh, 0, cb, prim_bbc, 0, totprim);
 }
 
+/* Leaves in the order build_sub() creates them (depth first, first child first). */
+static void pbvh_gather_leaves_build_order(PBVH *bvh, PBVHNode *node, PBVHNode **r_leaves, int *r_totleaf)
+{
+	if (node->flag & PBVH_Leaf) {
+		r_leaves[(*r_totleaf)++] = node;
+	}
+	else {
+		pbvh_gather_leaves_build_order(bvh, bvh->nodes + node->children_offset, r_leaves, r_totleaf);
+		pbvh_gather_leaves_build_order(bvh, bvh->nodes + node->children_offset + 1, r_leaves, r_totleaf);
+	}
+}
+
+typedef struct PBVHBuildMeshLeavesData {
+	PBVH *bvh;
+	PBVHNode **leaves;
+} PBVHBuildMeshLeavesData;
+
+static void pbvh_build_mesh_leaves_owner_task_cb(void *userdata, const int n)
+{
+	PBVHBuildMeshLeavesData *data = userdata;
+	PBVH *bvh = data->bvh;
+	PBVHNode *node = data->leaves[n];
+	const unsigned int leaf_index = (unsigned int)n;
+
+	for (int i = 0; i < node->totprim; ++i) {
+		const MLoopTri *lt = &bvh->looptri[node->prim_indices[i]];
+
+		for (int j = 0; j < 3; ++j) {
+			/* A vertex is unique to the first leaf using it, keep the lowest leaf index. */
+			unsigned int *owner = &bvh->vert_leaf_owner[bvh->mloop[lt->tri[j]].v];
+			unsigned int owner_prev = *owner;
+
+			while (leaf_index < owner_prev) {
+				const unsigned int owner_curr = atomic_cas_uint32(owner, owner_prev, leaf_index);
+				if (owner_curr == owner_prev) {
+					break;
+				}
+				owner_prev = owner_curr;
+			}
+		}
+	}
+}
+
+static void pbvh_build_mesh_leaves_task_cb(void *userdata, const int n)
+{
+	PBVHBuildMeshLeavesData *data = userdata;
+
+	build_mesh_leaf_node(data->bvh, data->leaves[n], (unsigned int)n);
+}
+
+/* Fill vertex data of all mesh leaves in parallel.
+ * Unique vertices go to the same leaves as when they were filled one by one during the build. */
+static void pbvh_build_mesh_leaves(PBVH *bvh)
+{
+	PBVHNode **leaves = MEM_mallocN(sizeof(*leaves) * bvh->totnode, __func__);
+	int totleaf = 0;
+
+	pbvh_gather_leaves_build_order(bvh, bvh->nodes, leaves, &totleaf);
+
+	PBVHBuildMeshLeavesData data = {
+	    .bvh = bvh, .leaves = leaves,
+	};
+
+	BLI_task_parallel_range(0, totleaf, &data, pbvh_build_mesh_leaves_owner_task_cb, totleaf > PBVH_THREADED_LIMIT);
+
+	BLI_task_parallel_range(0, totleaf, &data, pbvh_build_mesh_leaves_task_cb, totleaf > PBVH_THREADED_LIMIT);
+
+	MEM_freeN(leaves);
+}
+
+typedef struct PBVHBuildMeshBBCData {
+	PBVH *bvh;
+	BBC *prim_bbc;
+	BB *cb;
+} PBVHBuildMeshBBCData;
+
+static void pbvh_build_mesh_bbc_task_cb(void *userdata, void *userdata_chunk, const int i, const int UNUSED(thread_id))
+{
+	PBVHBuildMeshBBCData *data = userdata;
+	PBVH *bvh = data->bvh;
+	BB *cb = userdata_chunk;
+
+	const MLoopTri *lt = &bvh->looptri[i];
+	const int sides = 3;
+	BBC *bbc = data->prim_bbc + i;
+
+	BB_reset((BB *)bbc);
+
+	for (int j = 0; j < sides; ++j)
+		BB_expand((BB *)bbc, bvh->verts[bvh->mloop[lt->tri[j]].v].co);
+
+	BBC_update_centroid(bbc);
+
+	BB_expand(cb, bbc->bcentroid);
+}
+
+static void pbvh_build_mesh_bbc_finalize(void *userdata, void *userdata_chunk)
+{
+	PBVHBuildMeshBBCData *data = userdata;
+
+	BB_expand_with_bb(data->cb, userdata_chunk);
+}
+
 /**
  * Do a full rebuild with on Mesh data structure.
  *
@@ -533,7 +633,6 @@ void BKE_pbvh_build_mesh(
 	bvh->mloop = mloop;
 	bvh->looptri = looptri;
 	bvh->verts = verts;
-	bvh->vert_bitmap = BLI_BITMAP_NEW(totvert, "bvh->vert_bitmap");
 	bvh->totvert = totvert;
 	bvh->leaf_limit = LEAF_LIMIT;
 	bvh->vdata = vdata;
@@ -543,26 +642,33 @@ void BKE_pbvh_build_mesh(
 	/* For each face, store the AABB and the AABB centroid */
 	prim_bbc = MEM_mallocN(sizeof(BBC) * looptri_num, "prim_bbc");
 
-	for (int i = 0; i < looptri_num; ++i) {
-		const MLoopTri *lt = &looptri[i];
-		const int sides = 3;
-		BBC *bbc = prim_bbc + i;
-
-		BB_reset((BB *)bbc);
-
-		for (int j = 0; j < sides; ++j)
-			BB_expand((BB *)bbc, verts[bvh->mloop[lt->tri[j]].v].co);
+	{
+		PBVHBuildMeshBBCData data = {
+		    .bvh = bvh, .prim_bbc = prim_bbc, .cb = &cb,
+		};
+		BB cb_chunk;
 
-		BBC_update_centroid(bbc);
+		BB_reset(&cb_chunk);
 
-		BB_expand(&cb, bbc->bcentroid);
+		BLI_task_parallel_range_finalize(
+		        0, looptri_num, &data, &cb_chunk, sizeof(cb_chunk),
+		        pbvh_build_mesh_bbc_task_cb, pbvh_build_mesh_bbc_finalize,
+		        looptri_num > LEAF_LIMIT, false);
 	}
 
-	if (looptri_num)
+	if (looptri_num) {
 		pbvh_build(bvh, &cb, prim_bbc, looptri_num);
 
+		bvh->vert_leaf_owner = MEM_mallocN(sizeof(*bvh->vert_leaf_owner) * totvert, __func__);
+		memset(bvh->vert_leaf_owner, 0xff, sizeof(*bvh->vert_leaf_owner) * totvert);
+
+		pbvh_build_mesh_leaves(bvh);
+
+		MEM_freeN(bvh->vert_leaf_owner);
+		bvh->vert_leaf_owner = NULL;
+	}
+
 	MEM_freeN(prim_bbc);
-	MEM_freeN(bvh->vert_bitmap);
 }
 
 /* Do a full rebuild with on Grids data structure */
@@ -982,6 +1088,31 @@ static void pbvh_update_normals_accum_task_cb(void *userdata, const int n)
 				}
 			}
 		}
+
+		/* Record which part of the draw buffers must be uploaded again,
+		 * the vertex flags are cleared once the normals are stored. */
+		const int *verts = node->vert_indices;
+		const int totvert = node->uniq_verts + node->face_verts;
+		int range[2] = {totvert, 0};
+
+		for (int i = 0; i < totvert; ++i) {
+			if (bvh->verts[verts[i]].flag & ME_VERT_PBVH_UPDATE) {
+				range[0] = min_ii(range[0], i);
+				range[1] = i + 1;
+			}
+		}
+
+		if (range[0] >= range[1]) {
+			/* No flagged vertices, the change is unknown (mask, deformed coordinates). */
+			node->draw_range_full = true;
+		}
+		else if (node->draw_range[0] >= node->draw_range[1]) {
+			copy_v2_v2_int(node->draw_range, range);
+		}
+		else {
+			node->draw_range[0] = min_ii(node->draw_range[0], range[0]);
+			node->draw_range[1] = max_ii(node->draw_range[1], range[1]);
+		}
 	}
 }
 
@@ -1129,16 +1260,27 @@ static void pbvh_update_draw_buffers(PBVH *bvh, PBVHNode **nodes, int totnode)
 					                        bvh->show_diffuse_color);
 					break;
 				case PBVH_FACES:
+				{
+					const int totvert = node->uniq_verts + node->face_verts;
+					int update_range[2] = {0, totvert};
+
+					if (!node->draw_range_full && node->draw_range[0] < node->draw_range[1])
+						copy_v2_v2_int(update_range, node->draw_range);
+
 					GPU_update_mesh_pbvh_buffers(node->draw_buffers,
 					                        bvh->verts,
 					                        node->vert_indices,
-					                        node->uniq_verts +
-					                        node->face_verts,
+					                        totvert,
 					                        CustomData_get_layer(bvh->vdata,
 					                                             CD_PAINT_MASK),
 					                        node->face_vert_indices,
-					                        bvh->show_diffuse_color);
+					                        bvh->show_diffuse_color,
+					                        update_range[0], update_range[1]);
+
+					node->draw_range[0] = node->draw_range[1] = 0;
+					node->draw_range_full = false;
 					break;
+				}
 				case PBVH_BMESH:
 					GPU_update_bmesh_pbvh_buffers(node->draw_buffers,
 					                         bvh->bm,
@@ -1171,7 +1313,8 @@ static int pbvh_flush_bb(PBVH *bvh, PBVHNode *node, int flag)
 {
 	int update = 0;
 
-	/* difficult to multithread well, we just do single threaded recursive */
+	/* difficult to multithread well, we just do single threaded recursive.
+	 * only the ancestors of leaves flagged for an update are refit. */
 	if (node->flag & PBVH_Leaf) {
 		if (flag & PBVH_UpdateBB) {
 			update |= (node->flag & PBVH_UpdateBB);
@@ -1343,11 +1486,13 @@ void BKE_pbvh_node_mark_update(PBVHNode *node)
 void BKE_pbvh_node_mark_rebuild_draw(PBVHNode *node)
 {
 	node->flag |= PBVH_RebuildDrawBuffers | PBVH_UpdateDrawBuffers | PBVH_UpdateRedraw;
+	node->draw_range_full = true;
 }
 
 void BKE_pbvh_node_mark_redraw(PBVHNode *node)
 {
 	node->flag |= PBVH_UpdateDrawBuffers | PBVH_UpdateRedraw;
+	node->draw_range_full = true;
 }
 
 void BKE_pbvh_node_mark_normals_update(PBVHNode *node)
@@ -1827,8 +1972,10 @@ static void pbvh_node_check_diffuse_changed(PBVH *bvh, PBVHNode *node)
 	if (!node->draw_buffers)
 		return;
 
-	if (GPU_pbvh_buffers_diffuse_changed(node->draw_buffers, node->bm_faces, bvh->show_diffuse_color))
+	if (GPU_pbvh_buffers_diffuse_changed(node->draw_buffers, node->bm_faces, bvh->show_diffuse_color)) {
 		node->flag |= PBVH_UpdateDrawBuffers;
+		node->draw_range_full = true;
+	}
 }
 
 void BKE_pbvh_draw(PBVH *bvh, float (*planes)[4], float (*fnors)[3],
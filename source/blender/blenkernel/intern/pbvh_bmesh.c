@@ -30,6 +30,7 @@
 #include "BLI_heap.h"
 #include "BLI_math.h"
 #include "BLI_memarena.h"
+#include "BLI_task.h"
 
 #include "BKE_ccg.h"
 #include "BKE_DerivedMesh.h"
@@ -917,59 +918,147 @@ static void short_edge_queue_edge_add(
 	}
 }
 
-static void long_edge_queue_face_add(
-        EdgeQueueContext *eq_ctx,
-        BMFace *f)
+/* Whether edges of this face are candidates for the queue,
+ * only reads the face so it can be called from worker threads. */
+static bool edge_queue_face_test(const EdgeQueue *q, BMFace *f)
 {
 #ifdef USE_EDGEQUEUE_FRONTFACE
-	if (eq_ctx->q->use_view_normal) {
-		if (dot_v3v3(f->no, eq_ctx->q->view_normal) < 0.0f) {
-			return;
+	if (q->use_view_normal) {
+		if (dot_v3v3(f->no, q->view_normal) < 0.0f) {
+			return false;
 		}
 	}
 #endif
 
-	if (edge_queue_tri_in_sphere(eq_ctx->q, f)) {
-		/* Check each edge of the face */
-		BMLoop *l_first = BM_FACE_FIRST_LOOP(f);
-		BMLoop *l_iter = l_first;
-		do {
+	return edge_queue_tri_in_sphere(q, f);
+}
+
+/* Face must have passed edge_queue_face_test() */
+static void long_edge_queue_face_edges_add(
+        EdgeQueueContext *eq_ctx,
+        BMFace *f)
+{
+	/* Check each edge of the face */
+	BMLoop *l_first = BM_FACE_FIRST_LOOP(f);
+	BMLoop *l_iter = l_first;
+	do {
 #ifdef USE_EDGEQUEUE_EVEN_SUBDIV
-			const float len_sq = BM_edge_calc_length_squared(l_iter->e);
-			if (len_sq > eq_ctx->q->limit_len_squared) {
-				long_edge_queue_edge_add_recursive(
-				        eq_ctx, l_iter->radial_next, l_iter,
-				        len_sq, eq_ctx->q->limit_len);
-			}
+		const float len_sq = BM_edge_calc_length_squared(l_iter->e);
+		if (len_sq > eq_ctx->q->limit_len_squared) {
+			long_edge_queue_edge_add_recursive(
+			        eq_ctx, l_iter->radial_next, l_iter,
+			        len_sq, eq_ctx->q->limit_len);
+		}
 #else
-			long_edge_queue_edge_add(eq_ctx, l_iter->e);
+		long_edge_queue_edge_add(eq_ctx, l_iter->e);
 #endif
-		} while ((l_iter = l_iter->next) != l_first);
+	} while ((l_iter = l_iter->next) != l_first);
+}
+
+static void long_edge_queue_face_add(
+        EdgeQueueContext *eq_ctx,
+        BMFace *f)
+{
+	if (edge_queue_face_test(eq_ctx->q, f)) {
+		long_edge_queue_face_edges_add(eq_ctx, f);
 	}
 }
 
-static void short_edge_queue_face_add(
+/* Face must have passed edge_queue_face_test() */
+static void short_edge_queue_face_edges_add(
         EdgeQueueContext *eq_ctx,
         BMFace *f)
 {
-#ifdef USE_EDGEQUEUE_FRONTFACE
-	if (eq_ctx->q->use_view_normal) {
-		if (dot_v3v3(f->no, eq_ctx->q->view_normal) < 0.0f) {
-			return;
+	BMLoop *l_iter;
+	BMLoop *l_first;
+
+	/* Check each edge of the face */
+	l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+	do {
+		short_edge_queue_edge_add(eq_ctx, l_iter->e);
+	} while ((l_iter = l_iter->next) != l_first);
+}
+
+typedef struct EdgeQueueGatherData {
+	const EdgeQueue *q;
+	PBVHNode **nodes;
+	/* Faces passing edge_queue_face_test(), each node has room for all its faces from its offset. */
+	BMFace **faces;
+	const int *node_face_offset;
+	int *node_face_num;
+} EdgeQueueGatherData;
+
+static void edge_queue_gather_faces_task_cb(void *userdata, const int n)
+{
+	EdgeQueueGatherData *data = userdata;
+	PBVHNode *node = data->nodes[n];
+	BMFace **faces = data->faces + data->node_face_offset[n];
+	int face_num = 0;
+	GSetIterator gs_iter;
+
+	GSET_ITER (gs_iter, node->bm_faces) {
+		BMFace *f = BLI_gsetIterator_getKey(&gs_iter);
+
+		if (edge_queue_face_test(data->q, f)) {
+			faces[face_num++] = f;
 		}
 	}
-#endif
 
-	if (edge_queue_tri_in_sphere(eq_ctx->q, f)) {
-		BMLoop *l_iter;
-		BMLoop *l_first;
+	data->node_face_num[n] = face_num;
+}
 
-		/* Check each edge of the face */
-		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
-		do {
-			short_edge_queue_edge_add(eq_ctx, l_iter->e);
-		} while ((l_iter = l_iter->next) != l_first);
+/* Add edges of faces of leaf nodes marked for topology update.
+ *
+ * Testing faces against the brush is done in parallel for all nodes,
+ * edges are then added in the same order as when faces were tested one by one. */
+static void edge_queue_add_nodes(
+        EdgeQueueContext *eq_ctx, PBVH *bvh,
+        void (*face_add_fn)(EdgeQueueContext *eq_ctx, BMFace *f))
+{
+	PBVHNode **nodes = MEM_mallocN(sizeof(*nodes) * (size_t)bvh->totnode, __func__);
+	int *node_face_offset = MEM_mallocN(sizeof(*node_face_offset) * (size_t)bvh->totnode, __func__);
+	int *node_face_num = MEM_mallocN(sizeof(*node_face_num) * (size_t)bvh->totnode, __func__);
+	int totnode = 0;
+	int totface = 0;
+
+	for (int n = 0; n < bvh->totnode; n++) {
+		PBVHNode *node = &bvh->nodes[n];
+
+		/* Check leaf nodes marked for topology update */
+		if ((node->flag & PBVH_Leaf) &&
+		    (node->flag & PBVH_UpdateTopology) &&
+		    !(node->flag & PBVH_FullyHidden))
+		{
+			nodes[totnode] = node;
+			node_face_offset[totnode] = totface;
+			totface += (int)BLI_gset_size(node->bm_faces);
+			totnode++;
+		}
 	}
+
+	if (totface) {
+		EdgeQueueGatherData data = {
+		    .q = eq_ctx->q, .nodes = nodes,
+		    .faces = MEM_mallocN(sizeof(BMFace *) * (size_t)totface, __func__),
+		    .node_face_offset = node_face_offset, .node_face_num = node_face_num,
+		};
+
+		BLI_task_parallel_range(0, totnode, &data, edge_queue_gather_faces_task_cb, totnode > PBVH_THREADED_LIMIT);
+
+		for (int n = 0; n < totnode; n++) {
+			BMFace **faces = data.faces + node_face_offset[n];
+
+			for (int i = 0; i < node_face_num[n]; i++) {
+				face_add_fn(eq_ctx, faces[i]);
+			}
+		}
+
+		MEM_freeN(data.faces);
+	}
+
+	MEM_freeN(nodes);
+	MEM_freeN(node_face_offset);
+	MEM_freeN(node_face_num);
 }
 
 /* Create a priority queue containing vertex pairs connected by a long
@@ -1005,24 +1094,7 @@ static void long_edge_queue_create(
 	pbvh_bmesh_edge_tag_verify(bvh);
 #endif
 
-	for (int n = 0; n < bvh->totnode; n++) {
-		PBVHNode *node = &bvh->nodes[n];
-
-		/* Check leaf nodes marked for topology update */
-		if ((node->flag & PBVH_Leaf) &&
-		    (node->flag & PBVH_UpdateTopology) &&
-		    !(node->flag & PBVH_FullyHidden))
-		{
-			GSetIterator gs_iter;
-
-			/* Check each face */
-			GSET_ITER (gs_iter, node->bm_faces) {
-				BMFace *f = BLI_gsetIterator_getKey(&gs_iter);
-
-				long_edge_queue_face_add(eq_ctx, f);
-			}
-		}
-	}
+	edge_queue_add_nodes(eq_ctx, bvh, long_edge_queue_face_edges_add);
 }
 
 /* Create a priority queue containing vertex pairs connected by a
@@ -1054,24 +1126,7 @@ static void short_edge_queue_create(
 	UNUSED_VARS(view_normal);
 #endif
 
-	for (int n = 0; n < bvh->totnode; n++) {
-		PBVHNode *node = &bvh->nodes[n];
-
-		/* Check leaf nodes marked for topology update */
-		if ((node->flag & PBVH_Leaf) &&
-		    (node->flag & PBVH_UpdateTopology) &&
-		    !(node->flag & PBVH_FullyHidden))
-		{
-			GSetIterator gs_iter;
-
-			/* Check each face */
-			GSET_ITER (gs_iter, node->bm_faces) {
-				BMFace *f = BLI_gsetIterator_getKey(&gs_iter);
-
-				short_edge_queue_face_add(eq_ctx, f);
-			}
-		}
-	}
+	edge_queue_add_nodes(eq_ctx, bvh, short_edge_queue_face_edges_add);
 }
 
 /*************************** Topology update **************************/
@@ -1555,6 +1610,8 @@ bool BKE_pbvh_bmesh_node_raycast_detail(
 }
 
 
+/* Single threaded on purpose: faces and verts of a node are updated together while they are in cache.
+ * Updating them in separate parallel passes was measured slower than this loop. */
 void pbvh_bmesh_normals_update(PBVHNode **nodes, int totnode)
 {
 	for (int n = 0; n < totnode; n++) {
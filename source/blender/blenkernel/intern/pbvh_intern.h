@@ -25,6 +25,9 @@
  *  \ingroup bli
  */
 
+/* Minimum number of nodes to process them in parallel */
+#define PBVH_THREADED_LIMIT 4
+
 /* Axis-aligned bounding box */
 typedef struct {
 	float bmin[3], bmax[3];
@@ -89,6 +92,15 @@ struct PBVHNode {
 	 */
 	const int (*face_vert_indices)[3];
 
+	/* Range of 'vert_indices' whose coordinates changed since the draw
+	 * buffers were last updated, so only that part is uploaded again.
+	 * Empty when start >= end, 'draw_range_full' requests a full upload.
+	 *
+	 * Used for leaf nodes in a mesh-based PBVH (not multires.)
+	 */
+	int draw_range[2];
+	bool draw_range_full;
+
 	/* Indicates whether this node is a leaf or not; also used for
 	 * marking various updates that need to be applied. */
 	PBVHNodeFlags flag : 16;
@@ -151,8 +163,9 @@ struct PBVH {
 	struct GridCommonGPUBuffer *grid_common_gpu_buffer;
 
 	/* Only used during BVH build and update,
-	 * don't need to remain valid after */
-	BLI_bitmap *vert_bitmap;
+	 * don't need to remain valid after.
+	 * For each vertex, index (in build order) of the leaf that has it as unique vertex. */
+	unsigned int *vert_leaf_owner;
 
 #ifdef PERFCNTRS
 	int perf_modified;
@@ -34,6 +34,13 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#ifndef WIN32
+#  include <sys/mman.h>
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
 #include "DNA_ID.h"
@@ -49,6 +56,7 @@
 #include "BLI_blenlib.h"
 #include "BLI_threads.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -71,10 +79,6 @@
 
 #include "BIK_api.h"
 
-#ifdef WITH_BULLET
-#  include "RBI_api.h"
-#endif
-
 /* both in intern */
 #ifdef WITH_SMOKE
 #include "smoke_API.h"
@@ -137,10 +141,34 @@ static int ptcache_extra_datasize[] = {
 };
 
 /* forward declerations */
+/* A block of data that is (optionally) compressed in the cache file:
+ * [compressed][size][data][props size][props], where only LZMA has props and uncompressed
+ * blocks have neither size nor props. (De)compressing and file access are separate so
+ * several blocks of a frame can be (de)compressed in parallel. */
+typedef struct PTCacheStream {
+	/* uncompressed data */
+	unsigned char *data;
+	unsigned int len;
+
+	unsigned char compressed;
+	/* data as stored in the file, points into the file mapping or buf */
+	const unsigned char *in;
+	size_t in_len;
+	unsigned char *buf;
+	unsigned char props[16];
+	size_t props_len;
+
+	int r;
+} PTCacheStream;
+
+static void ptcache_file_close(PTCacheFile *pf);
 static int ptcache_file_compressed_read(PTCacheFile *pf, unsigned char *result, unsigned int len);
 static int ptcache_file_compressed_write(PTCacheFile *pf, unsigned char *in, unsigned int in_len, unsigned char *out, int mode);
+static void ptcache_file_compressed_read_streams(PTCacheFile *pf, PTCacheStream *streams, int tot);
+static void ptcache_file_compressed_write_streams(PTCacheFile *pf, PTCacheStream *streams, int tot, int mode);
 static int ptcache_file_write(PTCacheFile *pf, const void *f, unsigned int tot, unsigned int size);
 static int ptcache_file_read(PTCacheFile *pf, void *f, unsigned int tot, unsigned int size);
+static void ptcache_file_seek(PTCacheFile *pf, long offset, int origin);
 
 /* Common functions */
 static int ptcache_basic_header_read(PTCacheFile *pf)
@@ -148,10 +176,10 @@ static int ptcache_basic_header_read(PTCacheFile *pf)
 	int error=0;
 
 	/* Custom functions should read these basic elements too! */
-	if (!error && !fread(&pf->totpoint, sizeof(unsigned int), 1, pf->fp))
+	if (!error && !ptcache_file_read(pf, &pf->totpoint, 1, sizeof(unsigned int)))
 		error = 1;
 	
-	if (!error && !fread(&pf->data_types, sizeof(unsigned int), 1, pf->fp))
+	if (!error && !ptcache_file_read(pf, &pf->data_types, 1, sizeof(unsigned int)))
 		error = 1;
 
 	return !error;
@@ -159,10 +187,10 @@ static int ptcache_basic_header_read(PTCacheFile *pf)
 static int ptcache_basic_header_write(PTCacheFile *pf)
 {
 	/* Custom functions should write these basic elements too! */
-	if (!fwrite(&pf->totpoint, sizeof(unsigned int), 1, pf->fp))
+	if (!ptcache_file_write(pf, &pf->totpoint, 1, sizeof(unsigned int)))
 		return 0;
 	
-	if (!fwrite(&pf->data_types, sizeof(unsigned int), 1, pf->fp))
+	if (!ptcache_file_write(pf, &pf->data_types, 1, sizeof(unsigned int)))
 		return 0;
 
 	return 1;
@@ -573,7 +601,231 @@ static void ptcache_smoke_error(void *smoke_v, const char *message)
 	modifier_setError(&smd->modifier, "%s", message);
 }
 
-#define SMOKE_CACHE_VERSION "1.04"
+#define SMOKE_CACHE_VERSION "1.05"
+/* last version storing the fields as dense arrays */
+#define SMOKE_CACHE_VERSION_DENSE "1.04"
+
+/* Fields are split in bricks of SMOKE_CACHE_BLOCK_SIZE^3 cells, only bricks
+ * with a non zero value in any of the sparse fields (density, fire, color) are
+ * written for those. Most of a smoke domain is usually empty, so this saves both
+ * compression time and disk space. Heat and velocity are nonzero almost
+ * everywhere in the domain and are always written whole. */
+#define SMOKE_CACHE_BLOCK_SIZE 8
+#define SMOKE_CACHE_MAX_FIELDS 12
+
+typedef struct SmokeCacheBlocks {
+	int res[3];
+	int blocks[3];
+	unsigned char *mask;
+	unsigned int totblock;
+	/* number of cells inside the active blocks */
+	unsigned int totcell;
+} SmokeCacheBlocks;
+
+static void ptcache_smoke_blocks_init(SmokeCacheBlocks *sb, const int res[3])
+{
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		sb->res[i] = res[i];
+		sb->blocks[i] = (res[i] + SMOKE_CACHE_BLOCK_SIZE - 1) / SMOKE_CACHE_BLOCK_SIZE;
+	}
+
+	sb->totblock = (unsigned int)(sb->blocks[0] * sb->blocks[1] * sb->blocks[2]);
+	sb->mask = MEM_callocN(sb->totblock, "smoke cache block mask");
+	sb->totcell = 0;
+}
+
+static void ptcache_smoke_blocks_free(SmokeCacheBlocks *sb)
+{
+	MEM_freeN(sb->mask);
+}
+
+/* bits of the low resolution fields stored in blocks, in the order
+ * density, heat, heatold, flame, fuel, react, r, g, b, vx, vy, vz */
+static unsigned int ptcache_smoke_sparse_fields(int fluid_fields)
+{
+	unsigned int sparse = 1u;
+	int i = 1;
+
+	if (fluid_fields & SM_ACTIVE_HEAT)
+		i += 2;
+	if (fluid_fields & SM_ACTIVE_FIRE) {
+		sparse |= 7u << i;
+		i += 3;
+	}
+	if (fluid_fields & SM_ACTIVE_COLORS)
+		sparse |= 7u << i;
+
+	return sparse;
+}
+
+/* activate the blocks containing a non zero value of field */
+static void ptcache_smoke_blocks_add(SmokeCacheBlocks *sb, const float *field)
+{
+	int x, y, z;
+
+	for (z = 0; z < sb->res[2]; z++) {
+		for (y = 0; y < sb->res[1]; y++) {
+			unsigned char *mask = sb->mask + ((z / SMOKE_CACHE_BLOCK_SIZE) * sb->blocks[1] + y / SMOKE_CACHE_BLOCK_SIZE) * sb->blocks[0];
+			const float *row = field + ((size_t)z * sb->res[1] + y) * sb->res[0];
+
+			for (x = 0; x < sb->res[0]; x++) {
+				if (row[x] != 0.0f)
+					mask[x / SMOKE_CACHE_BLOCK_SIZE] = 1;
+			}
+		}
+	}
+}
+
+static void ptcache_smoke_blocks_count(SmokeCacheBlocks *sb)
+{
+	int bx, by, bz;
+	unsigned int b = 0;
+
+	sb->totcell = 0;
+
+	for (bz = 0; bz < sb->blocks[2]; bz++) {
+		for (by = 0; by < sb->blocks[1]; by++) {
+			for (bx = 0; bx < sb->blocks[0]; bx++, b++) {
+				if (sb->mask[b]) {
+					sb->totcell += (unsigned int)(MIN2(SMOKE_CACHE_BLOCK_SIZE, sb->res[0] - bx * SMOKE_CACHE_BLOCK_SIZE) *
+					                              MIN2(SMOKE_CACHE_BLOCK_SIZE, sb->res[1] - by * SMOKE_CACHE_BLOCK_SIZE) *
+					                              MIN2(SMOKE_CACHE_BLOCK_SIZE, sb->res[2] - bz * SMOKE_CACHE_BLOCK_SIZE));
+				}
+			}
+		}
+	}
+}
+
+/* copy the cells of the active blocks from field to buffer, or back */
+static void ptcache_smoke_blocks_copy(const SmokeCacheBlocks *sb, float *field, float *buffer, bool to_buffer)
+{
+	int bx, by, bz, y, z;
+	unsigned int b = 0;
+
+	for (bz = 0; bz < sb->blocks[2]; bz++) {
+		for (by = 0; by < sb->blocks[1]; by++) {
+			for (bx = 0; bx < sb->blocks[0]; bx++, b++) {
+				const int x0 = bx * SMOKE_CACHE_BLOCK_SIZE;
+				const int y0 = by * SMOKE_CACHE_BLOCK_SIZE;
+				const int z0 = bz * SMOKE_CACHE_BLOCK_SIZE;
+				const int len = MIN2(SMOKE_CACHE_BLOCK_SIZE, sb->res[0] - x0);
+
+				if (!sb->mask[b])
+					continue;
+
+				for (z = z0; z < MIN2(z0 + SMOKE_CACHE_BLOCK_SIZE, sb->res[2]); z++) {
+					for (y = y0; y < MIN2(y0 + SMOKE_CACHE_BLOCK_SIZE, sb->res[1]); y++) {
+						float *row = field + ((size_t)z * sb->res[1] + y) * sb->res[0] + x0;
+
+						if (to_buffer)
+							memcpy(buffer, row, sizeof(float) * len);
+						else
+							memcpy(row, buffer, sizeof(float) * len);
+
+						buffer += len;
+					}
+				}
+			}
+		}
+	}
+}
+
+/* sparse has a bit set for every field that is stored in blocks */
+static void ptcache_smoke_write_fields(PTCacheFile *pf, const int res[3], float **fields, int totfield,
+                                       unsigned int sparse, int mode)
+{
+	const size_t totcell = (size_t)res[0] * res[1] * res[2];
+	SmokeCacheBlocks sb;
+	PTCacheStream streams[SMOKE_CACHE_MAX_FIELDS] = {{NULL}};
+	unsigned int in_len;
+	unsigned char *out;
+	float *buffer;
+	int i;
+
+	ptcache_smoke_blocks_init(&sb, res);
+
+	for (i = 0; i < totfield; i++) {
+		if (sparse & (1u << i))
+			ptcache_smoke_blocks_add(&sb, fields[i]);
+	}
+
+	ptcache_smoke_blocks_count(&sb);
+
+	out = (unsigned char *)MEM_callocN(LZO_OUT_LEN(sb.totblock) * 4, "pointcache_lzo_buffer");
+	ptcache_file_compressed_write(pf, sb.mask, sb.totblock, out, mode);
+	MEM_freeN(out);
+
+	/* gather all fields first so they can be compressed in parallel */
+	in_len = sizeof(float) * sb.totcell;
+	buffer = MEM_mallocN(MAX2(in_len, sizeof(float)) * totfield, "smoke cache blocks");
+
+	for (i = 0; i < totfield; i++) {
+		if (sparse & (1u << i)) {
+			streams[i].data = (unsigned char *)(buffer + (size_t)sb.totcell * i);
+			streams[i].len = in_len;
+			ptcache_smoke_blocks_copy(&sb, fields[i], (float *)streams[i].data, true);
+		}
+		else {
+			streams[i].data = (unsigned char *)fields[i];
+			streams[i].len = sizeof(float) * (unsigned int)totcell;
+		}
+	}
+
+	ptcache_file_compressed_write_streams(pf, streams, totfield, mode);
+
+	MEM_freeN(buffer);
+	ptcache_smoke_blocks_free(&sb);
+}
+
+static void ptcache_smoke_read_fields(PTCacheFile *pf, const int res[3], float **fields, int totfield,
+                                      unsigned int sparse, bool dense)
+{
+	const size_t totcell = (size_t)res[0] * res[1] * res[2];
+	SmokeCacheBlocks sb;
+	PTCacheStream streams[SMOKE_CACHE_MAX_FIELDS] = {{NULL}};
+	float *buffer;
+	int i;
+
+	if (dense) {
+		for (i = 0; i < totfield; i++) {
+			streams[i].data = (unsigned char *)fields[i];
+			streams[i].len = sizeof(float) * (unsigned int)totcell;
+		}
+		ptcache_file_compressed_read_streams(pf, streams, totfield);
+		return;
+	}
+
+	ptcache_smoke_blocks_init(&sb, res);
+	ptcache_file_compressed_read(pf, sb.mask, sb.totblock);
+	ptcache_smoke_blocks_count(&sb);
+
+	buffer = MEM_mallocN(MAX2(sizeof(float) * sb.totcell, sizeof(float)) * totfield, "smoke cache blocks");
+
+	for (i = 0; i < totfield; i++) {
+		if (sparse & (1u << i)) {
+			streams[i].data = (unsigned char *)(buffer + (size_t)sb.totcell * i);
+			streams[i].len = sizeof(float) * sb.totcell;
+		}
+		else {
+			streams[i].data = (unsigned char *)fields[i];
+			streams[i].len = sizeof(float) * (unsigned int)totcell;
+		}
+	}
+
+	ptcache_file_compressed_read_streams(pf, streams, totfield);
+
+	for (i = 0; i < totfield; i++) {
+		if (sparse & (1u << i)) {
+			memset(fields[i], 0, sizeof(float) * totcell);
+			ptcache_smoke_blocks_copy(&sb, fields[i], (float *)streams[i].data, false);
+		}
+	}
+
+	MEM_freeN(buffer);
+	ptcache_smoke_blocks_free(&sb);
+}
 
 static int  ptcache_smoke_write(PTCacheFile *pf, void *smoke_v)
 {	
@@ -592,6 +844,9 @@ static int  ptcache_smoke_write(PTCacheFile *pf, void *smoke_v)
 	if (sds->fluid) {
 		size_t res = sds->res[0]*sds->res[1]*sds->res[2];
 		float dt, dx, *dens, *react, *fuel, *flame, *heat, *heatold, *vx, *vy, *vz, *r, *g, *b;
+		float *fields[SMOKE_CACHE_MAX_FIELDS];
+		int totfield = 0;
+		unsigned int sparse;
 		unsigned char *obstacles;
 		unsigned int in_len = sizeof(float)*(unsigned int)res;
 		unsigned char *out = (unsigned char *)MEM_callocN(LZO_OUT_LEN(in_len) * 4, "pointcache_lzo_buffer");
@@ -601,25 +856,28 @@ static int  ptcache_smoke_write(PTCacheFile *pf, void *smoke_v)
 
 		smoke_export(sds->fluid, &dt, &dx, &dens, &react, &flame, &fuel, &heat, &heatold, &vx, &vy, &vz, &r, &g, &b, &obstacles);
 
-		ptcache_file_compressed_write(pf, (unsigned char *)sds->shadow, in_len, out, mode);
-		ptcache_file_compressed_write(pf, (unsigned char *)dens, in_len, out, mode);
+		fields[totfield++] = dens;
 		if (fluid_fields & SM_ACTIVE_HEAT) {
-			ptcache_file_compressed_write(pf, (unsigned char *)heat, in_len, out, mode);
-			ptcache_file_compressed_write(pf, (unsigned char *)heatold, in_len, out, mode);
+			fields[totfield++] = heat;
+			fields[totfield++] = heatold;
 		}
 		if (fluid_fields & SM_ACTIVE_FIRE) {
-			ptcache_file_compressed_write(pf, (unsigned char *)flame, in_len, out, mode);
-			ptcache_file_compressed_write(pf, (unsigned char *)fuel, in_len, out, mode);
-			ptcache_file_compressed_write(pf, (unsigned char *)react, in_len, out, mode);
+			fields[totfield++] = flame;
+			fields[totfield++] = fuel;
+			fields[totfield++] = react;
 		}
 		if (fluid_fields & SM_ACTIVE_COLORS) {
-			ptcache_file_compressed_write(pf, (unsigned char *)r, in_len, out, mode);
-			ptcache_file_compressed_write(pf, (unsigned char *)g, in_len, out, mode);
-			ptcache_file_compressed_write(pf, (unsigned char *)b, in_len, out, mode);
+			fields[totfield++] = r;
+			fields[totfield++] = g;
+			fields[totfield++] = b;
 		}
-		ptcache_file_compressed_write(pf, (unsigned char *)vx, in_len, out, mode);
-		ptcache_file_compressed_write(pf, (unsigned char *)vy, in_len, out, mode);
-		ptcache_file_compressed_write(pf, (unsigned char *)vz, in_len, out, mode);
+		fields[totfield++] = vx;
+		fields[totfield++] = vy;
+		fields[totfield++] = vz;
+		sparse = ptcache_smoke_sparse_fields(fluid_fields);
+
+		ptcache_file_compressed_write(pf, (unsigned char *)sds->shadow, in_len, out, mode);
+		ptcache_smoke_write_fields(pf, sds->res, fields, totfield, sparse, mode);
 		ptcache_file_compressed_write(pf, (unsigned char *)obstacles, (unsigned int)res, out, mode);
 		ptcache_file_write(pf, &dt, 1, sizeof(float));
 		ptcache_file_write(pf, &dx, 1, sizeof(float));
@@ -641,37 +899,34 @@ static int  ptcache_smoke_write(PTCacheFile *pf, void *smoke_v)
 
 	if (sds->wt) {
 		int res_big_array[3];
-		int res_big;
 		int res = sds->res[0]*sds->res[1]*sds->res[2];
 		float *dens, *react, *fuel, *flame, *tcu, *tcv, *tcw, *r, *g, *b;
+		float *fields[SMOKE_CACHE_MAX_FIELDS];
+		int totfield = 0;
 		unsigned int in_len = sizeof(float)*(unsigned int)res;
-		unsigned int in_len_big;
 		unsigned char *out;
 		int mode;
 
 		smoke_turbulence_get_res(sds->wt, res_big_array);
-		res_big = res_big_array[0]*res_big_array[1]*res_big_array[2];
 		//mode =  res_big >= 1000000 ? 2 : 1;
 		mode = 1;	// light
 		if (sds->cache_high_comp == SM_CACHE_HEAVY) mode=2;	// heavy
 
-		in_len_big = sizeof(float) * (unsigned int)res_big;
-
 		smoke_turbulence_export(sds->wt, &dens, &react, &flame, &fuel, &r, &g, &b, &tcu, &tcv, &tcw);
 
-		out = (unsigned char *)MEM_callocN(LZO_OUT_LEN(in_len_big), "pointcache_lzo_buffer");
-		ptcache_file_compressed_write(pf, (unsigned char *)dens, in_len_big, out, mode);
+		fields[totfield++] = dens;
 		if (fluid_fields & SM_ACTIVE_FIRE) {
-			ptcache_file_compressed_write(pf, (unsigned char *)flame, in_len_big, out, mode);
-			ptcache_file_compressed_write(pf, (unsigned char *)fuel, in_len_big, out, mode);
-			ptcache_file_compressed_write(pf, (unsigned char *)react, in_len_big, out, mode);
+			fields[totfield++] = flame;
+			fields[totfield++] = fuel;
+			fields[totfield++] = react;
 		}
 		if (fluid_fields & SM_ACTIVE_COLORS) {
-			ptcache_file_compressed_write(pf, (unsigned char *)r, in_len_big, out, mode);
-			ptcache_file_compressed_write(pf, (unsigned char *)g, in_len_big, out, mode);
-			ptcache_file_compressed_write(pf, (unsigned char *)b, in_len_big, out, mode);
+			fields[totfield++] = r;
+			fields[totfield++] = g;
+			fields[totfield++] = b;
 		}
-		MEM_freeN(out);
+		/* all high resolution fields only exist where there is smoke */
+		ptcache_smoke_write_fields(pf, res_big_array, fields, totfield, (1u << totfield) - 1, mode);
 
 		out = (unsigned char *)MEM_callocN(LZO_OUT_LEN(in_len), "pointcache_lzo_buffer");
 		ptcache_file_compressed_write(pf, (unsigned char *)tcu, in_len, out, mode);
@@ -771,13 +1026,17 @@ static int ptcache_smoke_read(PTCacheFile *pf, void *smoke_v)
 	int cache_fields = 0;
 	int active_fields = 0;
 	int reallocate = 0;
+	bool dense = false;
 
 	/* version header */
 	ptcache_file_read(pf, version, 4, sizeof(char));
-	if (!STREQLEN(version, SMOKE_CACHE_VERSION, 4))
+	if (STREQLEN(version, SMOKE_CACHE_VERSION_DENSE, 4)) {
+		dense = true;
+	}
+	else if (!STREQLEN(version, SMOKE_CACHE_VERSION, 4))
 	{
 		/* reset file pointer */
-		fseek(pf->fp, -4, SEEK_CUR);
+		ptcache_file_seek(pf, -4, SEEK_CUR);
 		return ptcache_smoke_read_old(pf, smoke_v);
 	}
 
@@ -816,30 +1075,33 @@ static int ptcache_smoke_read(PTCacheFile *pf, void *smoke_v)
 	if (sds->fluid) {
 		size_t res = sds->res[0]*sds->res[1]*sds->res[2];
 		float dt, dx, *dens, *react, *fuel, *flame, *heat, *heatold, *vx, *vy, *vz, *r, *g, *b;
+		float *fields[SMOKE_CACHE_MAX_FIELDS];
+		int totfield = 0;
 		unsigned char *obstacles;
 		unsigned int out_len = (unsigned int)res * sizeof(float);
 		
 		smoke_export(sds->fluid, &dt, &dx, &dens, &react, &flame, &fuel, &heat, &heatold, &vx, &vy, &vz, &r, &g, &b, &obstacles);
 
 		ptcache_file_compressed_read(pf, (unsigned char *)sds->shadow, out_len);
-		ptcache_file_compressed_read(pf, (unsigned char *)dens, out_len);
+		fields[totfield++] = dens;
 		if (cache_fields & SM_ACTIVE_HEAT) {
-			ptcache_file_compressed_read(pf, (unsigned char *)heat, out_len);
-			ptcache_file_compressed_read(pf, (unsigned char *)heatold, out_len);
+			fields[totfield++] = heat;
+			fields[totfield++] = heatold;
 		}
 		if (cache_fields & SM_ACTIVE_FIRE) {
-			ptcache_file_compressed_read(pf, (unsigned char *)flame, out_len);
-			ptcache_file_compressed_read(pf, (unsigned char *)fuel, out_len);
-			ptcache_file_compressed_read(pf, (unsigned char *)react, out_len);
+			fields[totfield++] = flame;
+			fields[totfield++] = fuel;
+			fields[totfield++] = react;
 		}
 		if (cache_fields & SM_ACTIVE_COLORS) {
-			ptcache_file_compressed_read(pf, (unsigned char *)r, out_len);
-			ptcache_file_compressed_read(pf, (unsigned char *)g, out_len);
-			ptcache_file_compressed_read(pf, (unsigned char *)b, out_len);
+			fields[totfield++] = r;
+			fields[totfield++] = g;
+			fields[totfield++] = b;
 		}
-		ptcache_file_compressed_read(pf, (unsigned char *)vx, out_len);
-		ptcache_file_compressed_read(pf, (unsigned char *)vy, out_len);
-		ptcache_file_compressed_read(pf, (unsigned char *)vz, out_len);
+		fields[totfield++] = vx;
+		fields[totfield++] = vy;
+		fields[totfield++] = vz;
+		ptcache_smoke_read_fields(pf, sds->res, fields, totfield, ptcache_smoke_sparse_fields(cache_fields), dense);
 		ptcache_file_compressed_read(pf, (unsigned char *)obstacles, (unsigned int)res);
 		ptcache_file_read(pf, &dt, 1, sizeof(float));
 		ptcache_file_read(pf, &dx, 1, sizeof(float));
@@ -857,28 +1119,28 @@ static int ptcache_smoke_read(PTCacheFile *pf, void *smoke_v)
 
 	if (pf->data_types & (1<<BPHYS_DATA_SMOKE_HIGH) && sds->wt) {
 			int res = sds->res[0]*sds->res[1]*sds->res[2];
-			int res_big, res_big_array[3];
+			int res_big_array[3];
 			float *dens, *react, *fuel, *flame, *tcu, *tcv, *tcw, *r, *g, *b;
+			float *fields[SMOKE_CACHE_MAX_FIELDS];
+			int totfield = 0;
 			unsigned int out_len = sizeof(float)*(unsigned int)res;
-			unsigned int out_len_big;
 
 			smoke_turbulence_get_res(sds->wt, res_big_array);
-			res_big = res_big_array[0]*res_big_array[1]*res_big_array[2];
-			out_len_big = sizeof(float) * (unsigned int)res_big;
 
 			smoke_turbulence_export(sds->wt, &dens, &react, &flame, &fuel, &r, &g, &b, &tcu, &tcv, &tcw);
 
-			ptcache_file_compressed_read(pf, (unsigned char *)dens, out_len_big);
+			fields[totfield++] = dens;
 			if (cache_fields & SM_ACTIVE_FIRE) {
-				ptcache_file_compressed_read(pf, (unsigned char *)flame, out_len_big);
-				ptcache_file_compressed_read(pf, (unsigned char *)fuel, out_len_big);
-				ptcache_file_compressed_read(pf, (unsigned char *)react, out_len_big);
+				fields[totfield++] = flame;
+				fields[totfield++] = fuel;
+				fields[totfield++] = react;
 			}
 			if (cache_fields & SM_ACTIVE_COLORS) {
-				ptcache_file_compressed_read(pf, (unsigned char *)r, out_len_big);
-				ptcache_file_compressed_read(pf, (unsigned char *)g, out_len_big);
-				ptcache_file_compressed_read(pf, (unsigned char *)b, out_len_big);
+				fields[totfield++] = r;
+				fields[totfield++] = g;
+				fields[totfield++] = b;
 			}
+			ptcache_smoke_read_fields(pf, res_big_array, fields, totfield, (1u << totfield) - 1, dense);
 
 			ptcache_file_compressed_read(pf, (unsigned char *)tcu, out_len);
 			ptcache_file_compressed_read(pf, (unsigned char *)tcv, out_len);
@@ -1288,10 +1550,7 @@ static int  ptcache_rigidbody_write(int index, void *rb_v, void **data, int UNUS
 		RigidBodyOb *rbo = ob->rigidbody_object;
 		
 		if (rbo->type == RBO_TYPE_ACTIVE) {
-#ifdef WITH_BULLET
-			RB_body_get_position(rbo->physics_object, rbo->pos);
-			RB_body_get_orientation(rbo->physics_object, rbo->orn);
-#endif
+			/* transforms were copied from the simulation before writing */
 			PTCACHE_DATA_FROM(data, BPHYS_DATA_LOCATION, rbo->pos);
 			PTCACHE_DATA_FROM(data, BPHYS_DATA_ROTATION, rbo->orn);
 		}
@@ -1849,27 +2108,566 @@ static int ptcache_filename(PTCacheID *pid, char *filename, int cfra, short do_p
 		if (pid->cache->index < 0)
 			pid->cache->index =  pid->stack_index = BKE_object_insert_ptcache(pid->ob);
 
-		const char *ext = ptcache_file_extension(pid);
+		const char *ext = ptcache_file_extension(pid);
+
+		if (pid->cache->flag & PTCACHE_EXTERNAL) {
+			if (pid->cache->index >= 0)
+				BLI_snprintf(newname, MAX_PTCACHE_FILE, "_%06d_%02u%s", cfra, pid->stack_index, ext); /* always 6 chars */
+			else
+				BLI_snprintf(newname, MAX_PTCACHE_FILE, "_%06d%s", cfra, ext); /* always 6 chars */
+		}
+		else {
+			BLI_snprintf(newname, MAX_PTCACHE_FILE, "_%06d_%02u%s", cfra, pid->stack_index, ext); /* always 6 chars */
+		}
+		len += 16;
+	}
+	
+	return len; /* make sure the above string is always 16 chars */
+}
+
+/* Single file cache
+ *
+ * Instead of a file per frame all frames of a cache can be stored in one file, which is
+ * a lot friendlier to file systems and network shares with long simulations. A frame is
+ * stored exactly like a per frame file, so the frame read and write code is shared:
+ *
+ * - header: "BPHYSCON", version, number of frames, offset of the frame index
+ * - frame data and indices, new frames and the index are always appended
+ * - index: a PTCacheContainerEntry for every frame, sorted by frame
+ *
+ * The header is only updated once a new index has been written, so a file where writing
+ * a frame was interrupted still has a valid index. Overwritten frames and old indices
+ * leave holes, once those take more space than the frames the live frames are copied to
+ * a new file which replaces the old one only when it's complete. */
+
+#define PTCACHE_CONTAINER_VERSION 1
+#define PTCACHE_CONTAINER_HEADER_SIZE 24
+#define PTCACHE_CONTAINER_COPY_BUFFER (1 << 20)
+
+typedef struct PTCacheContainerEntry {
+	int frame, pad;
+	uint64_t offset, size;
+} PTCacheContainerEntry;
+
+typedef struct PTCacheContainer {
+	FILE *fp;
+	char filename[MAX_PTCACHE_FILE];
+
+	PTCacheContainerEntry *entries;
+	unsigned int totentry, maxentry;
+
+	uint64_t index_offset, file_size;
+	/* start of the frame that is being written */
+	uint64_t write_offset;
+
+	bool writing;
+	/* index has to be written on close */
+	bool dirty;
+} PTCacheContainer;
+
+static int ptcache_fseek(FILE *fp, uint64_t offset, int origin)
+{
+#ifdef WIN32
+	return _fseeki64(fp, (__int64)offset, origin);
+#else
+	return fseeko(fp, (off_t)offset, origin);
+#endif
+}
+
+static uint64_t ptcache_ftell(FILE *fp)
+{
+#ifdef WIN32
+	return (uint64_t)_ftelli64(fp);
+#else
+	return (uint64_t)ftello(fp);
+#endif
+}
+
+static bool ptcache_file_copy_range(FILE *src, uint64_t src_offset, FILE *dst, uint64_t dst_offset,
+                                    uint64_t size, unsigned char *buffer)
+{
+	while (size) {
+		const size_t len = (size_t)MIN2(size, (uint64_t)PTCACHE_CONTAINER_COPY_BUFFER);
+
+		if (ptcache_fseek(src, src_offset, SEEK_SET) != 0 || fread(buffer, 1, len, src) != len)
+			return false;
+		if (ptcache_fseek(dst, dst_offset, SEEK_SET) != 0 || fwrite(buffer, 1, len, dst) != len)
+			return false;
+
+		src_offset += len;
+		dst_offset += len;
+		size -= len;
+	}
+
+	return true;
+}
+
+static bool ptcache_use_container(const PTCacheID *pid)
+{
+	return (pid->cache->flag & PTCACHE_SINGLE_FILE) && (pid->file_type == PTCACHE_FILE_PTCACHE);
+}
+
+static int ptcache_container_filename(PTCacheID *pid, char *filename)
+{
+	int len = ptcache_filename(pid, filename, 0, 1, 0);
+
+	if (len == 0)
+		return 0;
+
+	if (pid->cache->index < 0)
+		pid->cache->index = pid->stack_index = BKE_object_insert_ptcache(pid->ob);
+
+	if ((pid->cache->flag & PTCACHE_EXTERNAL) && pid->cache->index < 0)
+		len += BLI_snprintf(filename + len, MAX_PTCACHE_FILE - len, "%s", PTCACHE_CONTAINER_EXT);
+	else
+		len += BLI_snprintf(filename + len, MAX_PTCACHE_FILE - len, "_%02u%s", pid->stack_index, PTCACHE_CONTAINER_EXT);
+
+	return len;
+}
+
+static bool ptcache_container_read_index(PTCacheContainer *pc)
+{
+	char magic[8];
+	unsigned int version, totentry;
+	uint64_t index_offset;
+
+	if (ptcache_fseek(pc->fp, 0, SEEK_END) != 0)
+		return false;
+
+	pc->file_size = ptcache_ftell(pc->fp);
+
+	if (pc->file_size < PTCACHE_CONTAINER_HEADER_SIZE || ptcache_fseek(pc->fp, 0, SEEK_SET) != 0)
+		return false;
+
+	if (fread(magic, sizeof(char), 8, pc->fp) != 8 || !STREQLEN(magic, "BPHYSCON", 8))
+		return false;
+
+	if (!fread(&version, sizeof(unsigned int), 1, pc->fp) || version != PTCACHE_CONTAINER_VERSION)
+		return false;
+
+	if (!fread(&totentry, sizeof(unsigned int), 1, pc->fp) || !fread(&index_offset, sizeof(uint64_t), 1, pc->fp))
+		return false;
+
+	if (index_offset < PTCACHE_CONTAINER_HEADER_SIZE ||
+	    index_offset + (uint64_t)totentry * sizeof(PTCacheContainerEntry) > pc->file_size)
+	{
+		return false;
+	}
+
+	pc->maxentry = MAX2(totentry, 16u);
+	pc->entries = MEM_reallocN(pc->entries, sizeof(PTCacheContainerEntry) * pc->maxentry);
+
+	if (ptcache_fseek(pc->fp, index_offset, SEEK_SET) != 0 ||
+	    fread(pc->entries, sizeof(PTCacheContainerEntry), totentry, pc->fp) != totentry)
+	{
+		return false;
+	}
+
+	pc->totentry = totentry;
+	pc->index_offset = index_offset;
+
+	return true;
+}
+
+static int ptcache_container_entry_offset_cmp(const void *a, const void *b)
+{
+	const PTCacheContainerEntry *entry_a = *(const PTCacheContainerEntry **)a;
+	const PTCacheContainerEntry *entry_b = *(const PTCacheContainerEntry **)b;
+
+	if (entry_a->offset < entry_b->offset)
+		return -1;
+	return (entry_a->offset > entry_b->offset);
+}
+
+static bool ptcache_container_write_header(FILE *fp, unsigned int totentry, uint64_t index_offset)
+{
+	const char *bphysics = "BPHYSCON";
+	const unsigned int version = PTCACHE_CONTAINER_VERSION;
+
+	return (ptcache_fseek(fp, 0, SEEK_SET) == 0 &&
+	        fwrite(bphysics, sizeof(char), 8, fp) == 8 &&
+	        fwrite(&version, sizeof(unsigned int), 1, fp) &&
+	        fwrite(&totentry, sizeof(unsigned int), 1, fp) &&
+	        fwrite(&index_offset, sizeof(uint64_t), 1, fp));
+}
+
+/* Copies all frames to the front of a new file which then replaces the container file.
+ * Until the rename the old file is left untouched, if anything fails it's still valid. */
+static bool ptcache_container_compact(PTCacheContainer *pc)
+{
+	PTCacheContainerEntry *entries, **sorted;
+	unsigned char *buffer;
+	char filename_tmp[MAX_PTCACHE_FILE + 1];
+	uint64_t end = PTCACHE_CONTAINER_HEADER_SIZE;
+	unsigned int i;
+	bool ok = true;
+	FILE *fp;
+
+	BLI_snprintf(filename_tmp, sizeof(filename_tmp), "%s@", pc->filename);
+
+	fp = BLI_fopen(filename_tmp, "wb+");
+	if (fp == NULL)
+		return false;
+
+	entries = MEM_dupallocN(pc->entries);
+	sorted = MEM_mallocN(sizeof(PTCacheContainerEntry *) * MAX2(pc->totentry, 1u), "ptcache container sort");
+	buffer = MEM_mallocN(PTCACHE_CONTAINER_COPY_BUFFER, "ptcache container copy");
+
+	for (i = 0; i < pc->totentry; i++)
+		sorted[i] = &entries[i];
+
+	qsort(sorted, pc->totentry, sizeof(PTCacheContainerEntry *), ptcache_container_entry_offset_cmp);
+
+	/* header is written last, an incomplete file is never valid */
+	ok = ptcache_container_write_header(fp, 0, 0);
+
+	for (i = 0; ok && i < pc->totentry; i++) {
+		PTCacheContainerEntry *entry = sorted[i];
+
+		ok = ptcache_file_copy_range(pc->fp, entry->offset, fp, end, entry->size, buffer);
+		entry->offset = end;
+		end += entry->size;
+	}
+
+	ok = ok &&
+	     ptcache_fseek(fp, end, SEEK_SET) == 0 &&
+	     fwrite(entries, sizeof(PTCacheContainerEntry), pc->totentry, fp) == pc->totentry &&
+	     fflush(fp) == 0 &&
+	     ptcache_container_write_header(fp, pc->totentry, end) &&
+	     fflush(fp) == 0;
+
+	MEM_freeN(buffer);
+	MEM_freeN(sorted);
+
+	if (fclose(fp) != 0)
+		ok = false;
+
+	if (ok) {
+		fclose(pc->fp);
+
+		if (BLI_rename(filename_tmp, pc->filename) == 0) {
+			/* the new file has its index already */
+			MEM_freeN(pc->entries);
+			pc->entries = entries;
+			pc->index_offset = end;
+			pc->file_size = end + (uint64_t)pc->totentry * sizeof(PTCacheContainerEntry);
+			pc->fp = BLI_fopen(pc->filename, "rb+");
+			return true;
+		}
+
+		/* when the old file is gone too the new one is kept, it has all frames */
+		pc->fp = BLI_fopen(pc->filename, "rb+");
+		ok = false;
+	}
+
+	MEM_freeN(entries);
+
+	if (pc->fp)
+		BLI_delete(filename_tmp, false, false);
+
+	return ok;
+}
+
+static bool ptcache_container_write_index(PTCacheContainer *pc)
+{
+	uint64_t live = 0, index_offset;
+	unsigned int i;
+
+	for (i = 0; i < pc->totentry; i++)
+		live += pc->entries[i].size;
+
+	if (pc->file_size - PTCACHE_CONTAINER_HEADER_SIZE > 2 * live + (PTCACHE_CONTAINER_COPY_BUFFER / 4)) {
+		if (ptcache_container_compact(pc)) {
+			pc->dirty = false;
+			return true;
+		}
+
+		/* keep the holes, the index is appended as usual */
+		if (pc->fp == NULL)
+			return false;
+	}
+
+	/* never overwrite the index the header points to, an interrupted write
+	 * would leave the file without a valid index */
+	index_offset = pc->file_size;
+
+	if (ptcache_fseek(pc->fp, index_offset, SEEK_SET) != 0 ||
+	    fwrite(pc->entries, sizeof(PTCacheContainerEntry), pc->totentry, pc->fp) != pc->totentry)
+	{
+		return false;
+	}
+
+	pc->file_size = ptcache_ftell(pc->fp);
+	pc->index_offset = index_offset;
+
+	/* make sure the index is on disk before the header points to it */
+	fflush(pc->fp);
+
+	if (!ptcache_container_write_header(pc->fp, pc->totentry, pc->index_offset))
+		return false;
+
+	pc->dirty = false;
+
+	return true;
+}
+
+/* mode PTCACHE_FILE_UPDATE only opens existing files for changing the index */
+static PTCacheContainer *ptcache_container_open(PTCacheID *pid, int mode)
+{
+	PTCacheContainer *pc;
+	FILE *fp;
+	char filename[MAX_PTCACHE_FILE];
+
+	if (!ptcache_container_filename(pid, filename))
+		return NULL;
+
+	if (mode == PTCACHE_FILE_READ) {
+		fp = BLI_fopen(filename, "rb");
+	}
+	else if (mode == PTCACHE_FILE_WRITE) {
+		BLI_make_existing_file(filename);
+		fp = BLI_fopen(filename, "rb+");
+		if (fp == NULL)
+			fp = BLI_fopen(filename, "wb+");
+	}
+	else {
+		fp = BLI_fopen(filename, "rb+");
+	}
+
+	if (!fp)
+		return NULL;
+
+	pc = MEM_callocN(sizeof(PTCacheContainer), "PTCacheContainer");
+	pc->fp = fp;
+	BLI_strncpy(pc->filename, filename, sizeof(pc->filename));
+
+	if (!ptcache_container_read_index(pc)) {
+		/* only a new, empty file is started over, baked frames are never thrown away */
+		if (mode != PTCACHE_FILE_WRITE || pc->file_size != 0) {
+			if (mode != PTCACHE_FILE_READ)
+				printf("Point cache file '%s' is damaged or from a newer version, not using it\n", filename);
+
+			fclose(fp);
+			MEM_SAFE_FREE(pc->entries);
+			MEM_freeN(pc);
+			return NULL;
+		}
+
+		pc->totentry = 0;
+		pc->index_offset = 0;
+		pc->file_size = PTCACHE_CONTAINER_HEADER_SIZE;
+		pc->dirty = true;
+	}
+
+	if (pc->entries == NULL) {
+		pc->maxentry = 16;
+		pc->entries = MEM_mallocN(sizeof(PTCacheContainerEntry) * pc->maxentry, "ptcache container index");
+	}
+
+	return pc;
+}
+
+static void ptcache_container_close(PTCacheContainer *pc)
+{
+	if (pc->dirty && !ptcache_container_write_index(pc)) {
+		if (G.debug & G_DEBUG)
+			printf("Error writing disk cache index\n");
+	}
+
+	if (pc->fp)
+		fclose(pc->fp);
+	MEM_freeN(pc->entries);
+	MEM_freeN(pc);
+}
+
+/* first entry with a frame not below frame */
+static unsigned int ptcache_container_lower_bound(const PTCacheContainer *pc, int frame)
+{
+	unsigned int low = 0, high = pc->totentry;
+
+	while (low < high) {
+		const unsigned int mid = (low + high) / 2;
+
+		if (pc->entries[mid].frame < frame)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+static PTCacheContainerEntry *ptcache_container_find(PTCacheContainer *pc, int frame)
+{
+	const unsigned int i = ptcache_container_lower_bound(pc, frame);
+
+	return (i < pc->totentry && pc->entries[i].frame == frame) ? &pc->entries[i] : NULL;
+}
+
+static void ptcache_container_remove(PTCacheContainer *pc, int frame)
+{
+	PTCacheContainerEntry *entry = ptcache_container_find(pc, frame);
+
+	if (entry) {
+		const unsigned int i = (unsigned int)(entry - pc->entries);
+
+		memmove(entry, entry + 1, sizeof(PTCacheContainerEntry) * (pc->totentry - i - 1));
+		pc->totentry--;
+		pc->dirty = true;
+	}
+}
+
+static void ptcache_container_add(PTCacheContainer *pc, int frame, uint64_t offset, uint64_t size)
+{
+	PTCacheContainerEntry *entry;
+	unsigned int i;
+
+	ptcache_container_remove(pc, frame);
+
+	if (pc->totentry == pc->maxentry) {
+		pc->maxentry *= 2;
+		pc->entries = MEM_reallocN(pc->entries, sizeof(PTCacheContainerEntry) * pc->maxentry);
+	}
+
+	i = ptcache_container_lower_bound(pc, frame);
+	entry = &pc->entries[i];
+	memmove(entry + 1, entry, sizeof(PTCacheContainerEntry) * (pc->totentry - i));
+
+	entry->frame = frame;
+	entry->pad = 0;
+	entry->offset = offset;
+	entry->size = size;
+
+	pc->totentry++;
+	pc->file_size = MAX2(pc->file_size, offset + size);
+	pc->dirty = true;
+}
+
+/* Removes the frames the clear mode applies to from the single file cache. */
+static void ptcache_container_clear(PTCacheID *pid, int mode, int cfra)
+{
+	PointCache *cache = pid->cache;
+	PTCacheContainer *pc;
+	char filename[MAX_PTCACHE_FILE];
+	unsigned int i;
+
+	if (mode == PTCACHE_CLEAR_ALL) {
+		cache->last_exact = MIN2(cache->startframe, 0);
+
+		if (ptcache_container_filename(pid, filename) && BLI_exists(filename))
+			BLI_delete(filename, false, false);
+
+		if (cache->cached_frames)
+			memset(cache->cached_frames, 0, MEM_allocN_len(cache->cached_frames));
+
+		return;
+	}
+
+	pc = ptcache_container_open(pid, PTCACHE_FILE_UPDATE);
+
+	if (pc == NULL)
+		return;
+
+	for (i = 0; i < pc->totentry; ) {
+		const int frame = pc->entries[i].frame;
+
+		if ((mode == PTCACHE_CLEAR_BEFORE && frame < cfra) ||
+		    (mode == PTCACHE_CLEAR_AFTER && frame > cfra) ||
+		    (mode == PTCACHE_CLEAR_FRAME && frame == cfra))
+		{
+			ptcache_container_remove(pc, frame);
+
+			if (cache->cached_frames && frame >= cache->startframe && frame <= cache->endframe)
+				cache->cached_frames[frame - cache->startframe] = 0;
+		}
+		else {
+			i++;
+		}
+	}
+
+	ptcache_container_close(pc);
+}
+
+static bool ptcache_container_frame_exists(PTCacheID *pid, int cfra)
+{
+	PTCacheContainer *pc = ptcache_container_open(pid, PTCACHE_FILE_READ);
+	bool exists;
+
+	if (pc == NULL)
+		return false;
+
+	exists = (ptcache_container_find(pc, cfra) != NULL);
+	ptcache_container_close(pc);
+
+	return exists;
+}
+
+/* Gives read access to size bytes of the file from offset through pf->mem, using a
+ * mapping of the file where possible and a copy otherwise. Frames are read from
+ * memory so the compressed streams in them can be decompressed in parallel. */
+static bool ptcache_file_map(PTCacheFile *pf, uint64_t offset, uint64_t size)
+{
+	void *buffer;
+
+	if (size == 0 || size >= (uint64_t)SIZE_MAX)
+		return false;
+
+#ifndef WIN32
+	{
+		const uint64_t page_size = (uint64_t)sysconf(_SC_PAGESIZE);
+		const uint64_t map_offset = offset - offset % page_size;
+		const size_t map_len = (size_t)(offset + size - map_offset);
+		void *map = mmap(NULL, map_len, PROT_READ, MAP_PRIVATE, fileno(pf->fp), (off_t)map_offset);
+
+		if (map != MAP_FAILED) {
+			pf->map = map;
+			pf->map_len = map_len;
+			pf->mem = (const unsigned char *)map + (offset - map_offset);
+			pf->mem_len = (size_t)size;
+			pf->mem_pos = 0;
+			return true;
+		}
+	}
+#endif
+
+	/* mmap_win.h isn't thread safe outside of imbuf's lock, read a copy instead */
+	buffer = MEM_mallocN((size_t)size, "ptcache file copy");
+
+	if (ptcache_fseek(pf->fp, offset, SEEK_SET) != 0 || fread(buffer, 1, (size_t)size, pf->fp) != (size_t)size) {
+		MEM_freeN(buffer);
+		ptcache_fseek(pf->fp, 0, SEEK_SET);
+		return false;
+	}
+
+	pf->map = buffer;
+	pf->map_len = 0;
+	pf->mem = buffer;
+	pf->mem_len = (size_t)size;
+	pf->mem_pos = 0;
+
+	return true;
+}
 
-		if (pid->cache->flag & PTCACHE_EXTERNAL) {
-			if (pid->cache->index >= 0)
-				BLI_snprintf(newname, MAX_PTCACHE_FILE, "_%06d_%02u%s", cfra, pid->stack_index, ext); /* always 6 chars */
-			else
-				BLI_snprintf(newname, MAX_PTCACHE_FILE, "_%06d%s", cfra, ext); /* always 6 chars */
-		}
-		else {
-			BLI_snprintf(newname, MAX_PTCACHE_FILE, "_%06d_%02u%s", cfra, pid->stack_index, ext); /* always 6 chars */
-		}
-		len += 16;
+static void ptcache_file_unmap(PTCacheFile *pf)
+{
+	if (pf->map_len) {
+#ifndef WIN32
+		munmap(pf->map, pf->map_len);
+#endif
 	}
-	
-	return len; /* make sure the above string is always 16 chars */
+	else if (pf->map) {
+		MEM_freeN(pf->map);
+	}
+
+	pf->map = NULL;
+	pf->mem = NULL;
 }
 
 /* youll need to close yourself after! */
 static PTCacheFile *ptcache_file_open(PTCacheID *pid, int mode, int cfra)
 {
 	PTCacheFile *pf;
+	PTCacheContainer *pc = NULL;
 	FILE *fp = NULL;
 	char filename[FILE_MAX * 2];
 
@@ -1880,147 +2678,350 @@ static PTCacheFile *ptcache_file_open(PTCacheID *pid, int mode, int cfra)
 #endif
 	if (!G.relbase_valid && (pid->cache->flag & PTCACHE_EXTERNAL)==0) return NULL; /* save blend file before using disk pointcache */
 	
-	ptcache_filename(pid, filename, cfra, 1, 1);
-
-	if (mode==PTCACHE_FILE_READ) {
-		fp = BLI_fopen(filename, "rb");
+	if (ptcache_use_container(pid)) {
+		pc = ptcache_container_open(pid, (mode == PTCACHE_FILE_READ) ? PTCACHE_FILE_READ : PTCACHE_FILE_WRITE);
+		fp = pc ? pc->fp : NULL;
 	}
-	else if (mode==PTCACHE_FILE_WRITE) {
-		BLI_make_existing_file(filename); /* will create the dir if needs be, same as //textures is created */
-		fp = BLI_fopen(filename, "wb");
-	}
-	else if (mode==PTCACHE_FILE_UPDATE) {
-		BLI_make_existing_file(filename);
-		fp = BLI_fopen(filename, "rb+");
+	else {
+		ptcache_filename(pid, filename, cfra, 1, 1);
+
+		if (mode==PTCACHE_FILE_READ) {
+			fp = BLI_fopen(filename, "rb");
+		}
+		else if (mode==PTCACHE_FILE_WRITE) {
+			BLI_make_existing_file(filename); /* will create the dir if needs be, same as //textures is created */
+			fp = BLI_fopen(filename, "wb");
+		}
+		else if (mode==PTCACHE_FILE_UPDATE) {
+			BLI_make_existing_file(filename);
+			fp = BLI_fopen(filename, "rb+");
+		}
 	}
 
 	if (!fp)
 		return NULL;
 
-	pf= MEM_mallocN(sizeof(PTCacheFile), "PTCacheFile");
+	pf= MEM_callocN(sizeof(PTCacheFile), "PTCacheFile");
 	pf->fp= fp;
+	pf->container = pc;
 	pf->old_format = 0;
 	pf->frame = cfra;
 
+	if (pc) {
+		if (mode == PTCACHE_FILE_READ) {
+			const PTCacheContainerEntry *entry = ptcache_container_find(pc, cfra);
+
+			if (entry == NULL || !ptcache_file_map(pf, entry->offset, entry->size)) {
+				ptcache_file_close(pf);
+				return NULL;
+			}
+		}
+		else {
+			/* the frame is appended, it's added to the index when the file is closed */
+			ptcache_fseek(fp, pc->file_size, SEEK_SET);
+			pc->write_offset = pc->file_size;
+			pc->writing = true;
+		}
+	}
+	else if (mode == PTCACHE_FILE_READ) {
+		/* falls back to reading the file directly */
+		ptcache_file_map(pf, 0, BLI_file_descriptor_size(fileno(fp)));
+	}
+
 	return pf;
 }
 static void ptcache_file_close(PTCacheFile *pf)
 {
 	if (pf) {
-		fclose(pf->fp);
-		MEM_freeN(pf);
-	}
-}
+		ptcache_file_unmap(pf);
 
-static int ptcache_file_compressed_read(PTCacheFile *pf, unsigned char *result, unsigned int len)
-{
-	int r = 0;
-	unsigned char compressed = 0;
-	size_t in_len;
-#ifdef WITH_LZO
-	size_t out_len = len;
-#endif
-	unsigned char *in;
-	unsigned char *props = MEM_callocN(16 * sizeof(char), "tmp");
+		if (pf->container) {
+			PTCacheContainer *pc = pf->container;
+
+			if (pc->writing) {
+				const uint64_t end = ptcache_ftell(pf->fp);
+				ptcache_container_add(pc, pf->frame, pc->write_offset, end - pc->write_offset);
+			}
 
-	ptcache_file_read(pf, &compressed, 1, sizeof(unsigned char));
-	if (compressed) {
-		unsigned int size;
-		ptcache_file_read(pf, &size, 1, sizeof(unsigned int));
-		in_len = (size_t)size;
-		if (in_len==0) {
-			/* do nothing */
+			ptcache_container_close(pc);
 		}
 		else {
-			in = (unsigned char *)MEM_callocN(sizeof(unsigned char)*in_len, "pointcache_compressed_buffer");
-			ptcache_file_read(pf, in, in_len, sizeof(unsigned char));
-#ifdef WITH_LZO
-			if (compressed == 1)
-				r = lzo1x_decompress_safe(in, (lzo_uint)in_len, result, (lzo_uint *)&out_len, NULL);
-#endif
-#ifdef WITH_LZMA
-			if (compressed == 2) {
-				size_t sizeOfIt;
-				size_t leni = in_len, leno = len;
-				ptcache_file_read(pf, &size, 1, sizeof(unsigned int));
-				sizeOfIt = (size_t)size;
-				ptcache_file_read(pf, props, sizeOfIt, sizeof(unsigned char));
-				r = LzmaUncompress(result, &leno, in, &leni, props, sizeOfIt);
-			}
-#endif
-			MEM_freeN(in);
+			fclose(pf->fp);
 		}
+
+		MEM_freeN(pf);
 	}
-	else {
-		ptcache_file_read(pf, result, len, sizeof(unsigned char));
-	}
+}
 
-	MEM_freeN(props);
+/* streams smaller than this together aren't worth threading */
+#define PTCACHE_STREAM_THREADED_SIZE (1 << 16)
 
-	return r;
-}
-static int ptcache_file_compressed_write(PTCacheFile *pf, unsigned char *in, unsigned int in_len, unsigned char *out, int mode)
+static void ptcache_stream_compress(PTCacheStream *st, unsigned char *out, int mode)
 {
 	int r = 0;
-	unsigned char compressed = 0;
-	size_t out_len= 0;
-	unsigned char *props = MEM_callocN(16 * sizeof(char), "tmp");
+	size_t out_len = LZO_OUT_LEN(st->len);
 	size_t sizeOfIt = 5;
 
 	(void)mode; /* unused when building w/o compression */
 
+	st->compressed = 0;
+
 #ifdef WITH_LZO
-	out_len= LZO_OUT_LEN(in_len);
 	if (mode == 1) {
 		LZO_HEAP_ALLOC(wrkmem, LZO1X_MEM_COMPRESS);
 		
-		r = lzo1x_1_compress(in, (lzo_uint)in_len, out, (lzo_uint *)&out_len, wrkmem);
-		if (!(r == LZO_E_OK) || (out_len >= in_len))
-			compressed = 0;
-		else
-			compressed = 1;
+		r = lzo1x_1_compress(st->data, (lzo_uint)st->len, out, (lzo_uint *)&out_len, wrkmem);
+		if ((r == LZO_E_OK) && (out_len < st->len))
+			st->compressed = 1;
 	}
 #endif
 #ifdef WITH_LZMA
 	if (mode == 2) {
 		
-		r = LzmaCompress(out, &out_len, in, in_len, //assume sizeof(char)==1....
-		                 props, &sizeOfIt, 5, 1 << 24, 3, 0, 2, 32, 2);
+		r = LzmaCompress(out, &out_len, st->data, st->len, //assume sizeof(char)==1....
+		                 st->props, &sizeOfIt, 5, 1 << 24, 3, 0, 2, 32, 2);
 
-		if (!(r == SZ_OK) || (out_len >= in_len))
-			compressed = 0;
-		else
-			compressed = 2;
+		if ((r == SZ_OK) && (out_len < st->len))
+			st->compressed = 2;
 	}
 #endif
-	
-	ptcache_file_write(pf, &compressed, 1, sizeof(unsigned char));
-	if (compressed) {
-		unsigned int size = out_len;
+
+	st->in = out;
+	st->in_len = out_len;
+	st->props_len = sizeOfIt;
+	st->r = r;
+}
+static void ptcache_stream_write(PTCacheFile *pf, const PTCacheStream *st)
+{
+	ptcache_file_write(pf, &st->compressed, 1, sizeof(unsigned char));
+	if (st->compressed) {
+		unsigned int size = (unsigned int)st->in_len;
 		ptcache_file_write(pf, &size, 1, sizeof(unsigned int));
-		ptcache_file_write(pf, out, out_len, sizeof(unsigned char));
+		ptcache_file_write(pf, st->in, size, sizeof(unsigned char));
 	}
 	else
-		ptcache_file_write(pf, in, in_len, sizeof(unsigned char));
+		ptcache_file_write(pf, st->data, st->len, sizeof(unsigned char));
+
+	if (st->compressed == 2) {
+		unsigned int size = (unsigned int)st->props_len;
+		ptcache_file_write(pf, &size, 1, sizeof(unsigned int));
+		ptcache_file_write(pf, st->props, size, sizeof(unsigned char));
+	}
+}
+/* Reads everything but the decompression, compressed data stays in the file mapping. */
+static bool ptcache_stream_read(PTCacheFile *pf, PTCacheStream *st)
+{
+	unsigned int size;
+
+	st->compressed = 0;
+	st->in = NULL;
+	st->in_len = st->len;
+	st->buf = NULL;
+	st->props_len = 0;
+	st->r = 0;
+
+	if (!ptcache_file_read(pf, &st->compressed, 1, sizeof(unsigned char)))
+		return false;
+
+	if (st->compressed) {
+		if (!ptcache_file_read(pf, &size, 1, sizeof(unsigned int)))
+			return false;
+		st->in_len = (size_t)size;
+	}
 
-	if (compressed == 2) {
-		unsigned int size = sizeOfIt;
-		ptcache_file_write(pf, &sizeOfIt, 1, sizeof(unsigned int));
-		ptcache_file_write(pf, props, size, sizeof(unsigned char));
+	if (pf->mem) {
+		if (st->in_len > pf->mem_len - pf->mem_pos)
+			return false;
+		st->in = pf->mem + pf->mem_pos;
+		pf->mem_pos += st->in_len;
+	}
+	else if (!st->compressed) {
+		st->in = st->data;
+		if (!ptcache_file_read(pf, st->data, st->len, sizeof(unsigned char)))
+			return false;
+	}
+	else if (st->in_len) {
+		st->buf = MEM_mallocN(st->in_len, "pointcache_compressed_buffer");
+		st->in = st->buf;
+		if (!ptcache_file_read(pf, st->buf, st->in_len, sizeof(unsigned char)))
+			return false;
+	}
+
+	if (st->compressed == 2) {
+		if (!ptcache_file_read(pf, &size, 1, sizeof(unsigned int)) || size > sizeof(st->props))
+			return false;
+		if (!ptcache_file_read(pf, st->props, size, sizeof(unsigned char)))
+			return false;
+		st->props_len = (size_t)size;
+	}
+
+	return true;
+}
+static int ptcache_stream_decompress(PTCacheStream *st)
+{
+	int r = 0;
+
+	if (st->in == NULL) {
+		/* do nothing */
+	}
+	else if (!st->compressed) {
+		if (st->in != st->data)
+			memcpy(st->data, st->in, st->len);
+	}
+	else if (st->in_len) {
+#ifdef WITH_LZO
+		if (st->compressed == 1) {
+			size_t out_len = st->len;
+			r = lzo1x_decompress_safe(st->in, (lzo_uint)st->in_len, st->data, (lzo_uint *)&out_len, NULL);
+		}
+#endif
+#ifdef WITH_LZMA
+		if (st->compressed == 2) {
+			size_t leni = st->in_len, leno = st->len;
+			r = LzmaUncompress(st->data, &leno, st->in, &leni, st->props, st->props_len);
+		}
+#endif
 	}
 
-	MEM_freeN(props);
+	MEM_SAFE_FREE(st->buf);
+	st->r = r;
 
 	return r;
 }
+
+static int ptcache_file_compressed_read(PTCacheFile *pf, unsigned char *result, unsigned int len)
+{
+	PTCacheStream st = {NULL};
+
+	st.data = result;
+	st.len = len;
+
+	if (!ptcache_stream_read(pf, &st)) {
+		MEM_SAFE_FREE(st.buf);
+		return 0;
+	}
+
+	return ptcache_stream_decompress(&st);
+}
+static int ptcache_file_compressed_write(PTCacheFile *pf, unsigned char *in, unsigned int in_len, unsigned char *out, int mode)
+{
+	PTCacheStream st = {NULL};
+
+	st.data = in;
+	st.len = in_len;
+
+	ptcache_stream_compress(&st, out, mode);
+	ptcache_stream_write(pf, &st);
+
+	return st.r;
+}
+
+typedef struct PTCacheStreamsData {
+	PTCacheStream *streams;
+	int mode;
+} PTCacheStreamsData;
+
+static bool ptcache_streams_use_threading(const PTCacheStream *streams, int tot)
+{
+	size_t len = 0;
+	int i;
+
+	for (i = 0; i < tot; i++)
+		len += streams[i].len;
+
+	return (tot > 1) && (len >= PTCACHE_STREAM_THREADED_SIZE);
+}
+
+static void ptcache_streams_compress_cb(void *userdata, const int i)
+{
+	PTCacheStreamsData *data = userdata;
+	PTCacheStream *st = &data->streams[i];
+
+	st->buf = MEM_mallocN(LZO_OUT_LEN(st->len), "pointcache_lzo_buffer");
+	ptcache_stream_compress(st, st->buf, data->mode);
+}
+
+static void ptcache_streams_decompress_cb(void *userdata, const int i)
+{
+	PTCacheStreamsData *data = userdata;
+
+	ptcache_stream_decompress(&data->streams[i]);
+}
+
+/* Compresses the streams in parallel, then writes them in order. Batches of thread count
+ * streams are done at once to bound the memory used for compressed data. */
+static void ptcache_file_compressed_write_streams(PTCacheFile *pf, PTCacheStream *streams, int tot, int mode)
+{
+	PTCacheStreamsData data = {streams, mode};
+	const int batch = MAX2(BLI_system_thread_count(), 1);
+	int first, i;
+
+	for (first = 0; first < tot; first += batch) {
+		const int last = MIN2(first + batch, tot);
+
+		BLI_task_parallel_range(first, last, &data, ptcache_streams_compress_cb,
+		                        ptcache_streams_use_threading(streams + first, last - first));
+
+		for (i = first; i < last; i++) {
+			ptcache_stream_write(pf, &streams[i]);
+			MEM_freeN(streams[i].buf);
+			streams[i].buf = NULL;
+		}
+	}
+}
+
+/* Reads the streams in order, then decompresses them in parallel. */
+static void ptcache_file_compressed_read_streams(PTCacheFile *pf, PTCacheStream *streams, int tot)
+{
+	PTCacheStreamsData data = {streams, 0};
+	int i;
+
+	for (i = 0; i < tot; i++) {
+		if (!ptcache_stream_read(pf, &streams[i])) {
+			/* leave the remaining data untouched, same as a failed read */
+			for (; i < tot; i++) {
+				MEM_SAFE_FREE(streams[i].buf);
+				streams[i].in = NULL;
+			}
+			break;
+		}
+	}
+
+	BLI_task_parallel_range(0, tot, &data, ptcache_streams_decompress_cb,
+	                        ptcache_streams_use_threading(streams, tot));
+}
 static int ptcache_file_read(PTCacheFile *pf, void *f, unsigned int tot, unsigned int size)
 {
+	if (pf->mem) {
+		const size_t len = (size_t)tot * size;
+
+		if (len > pf->mem_len - pf->mem_pos) {
+			pf->mem_pos = pf->mem_len;
+			return 0;
+		}
+
+		memcpy(f, pf->mem + pf->mem_pos, len);
+		pf->mem_pos += len;
+
+		return 1;
+	}
+
 	return (fread(f, size, tot, pf->fp) == tot);
 }
 static int ptcache_file_write(PTCacheFile *pf, const void *f, unsigned int tot, unsigned int size)
 {
 	return (fwrite(f, size, tot, pf->fp) == tot);
 }
+static void ptcache_file_seek(PTCacheFile *pf, long offset, int origin)
+{
+	if (pf->mem) {
+		const size_t pos = (origin == SEEK_CUR) ? pf->mem_pos : 0;
+		pf->mem_pos = ((long)pos + offset < 0) ? 0 : MIN2(pos + offset, pf->mem_len);
+	}
+	else {
+		fseek(pf->fp, offset, origin);
+	}
+}
 static int ptcache_file_data_read(PTCacheFile *pf)
 {
 	int i;
@@ -2051,13 +3052,13 @@ static int ptcache_file_header_begin_read(PTCacheFile *pf)
 	
 	pf->data_types = 0;
 	
-	if (fread(bphysics, sizeof(char), 8, pf->fp) != 8)
+	if (!ptcache_file_read(pf, bphysics, 8, sizeof(char)))
 		error = 1;
 	
 	if (!error && !STREQLEN(bphysics, "BPHYSICS", 8))
 		error = 1;
 
-	if (!error && !fread(&typeflag, sizeof(unsigned int), 1, pf->fp))
+	if (!error && !ptcache_file_read(pf, &typeflag, 1, sizeof(unsigned int)))
 		error = 1;
 
 	pf->type = (typeflag & PTCACHE_TYPEFLAG_TYPEMASK);
@@ -2065,7 +3066,7 @@ static int ptcache_file_header_begin_read(PTCacheFile *pf)
 	
 	/* if there was an error set file as it was */
 	if (error)
-		fseek(pf->fp, 0, SEEK_SET);
+		ptcache_file_seek(pf, 0, SEEK_SET);
 
 	return !error;
 }
@@ -2307,11 +3308,18 @@ static PTCacheMem *ptcache_disk_frame_to_mem(PTCacheID *pid, int cfra)
 		ptcache_data_alloc(pm);
 
 		if (pf->flag & PTCACHE_TYPEFLAG_COMPRESS) {
+			PTCacheStream streams[BPHYS_TOT_DATA] = {{NULL}};
+			int totstream = 0;
+
 			for (i=0; i<BPHYS_TOT_DATA; i++) {
-				unsigned int out_len = pm->totpoint*ptcache_data_size[i];
-				if (pf->data_types & (1<<i))
-					ptcache_file_compressed_read(pf, (unsigned char *)(pm->data[i]), out_len);
+				if (pf->data_types & (1<<i)) {
+					streams[totstream].data = (unsigned char *)(pm->data[i]);
+					streams[totstream].len = pm->totpoint*ptcache_data_size[i];
+					totstream++;
+				}
 			}
+
+			ptcache_file_compressed_read_streams(pf, streams, totstream);
 		}
 		else {
 			BKE_ptcache_mem_pointers_init(pm);
@@ -2394,14 +3402,18 @@ static int ptcache_mem_frame_to_disk(PTCacheID *pid, PTCacheMem *pm)
 
 	if (!error) {
 		if (pid->cache->compression) {
+			PTCacheStream streams[BPHYS_TOT_DATA] = {{NULL}};
+			int totstream = 0;
+
 			for (i=0; i<BPHYS_TOT_DATA; i++) {
 				if (pm->data[i]) {
-					unsigned int in_len = pm->totpoint*ptcache_data_size[i];
-					unsigned char *out = (unsigned char *)MEM_callocN(LZO_OUT_LEN(in_len) * 4, "pointcache_lzo_buffer");
-					ptcache_file_compressed_write(pf, (unsigned char *)(pm->data[i]), in_len, out, pid->cache->compression);
-					MEM_freeN(out);
+					streams[totstream].data = (unsigned char *)(pm->data[i]);
+					streams[totstream].len = pm->totpoint*ptcache_data_size[i];
+					totstream++;
 				}
 			}
+
+			ptcache_file_compressed_write_streams(pf, streams, totstream, pid->cache->compression);
 		}
 		else {
 			BKE_ptcache_mem_pointers_init(pm);
@@ -2978,7 +3990,10 @@ void BKE_ptcache_id_clear(PTCacheID *pid, int mode, unsigned int cfra)
 	case PTCACHE_CLEAR_ALL:
 	case PTCACHE_CLEAR_BEFORE:
 	case PTCACHE_CLEAR_AFTER:
-		if (pid->cache->flag & PTCACHE_DISK_CACHE) {
+		if ((pid->cache->flag & PTCACHE_DISK_CACHE) && ptcache_use_container(pid)) {
+			ptcache_container_clear(pid, mode, cfra);
+		}
+		else if (pid->cache->flag & PTCACHE_DISK_CACHE) {
 			ptcache_path(pid, path);
 			
 			dir = opendir(path);
@@ -3065,7 +4080,10 @@ void BKE_ptcache_id_clear(PTCacheID *pid, int mode, unsigned int cfra)
 		break;
 		
 	case PTCACHE_CLEAR_FRAME:
-		if (pid->cache->flag & PTCACHE_DISK_CACHE) {
+		if ((pid->cache->flag & PTCACHE_DISK_CACHE) && ptcache_use_container(pid)) {
+			ptcache_container_clear(pid, mode, cfra);
+		}
+		else if (pid->cache->flag & PTCACHE_DISK_CACHE) {
 			if (BKE_ptcache_id_exist(pid, cfra)) {
 				ptcache_filename(pid, filename, cfra, 1, 1); /* no path */
 				BLI_delete(filename, false, false);
@@ -3103,6 +4121,9 @@ int  BKE_ptcache_id_exist(PTCacheID *pid, int cfra)
 	
 	if (pid->cache->flag & PTCACHE_DISK_CACHE) {
 		char filename[MAX_PTCACHE_FILE];
+
+		if (ptcache_use_container(pid))
+			return ptcache_container_frame_exists(pid, cfra);
 		
 		ptcache_filename(pid, filename, cfra, 1, 1);
 
@@ -3179,7 +4200,22 @@ void BKE_ptcache_id_time(PTCacheID *pid, Scene *scene, float cfra, int *startfra
 
 		cache->cached_frames = MEM_callocN(sizeof(char) * (cache->endframe-cache->startframe+1), "cached frames array");
 
-		if (pid->cache->flag & PTCACHE_DISK_CACHE) {
+		if ((pid->cache->flag & PTCACHE_DISK_CACHE) && ptcache_use_container(pid)) {
+			PTCacheContainer *pc = ptcache_container_open(pid, PTCACHE_FILE_READ);
+
+			if (pc) {
+				unsigned int i;
+
+				for (i = 0; i < pc->totentry; i++) {
+					const int frame = pc->entries[i].frame;
+
+					if (frame >= sta && frame <= end)
+						cache->cached_frames[frame-sta] = 1;
+				}
+				ptcache_container_close(pc);
+			}
+		}
+		else if (pid->cache->flag & PTCACHE_DISK_CACHE) {
 			/* mode is same as fopen's modes */
 			DIR *dir; 
 			struct dirent *de;
@@ -3381,7 +4417,7 @@ void BKE_ptcache_remove(void)
 			if (FILENAME_IS_CURRPAR(de->d_name)) {
 				/* do nothing */
 			}
-			else if (strstr(de->d_name, PTCACHE_EXT)) { /* do we have the right extension?*/
+			else if (strstr(de->d_name, PTCACHE_EXT) || strstr(de->d_name, PTCACHE_CONTAINER_EXT)) { /* do we have the right extension?*/
 				BLI_join_dirfile(path_full, sizeof(path_full), path, de->d_name);
 				BLI_delete(path_full, false, false);
 			}
@@ -3461,7 +4497,7 @@ static PointCache *ptcache_copy(PointCache *cache, bool copy_data)
 		ncache->cached_frames = NULL;
 
 		/* flag is a mix of user settings and simulator/baking state */
-		ncache->flag= ncache->flag & (PTCACHE_DISK_CACHE|PTCACHE_EXTERNAL|PTCACHE_IGNORE_LIBPATH);
+		ncache->flag= ncache->flag & (PTCACHE_DISK_CACHE|PTCACHE_EXTERNAL|PTCACHE_IGNORE_LIBPATH|PTCACHE_SINGLE_FILE);
 		ncache->simframe= 0;
 	}
 	else {
@@ -3835,6 +4871,89 @@ void BKE_ptcache_toggle_disk_cache(PTCacheID *pid)
 	}
 }
 
+void BKE_ptcache_toggle_single_file(PTCacheID *pid)
+{
+	PointCache *cache = pid->cache;
+	const bool single_file = (cache->flag & PTCACHE_SINGLE_FILE) != 0;
+	PTCacheContainer *pc;
+	unsigned char *buffer;
+	char filename[MAX_PTCACHE_FILE];
+	int cfra, sfra = MIN2(cache->startframe, 0), efra = cache->endframe;
+	unsigned int i;
+
+	/* memory and external caches only change the flag */
+	if ((cache->flag & PTCACHE_DISK_CACHE) == 0 || (cache->flag & PTCACHE_EXTERNAL) ||
+	    pid->file_type != PTCACHE_FILE_PTCACHE || !G.relbase_valid)
+	{
+		return;
+	}
+
+	pc = ptcache_container_open(pid, single_file ? PTCACHE_FILE_WRITE : PTCACHE_FILE_READ);
+	if (pc == NULL)
+		return;
+
+	buffer = MEM_mallocN(PTCACHE_CONTAINER_COPY_BUFFER, "ptcache container copy");
+
+	/* the frame files are named with the flag cleared, frames are copied as they are */
+	cache->flag &= ~PTCACHE_SINGLE_FILE;
+
+	if (single_file) {
+		for (cfra = sfra; cfra <= efra; cfra++) {
+			FILE *fp;
+
+			ptcache_filename(pid, filename, cfra, 1, 1);
+			fp = BLI_fopen(filename, "rb");
+
+			if (fp) {
+				const uint64_t size = (uint64_t)BLI_file_descriptor_size(fileno(fp));
+				const uint64_t offset = pc->file_size;
+				const bool ok = ptcache_file_copy_range(fp, 0, pc->fp, offset, size, buffer);
+
+				fclose(fp);
+
+				if (ok) {
+					ptcache_container_add(pc, cfra, offset, size);
+					BLI_delete(filename, false, false);
+				}
+			}
+		}
+	}
+	else {
+		for (i = 0; i < pc->totentry; i++) {
+			const PTCacheContainerEntry *entry = &pc->entries[i];
+			FILE *fp;
+
+			ptcache_filename(pid, filename, entry->frame, 1, 1);
+			BLI_make_existing_file(filename);
+			fp = BLI_fopen(filename, "wb");
+
+			if (fp) {
+				ptcache_file_copy_range(pc->fp, entry->offset, fp, 0, entry->size, buffer);
+				fclose(fp);
+			}
+		}
+	}
+
+	MEM_freeN(buffer);
+	ptcache_container_close(pc);
+
+	if (single_file) {
+		cache->flag |= PTCACHE_SINGLE_FILE;
+	}
+	else if (ptcache_container_filename(pid, filename)) {
+		BLI_delete(filename, false, false);
+	}
+
+	if (cache->cached_frames) {
+		MEM_freeN(cache->cached_frames);
+		cache->cached_frames = NULL;
+	}
+
+	BKE_ptcache_id_time(pid, NULL, 0.0f, NULL, NULL, NULL);
+
+	BKE_ptcache_update_info(pid);
+}
+
 void BKE_ptcache_disk_cache_rename(PTCacheID *pid, const char *name_src, const char *name_dst)
 {
 	char old_name[80];
@@ -3854,6 +4973,17 @@ void BKE_ptcache_disk_cache_rename(PTCacheID *pid, const char *name_src, const c
 	/* get "from" filename */
 	BLI_strncpy(pid->cache->name, name_src, sizeof(pid->cache->name));
 
+	if (ptcache_use_container(pid)) {
+		if (ptcache_container_filename(pid, old_path_full) && BLI_exists(old_path_full)) {
+			BLI_strncpy(pid->cache->name, name_dst, sizeof(pid->cache->name));
+			if (ptcache_container_filename(pid, new_path_full))
+				BLI_rename(old_path_full, new_path_full);
+		}
+
+		BLI_strncpy(pid->cache->name, old_name, sizeof(pid->cache->name));
+		return;
+	}
+
 	len = ptcache_filename(pid, old_filename, 0, 0, 0); /* no path */
 
 	ptcache_path(pid, path);
@@ -3904,43 +5034,67 @@ void BKE_ptcache_load_external(PTCacheID *pid)
 	char path[MAX_PTCACHE_PATH];
 	char filename[MAX_PTCACHE_FILE];
 	char ext[MAX_PTCACHE_PATH];
+	PTCacheContainer *pc;
 
 	if (!cache)
 		return;
 
-	ptcache_path(pid, path);
-	
-	len = ptcache_filename(pid, filename, 1, 0, 0); /* no path */
-	
-	dir = opendir(path);
-	if (dir==NULL)
-		return;
+	pc = (pid->file_type == PTCACHE_FILE_PTCACHE) ? ptcache_container_open(pid, PTCACHE_FILE_READ) : NULL;
 
-	const char *fext = ptcache_file_extension(pid);
+	if (pc) {
+		unsigned int i;
 
-	if (cache->index >= 0)
-		BLI_snprintf(ext, sizeof(ext), "_%02d%s", cache->index, fext);
-	else
-		BLI_strncpy(ext, fext, sizeof(ext));
-	
-	while ((de = readdir(dir)) != NULL) {
-		if (strstr(de->d_name, ext)) { /* do we have the right extension?*/
-			if (STREQLEN(filename, de->d_name, len)) { /* do we have the right prefix */
-				/* read the number of the file */
-				const int frame = ptcache_frame_from_filename(de->d_name, ext);
+		for (i = 0; i < pc->totentry; i++) {
+			const int frame = pc->entries[i].frame;
 
-				if (frame != -1) {
-					if (frame) {
-						start = MIN2(start, frame);
-						end = MAX2(end, frame);
+			if (frame) {
+				start = MIN2(start, frame);
+				end = MAX2(end, frame);
+			}
+			else
+				info = 1;
+		}
+		ptcache_container_close(pc);
+
+		cache->flag |= PTCACHE_SINGLE_FILE;
+	}
+	else {
+		cache->flag &= ~PTCACHE_SINGLE_FILE;
+
+		ptcache_path(pid, path);
+
+		len = ptcache_filename(pid, filename, 1, 0, 0); /* no path */
+
+		dir = opendir(path);
+		if (dir==NULL)
+			return;
+
+		const char *fext = ptcache_file_extension(pid);
+
+		if (cache->index >= 0)
+			BLI_snprintf(ext, sizeof(ext), "_%02d%s", cache->index, fext);
+		else
+			BLI_strncpy(ext, fext, sizeof(ext));
+
+		while ((de = readdir(dir)) != NULL) {
+			if (strstr(de->d_name, ext)) { /* do we have the right extension?*/
+				if (STREQLEN(filename, de->d_name, len)) { /* do we have the right prefix */
+					/* read the number of the file */
+					const int frame = ptcache_frame_from_filename(de->d_name, ext);
+
+					if (frame != -1) {
+						if (frame) {
+							start = MIN2(start, frame);
+							end = MAX2(end, frame);
+						}
+						else
+							info = 1;
 					}
-					else
-						info = 1;
 				}
 			}
 		}
+		closedir(dir);
 	}
-	closedir(dir);
 
 	if (start != MAXFRAME) {
 		PTCacheFile *pf;
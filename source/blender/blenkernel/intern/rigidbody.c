@@ -41,6 +41,7 @@
 
 #include "BLI_blenlib.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #ifdef WITH_BULLET
 #  include "RBI_api.h"
@@ -1207,6 +1208,11 @@ static void rigidbody_update_ob_array(RigidBodyWorld *rbw)
 	}
 }
 
+static void rigidbody_parallel_range(int tot, void *userdata, rbParallelRangeFunc func)
+{
+	BLI_task_parallel_range(0, tot, userdata, func, true);
+}
+
 static void rigidbody_update_sim_world(Scene *scene, RigidBodyWorld *rbw)
 {
 	float adj_gravity[3];
@@ -1223,11 +1229,42 @@ static void rigidbody_update_sim_world(Scene *scene, RigidBodyWorld *rbw)
 	/* update gravity, since this RNA setting is not part of RigidBody settings */
 	RB_dworld_set_gravity(rbw->physics_world, adj_gravity);
 
+	/* solve simulation islands on the task scheduler */
+	RB_dworld_set_parallel(rbw->physics_world, rigidbody_parallel_range,
+	                       rbw->num_threads ? rbw->num_threads : BLI_task_scheduler_num_threads(BLI_task_scheduler_get()));
+
 	/* update object array in case there are changes */
 	rigidbody_update_ob_array(rbw);
 }
 
-static void rigidbody_update_sim_ob(Scene *scene, RigidBodyWorld *rbw, Object *ob, RigidBodyOb *rbo)
+/* Effectors are collected once and shared by all objects on the same layers. pdInitEffectors()
+ * leaves out the object the list is made for, so a list made for a force field object is
+ * only used for that object. */
+typedef struct RigidBodyEffectors {
+	ListBase *effectors;
+	/* object and layers the list was made for */
+	Object *ob_src;
+	unsigned int lay;
+	bool is_valid;
+} RigidBodyEffectors;
+
+static bool rigidbody_effectors_match(const RigidBodyEffectors *rb_effectors, Object *ob)
+{
+	const Object *ob_src = rb_effectors->ob_src;
+
+	if (!rb_effectors->is_valid || rb_effectors->lay != ob->lay)
+		return false;
+
+	if (ob_src == ob)
+		return true;
+
+	/* neither object can be left out of the list */
+	return ((ob_src->pd == NULL || ob_src->pd->forcefield == PFIELD_NULL) &&
+	        (ob->pd == NULL || ob->pd->forcefield == PFIELD_NULL));
+}
+
+static void rigidbody_update_sim_ob(Scene *scene, RigidBodyWorld *rbw, Object *ob, RigidBodyOb *rbo,
+                                    RigidBodyEffectors *rb_effectors)
 {
 	float loc[3];
 	float rot[4];
@@ -1275,7 +1312,14 @@ static void rigidbody_update_sim_ob(Scene *scene, RigidBodyWorld *rbw, Object *o
 		ListBase *effectors;
 
 		/* get effectors present in the group specified by effector_weights */
-		effectors = pdInitEffectors(scene, ob, NULL, effector_weights, true);
+		if (!rigidbody_effectors_match(rb_effectors, ob)) {
+			pdEndEffectors(&rb_effectors->effectors);
+			rb_effectors->effectors = pdInitEffectors(scene, ob, NULL, effector_weights, true);
+			rb_effectors->ob_src = ob;
+			rb_effectors->lay = ob->lay;
+			rb_effectors->is_valid = true;
+		}
+		effectors = rb_effectors->effectors;
 		if (effectors) {
 			float eff_force[3] = {0.0f, 0.0f, 0.0f};
 			float eff_loc[3], eff_vel[3];
@@ -1300,9 +1344,6 @@ static void rigidbody_update_sim_ob(Scene *scene, RigidBodyWorld *rbw, Object *o
 		}
 		else if (G.f & G_DEBUG)
 			printf("\tno forces to apply to '%s'\n", ob->id.name + 2);
-
-		/* cleanup */
-		pdEndEffectors(&effectors);
 	}
 	/* NOTE: passive objects don't need to be updated since they don't move */
 
@@ -1319,6 +1360,7 @@ static void rigidbody_update_sim_ob(Scene *scene, RigidBodyWorld *rbw, Object *o
 static void rigidbody_update_simulation(Scene *scene, RigidBodyWorld *rbw, bool rebuild)
 {
 	GroupObject *go;
+	RigidBodyEffectors rb_effectors = {NULL};
 
 	/* update world */
 	if (rebuild)
@@ -1387,9 +1429,10 @@ static void rigidbody_update_simulation(Scene *scene, RigidBodyWorld *rbw, bool
 			}
 
 			/* update simulation object... */
-			rigidbody_update_sim_ob(scene, rbw, ob, rbo);
+			rigidbody_update_sim_ob(scene, rbw, ob, rbo, &rb_effectors);
 		}
 	}
+	pdEndEffectors(&rb_effectors.effectors);
 	
 	/* update constraints */
 	if (rbw->constraints == NULL) /* no constraints, move on */
@@ -1427,6 +1470,27 @@ static void rigidbody_update_simulation(Scene *scene, RigidBodyWorld *rbw, bool
 	}
 }
 
+static void rigidbody_update_sim_transform_cb(void *userdata, const int index)
+{
+	RigidBodyWorld *rbw = userdata;
+	Object *ob = rbw->objects[index];
+
+	if (ob && ob->rigidbody_object) {
+		RigidBodyOb *rbo = ob->rigidbody_object;
+
+		if (rbo->type == RBO_TYPE_ACTIVE && rbo->physics_object) {
+			RB_body_get_position(rbo->physics_object, rbo->pos);
+			RB_body_get_orientation(rbo->physics_object, rbo->orn);
+		}
+	}
+}
+
+/* Copy the simulated transforms of all active bodies, for writing them to the cache */
+static void rigidbody_update_sim_transforms(RigidBodyWorld *rbw)
+{
+	BLI_task_parallel_range(0, rbw->numbodies, rbw, rigidbody_update_sim_transform_cb, rbw->numbodies > 1024);
+}
+
 static void rigidbody_update_simulation_post_step(RigidBodyWorld *rbw)
 {
 	GroupObject *go;
@@ -1592,6 +1656,7 @@ void BKE_rigidbody_do_simulation(Scene *scene, float ctime)
 	if (can_simulate) {
 		/* write cache for first frame when on second frame */
 		if (rbw->ltime == startframe && (cache->flag & PTCACHE_OUTDATED || cache->last_exact == 0)) {
+			rigidbody_update_sim_transforms(rbw);
 			BKE_ptcache_write(&pid, startframe);
 		}
 
@@ -1603,6 +1668,8 @@ void BKE_rigidbody_do_simulation(Scene *scene, float ctime)
 		/* step simulation by the requested timestep, steps per second are adjusted to take time scale into account */
 		RB_dworld_step_simulation(rbw->physics_world, timestep, INT_MAX, 1.0f / (float)rbw->steps_per_second * min_ff(rbw->time_scale, 1.0f));
 
+		rigidbody_update_sim_transforms(rbw);
+
 		rigidbody_update_simulation_post_step(rbw);
 
 		/* write cache for current frame */
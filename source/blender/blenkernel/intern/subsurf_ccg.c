@@ -56,6 +56,7 @@
 #include "BLI_edgehash.h"
 #include "BLI_math.h"
 #include "BLI_memarena.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BKE_pbvh.h"
@@ -151,7 +152,8 @@ static CCGSubSurf *_getSubSurf(CCGSubSurf *prevSS, int subdivLevels,
 		ccgSubSurf_getUseAgeCounts(prevSS, &oldUseAging, NULL, NULL, NULL);
 
 		if ((oldUseAging != useAging) ||
-		    (ccgSubSurf_getSimpleSubdiv(prevSS) != !!(flags & CCG_SIMPLE_SUBDIV)))
+		    (ccgSubSurf_getSimpleSubdiv(prevSS) != !!(flags & CCG_SIMPLE_SUBDIV)) ||
+		    (ccgSubSurf_getAllocMask(prevSS) != !!(flags & CCG_ALLOC_MASK)))
 		{
 			ccgSubSurf_free(prevSS);
 		}
@@ -781,6 +783,98 @@ static void ss_sync_ccg_from_derivedmesh(CCGSubSurf *ss,
 #endif
 }
 
+/* Check whether the topology synced into ss matches the one of dm,
+ * so the CCG elements can be kept and only the vertex coordinates need updating. */
+static bool ss_ccg_topology_matches_derivedmesh(CCGSubSurf *ss,
+                                                DerivedMesh *dm,
+                                                int useFlatSubdiv)
+{
+	float creaseFactor = (float) ccgSubSurf_getSubdivisionLevels(ss);
+	MEdge *medge = dm->getEdgeArray(dm), *me;
+	MLoop *mloop = dm->getLoopArray(dm), *ml;
+	MPoly *mpoly = dm->getPolyArray(dm), *mp;
+	int totedge = dm->getNumEdges(dm);
+	int i, j;
+
+	if ((ccgSubSurf_getNumVerts(ss) != dm->getNumVerts(dm)) ||
+	    (ccgSubSurf_getNumEdges(ss) != totedge) ||
+	    (ccgSubSurf_getNumFaces(ss) != dm->numPolyData))
+	{
+		return false;
+	}
+
+	for (i = 0, me = medge; i < totedge; i++, me++) {
+		CCGEdge *e = ccgSubSurf_getEdge(ss, SET_INT_IN_POINTER(i));
+		float crease = useFlatSubdiv ? creaseFactor :
+		               me->crease * creaseFactor / 255.0f;
+
+		if ((e == NULL) ||
+		    (ccgSubSurf_getVertVertHandle(ccgSubSurf_getEdgeVert0(e)) != SET_UINT_IN_POINTER(me->v1)) ||
+		    (ccgSubSurf_getVertVertHandle(ccgSubSurf_getEdgeVert1(e)) != SET_UINT_IN_POINTER(me->v2)) ||
+		    (ccgSubSurf_getEdgeCrease(e) != crease))
+		{
+			return false;
+		}
+	}
+
+	for (i = 0, mp = mpoly; i < dm->numPolyData; i++, mp++) {
+		CCGFace *f = ccgSubSurf_getFace(ss, SET_INT_IN_POINTER(i));
+
+		if ((f == NULL) || (ccgSubSurf_getFaceNumVerts(f) != mp->totloop)) {
+			return false;
+		}
+
+		ml = mloop + mp->loopstart;
+		for (j = 0; j < mp->totloop; j++, ml++) {
+			if (ccgSubSurf_getVertVertHandle(ccgSubSurf_getFaceVert(f, j)) != SET_UINT_IN_POINTER(ml->v)) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/* Update vertex coordinates of a subsurf with unchanged topology,
+ * only the vertices which moved (and their neighbors) get subdivided again. */
+static void ss_sync_ccg_coords_from_derivedmesh(CCGSubSurf *ss,
+                                                DerivedMesh *dm,
+                                                float (*vertexCos)[3])
+{
+	MVert *mvert = dm->getVertArray(dm), *mv;
+	int totvert = dm->getNumVerts(dm);
+	int totedge = dm->getNumEdges(dm);
+	int i;
+	int *index;
+
+	ccgSubSurf_initPartialSync(ss);
+
+	mv = mvert;
+	index = (int *)dm->getVertDataArray(dm, CD_ORIGINDEX);
+	for (i = 0; i < totvert; i++, mv++) {
+		CCGVert *v;
+
+		ccgSubSurf_syncVert(ss, SET_INT_IN_POINTER(i), vertexCos ? vertexCos[i] : mv->co, 0, &v);
+
+		((int *)ccgSubSurf_getVertUserData(ss, v))[1] = (index) ? *index++ : i;
+	}
+
+	/* original indices may differ even though the topology is the same */
+	index = (int *)dm->getEdgeDataArray(dm, CD_ORIGINDEX);
+	for (i = 0; i < totedge; i++) {
+		CCGEdge *e = ccgSubSurf_getEdge(ss, SET_INT_IN_POINTER(i));
+		((int *)ccgSubSurf_getEdgeUserData(ss, e))[1] = (index) ? index[i] : i;
+	}
+
+	index = (int *)dm->getPolyDataArray(dm, CD_ORIGINDEX);
+	for (i = 0; i < dm->numPolyData; i++) {
+		CCGFace *f = ccgSubSurf_getFace(ss, SET_INT_IN_POINTER(i));
+		((int *)ccgSubSurf_getFaceUserData(ss, f))[1] = (index) ? index[i] : i;
+	}
+
+	ccgSubSurf_processSync(ss);
+}
+
 #ifdef WITH_OPENSUBDIV
 static void ss_sync_osd_from_derivedmesh(CCGSubSurf *ss,
                                          DerivedMesh *dm)
@@ -1292,68 +1386,115 @@ BLI_INLINE void ccgDM_to_MVert(MVert *mv, const CCGKey *key, CCGElem *elem)
 	mv->flag = mv->bweight = 0;
 }
 
-static void ccgDM_copyFinalVertArray(DerivedMesh *dm, MVert *mvert)
+typedef struct CopyFinalArrayData {
+	CCGDerivedMesh *ccgdm;
+	CCGKey key;
+	int gridSize;
+	int edgeSize;
+
+	MVert *mvert;
+	MEdge *medge;
+	MLoop *mloop;
+	MPoly *mpoly;
+	short ed_interior_flag;
+} CopyFinalArrayData;
+
+/* Elements of the final arrays are written at offsets stored in the face/edge/vert maps,
+ * so each CCG element can be converted independently. */
+static void ccgDM_copyFinal_parallel_range(
+        CopyFinalArrayData *data, const int num_elems, TaskParallelRangeFuncEx func)
 {
-	CCGDerivedMesh *ccgdm = (CCGDerivedMesh *) dm;
+	CCGSubSurf *ss = data->ccgdm->ss;
+	const bool use_threading = (ccgSubSurf_getNumFaces(ss) * data->gridSize * data->gridSize * 4 >= CCG_TASK_LIMIT);
+
+	BLI_task_parallel_range_ex(0, num_elems, data, NULL, 0, func,
+	                           use_threading, num_elems >= CCG_TASK_DYNAMIC_LIMIT);
+}
+
+static void ccgDM_copyFinalVertArray_faces_cb(
+        void *__restrict userdata, void *UNUSED(userdata_chunk), const int index, const int UNUSED(threadid))
+{
+	CopyFinalArrayData *data = userdata;
+	CCGDerivedMesh *ccgdm = data->ccgdm;
 	CCGSubSurf *ss = ccgdm->ss;
+	const CCGKey *key = &data->key;
+	const int gridSize = data->gridSize;
+	CCGFace *f = ccgdm->faceMap[index].face;
+	MVert *mvert = data->mvert;
 	CCGElem *vd;
-	CCGKey key;
-	int index;
-	int totvert, totedge, totface;
-	int gridSize = ccgSubSurf_getGridSize(ss);
-	int edgeSize = ccgSubSurf_getEdgeSize(ss);
-	unsigned int i = 0;
+	int x, y, S, numVerts = ccgSubSurf_getFaceNumVerts(f);
+	unsigned int i = ccgdm->faceMap[index].startVert;
 
-	CCG_key_top_level(&key, ss);
-
-	totface = ccgSubSurf_getNumFaces(ss);
-	for (index = 0; index < totface; index++) {
-		CCGFace *f = ccgdm->faceMap[index].face;
-		int x, y, S, numVerts = ccgSubSurf_getFaceNumVerts(f);
+	vd = ccgSubSurf_getFaceCenterData(f);
+	ccgDM_to_MVert(&mvert[i++], key, vd);
 
-		vd = ccgSubSurf_getFaceCenterData(f);
-		ccgDM_to_MVert(&mvert[i++], &key, vd);
-		
-		for (S = 0; S < numVerts; S++) {
-			for (x = 1; x < gridSize - 1; x++) {
-				vd = ccgSubSurf_getFaceGridEdgeData(ss, f, S, x);
-				ccgDM_to_MVert(&mvert[i++], &key, vd);
-			}
+	for (S = 0; S < numVerts; S++) {
+		for (x = 1; x < gridSize - 1; x++) {
+			vd = ccgSubSurf_getFaceGridEdgeData(ss, f, S, x);
+			ccgDM_to_MVert(&mvert[i++], key, vd);
 		}
+	}
 
-		for (S = 0; S < numVerts; S++) {
-			for (y = 1; y < gridSize - 1; y++) {
-				for (x = 1; x < gridSize - 1; x++) {
-					vd = ccgSubSurf_getFaceGridData(ss, f, S, x, y);
-					ccgDM_to_MVert(&mvert[i++], &key, vd);
-				}
+	for (S = 0; S < numVerts; S++) {
+		for (y = 1; y < gridSize - 1; y++) {
+			for (x = 1; x < gridSize - 1; x++) {
+				vd = ccgSubSurf_getFaceGridData(ss, f, S, x, y);
+				ccgDM_to_MVert(&mvert[i++], key, vd);
 			}
 		}
 	}
+}
 
-	totedge = ccgSubSurf_getNumEdges(ss);
-	for (index = 0; index < totedge; index++) {
-		CCGEdge *e = ccgdm->edgeMap[index].edge;
-		int x;
-
-		for (x = 1; x < edgeSize - 1; x++) {
-			/* This gives errors with -debug-fpe
-			 * the normals don't seem to be unit length.
-			 * this is most likely caused by edges with no
-			 * faces which are now zerod out, see comment in:
-			 * ccgSubSurf__calcVertNormals(), - campbell */
-			vd = ccgSubSurf_getEdgeData(ss, e, x);
-			ccgDM_to_MVert(&mvert[i++], &key, vd);
-		}
+static void ccgDM_copyFinalVertArray_edges_cb(
+        void *__restrict userdata, void *UNUSED(userdata_chunk), const int index, const int UNUSED(threadid))
+{
+	CopyFinalArrayData *data = userdata;
+	CCGDerivedMesh *ccgdm = data->ccgdm;
+	CCGSubSurf *ss = ccgdm->ss;
+	const int edgeSize = data->edgeSize;
+	CCGEdge *e = ccgdm->edgeMap[index].edge;
+	MVert *mvert = data->mvert;
+	unsigned int i = ccgdm->edgeMap[index].startVert;
+	int x;
+
+	for (x = 1; x < edgeSize - 1; x++) {
+		/* This gives errors with -debug-fpe
+		 * the normals don't seem to be unit length.
+		 * this is most likely caused by edges with no
+		 * faces which are now zerod out, see comment in:
+		 * ccgSubSurf__calcVertNormals(), - campbell */
+		CCGElem *vd = ccgSubSurf_getEdgeData(ss, e, x);
+		ccgDM_to_MVert(&mvert[i++], &data->key, vd);
 	}
+}
 
-	totvert = ccgSubSurf_getNumVerts(ss);
-	for (index = 0; index < totvert; index++) {
-		CCGVert *v = ccgdm->vertMap[index].vert;
+static void ccgDM_copyFinalVertArray_verts_cb(
+        void *__restrict userdata, void *UNUSED(userdata_chunk), const int index, const int UNUSED(threadid))
+{
+	CopyFinalArrayData *data = userdata;
+	CCGDerivedMesh *ccgdm = data->ccgdm;
+	CCGVert *v = ccgdm->vertMap[index].vert;
+	CCGElem *vd = ccgSubSurf_getVertData(ccgdm->ss, v);
 
-		vd = ccgSubSurf_getVertData(ss, v);
-		ccgDM_to_MVert(&mvert[i++], &key, vd);
-	}
+	ccgDM_to_MVert(&data->mvert[ccgdm->vertMap[index].startVert], &data->key, vd);
+}
+
+static void ccgDM_copyFinalVertArray(DerivedMesh *dm, MVert *mvert)
+{
+	CCGDerivedMesh *ccgdm = (CCGDerivedMesh *) dm;
+	CCGSubSurf *ss = ccgdm->ss;
+	CopyFinalArrayData data = {
+	    .ccgdm = ccgdm,
+	    .gridSize = ccgSubSurf_getGridSize(ss),
+	    .edgeSize = ccgSubSurf_getEdgeSize(ss),
+	    .mvert = mvert,
+	};
+
+	CCG_key_top_level(&data.key, ss);
+
+	ccgDM_copyFinal_parallel_range(&data, ccgSubSurf_getNumFaces(ss), ccgDM_copyFinalVertArray_faces_cb);
+	ccgDM_copyFinal_parallel_range(&data, ccgSubSurf_getNumEdges(ss), ccgDM_copyFinalVertArray_edges_cb);
+	ccgDM_copyFinal_parallel_range(&data, ccgSubSurf_getNumVerts(ss), ccgDM_copyFinalVertArray_verts_cb);
 }
 
 
@@ -1366,75 +1507,95 @@ BLI_INLINE void ccgDM_to_MEdge(MEdge *med, const int v1, const int v2, const sho
 	med->flag = flag;
 }
 
-static void ccgDM_copyFinalEdgeArray(DerivedMesh *dm, MEdge *medge)
+static void ccgDM_copyFinalEdgeArray_faces_cb(
+        void *__restrict userdata, void *UNUSED(userdata_chunk), const int index, const int UNUSED(threadid))
 {
-	CCGDerivedMesh *ccgdm = (CCGDerivedMesh *) dm;
+	CopyFinalArrayData *data = userdata;
+	CCGDerivedMesh *ccgdm = data->ccgdm;
 	CCGSubSurf *ss = ccgdm->ss;
-	int index;
-	int totedge, totface;
-	int gridSize = ccgSubSurf_getGridSize(ss);
-	int edgeSize = ccgSubSurf_getEdgeSize(ss);
-	unsigned int i = 0;
-	short *edgeFlags = ccgdm->edgeFlags;
-	const short ed_interior_flag = ccgdm->drawInteriorEdges ? (ME_EDGEDRAW | ME_EDGERENDER) : 0;
-
-	totface = ccgSubSurf_getNumFaces(ss);
-	for (index = 0; index < totface; index++) {
-		CCGFace *f = ccgdm->faceMap[index].face;
-		int x, y, S, numVerts = ccgSubSurf_getFaceNumVerts(f);
+	const int gridSize = data->gridSize;
+	const int edgeSize = data->edgeSize;
+	const short ed_interior_flag = data->ed_interior_flag;
+	CCGFace *f = ccgdm->faceMap[index].face;
+	MEdge *medge = data->medge;
+	int x, y, S, numVerts = ccgSubSurf_getFaceNumVerts(f);
+	unsigned int i = ccgdm->faceMap[index].startEdge;
+
+	for (S = 0; S < numVerts; S++) {
+		for (x = 0; x < gridSize - 1; x++) {
+			ccgDM_to_MEdge(&medge[i++],
+			               getFaceIndex(ss, f, S, x,     0, edgeSize, gridSize),
+			               getFaceIndex(ss, f, S, x + 1, 0, edgeSize, gridSize),
+			               ed_interior_flag);
+		}
 
-		for (S = 0; S < numVerts; S++) {
-			for (x = 0; x < gridSize - 1; x++) {
+		for (x = 1; x < gridSize - 1; x++) {
+			for (y = 0; y < gridSize - 1; y++) {
 				ccgDM_to_MEdge(&medge[i++],
-				               getFaceIndex(ss, f, S, x,     0, edgeSize, gridSize),
-				               getFaceIndex(ss, f, S, x + 1, 0, edgeSize, gridSize),
+				               getFaceIndex(ss, f, S, x, y,    edgeSize, gridSize),
+				               getFaceIndex(ss, f, S, x, y + 1, edgeSize, gridSize),
+				               ed_interior_flag);
+				ccgDM_to_MEdge(&medge[i++],
+				               getFaceIndex(ss, f, S, y, x,     edgeSize, gridSize),
+				               getFaceIndex(ss, f, S, y + 1, x, edgeSize, gridSize),
 				               ed_interior_flag);
-			}
-
-			for (x = 1; x < gridSize - 1; x++) {
-				for (y = 0; y < gridSize - 1; y++) {
-					ccgDM_to_MEdge(&medge[i++],
-					               getFaceIndex(ss, f, S, x, y,    edgeSize, gridSize),
-					               getFaceIndex(ss, f, S, x, y + 1, edgeSize, gridSize),
-					               ed_interior_flag);
-					ccgDM_to_MEdge(&medge[i++],
-					               getFaceIndex(ss, f, S, y, x,     edgeSize, gridSize),
-					               getFaceIndex(ss, f, S, y + 1, x, edgeSize, gridSize),
-					               ed_interior_flag);
-				}
 			}
 		}
 	}
+}
 
-	totedge = ccgSubSurf_getNumEdges(ss);
-	for (index = 0; index < totedge; index++) {
-		CCGEdge *e = ccgdm->edgeMap[index].edge;
-		short ed_flag = 0;
-		int x;
-		int edgeIdx = GET_INT_FROM_POINTER(ccgSubSurf_getEdgeEdgeHandle(e));
+static void ccgDM_copyFinalEdgeArray_edges_cb(
+        void *__restrict userdata, void *UNUSED(userdata_chunk), const int index, const int UNUSED(threadid))
+{
+	CopyFinalArrayData *data = userdata;
+	CCGDerivedMesh *ccgdm = data->ccgdm;
+	CCGSubSurf *ss = ccgdm->ss;
+	const int edgeSize = data->edgeSize;
+	short *edgeFlags = ccgdm->edgeFlags;
+	CCGEdge *e = ccgdm->edgeMap[index].edge;
+	MEdge *medge = data->medge;
+	unsigned int i = ccgdm->edgeMap[index].startEdge;
+	short ed_flag = 0;
+	int x;
+	int edgeIdx = GET_INT_FROM_POINTER(ccgSubSurf_getEdgeEdgeHandle(e));
 
-		if (!ccgSubSurf_getEdgeNumFaces(e)) {
-			ed_flag |= ME_LOOSEEDGE;
-		}
+	if (!ccgSubSurf_getEdgeNumFaces(e)) {
+		ed_flag |= ME_LOOSEEDGE;
+	}
 
-		if (edgeFlags) {
-			if (edgeIdx != -1) {
-				ed_flag |= ((edgeFlags[index] & (ME_SEAM | ME_SHARP)) | ME_EDGEDRAW | ME_EDGERENDER);
-			}
-		}
-		else {
-			ed_flag |= ME_EDGEDRAW | ME_EDGERENDER;
+	if (edgeFlags) {
+		if (edgeIdx != -1) {
+			ed_flag |= ((edgeFlags[index] & (ME_SEAM | ME_SHARP)) | ME_EDGEDRAW | ME_EDGERENDER);
 		}
+	}
+	else {
+		ed_flag |= ME_EDGEDRAW | ME_EDGERENDER;
+	}
 
-		for (x = 0; x < edgeSize - 1; x++) {
-			ccgDM_to_MEdge(&medge[i++],
-			               getEdgeIndex(ss, e, x, edgeSize),
-			               getEdgeIndex(ss, e, x + 1, edgeSize),
-			               ed_flag);
-		}
+	for (x = 0; x < edgeSize - 1; x++) {
+		ccgDM_to_MEdge(&medge[i++],
+		               getEdgeIndex(ss, e, x, edgeSize),
+		               getEdgeIndex(ss, e, x + 1, edgeSize),
+		               ed_flag);
 	}
 }
 
+static void ccgDM_copyFinalEdgeArray(DerivedMesh *dm, MEdge *medge)
+{
+	CCGDerivedMesh *ccgdm = (CCGDerivedMesh *) dm;
+	CCGSubSurf *ss = ccgdm->ss;
+	CopyFinalArrayData data = {
+	    .ccgdm = ccgdm,
+	    .gridSize = ccgSubSurf_getGridSize(ss),
+	    .edgeSize = ccgSubSurf_getEdgeSize(ss),
+	    .medge = medge,
+	    .ed_interior_flag = ccgdm->drawInteriorEdges ? (ME_EDGEDRAW | ME_EDGERENDER) : 0,
+	};
+
+	ccgDM_copyFinal_parallel_range(&data, ccgSubSurf_getNumFaces(ss), ccgDM_copyFinalEdgeArray_faces_cb);
+	ccgDM_copyFinal_parallel_range(&data, ccgSubSurf_getNumEdges(ss), ccgDM_copyFinalEdgeArray_edges_cb);
+}
+
 static void ccgDM_copyFinalFaceArray(DerivedMesh *dm, MFace *mface)
 {
 	CCGDerivedMesh *ccgdm = (CCGDerivedMesh *) dm;
@@ -1477,22 +1638,72 @@ static void ccgDM_copyFinalFaceArray(DerivedMesh *dm, MFace *mface)
 	}
 }
 
+static void ccgDM_copyFinalLoopArray_faces_cb(
+        void *__restrict userdata, void *UNUSED(userdata_chunk), const int index, const int UNUSED(threadid))
+{
+	CopyFinalArrayData *data = userdata;
+	CCGDerivedMesh *ccgdm = data->ccgdm;
+	CCGSubSurf *ss = ccgdm->ss;
+	const int gridSize = data->gridSize;
+	const int edgeSize = data->edgeSize;
+	CCGFace *f = ccgdm->faceMap[index].face;
+	int x, y, S, numVerts = ccgSubSurf_getFaceNumVerts(f);
+	/* int flag = (faceFlags) ? faceFlags[index * 2]: ME_SMOOTH; */ /* UNUSED */
+	/* int mat_nr = (faceFlags) ? faceFlags[index * 2 + 1]: 0; */ /* UNUSED */
+	MLoop *mv = &data->mloop[ccgdm->faceMap[index].startFace * 4];
+
+	for (S = 0; S < numVerts; S++) {
+		for (y = 0; y < gridSize - 1; y++) {
+			for (x = 0; x < gridSize - 1; x++) {
+				unsigned int v1, v2, v3, v4;
+
+				v1 = getFaceIndex(ss, f, S, x + 0, y + 0,
+				                  edgeSize, gridSize);
+
+				v2 = getFaceIndex(ss, f, S, x + 0, y + 1,
+				                  edgeSize, gridSize);
+				v3 = getFaceIndex(ss, f, S, x + 1, y + 1,
+				                  edgeSize, gridSize);
+				v4 = getFaceIndex(ss, f, S, x + 1, y + 0,
+				                  edgeSize, gridSize);
+
+				mv->v = v1;
+				mv->e = GET_UINT_FROM_POINTER(BLI_edgehash_lookup(ccgdm->ehash, v1, v2));
+				mv++;
+
+				mv->v = v2;
+				mv->e = GET_UINT_FROM_POINTER(BLI_edgehash_lookup(ccgdm->ehash, v2, v3));
+				mv++;
+
+				mv->v = v3;
+				mv->e = GET_UINT_FROM_POINTER(BLI_edgehash_lookup(ccgdm->ehash, v3, v4));
+				mv++;
+
+				mv->v = v4;
+				mv->e = GET_UINT_FROM_POINTER(BLI_edgehash_lookup(ccgdm->ehash, v4, v1));
+				mv++;
+			}
+		}
+	}
+}
+
 static void ccgDM_copyFinalLoopArray(DerivedMesh *dm, MLoop *mloop)
 {
 	CCGDerivedMesh *ccgdm = (CCGDerivedMesh *) dm;
 	CCGSubSurf *ss = ccgdm->ss;
-	int index;
-	int totface;
-	int gridSize = ccgSubSurf_getGridSize(ss);
-	int edgeSize = ccgSubSurf_getEdgeSize(ss);
-	int i = 0;
-	MLoop *mv;
+	CopyFinalArrayData data = {
+	    .ccgdm = ccgdm,
+	    .gridSize = ccgSubSurf_getGridSize(ss),
+	    .edgeSize = ccgSubSurf_getEdgeSize(ss),
+	    .mloop = mloop,
+	};
 	/* DMFlagMat *faceFlags = ccgdm->faceFlags; */ /* UNUSED */
 
 	if (!ccgdm->ehash) {
 		BLI_rw_mutex_lock(&loops_cache_rwlock, THREAD_LOCK_WRITE);
 		if (!ccgdm->ehash) {
 			MEdge *medge;
+			int i;
 
 			ccgdm->ehash = BLI_edgehash_new_ex(__func__, ccgdm->dm.numEdgeData);
 			medge = ccgdm->dm.getEdgeArray((DerivedMesh *)ccgdm);
@@ -1504,86 +1715,52 @@ static void ccgDM_copyFinalLoopArray(DerivedMesh *dm, MLoop *mloop)
 		BLI_rw_mutex_unlock(&loops_cache_rwlock);
 	}
 
+	/* the edge-hash is only read from here on, lookups are safe from all threads */
 	BLI_rw_mutex_lock(&loops_cache_rwlock, THREAD_LOCK_READ);
-	totface = ccgSubSurf_getNumFaces(ss);
-	mv = mloop;
-	for (index = 0; index < totface; index++) {
-		CCGFace *f = ccgdm->faceMap[index].face;
-		int x, y, S, numVerts = ccgSubSurf_getFaceNumVerts(f);
-		/* int flag = (faceFlags) ? faceFlags[index * 2]: ME_SMOOTH; */ /* UNUSED */
-		/* int mat_nr = (faceFlags) ? faceFlags[index * 2 + 1]: 0; */ /* UNUSED */
-
-		for (S = 0; S < numVerts; S++) {
-			for (y = 0; y < gridSize - 1; y++) {
-				for (x = 0; x < gridSize - 1; x++) {
-					unsigned int v1, v2, v3, v4;
-
-					v1 = getFaceIndex(ss, f, S, x + 0, y + 0,
-					                  edgeSize, gridSize);
-
-					v2 = getFaceIndex(ss, f, S, x + 0, y + 1,
-					                  edgeSize, gridSize);
-					v3 = getFaceIndex(ss, f, S, x + 1, y + 1,
-					                  edgeSize, gridSize);
-					v4 = getFaceIndex(ss, f, S, x + 1, y + 0,
-					                  edgeSize, gridSize);
-
-					mv->v = v1;
-					mv->e = GET_UINT_FROM_POINTER(BLI_edgehash_lookup(ccgdm->ehash, v1, v2));
-					mv++; i++;
+	ccgDM_copyFinal_parallel_range(&data, ccgSubSurf_getNumFaces(ss), ccgDM_copyFinalLoopArray_faces_cb);
+	BLI_rw_mutex_unlock(&loops_cache_rwlock);
+}
 
-					mv->v = v2;
-					mv->e = GET_UINT_FROM_POINTER(BLI_edgehash_lookup(ccgdm->ehash, v2, v3));
-					mv++; i++;
+static void ccgDM_copyFinalPolyArray_faces_cb(
+        void *__restrict userdata, void *UNUSED(userdata_chunk), const int index, const int UNUSED(threadid))
+{
+	CopyFinalArrayData *data = userdata;
+	CCGDerivedMesh *ccgdm = data->ccgdm;
+	const int gridSize = data->gridSize;
+	DMFlagMat *faceFlags = ccgdm->faceFlags;
+	CCGFace *f = ccgdm->faceMap[index].face;
+	int x, y, S, numVerts = ccgSubSurf_getFaceNumVerts(f);
+	int flag = (faceFlags) ? faceFlags[index].flag : ME_SMOOTH;
+	int mat_nr = (faceFlags) ? faceFlags[index].mat_nr : 0;
+	int i = ccgdm->faceMap[index].startFace;
+
+	for (S = 0; S < numVerts; S++) {
+		for (y = 0; y < gridSize - 1; y++) {
+			for (x = 0; x < gridSize - 1; x++) {
+				MPoly *mp = &data->mpoly[i];
 
-					mv->v = v3;
-					mv->e = GET_UINT_FROM_POINTER(BLI_edgehash_lookup(ccgdm->ehash, v3, v4));
-					mv++; i++;
+				mp->mat_nr = mat_nr;
+				mp->flag = flag;
+				mp->loopstart = i * 4;
+				mp->totloop = 4;
 
-					mv->v = v4;
-					mv->e = GET_UINT_FROM_POINTER(BLI_edgehash_lookup(ccgdm->ehash, v4, v1));
-					mv++; i++;
-				}
+				i++;
 			}
 		}
 	}
-	BLI_rw_mutex_unlock(&loops_cache_rwlock);
 }
 
 static void ccgDM_copyFinalPolyArray(DerivedMesh *dm, MPoly *mpoly)
 {
 	CCGDerivedMesh *ccgdm = (CCGDerivedMesh *) dm;
 	CCGSubSurf *ss = ccgdm->ss;
-	int index;
-	int totface;
-	int gridSize = ccgSubSurf_getGridSize(ss);
-	/* int edgeSize = ccgSubSurf_getEdgeSize(ss); */ /* UNUSED */
-	int i = 0, k = 0;
-	DMFlagMat *faceFlags = ccgdm->faceFlags;
-
-	totface = ccgSubSurf_getNumFaces(ss);
-	for (index = 0; index < totface; index++) {
-		CCGFace *f = ccgdm->faceMap[index].face;
-		int x, y, S, numVerts = ccgSubSurf_getFaceNumVerts(f);
-		int flag = (faceFlags) ? faceFlags[index].flag : ME_SMOOTH;
-		int mat_nr = (faceFlags) ? faceFlags[index].mat_nr : 0;
-
-		for (S = 0; S < numVerts; S++) {
-			for (y = 0; y < gridSize - 1; y++) {
-				for (x = 0; x < gridSize - 1; x++) {
-					MPoly *mp = &mpoly[i];
+	CopyFinalArrayData data = {
+	    .ccgdm = ccgdm,
+	    .gridSize = ccgSubSurf_getGridSize(ss),
+	    .mpoly = mpoly,
+	};
 
-					mp->mat_nr = mat_nr;
-					mp->flag = flag;
-					mp->loopstart = k;
-					mp->totloop = 4;
-
-					k += 4;
-					i++;
-				}
-			}
-		}
-	}
+	ccgDM_copyFinal_parallel_range(&data, ccgSubSurf_getNumFaces(ss), ccgDM_copyFinalPolyArray_faces_cb);
 }
 
 static void ccgdm_getVertCos(DerivedMesh *dm, float (*cos)[3])
@@ -5136,6 +5313,10 @@ struct DerivedMesh *subsurf_make_derived_from_derived(
 		else {
 			CCGFlags ccg_flags = useSimple | CCG_USE_ARENA | CCG_CALC_NORMALS;
 			CCGSubSurf *prevSS = NULL;
+			bool use_coords_sync = false;
+
+			if (flags & SUBSURF_ALLOC_PAINT_MASK)
+				ccg_flags |= CCG_ALLOC_MASK;
 
 			if (smd->mCache && (flags & SUBSURF_IS_FINAL_CALC)) {
 #ifdef WITH_OPENSUBDIV
@@ -5153,21 +5334,39 @@ struct DerivedMesh *subsurf_make_derived_from_derived(
 				}
 				else
 #endif
+				/* Deforming input (armatures, shape keys...) only moves vertices,
+				 * in which case the cached topology is kept and only the moved
+				 * vertices are subdivided again. Any other change rebuilds the
+				 * cache from scratch, since the arena never gives memory back. */
+				if ((ccgSubSurf_getSubdivisionLevels(smd->mCache) == max_ii(levels, 1)) &&
+				    ss_ccg_topology_matches_derivedmesh(smd->mCache, dm, useSimple))
 				{
+					prevSS = smd->mCache;
+					use_coords_sync = true;
+				}
+				else {
 					ccgSubSurf_free(smd->mCache);
 					smd->mCache = NULL;
 				}
 			}
 
-
-			if (flags & SUBSURF_ALLOC_PAINT_MASK)
-				ccg_flags |= CCG_ALLOC_MASK;
-
 			ss = _getSubSurf(prevSS, levels, 3, ccg_flags);
+			if (use_coords_sync && (ss != prevSS)) {
+				/* cached subsurf was not compatible with the requested flags */
+				smd->mCache = NULL;
+				use_coords_sync = false;
+			}
 #ifdef WITH_OPENSUBDIV
 			ccgSubSurf_setSkipGrids(ss, use_gpu_backend);
 #endif
-			ss_sync_from_derivedmesh(ss, dm, vertCos, useSimple, useSubsurfUv);
+			if (use_coords_sync) {
+				/* the paint mask layer is only enabled after syncing */
+				ccgSubSurf_setNumLayers(ss, 3);
+				ss_sync_ccg_coords_from_derivedmesh(ss, dm, vertCos);
+			}
+			else {
+				ss_sync_from_derivedmesh(ss, dm, vertCos, useSimple, useSubsurfUv);
+			}
 
 			result = getCCGDerivedMesh(ss, drawInteriorEdges, useSubsurfUv, dm, use_gpu_backend);
 
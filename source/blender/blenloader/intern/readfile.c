@@ -4344,7 +4344,7 @@ static void direct_link_particlesystems(FileData *fd, ListBase *particles)
 		}
 
 		psys->tree = NULL;
-		psys->bvhtree = NULL;
+		psys->sph_grid = NULL;
 	}
 	return;
 }
@@ -5046,6 +5046,11 @@ static void direct_link_modifiers(FileData *fd, ListBase *lb)
 			
 			smd->emCache = smd->mCache = NULL;
 		}
+		else if (md->type == eModifierType_Multires) {
+			MultiresModifierData *mmd = (MultiresModifierData *)md;
+			
+			mmd->reshapeCache = NULL;
+		}
 		else if (md->type == eModifierType_Armature) {
 			ArmatureModifierData *amd = (ArmatureModifierData *)md;
 			
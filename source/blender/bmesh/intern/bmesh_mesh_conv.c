@@ -86,6 +86,7 @@
 #include "BLI_listbase.h"
 #include "BLI_alloca.h"
 #include "BLI_math_vector.h"
+#include "BLI_task.h"
 
 #include "BKE_mesh.h"
 #include "BKE_customdata.h"
@@ -217,6 +218,103 @@ static BMFace *bm_face_create_from_mpoly(
 }
 
 
+typedef struct BMFromMeTaskData {
+	BMesh *bm;
+	Mesh *me;
+	const struct BMeshFromMeshParams *params;
+
+	BMVert **vtable;
+	BMEdge **etable;
+	BMFace **ftable;
+
+	int tot_shape_keys;
+	const float (**shape_key_table)[3];
+
+	int cd_vert_bweight_offset;
+	int cd_edge_bweight_offset;
+	int cd_edge_crease_offset;
+	int cd_shape_key_offset;
+	int cd_shape_keyindex_offset;
+} BMFromMeTaskData;
+
+static void bm_from_me_vert_cb(void *userdata, const int i)
+{
+	const BMFromMeTaskData *data = userdata;
+	BMesh *bm = data->bm;
+	Mesh *me = data->me;
+	const MVert *mvert = &me->mvert[i];
+	BMVert *v = data->vtable[i];
+
+	normal_short_to_float_v3(v->no, mvert->no);
+
+	/* Copy Custom Data */
+	CustomData_to_bmesh_block(&me->vdata, &bm->vdata, i, &v->head.data, true);
+
+	if (data->cd_vert_bweight_offset != -1) {
+		BM_ELEM_CD_SET_FLOAT(v, data->cd_vert_bweight_offset, (float)mvert->bweight / 255.0f);
+	}
+
+	/* set shape key original index */
+	if (data->cd_shape_keyindex_offset != -1) {
+		BM_ELEM_CD_SET_INT(v, data->cd_shape_keyindex_offset, i);
+	}
+
+	/* set shapekey data */
+	if (data->tot_shape_keys) {
+		float (*co_dst)[3] = BM_ELEM_CD_GET_VOID_P(v, data->cd_shape_key_offset);
+		for (int j = 0; j < data->tot_shape_keys; j++, co_dst++) {
+			copy_v3_v3(*co_dst, data->shape_key_table[j][i]);
+		}
+	}
+}
+
+static void bm_from_me_edge_cb(void *userdata, const int i)
+{
+	const BMFromMeTaskData *data = userdata;
+	BMesh *bm = data->bm;
+	Mesh *me = data->me;
+	const MEdge *medge = &me->medge[i];
+	BMEdge *e = data->etable[i];
+
+	/* Copy Custom Data */
+	CustomData_to_bmesh_block(&me->edata, &bm->edata, i, &e->head.data, true);
+
+	if (data->cd_edge_bweight_offset != -1) {
+		BM_ELEM_CD_SET_FLOAT(e, data->cd_edge_bweight_offset, (float)medge->bweight / 255.0f);
+	}
+	if (data->cd_edge_crease_offset != -1) {
+		BM_ELEM_CD_SET_FLOAT(e, data->cd_edge_crease_offset, (float)medge->crease / 255.0f);
+	}
+}
+
+static void bm_from_me_face_cb(void *userdata, const int i)
+{
+	const BMFromMeTaskData *data = userdata;
+	BMesh *bm = data->bm;
+	Mesh *me = data->me;
+	BMFace *f = data->ftable[i];
+	BMLoop *l_iter, *l_first;
+	int j;
+
+	if (f == NULL) {
+		return;
+	}
+
+	j = me->mpoly[i].loopstart;
+	l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+	do {
+		CustomData_to_bmesh_block(&me->ldata, &bm->ldata, j++, &l_iter->head.data, true);
+	} while ((l_iter = l_iter->next) != l_first);
+
+	/* Copy Custom Data */
+	CustomData_to_bmesh_block(&me->pdata, &bm->pdata, i, &f->head.data, true);
+
+	if (data->params->calc_face_normal) {
+		BM_face_normal_update(f);
+	}
+}
+
+
 /**
  * \brief Mesh -> BMesh
  *
@@ -233,7 +331,7 @@ void BM_mesh_bm_from_me(
 	KeyBlock *actkey, *block;
 	BMVert *v, **vtable = NULL;
 	BMEdge *e, **etable = NULL;
-	BMFace *f;
+	BMFace *f, **ftable = NULL;
 	float (*keyco)[3] = NULL;
 	int totuv, totloops, i, j;
 
@@ -333,6 +431,20 @@ void BM_mesh_bm_from_me(
 	const int cd_shape_keyindex_offset = (tot_shape_keys || params->add_key_index) ?
 	          CustomData_get_offset(&bm->vdata, CD_SHAPE_KEYINDEX) : -1;
 
+	BMFromMeTaskData data = {
+	    .bm = bm, .me = me, .params = params,
+	    .tot_shape_keys = tot_shape_keys, .shape_key_table = shape_key_table,
+	    .cd_vert_bweight_offset = cd_vert_bweight_offset,
+	    .cd_edge_bweight_offset = cd_edge_bweight_offset,
+	    .cd_edge_crease_offset = cd_edge_crease_offset,
+	    .cd_shape_key_offset = cd_shape_key_offset,
+	    .cd_shape_keyindex_offset = cd_shape_keyindex_offset,
+	};
+
+	/* Elements and their custom-data blocks are allocated from memory pools (sized for the mesh
+	 * by #CustomData_bmesh_init_pool and the #BMesh allocation template), which can only be done
+	 * from one thread. Filling in the custom-data is done in parallel afterwards. */
+
 	for (i = 0, mvert = me->mvert; i < me->totvert; i++, mvert++) {
 		v = vtable[i] = BM_vert_create(
 		        bm, keyco && params->use_shapekey ? keyco[i] : mvert->co, NULL,
@@ -347,27 +459,14 @@ void BM_mesh_bm_from_me(
 			BM_vert_select_set(bm, v, true);
 		}
 
-		normal_short_to_float_v3(v->no, mvert->no);
-
-		/* Copy Custom Data */
-		CustomData_to_bmesh_block(&me->vdata, &bm->vdata, i, &v->head.data, true);
-
-		if (cd_vert_bweight_offset != -1) BM_ELEM_CD_SET_FLOAT(v, cd_vert_bweight_offset, (float)mvert->bweight / 255.0f);
-
-		/* set shape key original index */
-		if (cd_shape_keyindex_offset != -1) BM_ELEM_CD_SET_INT(v, cd_shape_keyindex_offset, i);
-
-		/* set shapekey data */
-		if (tot_shape_keys) {
-			float (*co_dst)[3] = BM_ELEM_CD_GET_VOID_P(v, cd_shape_key_offset);
-			for (j = 0; j < tot_shape_keys; j++, co_dst++) {
-				copy_v3_v3(*co_dst, shape_key_table[j][i]);
-			}
-		}
+		CustomData_bmesh_alloc_block(&bm->vdata, &v->head.data);
 	}
 
 	bm->elem_index_dirty &= ~BM_VERT; /* added in order, clear dirty flag */
 
+	data.vtable = vtable;
+	BLI_task_parallel_range(0, me->totvert, &data, bm_from_me_vert_cb, me->totvert >= BM_OMP_LIMIT);
+
 	if (!me->totedge) {
 		MEM_freeN(vtable);
 		return;
@@ -388,24 +487,27 @@ void BM_mesh_bm_from_me(
 			BM_edge_select_set(bm, e, true);
 		}
 
-		/* Copy Custom Data */
-		CustomData_to_bmesh_block(&me->edata, &bm->edata, i, &e->head.data, true);
-
-		if (cd_edge_bweight_offset != -1) BM_ELEM_CD_SET_FLOAT(e, cd_edge_bweight_offset, (float)medge->bweight / 255.0f);
-		if (cd_edge_crease_offset  != -1) BM_ELEM_CD_SET_FLOAT(e, cd_edge_crease_offset,  (float)medge->crease  / 255.0f);
-
+		CustomData_bmesh_alloc_block(&bm->edata, &e->head.data);
 	}
 
 	bm->elem_index_dirty &= ~BM_EDGE; /* added in order, clear dirty flag */
 
+	data.etable = etable;
+	BLI_task_parallel_range(0, me->totedge, &data, bm_from_me_edge_cb, me->totedge >= BM_OMP_LIMIT);
+
+	/* skipped (invalid) faces are left NULL */
+	if (me->totpoly) {
+		ftable = MEM_mallocN(sizeof(void **) * me->totpoly, "mesh to bmesh ftable");
+	}
+
 	mloop = me->mloop;
 	mp = me->mpoly;
 	for (i = 0, totloops = 0; i < me->totpoly; i++, mp++) {
 		BMLoop *l_iter;
 		BMLoop *l_first;
 
-		f = bm_face_create_from_mpoly(mp, mloop + mp->loopstart,
-		                              bm, vtable, etable);
+		f = ftable[i] = bm_face_create_from_mpoly(mp, mloop + mp->loopstart,
+		                                          bm, vtable, etable);
 
 		if (UNLIKELY(f == NULL)) {
 			printf("%s: Warning! Bad face in mesh"
@@ -428,26 +530,22 @@ void BM_mesh_bm_from_me(
 		f->mat_nr = mp->mat_nr;
 		if (i == me->act_face) bm->act_face = f;
 
-		j = mp->loopstart;
 		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
 		do {
 			/* don't use 'j' since we may have skipped some faces, hence some loops. */
 			BM_elem_index_set(l_iter, totloops++); /* set_ok */
 
-			/* Save index of correspsonding MLoop */
-			CustomData_to_bmesh_block(&me->ldata, &bm->ldata, j++, &l_iter->head.data, true);
+			CustomData_bmesh_alloc_block(&bm->ldata, &l_iter->head.data);
 		} while ((l_iter = l_iter->next) != l_first);
 
-		/* Copy Custom Data */
-		CustomData_to_bmesh_block(&me->pdata, &bm->pdata, i, &f->head.data, true);
-
-		if (params->calc_face_normal) {
-			BM_face_normal_update(f);
-		}
+		CustomData_bmesh_alloc_block(&bm->pdata, &f->head.data);
 	}
 
 	bm->elem_index_dirty &= ~(BM_FACE | BM_LOOP); /* added in order, clear dirty flag */
 
+	data.ftable = ftable;
+	BLI_task_parallel_range(0, me->totpoly, &data, bm_from_me_face_cb, me->totpoly >= BM_OMP_LIMIT);
+
 	if (me->mselect && me->totselect != 0) {
 
 		BMVert **vert_array = MEM_mallocN(sizeof(BMVert *) * bm->totvert, "VSelConv");
@@ -493,6 +591,7 @@ void BM_mesh_bm_from_me(
 
 	MEM_freeN(vtable);
 	MEM_freeN(etable);
+	MEM_SAFE_FREE(ftable);
 }
 
 
@@ -576,6 +675,104 @@ BLI_INLINE void bmesh_quick_edgedraw_flag(MEdge *med, BMEdge *e)
 	}
 }
 
+typedef struct BMToMeTaskData {
+	BMesh *bm;
+	Mesh *me;
+
+	int cd_vert_bweight_offset;
+	int cd_edge_bweight_offset;
+	int cd_edge_crease_offset;
+} BMToMeTaskData;
+
+static void bm_to_me_vert_cb(void *userdata, const int i)
+{
+	const BMToMeTaskData *data = userdata;
+	BMesh *bm = data->bm;
+	Mesh *me = data->me;
+	BMVert *v = bm->vtable[i];
+	MVert *mvert = &me->mvert[i];
+
+	copy_v3_v3(mvert->co, v->co);
+	normal_float_to_short_v3(mvert->no, v->no);
+
+	mvert->flag = BM_vert_flag_to_mflag(v);
+
+	/* copy over customdata */
+	CustomData_from_bmesh_block(&bm->vdata, &me->vdata, v->head.data, i);
+
+	if (data->cd_vert_bweight_offset != -1) {
+		mvert->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(v, data->cd_vert_bweight_offset);
+	}
+
+	BM_CHECK_ELEMENT(v);
+}
+
+static void bm_to_me_edge_cb(void *userdata, const int i)
+{
+	const BMToMeTaskData *data = userdata;
+	BMesh *bm = data->bm;
+	Mesh *me = data->me;
+	BMEdge *e = bm->etable[i];
+	MEdge *med = &me->medge[i];
+
+	med->v1 = BM_elem_index_get(e->v1);
+	med->v2 = BM_elem_index_get(e->v2);
+
+	med->flag = BM_edge_flag_to_mflag(e);
+
+	/* copy over customdata */
+	CustomData_from_bmesh_block(&bm->edata, &me->edata, e->head.data, i);
+
+	bmesh_quick_edgedraw_flag(med, e);
+
+	if (data->cd_edge_crease_offset  != -1) med->crease  = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, data->cd_edge_crease_offset);
+	if (data->cd_edge_bweight_offset != -1) med->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, data->cd_edge_bweight_offset);
+
+	BM_CHECK_ELEMENT(e);
+}
+
+static void bm_to_me_face_cb(void *userdata, const int i)
+{
+	const BMToMeTaskData *data = userdata;
+	BMesh *bm = data->bm;
+	Mesh *me = data->me;
+	BMFace *f = bm->ftable[i];
+	MPoly *mpoly = &me->mpoly[i];
+	BMLoop *l_iter, *l_first;
+	MLoop *mloop;
+	int j;
+
+	l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+
+	/* loops are indexed in face order */
+	j = BM_elem_index_get(l_first);
+	mloop = &me->mloop[j];
+
+	mpoly->loopstart = j;
+	mpoly->totloop = f->len;
+	mpoly->mat_nr = f->mat_nr;
+	mpoly->flag = BM_face_flag_to_mflag(f);
+
+	do {
+		mloop->e = BM_elem_index_get(l_iter->e);
+		mloop->v = BM_elem_index_get(l_iter->v);
+
+		/* copy over customdata */
+		CustomData_from_bmesh_block(&bm->ldata, &me->ldata, l_iter->head.data, j);
+
+		j++;
+		mloop++;
+		BM_CHECK_ELEMENT(l_iter);
+		BM_CHECK_ELEMENT(l_iter->e);
+		BM_CHECK_ELEMENT(l_iter->v);
+	} while ((l_iter = l_iter->next) != l_first);
+
+	/* copy over customdata */
+	CustomData_from_bmesh_block(&bm->pdata, &me->pdata, f->head.data, i);
+
+	BM_CHECK_ELEMENT(f);
+}
+
 void BM_mesh_bm_to_me(
         BMesh *bm, Mesh *me,
         const struct BMeshToMeshParams *params)
@@ -583,10 +780,8 @@ void BM_mesh_bm_to_me(
 	MLoop *mloop;
 	MPoly *mpoly;
 	MVert *mvert, *oldverts;
-	MEdge *med, *medge;
-	BMVert *v, *eve;
-	BMEdge *e;
-	BMFace *f;
+	MEdge *medge;
+	BMVert *eve;
 	BMIter iter;
 	int i, j, ototvert;
 
@@ -657,83 +852,26 @@ void BM_mesh_bm_to_me(
 	/* this is called again, 'dotess' arg is used there */
 	BKE_mesh_update_customdata_pointers(me, 0);
 
-	i = 0;
-	BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
-		copy_v3_v3(mvert->co, v->co);
-		normal_float_to_short_v3(mvert->no, v->no);
-
-		mvert->flag = BM_vert_flag_to_mflag(v);
-
-		BM_elem_index_set(v, i); /* set_inline */
-
-		/* copy over customdat */
-		CustomData_from_bmesh_block(&bm->vdata, &me->vdata, v->head.data, i);
-
-		if (cd_vert_bweight_offset != -1) mvert->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(v, cd_vert_bweight_offset);
-
-		i++;
-		mvert++;
-
-		BM_CHECK_ELEMENT(v);
-	}
-	bm->elem_index_dirty &= ~BM_VERT;
-
-	med = medge;
-	i = 0;
-	BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
-		med->v1 = BM_elem_index_get(e->v1);
-		med->v2 = BM_elem_index_get(e->v2);
-
-		med->flag = BM_edge_flag_to_mflag(e);
-
-		BM_elem_index_set(e, i); /* set_inline */
-
-		/* copy over customdata */
-		CustomData_from_bmesh_block(&bm->edata, &me->edata, e->head.data, i);
-
-		bmesh_quick_edgedraw_flag(med, e);
-
-		if (cd_edge_crease_offset  != -1) med->crease  = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, cd_edge_crease_offset);
-		if (cd_edge_bweight_offset != -1) med->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, cd_edge_bweight_offset);
+	/* Indices are written into the mesh, so always recalculate them. */
+	bm->elem_index_dirty |= BM_ALL;
+	BM_mesh_elem_index_ensure(bm, BM_ALL);
+	BM_mesh_elem_table_ensure(bm, BM_VERT | BM_EDGE | BM_FACE);
 
-		i++;
-		med++;
-		BM_CHECK_ELEMENT(e);
+	{
+		BMToMeTaskData data = {
+		    .bm = bm, .me = me,
+		    .cd_vert_bweight_offset = cd_vert_bweight_offset,
+		    .cd_edge_bweight_offset = cd_edge_bweight_offset,
+		    .cd_edge_crease_offset = cd_edge_crease_offset,
+		};
+
+		BLI_task_parallel_range(0, bm->totvert, &data, bm_to_me_vert_cb, bm->totvert >= BM_OMP_LIMIT);
+		BLI_task_parallel_range(0, bm->totedge, &data, bm_to_me_edge_cb, bm->totedge >= BM_OMP_LIMIT);
+		BLI_task_parallel_range(0, bm->totface, &data, bm_to_me_face_cb, bm->totface >= BM_OMP_LIMIT);
 	}
-	bm->elem_index_dirty &= ~BM_EDGE;
-
-	i = 0;
-	j = 0;
-	BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
-		BMLoop *l_iter, *l_first;
-		mpoly->loopstart = j;
-		mpoly->totloop = f->len;
-		mpoly->mat_nr = f->mat_nr;
-		mpoly->flag = BM_face_flag_to_mflag(f);
-
-		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
-		do {
-			mloop->e = BM_elem_index_get(l_iter->e);
-			mloop->v = BM_elem_index_get(l_iter->v);
-
-			/* copy over customdata */
-			CustomData_from_bmesh_block(&bm->ldata, &me->ldata, l_iter->head.data, j);
-
-			j++;
-			mloop++;
-			BM_CHECK_ELEMENT(l_iter);
-			BM_CHECK_ELEMENT(l_iter->e);
-			BM_CHECK_ELEMENT(l_iter->v);
-		} while ((l_iter = l_iter->next) != l_first);
-
-		if (f == bm->act_face) me->act_face = i;
-
-		/* copy over customdata */
-		CustomData_from_bmesh_block(&bm->pdata, &me->pdata, f->head.data, i);
 
-		i++;
-		mpoly++;
-		BM_CHECK_ELEMENT(f);
+	if (bm->act_face) {
+		me->act_face = BM_elem_index_get(bm->act_face);
 	}
 
 	/* patch hook indices and vertex parents */
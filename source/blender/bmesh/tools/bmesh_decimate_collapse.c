@@ -36,11 +36,13 @@
 #include "BLI_heap.h"
 #include "BLI_linklist.h"
 #include "BLI_alloca.h"
+#include "BLI_buffer.h"
 #include "BLI_memarena.h"
 #include "BLI_edgehash.h"
 #include "BLI_polyfill2d.h"
 #include "BLI_polyfill2d_beautify.h"
 #include "BLI_stackdefines.h"
+#include "BLI_task.h"
 
 
 #include "BKE_customdata.h"
@@ -83,62 +85,144 @@ typedef enum CD_UseFlag {
 /* BMesh Helper Functions
  * ********************** */
 
+static void bm_decim_face_plane(BMFace *f, double plane_db[4])
+{
+	float center[3];
+
+	BM_face_calc_center_mean(f, center);
+	copy_v3db_v3fl(plane_db, f->no);
+	plane_db[3] = -dot_v3db_v3fl(plane_db, center);
+}
+
 /**
- * \param vquadrics must be calloc'd
+ * \return false when the plane of boundary edge \a e can't be calculated.
  */
-static void bm_decim_build_quadrics(BMesh *bm, Quadric *vquadrics)
+static bool bm_decim_boundary_edge_quadric(BMEdge *e, Quadric *q)
 {
-	BMIter iter;
-	BMFace *f;
-	BMEdge *e;
+	float edge_vector[3];
+	float edge_plane[3];
+	double edge_plane_db[4];
+	sub_v3_v3v3(edge_vector, e->v2->co, e->v1->co);
 
-	BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
-		BMLoop *l_first;
-		BMLoop *l_iter;
+	cross_v3_v3v3(edge_plane, edge_vector, e->l->f->no);
+	copy_v3db_v3fl(edge_plane_db, edge_plane);
 
+	if (normalize_v3_d(edge_plane_db) > (double)FLT_EPSILON) {
 		float center[3];
-		double plane_db[4];
-		Quadric q;
 
-		BM_face_calc_center_mean(f, center);
-		copy_v3db_v3fl(plane_db, f->no);
-		plane_db[3] = -dot_v3db_v3fl(plane_db, center);
+		mid_v3_v3v3(center, e->v1->co, e->v2->co);
 
-		BLI_quadric_from_plane(&q, plane_db);
+		edge_plane_db[3] = -dot_v3db_v3fl(edge_plane_db, center);
+		BLI_quadric_from_plane(q, edge_plane_db);
+		BLI_quadric_mul(q, BOUNDARY_PRESERVE_WEIGHT);
+		return true;
+	}
+	return false;
+}
 
-		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
-		do {
-			BLI_quadric_add_qu_qu(&vquadrics[BM_elem_index_get(l_iter->v)], &q);
-		} while ((l_iter = l_iter->next) != l_first);
+/* sort the (few) indices of elements around a vertex */
+static void bm_decim_index_sort(int *index, const int index_len)
+{
+	int i, j;
+
+	for (i = 1; i < index_len; i++) {
+		const int value = index[i];
+		for (j = i; (j > 0) && (index[j - 1] > value); j--) {
+			index[j] = index[j - 1];
+		}
+		index[j] = value;
 	}
+}
 
-	/* boundary edges */
-	BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
-		if (UNLIKELY(BM_edge_is_boundary(e))) {
-			float edge_vector[3];
-			float edge_plane[3];
-			double edge_plane_db[4];
-			sub_v3_v3v3(edge_vector, e->v2->co, e->v1->co);
-			f = e->l->f;
+struct DecimQuadricData {
+	BMesh *bm;
+	Quadric *vquadrics;
+	double (*fplanes)[4];
+};
+
+static void bm_decim_build_face_planes_cb(void *userdata, const int index)
+{
+	struct DecimQuadricData *data = userdata;
+
+	bm_decim_face_plane(BM_face_at_index(data->bm, index), data->fplanes[index]);
+}
+
+/**
+ * Each vertex sums the quadrics of its own faces and boundary edges,
+ * so vertices can be handled in parallel without write conflicts.
+ *
+ * Quadrics are added in face, then boundary edge index order,
+ * the same order as when looping over all faces and edges of the mesh,
+ * so the result doesn't depend on threading and matches the single threaded sum exactly.
+ */
+static void bm_decim_build_quadrics_cb(void *userdata, const int index)
+{
+	struct DecimQuadricData *data = userdata;
+	BMVert *v = BM_vert_at_index(data->bm, index);
+	Quadric *vq = &data->vquadrics[index];
+	BMIter iter;
+	BMLoop *l;
+	BMEdge *e;
+	Quadric q;
+	int i;
+
+	BLI_buffer_declare_static(int, index_buf, BLI_BUFFER_NOP, 32);
 
-			cross_v3_v3v3(edge_plane, edge_vector, f->no);
-			copy_v3db_v3fl(edge_plane_db, edge_plane);
+	BM_ITER_ELEM (l, &iter, v, BM_LOOPS_OF_VERT) {
+		BLI_buffer_append(&index_buf, int, BM_elem_index_get(l->f));
+	}
+	bm_decim_index_sort(index_buf.data, (int)index_buf.count);
 
-			if (normalize_v3_d(edge_plane_db) > (double)FLT_EPSILON) {
-				Quadric q;
-				float center[3];
+	for (i = 0; i < (int)index_buf.count; i++) {
+		BLI_quadric_from_plane(&q, data->fplanes[BLI_buffer_at(&index_buf, int, i)]);
+		BLI_quadric_add_qu_qu(vq, &q);
+	}
 
-				mid_v3_v3v3(center, e->v1->co, e->v2->co);
+	/* boundary edges */
+	BLI_buffer_empty(&index_buf);
+	BM_ITER_ELEM (e, &iter, v, BM_EDGES_OF_VERT) {
+		if (UNLIKELY(BM_edge_is_boundary(e))) {
+			BLI_buffer_append(&index_buf, int, BM_elem_index_get(e));
+		}
+	}
 
-				edge_plane_db[3] = -dot_v3db_v3fl(edge_plane_db, center);
-				BLI_quadric_from_plane(&q, edge_plane_db);
-				BLI_quadric_mul(&q, BOUNDARY_PRESERVE_WEIGHT);
+	if (UNLIKELY(index_buf.count != 0)) {
+		bm_decim_index_sort(index_buf.data, (int)index_buf.count);
 
-				BLI_quadric_add_qu_qu(&vquadrics[BM_elem_index_get(e->v1)], &q);
-				BLI_quadric_add_qu_qu(&vquadrics[BM_elem_index_get(e->v2)], &q);
+		for (i = 0; i < (int)index_buf.count; i++) {
+			if (bm_decim_boundary_edge_quadric(BM_edge_at_index(data->bm, BLI_buffer_at(&index_buf, int, i)), &q)) {
+				BLI_quadric_add_qu_qu(vq, &q);
 			}
 		}
 	}
+
+	BLI_buffer_free(&index_buf);
+}
+
+/**
+ * \param vquadrics must be calloc'd
+ */
+static void bm_decim_build_quadrics(BMesh *bm, Quadric *vquadrics)
+{
+	struct DecimQuadricData data = {
+		.bm = bm,
+		.vquadrics = vquadrics,
+		.fplanes = MEM_mallocN(sizeof(*data.fplanes) * (size_t)bm->totface, __func__),
+	};
+
+	BM_mesh_elem_index_ensure(bm, BM_VERT | BM_EDGE | BM_FACE);
+	BM_mesh_elem_table_ensure(bm, BM_VERT | BM_EDGE | BM_FACE);
+
+	/* face planes are shared by all vertices of the face, calculate them once */
+	BLI_task_parallel_range(
+	        0, bm->totface, &data, bm_decim_build_face_planes_cb,
+	        bm->totface >= BM_OMP_LIMIT);
+
+	BLI_task_parallel_range(
+	        0, bm->totvert, &data, bm_decim_build_quadrics_cb,
+	        bm->totvert >= BM_OMP_LIMIT);
+
+	MEM_freeN(data.fplanes);
 }
 
 
@@ -248,18 +332,17 @@ static float bm_decim_build_edge_cost_single__topology(BMEdge *e)
 
 #endif  /* USE_TOPOLOGY_FALLBACK */
 
-static void bm_decim_build_edge_cost_single(
+/**
+ * \return false when \a e can't be collapsed, otherwise calculate \a r_cost.
+ */
+static bool bm_decim_calc_edge_cost_single(
         BMEdge *e,
         const Quadric *vquadrics,
         const float *vweights, const float vweight_factor,
-        Heap *eheap, HeapNode **eheap_table)
+        float *r_cost)
 {
 	float cost;
 
-	if (eheap_table[BM_elem_index_get(e)]) {
-		BLI_heap_remove(eheap, eheap_table[BM_elem_index_get(e)]);
-	}
-
 	if (UNLIKELY(vweights &&
 	             ((vweights[BM_elem_index_get(e->v1)] == 0.0f) ||
 	              (vweights[BM_elem_index_get(e->v2)] == 0.0f))))
@@ -341,11 +424,31 @@ static void bm_decim_build_edge_cost_single(
 		}
 	}
 
-	eheap_table[BM_elem_index_get(e)] = BLI_heap_insert(eheap, cost, e);
-	return;
+	*r_cost = cost;
+	return true;
 
 clear:
-	eheap_table[BM_elem_index_get(e)] = NULL;
+	return false;
+}
+
+static void bm_decim_build_edge_cost_single(
+        BMEdge *e,
+        const Quadric *vquadrics,
+        const float *vweights, const float vweight_factor,
+        Heap *eheap, HeapNode **eheap_table)
+{
+	float cost;
+
+	if (eheap_table[BM_elem_index_get(e)]) {
+		BLI_heap_remove(eheap, eheap_table[BM_elem_index_get(e)]);
+	}
+
+	if (bm_decim_calc_edge_cost_single(e, vquadrics, vweights, vweight_factor, &cost)) {
+		eheap_table[BM_elem_index_get(e)] = BLI_heap_insert(eheap, cost, e);
+	}
+	else {
+		eheap_table[BM_elem_index_get(e)] = NULL;
+	}
 }
 
 
@@ -359,6 +462,25 @@ static void bm_decim_invalid_edge_cost_single(
 	eheap_table[BM_elem_index_get(e)] = BLI_heap_insert(eheap, COST_INVALID, e);
 }
 
+struct DecimEdgeCostData {
+	BMEdge **edges;
+	const Quadric *vquadrics;
+	const float *vweights;
+	float vweight_factor;
+
+	float *r_costs;
+	bool *r_valid;
+};
+
+static void bm_decim_build_edge_cost_cb(void *userdata, const int index)
+{
+	struct DecimEdgeCostData *data = userdata;
+	BMEdge *e = data->edges[index];
+
+	data->r_valid[index] = bm_decim_calc_edge_cost_single(
+	        e, data->vquadrics, data->vweights, data->vweight_factor, &data->r_costs[index]);
+}
+
 static void bm_decim_build_edge_cost(
         BMesh *bm,
         const Quadric *vquadrics,
@@ -369,10 +491,28 @@ static void bm_decim_build_edge_cost(
 	BMEdge *e;
 	unsigned int i;
 
+	/* costs are calculated in parallel, only filling the heap is serial */
+	struct DecimEdgeCostData data = {
+		.vquadrics = vquadrics,
+		.vweights = vweights,
+		.vweight_factor = vweight_factor,
+		.r_costs = MEM_mallocN(sizeof(float) * (size_t)bm->totedge, __func__),
+		.r_valid = MEM_mallocN(sizeof(bool) * (size_t)bm->totedge, __func__),
+	};
+
+	BM_mesh_elem_table_ensure(bm, BM_EDGE);
+	data.edges = bm->etable;
+
+	BLI_task_parallel_range(
+	        0, bm->totedge, &data, bm_decim_build_edge_cost_cb,
+	        bm->totedge >= BM_OMP_LIMIT);
+
 	BM_ITER_MESH_INDEX (e, &iter, bm, BM_EDGES_OF_MESH, i) {
-		eheap_table[i] = NULL;  /* keep sanity check happy */
-		bm_decim_build_edge_cost_single(e, vquadrics, vweights, vweight_factor, eheap, eheap_table);
+		eheap_table[i] = data.r_valid[i] ? BLI_heap_insert(eheap, data.r_costs[i], e) : NULL;
 	}
+
+	MEM_freeN(data.r_costs);
+	MEM_freeN(data.r_valid);
 }
 
 #ifdef USE_SYMMETRY
@@ -1134,9 +1274,30 @@ static bool bm_edge_collapse(
 }
 
 
+/**
+ * Update the cost of an edge around a collapse,
+ * or only collect it when \a edges_cost_update is given, to update many at once later.
+ */
+static void bm_decim_edge_cost_update(
+        BMEdge *e,
+        const Quadric *vquadrics,
+        const float *vweights, const float vweight_factor,
+        Heap *eheap, HeapNode **eheap_table,
+        BLI_Buffer *edges_cost_update)
+{
+	if (edges_cost_update) {
+		BLI_buffer_append(edges_cost_update, BMEdge *, e);
+	}
+	else {
+		bm_decim_build_edge_cost_single(e, vquadrics, vweights, vweight_factor, eheap, eheap_table);
+	}
+}
+
 /**
  * Collapse e the edge, removing e->v2
  *
+ * \param edges_cost_update: When not NULL, edges which need their cost updated are appended,
+ * instead of being updated in the heap right away.
  * \return true when the edge was collapsed.
  */
 static bool bm_decim_edge_collapse(
@@ -1148,7 +1309,8 @@ static bool bm_decim_edge_collapse(
         int *edge_symmetry_map,
 #endif
         const CD_UseFlag customdata_flag,
-        float optimize_co[3], bool optimize_co_calc
+        float optimize_co[3], bool optimize_co_calc,
+        BLI_Buffer *edges_cost_update
         )
 {
 	int e_clear_other[2];
@@ -1245,7 +1407,9 @@ static bool bm_decim_edge_collapse(
 			e_iter = e_first = v_other->e;
 			do {
 				BLI_assert(BM_edge_find_double(e_iter) == NULL);
-				bm_decim_build_edge_cost_single(e_iter, vquadrics, vweights, vweight_factor, eheap, eheap_table);
+				bm_decim_edge_cost_update(
+				        e_iter, vquadrics, vweights, vweight_factor, eheap, eheap_table,
+				        edges_cost_update);
 			} while ((e_iter = bmesh_disk_edge_next(e_iter, v_other)) != e_first);
 		}
 
@@ -1267,7 +1431,9 @@ static bool bm_decim_edge_collapse(
 
 					BLI_assert(BM_vert_in_edge(e_outer, l->v) == false);
 
-					bm_decim_build_edge_cost_single(e_outer, vquadrics, vweights, vweight_factor, eheap, eheap_table);
+					bm_decim_edge_cost_update(
+					        e_outer, vquadrics, vweights, vweight_factor, eheap, eheap_table,
+					        edges_cost_update);
 				}
 			}
 		}
@@ -1283,6 +1449,209 @@ static bool bm_decim_edge_collapse(
 }
 
 
+/* Parallel Collapse
+ * ***************** */
+
+/* Edges taken from the heap for one round of the parallel collapse,
+ * the ones which can't be collapsed along with the others are put back. */
+#define DECIM_PARALLEL_ROUND_EDGES 256
+
+/**
+ * Check none of the vertices read or changed when collapsing \a e
+ * are used by another collapse of this round, then claim them.
+ * Faces are all triangles, so these are the vertices of the edge and their neighbors.
+ */
+static bool bm_decim_edge_collapse_region_claim(BMEdge *e, unsigned int *vert_round, const unsigned int round)
+{
+	BMVert *v_pair[2] = {e->v1, e->v2};
+	BMEdge *e_iter;
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		e_iter = v_pair[i]->e;
+		do {
+			if ((vert_round[BM_elem_index_get(e_iter->v1)] == round) ||
+			    (vert_round[BM_elem_index_get(e_iter->v2)] == round))
+			{
+				return false;
+			}
+		} while ((e_iter = bmesh_disk_edge_next(e_iter, v_pair[i])) != v_pair[i]->e);
+	}
+
+	for (i = 0; i < 2; i++) {
+		e_iter = v_pair[i]->e;
+		do {
+			vert_round[BM_elem_index_get(e_iter->v1)] = round;
+			vert_round[BM_elem_index_get(e_iter->v2)] = round;
+		} while ((e_iter = bmesh_disk_edge_next(e_iter, v_pair[i])) != v_pair[i]->e);
+	}
+
+	return true;
+}
+
+struct DecimCollapseCheckData {
+	BMEdge **edges;
+	const Quadric *vquadrics;
+
+	float (*r_optimize_co)[3];
+	bool *r_valid;
+};
+
+static void bm_decim_edge_collapse_check_cb(void *userdata, const int index)
+{
+	struct DecimCollapseCheckData *data = userdata;
+	BMEdge *e = data->edges[index];
+	float *optimize_co = data->r_optimize_co[index];
+
+	/* same checks as bm_decim_edge_collapse() does before collapsing a single edge */
+	if (UNLIKELY(bm_edge_collapse_is_degenerate_topology(e))) {
+		data->r_valid[index] = false;
+		return;
+	}
+
+	bm_decim_calc_target_co_fl(e, optimize_co, data->vquadrics);
+
+	data->r_valid[index] = !bm_edge_collapse_is_degenerate_flip(e, optimize_co);
+}
+
+/**
+ * Collapse edges in rounds, each round takes the cheapest edges which don't share any vertex neighbors.
+ * Checking the collapses of a round and updating the costs around them runs in parallel,
+ * only changing the mesh and the heap is serial.
+ *
+ * Edges which become cheaper from a collapse are only considered from the next round on,
+ * so the result differs from collapsing one edge at a time, it doesn't depend on the number of threads.
+ */
+static void bm_decim_edge_collapse_parallel(
+        BMesh *bm, const int face_tot_target,
+        Quadric *vquadrics,
+        float *vweights, const float vweight_factor,
+        Heap *eheap, HeapNode **eheap_table,
+        const CD_UseFlag customdata_flag)
+{
+	BMEdge **edges = MEM_mallocN(sizeof(*edges) * DECIM_PARALLEL_ROUND_EDGES, __func__);
+	float (*optimize_cos)[3] = MEM_mallocN(sizeof(*optimize_cos) * DECIM_PARALLEL_ROUND_EDGES, __func__);
+	bool *edges_valid = MEM_mallocN(sizeof(*edges_valid) * DECIM_PARALLEL_ROUND_EDGES, __func__);
+	BMEdge **edges_skip = MEM_mallocN(sizeof(*edges_skip) * DECIM_PARALLEL_ROUND_EDGES, __func__);
+	float *edges_skip_cost = MEM_mallocN(sizeof(*edges_skip_cost) * DECIM_PARALLEL_ROUND_EDGES, __func__);
+	/* the last round each vertex was claimed in */
+	unsigned int *vert_round = MEM_callocN(sizeof(*vert_round) * (size_t)bm->totvert, __func__);
+	unsigned int round = 0;
+
+	BLI_buffer_declare(BMEdge *, edges_cost_update, BLI_BUFFER_NOP);
+	BLI_buffer_declare(float, costs_buf, BLI_BUFFER_NOP);
+	BLI_buffer_declare(bool, costs_valid_buf, BLI_BUFFER_NOP);
+
+	while ((bm->totface > face_tot_target) &&
+	       (BLI_heap_is_empty(eheap) == false) &&
+	       (BLI_heap_node_value(BLI_heap_top(eheap)) != COST_INVALID))
+	{
+		int face_tot_round = bm->totface;
+		int edges_len = 0, edges_skip_len = 0;
+		int i;
+
+		round++;
+
+		/* take the cheapest edges which can be collapsed independently */
+		while ((edges_len + edges_skip_len < DECIM_PARALLEL_ROUND_EDGES) &&
+		       (face_tot_round > face_tot_target) &&
+		       (BLI_heap_is_empty(eheap) == false) &&
+		       (BLI_heap_node_value(BLI_heap_top(eheap)) != COST_INVALID))
+		{
+			const float cost = BLI_heap_node_value(BLI_heap_top(eheap));
+			BMEdge *e = BLI_heap_popmin(eheap);
+
+			eheap_table[BM_elem_index_get(e)] = NULL;
+
+			if (bm_decim_edge_collapse_region_claim(e, vert_round, round)) {
+				edges[edges_len++] = e;
+				face_tot_round -= BM_edge_is_boundary(e) ? 1 : 2;
+			}
+			else {
+				edges_skip[edges_skip_len] = e;
+				edges_skip_cost[edges_skip_len] = cost;
+				edges_skip_len++;
+			}
+		}
+
+		/* skipped edges are added back before collapsing, which may remove them from the heap */
+		for (i = 0; i < edges_skip_len; i++) {
+			eheap_table[BM_elem_index_get(edges_skip[i])] = BLI_heap_insert(eheap, edges_skip_cost[i], edges_skip[i]);
+		}
+
+		{
+			struct DecimCollapseCheckData data = {
+				.edges = edges,
+				.vquadrics = vquadrics,
+				.r_optimize_co = optimize_cos,
+				.r_valid = edges_valid,
+			};
+
+			BLI_task_parallel_range(0, edges_len, &data, bm_decim_edge_collapse_check_cb, true);
+		}
+
+		BLI_buffer_empty(&edges_cost_update);
+
+		for (i = 0; i < edges_len; i++) {
+			if (edges_valid[i]) {
+				bm_decim_edge_collapse(
+				        bm, edges[i], vquadrics, vweights, vweight_factor, eheap, eheap_table,
+#ifdef USE_SYMMETRY
+				        NULL,
+#endif
+				        customdata_flag,
+				        optimize_cos[i], false,
+				        &edges_cost_update);
+			}
+			else {
+				/* add back with a high cost */
+				bm_decim_invalid_edge_cost_single(edges[i], eheap, eheap_table);
+			}
+		}
+
+		/* the regions don't overlap either, each edge is only added once */
+		if (edges_cost_update.count != 0) {
+			const int edges_update_len = (int)edges_cost_update.count;
+			struct DecimEdgeCostData data = {
+				.edges = BLI_buffer_array(&edges_cost_update, BMEdge *),
+				.vquadrics = vquadrics,
+				.vweights = vweights,
+				.vweight_factor = vweight_factor,
+				.r_costs = BLI_buffer_reinit_data(&costs_buf, float, edges_update_len),
+				.r_valid = BLI_buffer_reinit_data(&costs_valid_buf, bool, edges_update_len),
+			};
+
+			BLI_task_parallel_range(0, edges_update_len, &data, bm_decim_build_edge_cost_cb, true);
+
+			for (i = 0; i < edges_update_len; i++) {
+				BMEdge *e = data.edges[i];
+				const int e_index = BM_elem_index_get(e);
+
+				if (eheap_table[e_index]) {
+					/* most edges of the face fans keep their cost, leave them in place */
+					if (data.r_valid[i] && (BLI_heap_node_value(eheap_table[e_index]) == data.r_costs[i])) {
+						continue;
+					}
+					BLI_heap_remove(eheap, eheap_table[e_index]);
+				}
+				eheap_table[e_index] = data.r_valid[i] ? BLI_heap_insert(eheap, data.r_costs[i], e) : NULL;
+			}
+		}
+	}
+
+	BLI_buffer_free(&edges_cost_update);
+	BLI_buffer_free(&costs_buf);
+	BLI_buffer_free(&costs_valid_buf);
+
+	MEM_freeN(edges);
+	MEM_freeN(optimize_cos);
+	MEM_freeN(edges_valid);
+	MEM_freeN(edges_skip);
+	MEM_freeN(edges_skip_cost);
+	MEM_freeN(vert_round);
+}
+
+
 /* Main Decimate Function
  * ********************** */
 
@@ -1294,13 +1663,17 @@ static bool bm_decim_edge_collapse(
  *        a vertex group is the usual source for this.
  * \param symmetry_axis: Axis of symmetry, -1 to disable mirror decimate.
  * \param symmetry_eps: Threshold when matching mirror verts.
+ * \param use_parallel: Collapse independent edges in parallel rounds, which can be faster
+ *        on large meshes with many threads, the result differs from collapsing one edge at a time.
+ *        Not used with symmetry.
  */
 void BM_mesh_decimate_collapse(
         BMesh *bm,
         const float factor,
         float *vweights, float vweight_factor,
         const bool do_triangulate,
-        const int symmetry_axis, const float symmetry_eps)
+        const int symmetry_axis, const float symmetry_eps,
+        const bool use_parallel)
 {
 	Heap *eheap;             /* edge heap */
 	HeapNode **eheap_table;  /* edge index aligned table pointing to the eheap */
@@ -1354,6 +1727,17 @@ void BM_mesh_decimate_collapse(
 #endif
 
 	/* iterative edge collapse and maintain the eheap */
+	if (use_parallel
+#ifdef USE_SYMMETRY
+	    && (use_symmetry == false)
+#endif
+	    )
+	{
+		bm_decim_edge_collapse_parallel(
+		        bm, face_tot_target, vquadrics, vweights, vweight_factor, eheap, eheap_table,
+		        customdata_flag);
+	}
+	else
 #ifdef USE_SYMMETRY
 	if (use_symmetry == false)
 #endif
@@ -1378,8 +1762,8 @@ void BM_mesh_decimate_collapse(
 			        edge_symmetry_map,
 #endif
 			        customdata_flag,
-			        optimize_co, true
-			        );
+			        optimize_co, true,
+			        NULL);
 		}
 	}
 #ifdef USE_SYMMETRY
@@ -1459,7 +1843,8 @@ void BM_mesh_decimate_collapse(
 			        bm, e, vquadrics, vweights, vweight_factor, eheap, eheap_table,
 			        edge_symmetry_map,
 			        customdata_flag,
-			        optimize_co, false))
+			        optimize_co, false,
+			        NULL))
 			{
 				if (e_mirr && (eheap_table[e_index_mirr])) {
 					BLI_assert(e_index_mirr != e_index);
@@ -1470,7 +1855,8 @@ void BM_mesh_decimate_collapse(
 					        bm, e_mirr, vquadrics, vweights, vweight_factor, eheap, eheap_table,
 					        edge_symmetry_map,
 					        customdata_flag,
-					        optimize_co, false);
+					        optimize_co, false,
+					        NULL);
 				}
 			}
 			else {
@@ -51,6 +51,7 @@
 
 #include "BLI_kdopbvh.h"
 #include "BLI_buffer.h"
+#include "BLI_task.h"
 
 #include "bmesh.h"
 #include "intern/bmesh_private.h"
@@ -858,6 +859,62 @@ finally:
 
 #ifdef USE_BVH
 
+struct OverlapFilterData {
+	struct BMLoop *(*looptris)[3];
+	float eps_margin;
+};
+
+/**
+ * Return true when all points of \a tri_a are on one side of the plane of \a tri_b
+ * (further than \a eps), in which case the triangles can't intersect.
+ */
+static bool isect_tri_tri_plane_separated(
+        const float *tri_a[3], const float *tri_b[3], const float eps)
+{
+	float nor[3];
+	float side[3];
+	unsigned int i;
+
+	if (normal_tri_v3(nor, UNPACK3(tri_b)) == 0.0f) {
+		/* degenerate, can't tell */
+		return false;
+	}
+
+	for (i = 0; i < 3; i++) {
+		float dir[3];
+		sub_v3_v3v3(dir, tri_a[i], tri_b[0]);
+		side[i] = dot_v3v3(dir, nor);
+	}
+
+	return (((side[0] >  eps) && (side[1] >  eps) && (side[2] >  eps)) ||
+	        ((side[0] < -eps) && (side[1] < -eps) && (side[2] < -eps)));
+}
+
+/**
+ * Run from the #BLI_bvhtree_overlap threads,
+ * removes pairs which #bm_isect_tri_tri would skip before they're intersected one at a time.
+ */
+static bool bm_isect_overlap_filter_cb(void *userdata, int index_a, int index_b, int UNUSED(thread))
+{
+	struct OverlapFilterData *data = userdata;
+	BMLoop **a = data->looptris[index_a];
+	BMLoop **b = data->looptris[index_b];
+	const BMVert *fv_a[3] = {UNPACK3_EX(, a, ->v)};
+	const BMVert *fv_b[3] = {UNPACK3_EX(, b, ->v)};
+	const float *f_a_cos[3] = {UNPACK3_EX(, fv_a, ->co)};
+	const float *f_b_cos[3] = {UNPACK3_EX(, fv_b, ->co)};
+
+	if (UNLIKELY(ELEM(fv_a[0], UNPACK3(fv_b)) ||
+	             ELEM(fv_a[1], UNPACK3(fv_b)) ||
+	             ELEM(fv_a[2], UNPACK3(fv_b))))
+	{
+		return false;
+	}
+
+	return !(isect_tri_tri_plane_separated(f_a_cos, f_b_cos, data->eps_margin) ||
+	         isect_tri_tri_plane_separated(f_b_cos, f_a_cos, data->eps_margin));
+}
+
 struct RaycastData {
 	const float **looptris;
 	BLI_Buffer *z_buffer;
@@ -971,6 +1028,44 @@ static int isect_bvhtree_point_v3(
 	return num_isect;
 }
 
+struct GroupRaycastData {
+	BMFace **ftable;
+	const int *groups_array;
+	int (*group_index)[2];
+	int (*test_fn)(BMFace *f, void *user_data);
+	void *user_data;
+	BVHTree **tree_pair;
+	const float **looptri_coords;
+
+	/* per group: -1 to skip the group, otherwise the number of hits */
+	int *r_group_hits;
+	/* per group: the side which is tested against (the other mesh) */
+	int *r_group_side;
+};
+
+static void bm_isect_group_raycast_cb(void *userdata, const int i)
+{
+	struct GroupRaycastData *data = userdata;
+
+	/* for now assyme this is an OK face to test with (not degenerate!) */
+	BMFace *f = data->ftable[data->groups_array[data->group_index[i][0]]];
+	float co[3];
+	int side = data->test_fn(f, data->user_data);
+
+	if (side == -1) {
+		data->r_group_hits[i] = -1;
+		return;
+	}
+	BLI_assert(ELEM(side, 0, 1));
+	side = !side;
+
+	// BM_face_calc_center_mean(f, co);
+	BM_face_calc_point_in_face(f, co);
+
+	data->r_group_hits[i] = isect_bvhtree_point_v3(data->tree_pair[side], data->looptri_coords, co);
+	data->r_group_side[i] = side;
+}
+
 #endif  /* USE_BVH */
 
 /**
@@ -1114,7 +1209,15 @@ bool BM_mesh_intersect(
 		tree_b = tree_a;
 	}
 
-	overlap = BLI_bvhtree_overlap(tree_b, tree_a, &tree_overlap_tot, NULL, NULL);
+	{
+		struct OverlapFilterData overlap_filter_data = {
+			.looptris = looptris,
+			.eps_margin = s.epsilon.eps_margin,
+		};
+		overlap = BLI_bvhtree_overlap(
+		        tree_b, tree_a, &tree_overlap_tot,
+		        bm_isect_overlap_filter_cb, &overlap_filter_data);
+	}
 
 	if (overlap) {
 		unsigned int i;
@@ -1547,6 +1650,7 @@ bool BM_mesh_intersect(
 		int *groups_array;
 		int (*group_index)[2];
 		int group_tot;
+		int *group_hits, *group_side;
 		int i;
 		BMFace **ftable;
 
@@ -1569,29 +1673,39 @@ bool BM_mesh_intersect(
 		printf("%s: Total face-groups: %d\n", __func__, group_tot);
 #endif
 
-		/* Check if island is inside/outside */
+		/* Check if island is inside/outside,
+		 * ray-casts are independent of each other so run them threaded */
+		group_hits = MEM_mallocN(sizeof(*group_hits) * (size_t)group_tot, __func__);
+		group_side = MEM_mallocN(sizeof(*group_side) * (size_t)group_tot, __func__);
+		{
+			struct GroupRaycastData raycast_data = {
+				.ftable = ftable,
+				.groups_array = groups_array,
+				.group_index = group_index,
+				.test_fn = test_fn,
+				.user_data = user_data,
+				.tree_pair = tree_pair,
+				.looptri_coords = looptri_coords,
+				.r_group_hits = group_hits,
+				.r_group_side = group_side,
+			};
+			BLI_task_parallel_range(
+			        0, group_tot, &raycast_data, bm_isect_group_raycast_cb,
+			        (group_tot > 1) && (looptris_tot >= BM_OMP_LIMIT));
+		}
+
 		for (i = 0; i < group_tot; i++) {
 			int fg     = group_index[i][0];
 			int fg_end = group_index[i][1] + fg;
 			bool do_remove, do_flip;
 
 			{
-				/* for now assyme this is an OK face to test with (not degenerate!) */
-				BMFace *f = ftable[groups_array[fg]];
-				float co[3];
-				int hits;
-				int side = test_fn(f, user_data);
+				const int hits = group_hits[i];
+				const int side = group_side[i];
 
-				if (side == -1) {
+				if (hits == -1) {
 					continue;
 				}
-				BLI_assert(ELEM(side, 0, 1));
-				side = !side;
-
-				// BM_face_calc_center_mean(f, co);
-				BM_face_calc_point_in_face(f, co);
-
-				hits = isect_bvhtree_point_v3(tree_pair[side], looptri_coords, co);
 
 				switch (boolean_mode) {
 					case BMESH_ISECT_BOOLEAN_ISECT:
@@ -1611,7 +1725,9 @@ bool BM_mesh_intersect(
 #ifdef USE_BOOLEAN_RAYCAST_DRAW
 				{
 					unsigned int colors[4] = {0x00000000, 0xffffffff, 0xff000000, 0x0000ff};
-					float co_other[3] = {UNPACK3(co)};
+					float co[3], co_other[3];
+					BM_face_calc_point_in_face(ftable[groups_array[fg]], co);
+					copy_v3_v3(co_other, co);
 					co_other[0] += 1000.0f;
 					bl_debug_color_set(colors[(hits & 1) == 1]);
 					bl_debug_draw_edge_add(co, co_other);
@@ -1638,6 +1754,8 @@ bool BM_mesh_intersect(
 
 		MEM_freeN(groups_array);
 		MEM_freeN(group_index);
+		MEM_freeN(group_hits);
+		MEM_freeN(group_side);
 
 #ifdef USE_DISSOLVE
 		/* We have dissolve code above, this is alternative logic,
@@ -237,10 +237,13 @@ GPU_PBVH_Buffers *GPU_build_bmesh_pbvh_buffers(bool smooth_shading);
 
 /* update */
 
+/* Only the vertices in [update_start, update_end) are uploaded when the buffers
+ * allow it, pass 0 and totvert to update everything. */
 void GPU_update_mesh_pbvh_buffers(
         GPU_PBVH_Buffers *buffers, const struct MVert *mvert,
         const int *vert_indices, int totvert, const float *vmask,
-        const int (*face_vert_indices)[3], bool show_diffuse_color);
+        const int (*face_vert_indices)[3], bool show_diffuse_color,
+        int update_start, int update_end);
 
 void GPU_update_bmesh_pbvh_buffers(GPU_PBVH_Buffers *buffers,
                               struct BMesh *bm,
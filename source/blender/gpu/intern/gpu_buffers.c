@@ -973,6 +973,8 @@ struct GPU_PBVH_Buffers {
 	const int *face_indices;
 	int        face_indices_len;
 	const float *vmask;
+	/* Number of vertices in a smooth-shaded vert_buf. */
+	int totvert;
 
 	/* grid pointers */
 	CCGKey gridkey;
@@ -1030,30 +1032,82 @@ static void gpu_color_from_mask_quad_copy(const CCGKey *key,
 	out[2] = diffuse_color[2] * mask_color;
 }
 
+/* Re-upload a range of a smooth-shaded vert_buf, which holds one element per
+ * node vertex, in the same layout as the full update. */
+static void gpu_update_mesh_pbvh_buffers_range(
+        GPU_PBVH_Buffers *buffers, const MVert *mvert,
+        const int *vert_indices, const float *vmask, const float diffuse_color[4],
+        int update_start, int update_end)
+{
+	const int totelem = update_end - update_start;
+	VertexBufferFormat *vert_data = MEM_mallocN(sizeof(VertexBufferFormat) * totelem, __func__);
+	int i;
+
+	for (i = 0; i < totelem; ++i) {
+		const int vertex = vert_indices[update_start + i];
+		const MVert *v = &mvert[vertex];
+		VertexBufferFormat *out = vert_data + i;
+
+		copy_v3_v3(out->co, v->co);
+		memcpy(out->no, v->no, sizeof(short) * 3);
+
+		if (vmask)
+			gpu_color_from_mask_copy(vmask[vertex], diffuse_color, out->color);
+		else
+			rgb_float_to_uchar(out->color, diffuse_color);
+	}
+
+	GPU_buffer_bind(buffers->vert_buf, GPU_BINDING_ARRAY);
+	glBufferSubData(GL_ARRAY_BUFFER, sizeof(VertexBufferFormat) * update_start,
+	                sizeof(VertexBufferFormat) * totelem, vert_data);
+	GPU_buffer_unbind(buffers->vert_buf, GPU_BINDING_ARRAY);
+
+	MEM_freeN(vert_data);
+}
+
 void GPU_update_mesh_pbvh_buffers(
         GPU_PBVH_Buffers *buffers, const MVert *mvert,
         const int *vert_indices, int totvert, const float *vmask,
-        const int (*face_vert_indices)[3], bool show_diffuse_color)
+        const int (*face_vert_indices)[3], bool show_diffuse_color,
+        int update_start, int update_end)
 {
 	VertexBufferFormat *vert_data;
 	int i, j;
+	const bool use_matcaps = GPU_material_use_matcaps_get();
+	float diffuse_color[4] = {0.8f, 0.8f, 0.8f, 0.8f};
+
+	if (use_matcaps)
+		diffuse_color[0] = diffuse_color[1] = diffuse_color[2] = 1.0;
+	else if (show_diffuse_color) {
+		const MLoopTri *lt = &buffers->looptri[buffers->face_indices[0]];
+		const MPoly *mp = &buffers->mpoly[lt->poly];
+
+		GPU_material_diffuse_get(mp->mat_nr + 1, diffuse_color);
+	}
+
+	/* A partial update is only possible when everything but the
+	 * coordinates and normals of the range is unchanged. */
+	if (buffers->smooth && buffers->vert_buf && buffers->totvert == totvert &&
+	    buffers->vmask == vmask &&
+	    buffers->show_diffuse_color == show_diffuse_color &&
+	    buffers->use_matcaps == use_matcaps &&
+	    equals_v4v4(buffers->diffuse_color, diffuse_color) &&
+	    update_start >= 0 && update_start < update_end && update_end <= totvert &&
+	    (update_end - update_start) < totvert)
+	{
+		gpu_update_mesh_pbvh_buffers_range(buffers, mvert, vert_indices, vmask, diffuse_color,
+		                                   update_start, update_end);
+		buffers->mvert = mvert;
+		return;
+	}
 
 	buffers->vmask = vmask;
 	buffers->show_diffuse_color = show_diffuse_color;
-	buffers->use_matcaps = GPU_material_use_matcaps_get();
+	buffers->use_matcaps = use_matcaps;
+	buffers->totvert = 0;
 
 	{
 		int totelem = (buffers->smooth ? totvert : (buffers->tot_tri * 3));
-		float diffuse_color[4] = {0.8f, 0.8f, 0.8f, 0.8f};
-
-		if (buffers->use_matcaps)
-			diffuse_color[0] = diffuse_color[1] = diffuse_color[2] = 1.0;
-		else if (show_diffuse_color) {
-			const MLoopTri *lt = &buffers->looptri[buffers->face_indices[0]];
-			const MPoly *mp = &buffers->mpoly[lt->poly];
-
-			GPU_material_diffuse_get(mp->mat_nr + 1, diffuse_color);
-		}
 
 		copy_v4_v4(buffers->diffuse_color, diffuse_color);
 
@@ -1098,6 +1152,8 @@ void GPU_update_mesh_pbvh_buffers(
 					UPDATE_VERTEX(i, vtri[2], 2, diffuse_color);
 				}
 #undef UPDATE_VERTEX
+
+				buffers->totvert = totvert;
 			}
 			else {
 				/* calculate normal for each polygon only once */
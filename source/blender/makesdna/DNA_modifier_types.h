@@ -453,6 +453,7 @@ enum {
 	MOD_DECIM_FLAG_TRIANGULATE         = (1 << 1),  /* for collapse only. dont convert tri pairs back to quads */
 	MOD_DECIM_FLAG_ALL_BOUNDARY_VERTS  = (1 << 2),  /* for dissolve only. collapse all verts between 2 faces */
 	MOD_DECIM_FLAG_SYMMETRY            = (1 << 3),
+	MOD_DECIM_FLAG_PARALLEL            = (1 << 4),  /* for collapse only. collapse independent edges in parallel */
 };
 
 enum {
@@ -778,6 +779,9 @@ typedef struct MultiresModifierData {
 
 	char lvl, sculptlvl, renderlvl, totlvl;
 	char simple, flags, pad[2];
+
+	/* runtime, subsurf of the undisplaced mesh at totlvl, reused when updating displacements */
+	void *reshapeCache;
 } MultiresModifierData;
 
 typedef enum {
@@ -55,7 +55,8 @@ typedef struct RigidBodyWorld {
 	
 	struct Group *constraints;	/* Group containing objects to use for Rigid Body Constraints*/
 
-	int pad;
+	short num_threads;			/* number of threads simulation islands are solved on, 0 for automatic */
+	short pad;
 	float ltime;				/* last frame world was evaluated for (internal) */
 	
 	/* cache */
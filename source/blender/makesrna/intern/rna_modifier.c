@@ -1597,6 +1597,13 @@ static void rna_def_modifier_decimate(BlenderRNA *brna)
 	RNA_def_property_ui_text(prop, "Triangulate", "Keep triangulated faces resulting from decimation (collapse only)");
 	RNA_def_property_update(prop, 0, "rna_Modifier_update");
 
+	prop = RNA_def_property(srna, "use_collapse_parallel", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flag", MOD_DECIM_FLAG_PARALLEL);
+	RNA_def_property_ui_text(prop, "Parallel",
+	                         "Collapse edges which don't share neighbors at once using multiple threads, "
+	                         "can be faster on large meshes, but gives a different result (collapse only, not used with symmetry)");
+	RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
 	prop = RNA_def_property(srna, "use_symmetry", PROP_BOOLEAN, PROP_NONE);
 	RNA_def_property_boolean_sdna(prop, NULL, "flag", MOD_DECIM_FLAG_SYMMETRY);
 	RNA_def_property_ui_text(prop, "Symmetry", "Maintain symmetry on an axis");
@@ -40,6 +40,7 @@
 
 #include "BLI_utildefines.h"
 #include "BLI_math.h"
+#include "BLI_threads.h"
 
 #include "WM_types.h"
 
@@ -790,6 +791,15 @@ static void rna_def_rigidbody_world(BlenderRNA *brna)
 	                         "accurate but slower)");
 	RNA_def_property_update(prop, NC_SCENE, "rna_RigidBodyWorld_reset");
 	
+	/* threads */
+	prop = RNA_def_property(srna, "threads", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "num_threads");
+	RNA_def_property_range(prop, 0, BLENDER_MAX_THREADS);
+	RNA_def_property_ui_text(prop, "Threads",
+	                         "Number of threads used to solve independent groups of colliding objects, "
+	                         "0 uses all system threads (results are the same for any number)");
+	RNA_def_property_update(prop, NC_SCENE, NULL);
+
 	/* split impulse */
 	prop = RNA_def_property(srna, "use_split_impulse", PROP_BOOLEAN, PROP_NONE);
 	RNA_def_property_boolean_sdna(prop, NULL, "flag", RBW_FLAG_USE_SPLIT_IMPULSE);
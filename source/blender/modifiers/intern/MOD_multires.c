@@ -46,6 +46,8 @@
 #include "BKE_modifier.h"
 #include "BKE_subsurf.h"
 
+#include "intern/CCGSubSurf.h"
+
 static void initData(ModifierData *md)
 {
 	MultiresModifierData *mmd = (MultiresModifierData *)md;
@@ -60,9 +62,21 @@ static void copyData(ModifierData *md, ModifierData *target)
 {
 #if 0
 	MultiresModifierData *mmd = (MultiresModifierData *) md;
-	MultiresModifierData *tmmd = (MultiresModifierData *) target;
 #endif
+	MultiresModifierData *tmmd = (MultiresModifierData *) target;
+
 	modifier_copyData_generic(md, target);
+
+	tmmd->reshapeCache = NULL;
+}
+
+static void freeData(ModifierData *md)
+{
+	MultiresModifierData *mmd = (MultiresModifierData *) md;
+
+	if (mmd->reshapeCache) {
+		ccgSubSurf_free(mmd->reshapeCache);
+	}
 }
 
 static DerivedMesh *applyModifier(ModifierData *md, Object *ob, DerivedMesh *dm,
@@ -159,7 +173,7 @@ ModifierTypeInfo modifierType_Multires = {
 	/* applyModifierEM */   NULL,
 	/* initData */          initData,
 	/* requiredDataMask */  NULL,
-	/* freeData */          NULL,
+	/* freeData */          freeData,
 	/* isDisabled */        NULL,
 	/* updateDepgraph */    NULL,
 	/* updateDepsgraph */   NULL,
@@ -33,6 +33,10 @@
 
 #ifdef IMPLICIT_SOLVER_BLENDER
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
 #include "DNA_scene_types.h"
@@ -43,6 +47,7 @@
 
 #include "BLI_math.h"
 #include "BLI_linklist.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_cloth.h"
@@ -631,6 +636,220 @@ DO_INLINE void subadd_bfmatrixS_bfmatrixS( fmatrix3x3 *to, fmatrix3x3 *from, flo
 
 }
 
+///////////////////////////
+// Block compressed sparse row matrix
+///////////////////////////
+/* The big matrices above store each spring block once and apply it to both of its
+ * vertices, which doesn't split between threads. The solver converts them to block CSR,
+ * where every row lists all blocks contributing to its vertex, so rows are computed
+ * independently. Spring blocks are still stored once and referenced by both rows.
+ * Blocks are kept as columns padded to 4 floats, which maps the block product onto SSE. */
+
+/* vertices per task of the parallel vector operations */
+#define CLOTH_PARALLEL_CHUNK 1024
+#define CLOTH_PARALLEL_LIMIT (4 * CLOTH_PARALLEL_CHUNK)
+
+typedef struct BCSRMatrix {
+	unsigned int numrows, numentries, numblocks;
+	unsigned int maxrows, maxentries, maxblocks;
+	unsigned int *row_start;	/* first entry of every row, numrows + 1 values */
+	unsigned int *col;			/* column of every entry */
+	unsigned int *block;		/* block of every entry */
+	float (*blocks)[3][4];		/* block columns */
+} BCSRMatrix;
+
+BLI_INLINE int cloth_parallel_chunks(unsigned int verts)
+{
+	return (int)((verts + CLOTH_PARALLEL_CHUNK - 1) / CLOTH_PARALLEL_CHUNK);
+}
+
+BLI_INLINE void cloth_parallel_chunk_range(int chunk, unsigned int verts, unsigned int *r_start, unsigned int *r_end)
+{
+	*r_start = (unsigned int)chunk * CLOTH_PARALLEL_CHUNK;
+	*r_end = min_ii(*r_start + CLOTH_PARALLEL_CHUNK, verts);
+}
+
+/* partial sums are added in order, so the result doesn't depend on the threads used */
+static float cloth_parallel_sum(const float *partial, int tot)
+{
+	float sum = 0.0f;
+	int i;
+
+	for (i = 0; i < tot; i++)
+		sum += partial[i];
+
+	return sum;
+}
+
+static void del_bcsrmatrix(BCSRMatrix *mat)
+{
+	MEM_SAFE_FREE(mat->row_start);
+	MEM_SAFE_FREE(mat->col);
+	MEM_SAFE_FREE(mat->block);
+	MEM_SAFE_FREE(mat->blocks);
+	mat->maxrows = mat->maxentries = mat->maxblocks = 0;
+}
+
+/* build the rows of a big matrix with numsprings used off-diagonal blocks */
+static void bcsr_build_structure(BCSRMatrix *mat, fmatrix3x3 *from, unsigned int numsprings)
+{
+	const unsigned int vcount = from[0].vcount;
+	unsigned int *row_start;
+	unsigned int i, r;
+
+	mat->numrows = vcount;
+	mat->numblocks = vcount + numsprings;
+	mat->numentries = vcount + 2 * numsprings;
+
+	if (mat->maxrows < vcount + 1) {
+		MEM_SAFE_FREE(mat->row_start);
+		mat->row_start = MEM_mallocN(sizeof(unsigned int) * (vcount + 1), "cloth bcsr rows");
+		mat->maxrows = vcount + 1;
+	}
+	if (mat->maxentries < mat->numentries) {
+		MEM_SAFE_FREE(mat->col);
+		MEM_SAFE_FREE(mat->block);
+		mat->col = MEM_mallocN(sizeof(unsigned int) * mat->numentries, "cloth bcsr columns");
+		mat->block = MEM_mallocN(sizeof(unsigned int) * mat->numentries, "cloth bcsr entry blocks");
+		mat->maxentries = mat->numentries;
+	}
+	if (mat->maxblocks < mat->numblocks) {
+		MEM_SAFE_FREE(mat->blocks);
+		mat->blocks = MEM_mallocN_aligned(sizeof(*mat->blocks) * mat->numblocks, 16, "cloth bcsr blocks");
+		mat->maxblocks = mat->numblocks;
+	}
+
+	row_start = mat->row_start;
+
+	/* count the entries of every row, diagonal blocks first */
+	memset(row_start, 0, sizeof(unsigned int) * (vcount + 1));
+	for (i = 0; i < vcount; i++)
+		row_start[i + 1]++;
+	for (i = vcount; i < mat->numblocks; i++) {
+		row_start[from[i].r + 1]++;
+		row_start[from[i].c + 1]++;
+	}
+	for (r = 0; r < vcount; r++)
+		row_start[r + 1] += row_start[r];
+
+	/* fill, using the row starts as cursors and shifting them back afterwards */
+	for (i = 0; i < vcount; i++) {
+		const unsigned int e = row_start[i]++;
+		mat->col[e] = i;
+		mat->block[e] = i;
+	}
+	/* springs apply their block to both vertices, see mul_bfmatrix_lfvector */
+	for (i = vcount; i < mat->numblocks; i++) {
+		unsigned int e = row_start[from[i].r]++;
+		mat->col[e] = from[i].c;
+		mat->block[e] = i;
+
+		e = row_start[from[i].c]++;
+		mat->col[e] = from[i].r;
+		mat->block[e] = i;
+	}
+	for (r = vcount; r > 0; r--)
+		row_start[r] = row_start[r - 1];
+	row_start[0] = 0;
+}
+
+typedef struct BCSRValuesData {
+	BCSRMatrix *mat;
+	fmatrix3x3 *from, *a, *b;
+	float aS, bS;
+} BCSRValuesData;
+
+static void bcsr_values_cb(void *userdata, const int chunk)
+{
+	BCSRValuesData *data = userdata;
+	unsigned int start, end, k, i, j;
+
+	cloth_parallel_chunk_range(chunk, data->mat->numblocks, &start, &end);
+
+	for (k = start; k < end; k++) {
+		float m[3][3];
+		float (*block)[4] = data->mat->blocks[k];
+
+		copy_m3_m3(m, data->from[k].m);
+		if (data->a)
+			subadd_fmatrixS_fmatrixS(m, data->a[k].m, data->aS, data->b[k].m, data->bS);
+
+		for (j = 0; j < 3; j++) {
+			for (i = 0; i < 3; i++)
+				block[j][i] = m[i][j];
+			block[j][3] = 0.0f;
+		}
+	}
+}
+
+/* blocks = from - a * aS - b * bS, or a copy of from when a is NULL */
+static void bcsr_set_values(BCSRMatrix *mat, fmatrix3x3 *from, fmatrix3x3 *a, float aS, fmatrix3x3 *b, float bS)
+{
+	BCSRValuesData data = {mat, from, a, b, aS, bS};
+
+	BLI_task_parallel_range(0, cloth_parallel_chunks(mat->numblocks), &data, bcsr_values_cb,
+	                        mat->numblocks > CLOTH_PARALLEL_LIMIT);
+}
+
+/* r = row of the matrix * v */
+BLI_INLINE void bcsr_mul_row(const BCSRMatrix *mat, unsigned int row, lfVector *v, float r[3])
+{
+	const unsigned int end = mat->row_start[row + 1];
+	unsigned int e;
+#ifdef __SSE2__
+	__m128 sum = _mm_setzero_ps();
+	float tmp[4];
+
+	for (e = mat->row_start[row]; e < end; e++) {
+		const float (*block)[4] = (const float (*)[4])mat->blocks[mat->block[e]];
+		const float *x = v[mat->col[e]];
+
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(block[0]), _mm_set1_ps(x[0])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(block[1]), _mm_set1_ps(x[1])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(block[2]), _mm_set1_ps(x[2])));
+	}
+
+	_mm_storeu_ps(tmp, sum);
+	copy_v3_v3(r, tmp);
+#else
+	zero_v3(r);
+
+	for (e = mat->row_start[row]; e < end; e++) {
+		float (*block)[4] = mat->blocks[mat->block[e]];
+		const float *x = v[mat->col[e]];
+
+		madd_v3_v3fl(r, block[0], x[0]);
+		madd_v3_v3fl(r, block[1], x[1]);
+		madd_v3_v3fl(r, block[2], x[2]);
+	}
+#endif
+}
+
+typedef struct BCSRMulData {
+	const BCSRMatrix *mat;
+	lfVector *to, *from;
+} BCSRMulData;
+
+static void mul_bcsr_lfvector_cb(void *userdata, const int chunk)
+{
+	BCSRMulData *data = userdata;
+	unsigned int start, end, i;
+
+	cloth_parallel_chunk_range(chunk, data->mat->numrows, &start, &end);
+
+	for (i = start; i < end; i++)
+		bcsr_mul_row(data->mat, i, data->from, data->to[i]);
+}
+
+/* to = matrix * from */
+static void mul_bcsr_lfvector(float (*to)[3], const BCSRMatrix *mat, lfVector *from)
+{
+	BCSRMulData data = {mat, to, from};
+
+	BLI_task_parallel_range(0, cloth_parallel_chunks(mat->numrows), &data, mul_bcsr_lfvector_cb,
+	                        mat->numrows > CLOTH_PARALLEL_LIMIT);
+}
+
 ///////////////////////////////////////////////////////////////////
 // simulator start
 ///////////////////////////////////////////////////////////////////
@@ -650,7 +869,7 @@ typedef struct Implicit_Data  {
 	
 	/* internal solver data */
 	lfVector *B;				/* B for A*dV = B */
-	fmatrix3x3 *A;				/* A for A*dV = B */
+	BCSRMatrix A;				/* A for A*dV = B, also holds dFdX while computing B */
 	
 	lfVector *dV;				/* velocity change (solution of A*dV = B) */
 	lfVector *z;				/* target velocity in constrained directions */
@@ -664,7 +883,6 @@ Implicit_Data *BPH_mass_spring_solver_create(int numverts, int numsprings)
 	
 	/* process diagonal elements */
 	id->tfm = create_bfmatrix(numverts, 0);
-	id->A = create_bfmatrix(numverts, numsprings);
 	id->dFdV = create_bfmatrix(numverts, numsprings);
 	id->dFdX = create_bfmatrix(numverts, numsprings);
 	id->S = create_bfmatrix(numverts, 0);
@@ -689,7 +907,7 @@ Implicit_Data *BPH_mass_spring_solver_create(int numverts, int numsprings)
 void BPH_mass_spring_solver_free(Implicit_Data *id)
 {
 	del_bfmatrix(id->tfm);
-	del_bfmatrix(id->A);
+	del_bcsrmatrix(&id->A);
 	del_bfmatrix(id->dFdV);
 	del_bfmatrix(id->dFdX);
 	del_bfmatrix(id->S);
@@ -814,44 +1032,129 @@ static int  cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z
 }
 #endif
 
-static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z, fmatrix3x3 *S, ImplicitSolverResult *result)
+typedef struct CGFilteredData {
+	const BCSRMatrix *A;
+	fmatrix3x3 *S;
+	lfVector *dV, *B, *r, *c, *q;
+	float alpha, beta;
+	float *partial, *partial_b;		/* per chunk dot products */
+} CGFilteredData;
+
+/* r = filter(B - A * dV), c = filter(r) */
+static void cg_filtered_residual_cb(void *userdata, const int chunk)
+{
+	CGFilteredData *data = userdata;
+	fmatrix3x3 *S = data->S;
+	float delta = 0.0f, bnorm2 = 0.0f;
+	unsigned int start, end, i;
+
+	cloth_parallel_chunk_range(chunk, data->A->numrows, &start, &end);
+
+	/* S only has diagonal blocks */
+	for (i = start; i < end; i++) {
+		float fB[3], AdV[3];
+
+		mul_v3_m3v3(fB, S[i].m, data->B[i]);
+		bnorm2 += dot_v3v3(fB, fB);
+
+		bcsr_mul_row(data->A, i, data->dV, AdV);
+		sub_v3_v3v3(data->r[i], data->B[i], AdV);
+		mul_m3_v3(S[i].m, data->r[i]);
+
+		mul_v3_m3v3(data->c[i], S[i].m, data->r[i]);
+		delta += dot_v3v3(data->r[i], data->c[i]);
+	}
+
+	data->partial[chunk] = delta;
+	data->partial_b[chunk] = bnorm2;
+}
+
+/* q = filter(A * c) */
+static void cg_filtered_search_cb(void *userdata, const int chunk)
+{
+	CGFilteredData *data = userdata;
+	float cq = 0.0f;
+	unsigned int start, end, i;
+
+	cloth_parallel_chunk_range(chunk, data->A->numrows, &start, &end);
+
+	for (i = start; i < end; i++) {
+		bcsr_mul_row(data->A, i, data->c, data->q[i]);
+		mul_m3_v3(data->S[i].m, data->q[i]);
+		cq += dot_v3v3(data->c[i], data->q[i]);
+	}
+
+	data->partial[chunk] = cq;
+}
+
+/* dV += c * alpha, r -= q * alpha */
+static void cg_filtered_update_cb(void *userdata, const int chunk)
+{
+	CGFilteredData *data = userdata;
+	float delta = 0.0f;
+	unsigned int start, end, i;
+
+	cloth_parallel_chunk_range(chunk, data->A->numrows, &start, &end);
+
+	for (i = start; i < end; i++) {
+		madd_v3_v3fl(data->dV[i], data->c[i], data->alpha);
+		madd_v3_v3fl(data->r[i], data->q[i], -data->alpha);
+		/* s = P^-1 * r */
+		delta += dot_v3v3(data->r[i], data->r[i]);
+	}
+
+	data->partial[chunk] = delta;
+}
+
+/* c = filter(s + c * beta) */
+static void cg_filtered_direction_cb(void *userdata, const int chunk)
+{
+	CGFilteredData *data = userdata;
+	unsigned int start, end, i;
+
+	cloth_parallel_chunk_range(chunk, data->A->numrows, &start, &end);
+
+	for (i = start; i < end; i++) {
+		mul_v3_fl(data->c[i], data->beta);
+		add_v3_v3(data->c[i], data->r[i]);
+		mul_m3_v3(data->S[i].m, data->c[i]);
+	}
+}
+
+static int cg_filtered(lfVector *ldV, const BCSRMatrix *lA, lfVector *lB, lfVector *z, fmatrix3x3 *S, ImplicitSolverResult *result)
 {
 	// Solves for unknown X in equation AX=B
 	unsigned int conjgrad_loopcount=0, conjgrad_looplimit=100;
 	float conjgrad_epsilon=0.01f;
 	
-	unsigned int numverts = lA[0].vcount;
-	lfVector *fB = create_lfvector(numverts);
-	lfVector *AdV = create_lfvector(numverts);
-	lfVector *r = create_lfvector(numverts);
-	lfVector *c = create_lfvector(numverts);
-	lfVector *q = create_lfvector(numverts);
-	lfVector *s = create_lfvector(numverts);
-	float bnorm2, delta_new, delta_old, delta_target, alpha;
+	unsigned int numverts = lA->numrows;
+	const int numchunks = cloth_parallel_chunks(numverts);
+	const bool use_threading = numverts > CLOTH_PARALLEL_LIMIT;
+	CGFilteredData data;
+	float bnorm2, delta_new, delta_old, delta_target;
+	
+	data.A = lA;
+	data.S = S;
+	data.dV = ldV;
+	data.B = lB;
+	data.r = create_lfvector(numverts);
+	data.c = create_lfvector(numverts);
+	data.q = create_lfvector(numverts);
+	data.partial = MEM_mallocN(sizeof(float) * numchunks, "cloth cg partial sums");
+	data.partial_b = MEM_mallocN(sizeof(float) * numchunks, "cloth cg partial sums");
 	
 	cp_lfvector(ldV, z, numverts);
 	
-	/* d0 = filter(B)^T * P * filter(B) */
-	cp_lfvector(fB, lB, numverts);
-	filter(fB, S);
-	bnorm2 = dot_lfvector(fB, fB, numverts);
+	/* d0 = filter(B)^T * P * filter(B)
+	 * r = filter(B - A * dV)
+	 * c = filter(P^-1 * r)
+	 * delta = r^T * c */
+	BLI_task_parallel_range(0, numchunks, &data, cg_filtered_residual_cb, use_threading);
+	bnorm2 = cloth_parallel_sum(data.partial_b, numchunks);
+	delta_new = cloth_parallel_sum(data.partial, numchunks);
 	delta_target = conjgrad_epsilon*conjgrad_epsilon * bnorm2;
 	
-	/* r = filter(B - A * dV) */
-	mul_bfmatrix_lfvector(AdV, lA, ldV);
-	sub_lfvector_lfvector(r, lB, AdV, numverts);
-	filter(r, S);
-	
-	/* c = filter(P^-1 * r) */
-	cp_lfvector(c, r, numverts);
-	filter(c, S);
-	
-	/* delta = r^T * c */
-	delta_new = dot_lfvector(r, c, numverts);
-	
 #ifdef IMPLICIT_PRINT_SOLVER_INPUT_OUTPUT
-	printf("==== A ====\n");
-	print_bfmatrix(lA);
 	printf("==== z ====\n");
 	print_lvector(z, numverts);
 	printf("==== B ====\n");
@@ -861,22 +1164,15 @@ static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z,
 #endif
 	
 	while (delta_new > delta_target && conjgrad_loopcount < conjgrad_looplimit) {
-		mul_bfmatrix_lfvector(q, lA, c);
-		filter(q, S);
+		BLI_task_parallel_range(0, numchunks, &data, cg_filtered_search_cb, use_threading);
+		data.alpha = delta_new / cloth_parallel_sum(data.partial, numchunks);
 		
-		alpha = delta_new / dot_lfvector(c, q, numverts);
-		
-		add_lfvector_lfvectorS(ldV, ldV, c, alpha, numverts);
-		
-		add_lfvector_lfvectorS(r, r, q, -alpha, numverts);
-		
-		/* s = P^-1 * r */
-		cp_lfvector(s, r, numverts);
+		BLI_task_parallel_range(0, numchunks, &data, cg_filtered_update_cb, use_threading);
 		delta_old = delta_new;
-		delta_new = dot_lfvector(r, s, numverts);
+		delta_new = cloth_parallel_sum(data.partial, numchunks);
 		
-		add_lfvector_lfvectorS(c, s, c, delta_new / delta_old, numverts);
-		filter(c, S);
+		data.beta = delta_new / delta_old;
+		BLI_task_parallel_range(0, numchunks, &data, cg_filtered_direction_cb, use_threading);
 		
 		conjgrad_loopcount++;
 	}
@@ -887,12 +1183,11 @@ static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z,
 	printf("========\n");
 #endif
 	
-	del_lfvector(fB);
-	del_lfvector(AdV);
-	del_lfvector(r);
-	del_lfvector(c);
-	del_lfvector(q);
-	del_lfvector(s);
+	del_lfvector(data.r);
+	del_lfvector(data.c);
+	del_lfvector(data.q);
+	MEM_freeN(data.partial);
+	MEM_freeN(data.partial_b);
 	// printf("W/O conjgrad_loopcount: %d\n", conjgrad_loopcount);
 
 	result->status = conjgrad_loopcount < conjgrad_looplimit ? BPH_SOLVER_SUCCESS : BPH_SOLVER_NO_CONVERGENCE;
@@ -1105,11 +1400,13 @@ bool BPH_mass_spring_solve_velocities(Implicit_Data *data, float dt, ImplicitSol
 	lfVector *dFdXmV = create_lfvector(numverts);
 	zero_lfvector(data->dV, numverts);
 
-	cp_bfmatrix(data->A, data->M);
+	/* all matrices share the block layout of dFdX */
+	bcsr_build_structure(&data->A, data->dFdX, data->num_blocks);
 
-	subadd_bfmatrixS_bfmatrixS(data->A, data->dFdV, dt, data->dFdX, (dt*dt));
+	bcsr_set_values(&data->A, data->dFdX, NULL, 0.0f, NULL, 0.0f);
+	mul_bcsr_lfvector(dFdXmV, &data->A, data->V);
 
-	mul_bfmatrix_lfvector(dFdXmV, data->dFdX, data->V);
+	bcsr_set_values(&data->A, data->M, data->dFdV, dt, data->dFdX, (dt*dt));
 
 	add_lfvectorS_lfvectorS(data->B, data->F, dt, dFdXmV, (dt*dt), numverts);
 
@@ -1117,7 +1414,7 @@ bool BPH_mass_spring_solve_velocities(Implicit_Data *data, float dt, ImplicitSol
 	double start = PIL_check_seconds_timer();
 #endif
 
-	cg_filtered(data->dV, data->A, data->B, data->z, data->S, result); /* conjugate gradient algorithm to solve Ax=b */
+	cg_filtered(data->dV, &data->A, data->B, data->z, data->S, result); /* conjugate gradient algorithm to solve Ax=b */
 	// cg_filtered_pre(id->dV, id->A, id->B, id->z, id->S, id->P, id->Pinv, id->bigI);
 
 #ifdef DEBUG_TIME
@@ -1226,7 +1523,6 @@ static int BPH_mass_spring_add_block(Implicit_Data *data, int v1, int v2)
 	init_fmatrix(data->M + s, v1, v2);
 	init_fmatrix(data->dFdX + s, v1, v2);
 	init_fmatrix(data->dFdV + s, v1, v2);
-	init_fmatrix(data->A + s, v1, v2);
 	init_fmatrix(data->P + s, v1, v2);
 	init_fmatrix(data->Pinv + s, v1, v2);
 	
@@ -0,0 +1,300 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
+
+#include "CCGSubSurf.h"
+}
+
+/* Rings and segments of the test torus (~23k faces). */
+#define TORUS_RINGS 200
+#define TORUS_SEGMENTS 100
+
+/* Number of re-syncs timed for every level, the best one is reported. */
+#define ITERATIONS 5
+
+/* Number of objects evaluated at once from a task pool. */
+#define NUM_OBJECTS 8
+
+#define HANDLE(i) ((void *)(intptr_t)(i))
+
+/* Coordinates followed by the normal, as used by subsurf_ccg.c. */
+#define VERT_DATA_FLOATS 6
+
+typedef struct TestMesh {
+	int totvert, totedge, totface;
+	float (*co)[3];
+	int (*edges)[2];
+	float *crease;
+	int *face_len;
+	int (*faces)[4];
+} TestMesh;
+
+static void test_mesh_add_edge(TestMesh *me, const int v1, const int v2)
+{
+	me->edges[me->totedge][0] = v1;
+	me->edges[me->totedge][1] = v2;
+	/* Some creased edges, so sharp and smooth edge paths are both used. */
+	me->crease[me->totedge] = ((v1 * 7 + v2 * 3) % 11 == 0) ? 0.7f : 0.0f;
+	me->totedge++;
+}
+
+static void test_mesh_add_face(TestMesh *me, const int *verts, const int len)
+{
+	me->face_len[me->totface] = len;
+	memcpy(me->faces[me->totface], verts, sizeof(int) * len);
+	me->totface++;
+}
+
+/* Torus of quads, every 7th quad is split in two triangles so vertices of different valence are used. */
+static TestMesh *test_mesh_torus_create(const int rings, const int segments)
+{
+	TestMesh *me = (TestMesh *)MEM_callocN(sizeof(TestMesh), __func__);
+	const int tot = rings * segments;
+	int r, s;
+
+	me->co = (float (*)[3])MEM_mallocN(sizeof(*me->co) * tot, __func__);
+	me->edges = (int (*)[2])MEM_mallocN(sizeof(*me->edges) * tot * 3, __func__);
+	me->crease = (float *)MEM_mallocN(sizeof(*me->crease) * tot * 3, __func__);
+	me->face_len = (int *)MEM_mallocN(sizeof(*me->face_len) * tot * 2, __func__);
+	me->faces = (int (*)[4])MEM_mallocN(sizeof(*me->faces) * tot * 2, __func__);
+	me->totvert = tot;
+
+	for (r = 0; r < rings; r++) {
+		for (s = 0; s < segments; s++) {
+			const float u = 2.0f * (float)M_PI * r / rings;
+			const float v = 2.0f * (float)M_PI * s / segments;
+			float *co = me->co[r * segments + s];
+
+			co[0] = (2.0f + cosf(v)) * cosf(u);
+			co[1] = (2.0f + cosf(v)) * sinf(u);
+			co[2] = sinf(v);
+		}
+	}
+
+	for (r = 0; r < rings; r++) {
+		for (s = 0; s < segments; s++) {
+			const int v = r * segments + s;
+			test_mesh_add_edge(me, v, ((r + 1) % rings) * segments + s);
+			test_mesh_add_edge(me, v, r * segments + (s + 1) % segments);
+		}
+	}
+
+	for (r = 0; r < rings; r++) {
+		for (s = 0; s < segments; s++) {
+			const int quad[4] = {
+			    r * segments + s,
+			    ((r + 1) % rings) * segments + s,
+			    ((r + 1) % rings) * segments + (s + 1) % segments,
+			    r * segments + (s + 1) % segments,
+			};
+
+			if ((r * segments + s) % 7 == 3) {
+				const int tri_a[3] = {quad[0], quad[1], quad[2]};
+				const int tri_b[3] = {quad[0], quad[2], quad[3]};
+				test_mesh_add_edge(me, quad[0], quad[2]);
+				test_mesh_add_face(me, tri_a, 3);
+				test_mesh_add_face(me, tri_b, 3);
+			}
+			else {
+				test_mesh_add_face(me, quad, 4);
+			}
+		}
+	}
+
+	return me;
+}
+
+static void test_mesh_free(TestMesh *me)
+{
+	MEM_freeN(me->co);
+	MEM_freeN(me->edges);
+	MEM_freeN(me->crease);
+	MEM_freeN(me->face_len);
+	MEM_freeN(me->faces);
+	MEM_freeN(me);
+}
+
+static CCGSubSurf *test_subsurf_create(const int levels)
+{
+	CCGMeshIFC ifc;
+	CCGSubSurf *ss;
+
+	ifc.vertUserSize = ifc.edgeUserSize = ifc.faceUserSize = 8;
+	ifc.numLayers = 3;
+	ifc.vertDataSize = sizeof(float) * VERT_DATA_FLOATS;
+	ifc.simpleSubdiv = 0;
+
+	ss = ccgSubSurf_new(&ifc, levels, NULL, NULL);
+	ccgSubSurf_setCalcVertexNormals(ss, 1, sizeof(float) * 3);
+	return ss;
+}
+
+/* Full sync with every vertex moved by a different amount, like a deforming modifier stack would. */
+static void test_subsurf_sync(CCGSubSurf *ss, const TestMesh *me, const float offset)
+{
+	int i;
+
+	ccgSubSurf_initFullSync(ss);
+	for (i = 0; i < me->totvert; i++) {
+		float data[VERT_DATA_FLOATS] = {0.0f};
+		data[0] = me->co[i][0] + offset * sinf((float)i);
+		data[1] = me->co[i][1];
+		data[2] = me->co[i][2] + offset * cosf((float)i);
+		ccgSubSurf_syncVert(ss, HANDLE(i), data, 0, NULL);
+	}
+	for (i = 0; i < me->totedge; i++) {
+		ccgSubSurf_syncEdge(ss, HANDLE(i), HANDLE(me->edges[i][0]), HANDLE(me->edges[i][1]), me->crease[i], NULL);
+	}
+	for (i = 0; i < me->totface; i++) {
+		CCGVertHDL verts[4];
+		int j;
+		for (j = 0; j < me->face_len[i]; j++) {
+			verts[j] = HANDLE(me->faces[i][j]);
+		}
+		ccgSubSurf_syncFace(ss, HANDLE(i), me->face_len[i], verts, NULL);
+	}
+	ccgSubSurf_processSync(ss);
+}
+
+/* Copy of all grid coordinates and normals, in face order. */
+static float *test_subsurf_grids_copy(CCGSubSurf *ss, const TestMesh *me, size_t *r_len)
+{
+	const int grid_size = ccgSubSurf_getGridSize(ss);
+	const size_t grid_len = (size_t)grid_size * grid_size * VERT_DATA_FLOATS;
+	size_t len = 0;
+	float *grids;
+	int i, S;
+
+	for (i = 0; i < me->totface; i++) {
+		len += grid_len * me->face_len[i];
+	}
+	grids = (float *)MEM_mallocN(sizeof(float) * len, __func__);
+
+	len = 0;
+	for (i = 0; i < me->totface; i++) {
+		CCGFace *f = ccgSubSurf_getFace(ss, HANDLE(i));
+		for (S = 0; S < me->face_len[i]; S++) {
+			memcpy(&grids[len], ccgSubSurf_getFaceGridDataArray(ss, f, S), sizeof(float) * grid_len);
+			len += grid_len;
+		}
+	}
+
+	*r_len = len;
+	return grids;
+}
+
+typedef struct ObjectsData {
+	const TestMesh *me;
+	int levels;
+	float *grids[NUM_OBJECTS];
+	size_t grids_len[NUM_OBJECTS];
+} ObjectsData;
+
+static void object_evaluate_task(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid))
+{
+	ObjectsData *data = (ObjectsData *)BLI_task_pool_userdata(pool);
+	const int index = (int)(intptr_t)taskdata;
+	CCGSubSurf *ss = test_subsurf_create(data->levels);
+
+	test_subsurf_sync(ss, data->me, 0.0f);
+	test_subsurf_sync(ss, data->me, 0.05f);
+	data->grids[index] = test_subsurf_grids_copy(ss, data->me, &data->grids_len[index]);
+	ccgSubSurf_free(ss);
+}
+
+TEST(ccg_subsurf, Levels)
+{
+	TestMesh *me = test_mesh_torus_create(TORUS_RINGS, TORUS_SEGMENTS);
+
+	BLI_threadapi_init();
+
+	printf("\n========== STARTING ccg_subsurf.Levels (%d faces) ==========\n", me->totface);
+
+	for (int levels = 1; levels <= 4; levels++) {
+		CCGSubSurf *ss = test_subsurf_create(levels);
+		double time_start = PIL_check_seconds_timer();
+		double time_best = DBL_MAX;
+
+		test_subsurf_sync(ss, me, 0.0f);
+		printf("Level %d, first sync: %.1f ms\n", levels, (PIL_check_seconds_timer() - time_start) * 1e3);
+
+		for (int i = 0; i < ITERATIONS; i++) {
+			time_start = PIL_check_seconds_timer();
+			test_subsurf_sync(ss, me, 0.05f * (i + 1));
+			time_best = MIN2(time_best, PIL_check_seconds_timer() - time_start);
+		}
+		printf("Level %d, re-sync (best of %d): %.1f ms\n", levels, ITERATIONS, time_best * 1e3);
+
+		EXPECT_EQ(me->totface, ccgSubSurf_getNumFaces(ss));
+		ccgSubSurf_free(ss);
+	}
+
+	test_mesh_free(me);
+
+	printf("========== ENDED ccg_subsurf.Levels ==========\n\n");
+}
+
+/* Objects evaluated from a task pool run the CCG passes as nested parallel ranges,
+ * the result has to match an evaluation from the main thread exactly. */
+TEST(ccg_subsurf, NestedObjects)
+{
+	TestMesh *me = test_mesh_torus_create(TORUS_RINGS, TORUS_SEGMENTS);
+	ObjectsData data = {NULL};
+	float *grids_ref;
+	size_t grids_ref_len;
+
+	BLI_threadapi_init();
+
+	data.me = me;
+	data.levels = 3;
+
+	printf("\n========== STARTING ccg_subsurf.NestedObjects (%d objects, level %d) ==========\n",
+	       NUM_OBJECTS, data.levels);
+
+	{
+		CCGSubSurf *ss = test_subsurf_create(data.levels);
+		double time_start = PIL_check_seconds_timer();
+
+		test_subsurf_sync(ss, me, 0.0f);
+		test_subsurf_sync(ss, me, 0.05f);
+		printf("Single object from main thread: %.1f ms\n", (PIL_check_seconds_timer() - time_start) * 1e3);
+
+		grids_ref = test_subsurf_grids_copy(ss, me, &grids_ref_len);
+		ccgSubSurf_free(ss);
+	}
+
+	{
+		TaskScheduler *scheduler = BLI_task_scheduler_get();
+		TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+		double time_start = PIL_check_seconds_timer();
+
+		for (int i = 0; i < NUM_OBJECTS; i++) {
+			BLI_task_pool_push(pool, object_evaluate_task, HANDLE(i), false, TASK_PRIORITY_LOW);
+		}
+		BLI_task_pool_work_and_wait(pool);
+		BLI_task_pool_free(pool);
+
+		printf("%d objects from task pool (%d threads): %.1f ms\n",
+		       NUM_OBJECTS, BLI_task_scheduler_num_threads(scheduler),
+		       (PIL_check_seconds_timer() - time_start) * 1e3);
+	}
+
+	for (int i = 0; i < NUM_OBJECTS; i++) {
+		ASSERT_EQ(grids_ref_len, data.grids_len[i]);
+		EXPECT_EQ(0, memcmp(grids_ref, data.grids[i], sizeof(float) * grids_ref_len));
+		MEM_freeN(data.grids[i]);
+	}
+
+	MEM_freeN(grids_ref);
+	test_mesh_free(me);
+
+	printf("========== ENDED ccg_subsurf.NestedObjects ==========\n\n");
+}
@@ -0,0 +1,168 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
+
+#include "DNA_meshdata_types.h"
+
+#include "BKE_mesh.h"
+}
+
+/* Quads along each side of the test grid (~2M loops). */
+#define GRID_SIZE 708
+
+/* Number of evaluations timed, the best one is reported. */
+#define ITERATIONS 5
+
+typedef struct TestMesh {
+	int totvert, totedge, totloop, totpoly;
+	MVert *mvert;
+	MEdge *medge;
+	MLoop *mloop;
+	MPoly *mpoly;
+	float (*polynors)[3];
+	short (*clnors)[2];
+} TestMesh;
+
+/* Smooth grid with ridges (sharp by angle) every 16 quads, a few edges tagged sharp, and custom normals. */
+static TestMesh *test_mesh_grid_create(const int size)
+{
+	TestMesh *me = (TestMesh *)MEM_callocN(sizeof(TestMesh), __func__);
+	const int row = size + 1;
+	int x, y, i;
+
+	me->totvert = row * row;
+	me->totedge = 2 * size * row;
+	me->totpoly = size * size;
+	me->totloop = me->totpoly * 4;
+
+	me->mvert = (MVert *)MEM_callocN(sizeof(MVert) * me->totvert, __func__);
+	me->medge = (MEdge *)MEM_callocN(sizeof(MEdge) * me->totedge, __func__);
+	me->mloop = (MLoop *)MEM_callocN(sizeof(MLoop) * me->totloop, __func__);
+	me->mpoly = (MPoly *)MEM_callocN(sizeof(MPoly) * me->totpoly, __func__);
+	me->polynors = (float (*)[3])MEM_mallocN(sizeof(float[3]) * me->totpoly, __func__);
+	me->clnors = (short (*)[2])MEM_mallocN(sizeof(short[2]) * me->totloop, __func__);
+
+	for (y = 0; y < row; y++) {
+		for (x = 0; x < row; x++) {
+			float *co = me->mvert[y * row + x].co;
+			co[0] = (float)x;
+			co[1] = (float)y;
+			co[2] = 3.0f * fabsf(sinf((float)x * (float)M_PI / 16.0f)) + 0.5f * sinf((float)y * 0.3f);
+		}
+	}
+
+	/* edges along x come first, then the ones along y */
+#define EDGE_X(x, y) ((y) * size + (x))
+#define EDGE_Y(x, y) (size * row + (x) * size + (y))
+	for (y = 0; y < row; y++) {
+		for (x = 0; x < size; x++) {
+			me->medge[EDGE_X(x, y)].v1 = y * row + x;
+			me->medge[EDGE_X(x, y)].v2 = y * row + x + 1;
+			me->medge[EDGE_Y(y, x)].v1 = x * row + y;
+			me->medge[EDGE_Y(y, x)].v2 = (x + 1) * row + y;
+			if ((x + y) % 97 == 0) {
+				me->medge[EDGE_X(x, y)].flag |= ME_SHARP;
+			}
+		}
+	}
+
+	for (y = 0; y < size; y++) {
+		for (x = 0; x < size; x++) {
+			const int p = y * size + x;
+			const int corner_v[4] = {y * row + x, y * row + x + 1, (y + 1) * row + x + 1, (y + 1) * row + x};
+			const int corner_e[4] = {EDGE_X(x, y), EDGE_Y(x + 1, y), EDGE_X(x, y + 1), EDGE_Y(x, y)};
+			MPoly *mp = &me->mpoly[p];
+
+			mp->loopstart = p * 4;
+			mp->totloop = 4;
+			mp->flag = ME_SMOOTH;
+			for (i = 0; i < 4; i++) {
+				me->mloop[mp->loopstart + i].v = corner_v[i];
+				me->mloop[mp->loopstart + i].e = corner_e[i];
+			}
+		}
+	}
+#undef EDGE_X
+#undef EDGE_Y
+
+	for (i = 0; i < me->totloop; i++) {
+		me->clnors[i][0] = (short)((i * 37) % 200 - 100);
+		me->clnors[i][1] = (short)((i * 91) % 200 - 100);
+	}
+
+	BKE_mesh_calc_normals_poly(
+	        me->mvert, NULL, me->totvert, me->mloop, me->mpoly, me->totloop, me->totpoly, me->polynors, false);
+
+	return me;
+}
+
+static void test_mesh_free(TestMesh *me)
+{
+	MEM_freeN(me->mvert);
+	MEM_freeN(me->medge);
+	MEM_freeN(me->mloop);
+	MEM_freeN(me->mpoly);
+	MEM_freeN(me->polynors);
+	MEM_freeN(me->clnors);
+	MEM_freeN(me);
+}
+
+static double test_mesh_normals_loop_split(
+        TestMesh *me, float (*r_loopnors)[3], const bool use_spacearr, const bool use_clnors)
+{
+	double time_best = DBL_MAX;
+
+	for (int i = 0; i < ITERATIONS; i++) {
+		MLoopNorSpaceArray lnors_spacearr = {NULL};
+		const double time_start = PIL_check_seconds_timer();
+
+		BKE_mesh_normals_loop_split(
+		        me->mvert, me->totvert, me->medge, me->totedge, me->mloop, r_loopnors, me->totloop,
+		        me->mpoly, (const float (*)[3])me->polynors, me->totpoly, true, DEG2RADF(30.0f),
+		        use_spacearr ? &lnors_spacearr : NULL, use_clnors ? me->clnors : NULL, NULL);
+
+		time_best = MIN2(time_best, PIL_check_seconds_timer() - time_start);
+
+		if (use_spacearr) {
+			BKE_lnor_spacearr_free(&lnors_spacearr);
+		}
+	}
+
+	return time_best;
+}
+
+TEST(mesh_normals, LoopSplit)
+{
+	TestMesh *me;
+	float (*loopnors)[3];
+
+	BLI_threadapi_init();
+
+	me = test_mesh_grid_create(GRID_SIZE);
+	loopnors = (float (*)[3])MEM_mallocN(sizeof(float[3]) * me->totloop, __func__);
+
+	printf("\n========== STARTING mesh_normals.LoopSplit (%d loops) ==========\n", me->totloop);
+
+	printf("Split normals: %.1f ms\n",
+	       test_mesh_normals_loop_split(me, loopnors, false, false) * 1e3);
+	printf("Split normals, lnor spaces: %.1f ms\n",
+	       test_mesh_normals_loop_split(me, loopnors, true, false) * 1e3);
+	printf("Split normals, custom normals: %.1f ms\n",
+	       test_mesh_normals_loop_split(me, loopnors, false, true) * 1e3);
+
+	for (int i = 0; i < me->totloop; i++) {
+		EXPECT_NEAR(1.0f, len_v3(loopnors[i]), 1e-4f);
+	}
+
+	MEM_freeN(loopnors);
+	test_mesh_free(me);
+
+	printf("========== ENDED mesh_normals.LoopSplit ==========\n\n");
+}
@@ -0,0 +1,240 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_listbase.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+
+#include "BKE_ccg.h"
+#include "BKE_cdderivedmesh.h"
+#include "BKE_customdata.h"
+/* before BKE_multires.h, which only forward declares MultiresModifiedFlags */
+#include "BKE_subsurf.h"
+#include "BKE_multires.h"
+
+#include "CCGSubSurf.h"
+}
+
+/* Quads along each side of the base mesh. */
+#define GRID_SIZE 24
+
+/* Highest multires level benchmarked. */
+#define MAX_LEVELS 5
+
+/* Number of updates timed for every level once the reshape cache is filled, the best one is reported. */
+#define ITERATIONS 5
+
+typedef struct TestObject {
+	Object *ob;
+	Mesh *me;
+	MultiresModifierData *mmd;
+} TestObject;
+
+/* Object with a multires modifier and a wavy quad grid as base mesh, in sculpt mode. */
+static TestObject *test_object_create(const int size)
+{
+	TestObject *tob = (TestObject *)MEM_callocN(sizeof(TestObject), __func__);
+	const int row = size + 1;
+	Mesh *me;
+	int x, y, i;
+
+	tob->me = me = (Mesh *)MEM_callocN(sizeof(Mesh), __func__);
+	me->totvert = row * row;
+	me->totedge = 2 * size * row;
+	me->totpoly = size * size;
+	me->totloop = me->totpoly * 4;
+
+	CustomData_reset(&me->vdata);
+	CustomData_reset(&me->edata);
+	CustomData_reset(&me->fdata);
+	CustomData_reset(&me->ldata);
+	CustomData_reset(&me->pdata);
+
+	me->mvert = (MVert *)CustomData_add_layer(&me->vdata, CD_MVERT, CD_CALLOC, NULL, me->totvert);
+	me->medge = (MEdge *)CustomData_add_layer(&me->edata, CD_MEDGE, CD_CALLOC, NULL, me->totedge);
+	me->mloop = (MLoop *)CustomData_add_layer(&me->ldata, CD_MLOOP, CD_CALLOC, NULL, me->totloop);
+	me->mpoly = (MPoly *)CustomData_add_layer(&me->pdata, CD_MPOLY, CD_CALLOC, NULL, me->totpoly);
+
+	for (y = 0; y < row; y++) {
+		for (x = 0; x < row; x++) {
+			float *co = me->mvert[y * row + x].co;
+			co[0] = (float)x / size;
+			co[1] = (float)y / size;
+			co[2] = 0.1f * sinf((float)x * 0.5f) * cosf((float)y * 0.3f);
+		}
+	}
+
+	/* edges along x come first, then the ones along y */
+#define EDGE_X(x, y) ((y) * size + (x))
+#define EDGE_Y(x, y) (size * row + (x) * size + (y))
+	for (y = 0; y < row; y++) {
+		for (x = 0; x < size; x++) {
+			me->medge[EDGE_X(x, y)].v1 = y * row + x;
+			me->medge[EDGE_X(x, y)].v2 = y * row + x + 1;
+			me->medge[EDGE_Y(y, x)].v1 = x * row + y;
+			me->medge[EDGE_Y(y, x)].v2 = (x + 1) * row + y;
+		}
+	}
+
+	for (y = 0; y < size; y++) {
+		for (x = 0; x < size; x++) {
+			const int p = y * size + x;
+			const int corner_v[4] = {y * row + x, y * row + x + 1, (y + 1) * row + x + 1, (y + 1) * row + x};
+			const int corner_e[4] = {EDGE_X(x, y), EDGE_Y(x + 1, y), EDGE_X(x, y + 1), EDGE_Y(x, y)};
+			MPoly *mp = &me->mpoly[p];
+
+			mp->loopstart = p * 4;
+			mp->totloop = 4;
+			for (i = 0; i < 4; i++) {
+				me->mloop[mp->loopstart + i].v = corner_v[i];
+				me->mloop[mp->loopstart + i].e = corner_e[i];
+			}
+		}
+	}
+#undef EDGE_X
+#undef EDGE_Y
+
+	tob->ob = (Object *)MEM_callocN(sizeof(Object), __func__);
+	tob->ob->type = OB_MESH;
+	tob->ob->mode = OB_MODE_SCULPT;
+	tob->ob->data = me;
+
+	tob->mmd = (MultiresModifierData *)MEM_callocN(sizeof(MultiresModifierData), __func__);
+	tob->mmd->modifier.type = eModifierType_Multires;
+	BLI_addtail(&tob->ob->modifiers, tob->mmd);
+
+	return tob;
+}
+
+static void test_object_free(TestObject *tob)
+{
+	if (tob->mmd->reshapeCache) {
+		ccgSubSurf_free((CCGSubSurf *)tob->mmd->reshapeCache);
+	}
+	MEM_freeN(tob->mmd);
+	MEM_freeN(tob->ob);
+
+	CustomData_free(&tob->me->vdata, tob->me->totvert);
+	CustomData_free(&tob->me->edata, tob->me->totedge);
+	CustomData_free(&tob->me->ldata, tob->me->totloop);
+	CustomData_free(&tob->me->pdata, tob->me->totpoly);
+	MEM_freeN(tob->me);
+	MEM_freeN(tob);
+}
+
+/* Copy of all displacements, in loop order. */
+static float *test_disps_copy(const Mesh *me)
+{
+	const MDisps *mdisps = (const MDisps *)CustomData_get_layer(&me->ldata, CD_MDISPS);
+	const int totdisp = mdisps[0].totdisp;
+	float *disps = (float *)MEM_mallocN(sizeof(float[3]) * totdisp * me->totloop, __func__);
+
+	for (int i = 0; i < me->totloop; i++) {
+		memcpy(&disps[i * totdisp * 3], mdisps[i].disps, sizeof(float[3]) * totdisp);
+	}
+
+	return disps;
+}
+
+static void test_disps_restore(Mesh *me, const float *disps)
+{
+	MDisps *mdisps = (MDisps *)CustomData_get_layer(&me->ldata, CD_MDISPS);
+	const int totdisp = mdisps[0].totdisp;
+
+	for (int i = 0; i < me->totloop; i++) {
+		memcpy(mdisps[i].disps, &disps[i * totdisp * 3], sizeof(float[3]) * totdisp);
+	}
+}
+
+/* Move the grids of every third face like a brush would, then time writing them back into
+ * the displacements, which happens when the sculpted result gets released. */
+static double test_multires_reshape(TestObject *tob, const float offset)
+{
+	DerivedMesh *cddm = CDDM_from_mesh(tob->me);
+	DerivedMesh *dm = multires_make_derived_from_derived(cddm, tob->mmd, tob->ob, (MultiresFlags)0);
+	CCGElem **grids = dm->getGridData(dm);
+	const int *grid_offset = dm->getGridOffset(dm);
+	CCGKey key;
+	double time_start;
+
+	dm->getGridKey(dm, &key);
+
+	for (int p = 0; p < tob->me->totpoly; p += 3) {
+		for (int S = 0; S < tob->me->mpoly[p].totloop; S++) {
+			CCGElem *grid = grids[grid_offset[p] + S];
+			for (int i = 0; i < key.grid_area; i++) {
+				CCG_elem_offset_co(&key, grid, i)[2] += offset * (float)(i % 7);
+			}
+		}
+	}
+
+	((CCGDerivedMesh *)dm)->multires.modified_flags = MULTIRES_COORDS_MODIFIED;
+
+	time_start = PIL_check_seconds_timer();
+	dm->release(dm);
+	cddm->release(cddm);
+
+	return PIL_check_seconds_timer() - time_start;
+}
+
+TEST(multires, Reshape)
+{
+	TestObject *tob;
+
+	BLI_threadapi_init();
+
+	tob = test_object_create(GRID_SIZE);
+
+	printf("\n========== STARTING multires.Reshape (%d faces) ==========\n", tob->me->totpoly);
+
+	for (int levels = 1; levels <= MAX_LEVELS; levels++) {
+		double time_first, time_best = DBL_MAX;
+		float *disps_orig, *disps_cached, *disps_rebuilt;
+		const int side = (1 << (levels - 1)) + 1;
+		const int totdisp_all = tob->me->totloop * side * side * 3;
+
+		multiresModifier_subdivide(tob->mmd, tob->ob, 0, 0);
+		EXPECT_EQ(levels, tob->mmd->totlvl);
+
+		/* the cache still holds the previous level, this is the same as without a cache */
+		time_first = test_multires_reshape(tob, 0.001f);
+
+		for (int i = 0; i < ITERATIONS; i++) {
+			time_best = MIN2(time_best, test_multires_reshape(tob, 0.001f));
+		}
+
+		printf("Level %d, first update: %.1f ms, cached update (best of %d): %.1f ms\n",
+		       levels, time_first * 1e3, ITERATIONS, time_best * 1e3);
+
+		/* the cached update has to give the same displacements as one from scratch */
+		disps_orig = test_disps_copy(tob->me);
+		test_multires_reshape(tob, 0.002f);
+		disps_cached = test_disps_copy(tob->me);
+
+		test_disps_restore(tob->me, disps_orig);
+		ccgSubSurf_free((CCGSubSurf *)tob->mmd->reshapeCache);
+		tob->mmd->reshapeCache = NULL;
+		test_multires_reshape(tob, 0.002f);
+		disps_rebuilt = test_disps_copy(tob->me);
+
+		EXPECT_EQ(0, memcmp(disps_cached, disps_rebuilt, sizeof(float) * totdisp_all));
+
+		MEM_freeN(disps_orig);
+		MEM_freeN(disps_cached);
+		MEM_freeN(disps_rebuilt);
+	}
+
+	test_object_free(tob);
+
+	printf("========== ENDED multires.Reshape ==========\n\n");
+}
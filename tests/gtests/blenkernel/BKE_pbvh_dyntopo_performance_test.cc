@@ -0,0 +1,194 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
+
+#include "DNA_customdata_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_pbvh.h"
+
+#include "bmesh.h"
+}
+
+/* Quads along each side of the test grid, each split in two triangles (80k faces). */
+#define GRID_SIZE 200
+
+/* Dabs along one stroke, going across the grid diagonally. */
+#define STROKE_DABS 100
+
+/* Brush radius and detail size, relative to the grid size of 1. */
+#define BRUSH_RADIUS 0.05f
+#define DETAIL_SIZE (0.75f / GRID_SIZE)
+
+typedef struct TestSculpt {
+	BMesh *bm;
+	BMLog *log;
+	PBVH *pbvh;
+} TestSculpt;
+
+/* Triangulated grid in the XY plane, set up the same way sculpt mode enables dynamic topology. */
+static TestSculpt *test_sculpt_create(const int size)
+{
+	TestSculpt *sculpt = (TestSculpt *)MEM_callocN(sizeof(TestSculpt), __func__);
+	BMeshCreateParams params = {0};
+	const int row = size + 1;
+	BMVert **verts = (BMVert **)MEM_mallocN(sizeof(*verts) * row * row, __func__);
+	int x, y;
+
+	sculpt->bm = BM_mesh_create(&bm_mesh_allocsize_default, &params);
+
+	for (y = 0; y < row; y++) {
+		for (x = 0; x < row; x++) {
+			const float co[3] = {(float)x / size, (float)y / size, 0.0f};
+			verts[y * row + x] = BM_vert_create(sculpt->bm, co, NULL, BM_CREATE_NOP);
+		}
+	}
+
+	for (y = 0; y < size; y++) {
+		for (x = 0; x < size; x++) {
+			BMVert *tri_a[3] = {verts[y * row + x], verts[y * row + x + 1], verts[(y + 1) * row + x + 1]};
+			BMVert *tri_b[3] = {verts[y * row + x], verts[(y + 1) * row + x + 1], verts[(y + 1) * row + x]};
+			BM_face_create_verts(sculpt->bm, tri_a, 3, NULL, BM_CREATE_NOP, true);
+			BM_face_create_verts(sculpt->bm, tri_b, 3, NULL, BM_CREATE_NOP, true);
+		}
+	}
+
+	MEM_freeN(verts);
+
+	BM_data_layer_add(sculpt->bm, &sculpt->bm->vdata, CD_PAINT_MASK);
+	BM_data_layer_add(sculpt->bm, &sculpt->bm->vdata, CD_PROP_INT);
+	BM_data_layer_add(sculpt->bm, &sculpt->bm->pdata, CD_PROP_INT);
+	BM_mesh_normals_update(sculpt->bm);
+
+	sculpt->log = BM_log_create(sculpt->bm);
+	/* Like the undo push at the start of a stroke. */
+	BM_log_entry_add(sculpt->log);
+
+	sculpt->pbvh = BKE_pbvh_new();
+	BKE_pbvh_build_bmesh(
+	        sculpt->pbvh, sculpt->bm, false, sculpt->log,
+	        CustomData_get_offset(&sculpt->bm->vdata, CD_PROP_INT),
+	        CustomData_get_offset(&sculpt->bm->pdata, CD_PROP_INT));
+	BKE_pbvh_bmesh_detail_size_set(sculpt->pbvh, DETAIL_SIZE);
+
+	return sculpt;
+}
+
+static void test_sculpt_free(TestSculpt *sculpt)
+{
+	BKE_pbvh_free(sculpt->pbvh);
+	BM_log_free(sculpt->log);
+	BM_mesh_free(sculpt->bm);
+	MEM_freeN(sculpt);
+}
+
+typedef struct SearchSphereData {
+	const float *center;
+	float radius_squared;
+} SearchSphereData;
+
+static bool test_search_sphere_cb(PBVHNode *node, void *data_v)
+{
+	SearchSphereData *data = (SearchSphereData *)data_v;
+	float bb_min[3], bb_max[3], nearest[3];
+
+	BKE_pbvh_node_get_BB(node, bb_min, bb_max);
+	for (int i = 0; i < 3; i++) {
+		nearest[i] = min_ff(max_ff(data->center[i], bb_min[i]), bb_max[i]);
+	}
+
+	return len_squared_v3v3(data->center, nearest) < data->radius_squared;
+}
+
+/* One dab: topology update around the brush, then a small inflate of the verts under it,
+ * following the order of sculpt_topology_update() and the brush action. */
+static void test_sculpt_dab(TestSculpt *sculpt, const float center[3])
+{
+	SearchSphereData data = {center, SQUARE(BRUSH_RADIUS * 1.25f)};
+	PBVHNode **nodes = NULL;
+	int totnode;
+
+	BKE_pbvh_search_gather(sculpt->pbvh, test_search_sphere_cb, &data, &nodes, &totnode);
+
+	if (totnode == 0) {
+		return;
+	}
+
+	for (int n = 0; n < totnode; n++) {
+		BKE_pbvh_node_mark_update(nodes[n]);
+		BKE_pbvh_node_mark_topology_update(nodes[n]);
+		BKE_pbvh_bmesh_node_save_orig(nodes[n]);
+	}
+
+	BKE_pbvh_bmesh_update_topology(
+	        sculpt->pbvh, (PBVHTopologyUpdateMode)(PBVH_Subdivide | PBVH_Collapse), center, NULL, BRUSH_RADIUS);
+
+	MEM_freeN(nodes);
+
+	/* The topology update adds nodes, gather again. */
+	BKE_pbvh_search_gather(sculpt->pbvh, test_search_sphere_cb, &data, &nodes, &totnode);
+
+	for (int n = 0; n < totnode; n++) {
+		GSetIterator gs_iter;
+
+		GSET_ITER (gs_iter, BKE_pbvh_bmesh_node_unique_verts(nodes[n])) {
+			BMVert *v = (BMVert *)BLI_gsetIterator_getKey(&gs_iter);
+			const float dist = len_v3v3(v->co, center);
+
+			if (dist < BRUSH_RADIUS) {
+				const float fade = 1.0f - dist / BRUSH_RADIUS;
+				BM_log_vert_before_modified(sculpt->log, v, CustomData_get_offset(&sculpt->bm->vdata, CD_PAINT_MASK));
+				madd_v3_v3fl(v->co, v->no, 0.002f * fade * fade);
+			}
+		}
+		BKE_pbvh_node_mark_update(nodes[n]);
+	}
+
+	MEM_freeN(nodes);
+
+	BKE_pbvh_update(sculpt->pbvh, PBVH_UpdateBB | PBVH_UpdateOriginalBB | PBVH_UpdateNormals, NULL);
+}
+
+TEST(pbvh_dyntopo, Stroke)
+{
+	TestSculpt *sculpt;
+	double time_total = 0.0, time_max = 0.0;
+
+	BLI_threadapi_init();
+
+	sculpt = test_sculpt_create(GRID_SIZE);
+
+	printf("\n========== STARTING pbvh_dyntopo.Stroke (%d faces, %d dabs) ==========\n",
+	       sculpt->bm->totface, STROKE_DABS);
+
+	for (int i = 0; i < STROKE_DABS; i++) {
+		const float t = 0.1f + 0.8f * (float)i / (STROKE_DABS - 1);
+		const float center[3] = {t, t + 0.05f * sinf(t * 20.0f), 0.0f};
+		const double time_start = PIL_check_seconds_timer();
+
+		test_sculpt_dab(sculpt, center);
+
+		const double time = PIL_check_seconds_timer() - time_start;
+		time_total += time;
+		time_max = MAX2(time_max, time);
+	}
+
+	BKE_pbvh_bmesh_after_stroke(sculpt->pbvh);
+
+	printf("Faces after stroke: %d\n", sculpt->bm->totface);
+	printf("Dab latency: average %.2f ms, max %.2f ms, stroke %.1f ms\n",
+	       time_total / STROKE_DABS * 1e3, time_max * 1e3, time_total * 1e3);
+
+	EXPECT_GT(sculpt->bm->totface, 2 * GRID_SIZE * GRID_SIZE);
+
+	test_sculpt_free(sculpt);
+
+	printf("========== ENDED pbvh_dyntopo.Stroke ==========\n\n");
+}
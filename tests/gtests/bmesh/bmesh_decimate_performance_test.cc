@@ -0,0 +1,129 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
+
+#include "bmesh.h"
+#include "bmesh_tools.h"
+}
+
+/* Quads along each side of the test grid, each split in two triangles (180k faces). */
+#define GRID_SIZE 300
+
+/* Faces kept by the decimation, the same as the modifier ratio. */
+#define RATIO 0.1f
+
+/* Triangulated grid with bumps of different sizes, so edge costs vary across the mesh. */
+static BMesh *test_mesh_create(const int size)
+{
+	BMeshCreateParams params = {0};
+	BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default, &params);
+	const int row = size + 1;
+	BMVert **verts = (BMVert **)MEM_mallocN(sizeof(*verts) * row * row, __func__);
+	int x, y;
+
+	for (y = 0; y < row; y++) {
+		for (x = 0; x < row; x++) {
+			const float co[3] = {
+			    (float)x / size,
+			    (float)y / size,
+			    0.05f * sinf((float)x * 0.1f) * cosf((float)y * 0.07f) + 0.01f * sinf((float)(x * y) * 0.01f),
+			};
+			verts[y * row + x] = BM_vert_create(bm, co, NULL, BM_CREATE_NOP);
+		}
+	}
+
+	for (y = 0; y < size; y++) {
+		for (x = 0; x < size; x++) {
+			BMVert *tri_a[3] = {verts[y * row + x], verts[y * row + x + 1], verts[(y + 1) * row + x + 1]};
+			BMVert *tri_b[3] = {verts[y * row + x], verts[(y + 1) * row + x + 1], verts[(y + 1) * row + x]};
+			BM_face_create_verts(bm, tri_a, 3, NULL, BM_CREATE_NOP, true);
+			BM_face_create_verts(bm, tri_b, 3, NULL, BM_CREATE_NOP, true);
+		}
+	}
+
+	MEM_freeN(verts);
+
+	/* clean like the mesh conversion leaves them, decimate expects vertex indices to be valid */
+	BM_mesh_elem_index_ensure(bm, BM_VERT | BM_EDGE | BM_FACE);
+
+	return bm;
+}
+
+/* Copy of all vertex coordinates, in iteration order. */
+static float *test_mesh_coords_copy(BMesh *bm)
+{
+	float (*coords)[3] = (float (*)[3])MEM_mallocN(sizeof(*coords) * bm->totvert, __func__);
+	BMIter iter;
+	BMVert *v;
+	int i;
+
+	BM_ITER_MESH_INDEX (v, &iter, bm, BM_VERTS_OF_MESH, i) {
+		copy_v3_v3(coords[i], v->co);
+	}
+
+	return (float *)coords;
+}
+
+/* Decimate a new test mesh, returns the coordinates of the result. */
+static float *test_decimate(const bool use_parallel, int *r_totvert)
+{
+	BMesh *bm = test_mesh_create(GRID_SIZE);
+	const int totface_orig = bm->totface;
+	const double time_start = PIL_check_seconds_timer();
+	double time;
+	float *coords;
+
+	BM_mesh_decimate_collapse(bm, RATIO, NULL, 1.0f, false, -1, 0.0f, use_parallel);
+
+	time = PIL_check_seconds_timer() - time_start;
+
+	printf("%s collapse: %.1f ms, %d -> %d faces, %.0fk triangles/sec\n",
+	       use_parallel ? "Parallel" : "Serial", time * 1e3, totface_orig, bm->totface,
+	       (double)totface_orig / time * 1e-3);
+
+	EXPECT_NEAR(totface_orig * RATIO, bm->totface, totface_orig * RATIO * 0.05f);
+
+	coords = test_mesh_coords_copy(bm);
+	*r_totvert = bm->totvert;
+
+	BM_mesh_free(bm);
+
+	return coords;
+}
+
+static void test_decimate_mode(const bool use_parallel)
+{
+	float *coords_a, *coords_b;
+	int totvert_a, totvert_b;
+
+	coords_a = test_decimate(use_parallel, &totvert_a);
+	coords_b = test_decimate(use_parallel, &totvert_b);
+
+	/* the same input always gives the same result, whatever the threads did */
+	ASSERT_EQ(totvert_a, totvert_b);
+	EXPECT_EQ(0, memcmp(coords_a, coords_b, sizeof(float[3]) * totvert_a));
+
+	MEM_freeN(coords_a);
+	MEM_freeN(coords_b);
+}
+
+TEST(bmesh_decimate, Collapse)
+{
+	BLI_threadapi_init();
+
+	printf("\n========== STARTING bmesh_decimate.Collapse (%d faces, %d threads) ==========\n",
+	       GRID_SIZE * GRID_SIZE * 2, BLI_task_scheduler_num_threads(BLI_task_scheduler_get()));
+
+	test_decimate_mode(false);
+	test_decimate_mode(true);
+
+	printf("========== ENDED bmesh_decimate.Collapse ==========\n\n");
+}
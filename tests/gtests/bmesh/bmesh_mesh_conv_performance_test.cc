@@ -0,0 +1,193 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "PIL_time_utildefines.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_mesh.h"
+
+#include "bmesh.h"
+}
+
+/* Quads along each side of the test grid (1M faces). */
+#define GRID_SIZE 1000
+
+/* Number of conversion round-trips to time. */
+#define ITERATIONS 3
+
+static Mesh *mesh_alloc(void)
+{
+	Mesh *me = (Mesh *)MEM_callocN(sizeof(Mesh), __func__);
+	CustomData_reset(&me->vdata);
+	CustomData_reset(&me->edata);
+	CustomData_reset(&me->fdata);
+	CustomData_reset(&me->ldata);
+	CustomData_reset(&me->pdata);
+	me->act_face = -1;
+	return me;
+}
+
+static void mesh_free(Mesh *me)
+{
+	BKE_mesh_free(me);
+	MEM_freeN(me);
+}
+
+/* Grid of quads with a float vertex layer and a UV layer,
+ * so custom-data copying is part of the timing. */
+static Mesh *mesh_grid_create(const int size)
+{
+	Mesh *me = mesh_alloc();
+	const int row = size + 1;
+	int x, y;
+
+	me->totvert = row * row;
+	me->totedge = 2 * size * row;
+	me->totpoly = size * size;
+	me->totloop = me->totpoly * 4;
+
+	CustomData_add_layer(&me->vdata, CD_MVERT, CD_CALLOC, NULL, me->totvert);
+	CustomData_add_layer(&me->edata, CD_MEDGE, CD_CALLOC, NULL, me->totedge);
+	CustomData_add_layer(&me->ldata, CD_MLOOP, CD_CALLOC, NULL, me->totloop);
+	CustomData_add_layer(&me->pdata, CD_MPOLY, CD_CALLOC, NULL, me->totpoly);
+	CustomData_add_layer(&me->ldata, CD_MLOOPUV, CD_CALLOC, NULL, me->totloop);
+	CustomData_add_layer(&me->pdata, CD_MTEXPOLY, CD_CALLOC, NULL, me->totpoly);
+	float *vert_weight = (float *)CustomData_add_layer(&me->vdata, CD_PROP_FLT, CD_CALLOC, NULL, me->totvert);
+	BKE_mesh_update_customdata_pointers(me, false);
+
+	MLoopUV *mloopuv = (MLoopUV *)CustomData_get_layer(&me->ldata, CD_MLOOPUV);
+
+	for (y = 0; y < row; y++) {
+		for (x = 0; x < row; x++) {
+			const int v = y * row + x;
+			me->mvert[v].co[0] = (float)x;
+			me->mvert[v].co[1] = (float)y;
+			me->mvert[v].no[2] = 32767;
+			vert_weight[v] = (float)v;
+		}
+	}
+
+	/* edges along x come first, then the ones along y */
+#define EDGE_X(x, y) ((y) * size + (x))
+#define EDGE_Y(x, y) (size * row + (x) * size + (y))
+	for (y = 0; y < row; y++) {
+		for (x = 0; x < size; x++) {
+			me->medge[EDGE_X(x, y)].v1 = y * row + x;
+			me->medge[EDGE_X(x, y)].v2 = y * row + x + 1;
+			me->medge[EDGE_Y(y, x)].v1 = x * row + y;
+			me->medge[EDGE_Y(y, x)].v2 = (x + 1) * row + y;
+		}
+	}
+
+	for (y = 0; y < size; y++) {
+		for (x = 0; x < size; x++) {
+			const int p = y * size + x;
+			const int corner_v[4] = {y * row + x, y * row + x + 1, (y + 1) * row + x + 1, (y + 1) * row + x};
+			const int corner_e[4] = {EDGE_X(x, y), EDGE_Y(x + 1, y), EDGE_X(x, y + 1), EDGE_Y(x, y)};
+			MPoly *mp = &me->mpoly[p];
+
+			mp->loopstart = p * 4;
+			mp->totloop = 4;
+			for (int i = 0; i < 4; i++) {
+				me->mloop[mp->loopstart + i].v = corner_v[i];
+				me->mloop[mp->loopstart + i].e = corner_e[i];
+				copy_v2_v2(mloopuv[mp->loopstart + i].uv, me->mvert[corner_v[i]].co);
+			}
+		}
+	}
+#undef EDGE_X
+#undef EDGE_Y
+
+	return me;
+}
+
+static BMesh *bmesh_from_mesh(Mesh *me)
+{
+	BMAllocTemplate allocsize = {me->totvert, me->totedge, me->totloop, me->totpoly};
+	BMeshCreateParams create_params = {0};
+	BMeshFromMeshParams convert_params = {0};
+	convert_params.calc_face_normal = true;
+
+	BMesh *bm = BM_mesh_create(&allocsize, &create_params);
+	BM_mesh_bm_from_me(bm, me, &convert_params);
+	return bm;
+}
+
+static Mesh *bmesh_to_mesh(BMesh *bm)
+{
+	BMeshToMeshParams convert_params = {0};
+	Mesh *me = mesh_alloc();
+
+	BM_mesh_bm_to_me(bm, me, &convert_params);
+	return me;
+}
+
+TEST(bmesh_mesh_conv, RoundTrip)
+{
+	Mesh *me_src = mesh_grid_create(GRID_SIZE);
+	Mesh *me_dst = NULL;
+	BMesh *bm = NULL;
+
+	printf("\n========== STARTING %s (%d faces) ==========\n", __func__, me_src->totpoly);
+
+	for (int i = 0; i < ITERATIONS; i++) {
+		if (bm) {
+			BM_mesh_free(bm);
+		}
+		if (me_dst) {
+			mesh_free(me_dst);
+		}
+
+		TIMEIT_START(mesh_to_bmesh);
+		bm = bmesh_from_mesh(me_src);
+		TIMEIT_END(mesh_to_bmesh);
+
+		TIMEIT_START(bmesh_to_mesh);
+		me_dst = bmesh_to_mesh(bm);
+		TIMEIT_END(bmesh_to_mesh);
+	}
+
+	EXPECT_EQ(me_src->totvert, bm->totvert);
+	EXPECT_EQ(me_src->totedge, bm->totedge);
+	EXPECT_EQ(me_src->totloop, bm->totloop);
+	EXPECT_EQ(me_src->totpoly, bm->totface);
+
+	ASSERT_EQ(me_src->totvert, me_dst->totvert);
+	ASSERT_EQ(me_src->totedge, me_dst->totedge);
+	ASSERT_EQ(me_src->totloop, me_dst->totloop);
+	ASSERT_EQ(me_src->totpoly, me_dst->totpoly);
+
+	EXPECT_EQ(0, memcmp(me_src->mloop, me_dst->mloop, sizeof(MLoop) * me_src->totloop));
+	EXPECT_EQ(0, memcmp(CustomData_get_layer(&me_src->ldata, CD_MLOOPUV),
+	                    CustomData_get_layer(&me_dst->ldata, CD_MLOOPUV),
+	                    sizeof(MLoopUV) * me_src->totloop));
+	EXPECT_EQ(0, memcmp(CustomData_get_layer(&me_src->vdata, CD_PROP_FLT),
+	                    CustomData_get_layer(&me_dst->vdata, CD_PROP_FLT),
+	                    sizeof(float) * me_src->totvert));
+
+	for (int i = 0; i < me_src->totvert; i++) {
+		EXPECT_V3_NEAR(me_src->mvert[i].co, me_dst->mvert[i].co, 0.0f);
+	}
+	for (int i = 0; i < me_src->totedge; i++) {
+		EXPECT_EQ(me_src->medge[i].v1, me_dst->medge[i].v1);
+		EXPECT_EQ(me_src->medge[i].v2, me_dst->medge[i].v2);
+	}
+	for (int i = 0; i < me_src->totpoly; i++) {
+		EXPECT_EQ(me_src->mpoly[i].loopstart, me_dst->mpoly[i].loopstart);
+		EXPECT_EQ(me_src->mpoly[i].totloop, me_dst->mpoly[i].totloop);
+	}
+
+	BM_mesh_free(bm);
+	mesh_free(me_dst);
+	mesh_free(me_src);
+
+	printf("========== ENDED %s ==========\n\n", __func__);
+}
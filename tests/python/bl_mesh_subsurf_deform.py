@@ -0,0 +1,149 @@
+# Apache License, Version 2.0
+
+# ./blender.bin --background -noaudio --factory-startup --python tests/python/bl_mesh_subsurf_deform.py -- --verbose
+#
+# The subsurf modifier keeps its CCG topology between updates when the
+# input mesh is only deformed (by an armature here), re-subdividing the
+# moved vertices only. Compare that cached result against a fresh rebuild.
+
+import unittest
+
+import bpy
+import bmesh
+
+# Largest difference allowed between the cached and the rebuilt result.
+EPSILON = 1e-6
+
+
+def scene_clear(scene):
+    for obj in scene.objects[:]:
+        bpy.data.objects.remove(obj, do_unlink=True)
+
+
+def mesh_grid_add(scene):
+    mesh = bpy.data.meshes.new("Grid")
+    bm = bmesh.new()
+    bmesh.ops.create_grid(bm, x_segments=24, y_segments=6, size=1.0)
+    bm.to_mesh(mesh)
+    bm.free()
+
+    # some creased edges so both sharp and smooth subdivision rules are used
+    for edge in mesh.edges[::5]:
+        edge.crease = 0.6
+
+    obj = bpy.data.objects.new("Grid", mesh)
+    scene.objects.link(obj)
+    return obj
+
+
+def armature_add(scene, obj):
+    arm_data = bpy.data.armatures.new("Armature")
+    obj_arm = bpy.data.objects.new("Armature", arm_data)
+    scene.objects.link(obj_arm)
+    scene.objects.active = obj_arm
+
+    bpy.ops.object.mode_set(mode='EDIT', toggle=False)
+    bone_a = arm_data.edit_bones.new("Bone.A")
+    bone_b = arm_data.edit_bones.new("Bone.B")
+    bone_b.parent = bone_a
+    bone_a.head = -1, 0, 0
+    bone_a.tail = 0, 0, 0
+    bone_b.head = 0, 0, 0
+    bone_b.tail = 1, 0, 0
+    bpy.ops.object.mode_set(mode='OBJECT', toggle=False)
+
+    scene.objects.active = obj
+
+    # weights blend between both bones along the grid
+    vgroup_a = obj.vertex_groups.new(name="Bone.A")
+    vgroup_b = obj.vertex_groups.new(name="Bone.B")
+    for v in obj.data.vertices:
+        f = (v.co.x + 1.0) / 2.0
+        vgroup_a.add([v.index], 1.0 - f, 'REPLACE')
+        vgroup_b.add([v.index], f, 'REPLACE')
+
+    mod = obj.modifiers.new(name="Armature", type='ARMATURE')
+    mod.object = obj_arm
+    return obj_arm
+
+
+class SubsurfDeformTest(unittest.TestCase):
+    def setUp(self):
+        self.scene = bpy.context.scene
+        scene_clear(self.scene)
+
+        self.obj = mesh_grid_add(self.scene)
+        self.obj_arm = armature_add(self.scene, self.obj)
+
+        self.subsurf = self.obj.modifiers.new(name="Subsurf", type='SUBSURF')
+        self.subsurf.levels = 2
+
+        self.scene.update()
+
+    def tearDown(self):
+        scene_clear(self.scene)
+
+    def pose_set(self, angle):
+        bone = self.obj_arm.pose.bones["Bone.B"]
+        bone.rotation_mode = 'XYZ'
+        bone.rotation_euler = angle, angle * 0.5, 0.0
+        self.scene.update()
+
+    def coords_cached(self):
+        # ob->derivedFinal, evaluated with the modifier cache
+        bm = bmesh.new()
+        bm.from_object(self.obj, self.scene)
+        coords = [v.co.copy() for v in bm.verts]
+        bm.free()
+        return coords
+
+    def coords_rebuilt(self):
+        # evaluated without the modifier cache, the subsurf is built from scratch
+        mesh = self.obj.to_mesh(self.scene, True, 'PREVIEW')
+        coords = [v.co.copy() for v in mesh.vertices]
+        bpy.data.meshes.remove(mesh)
+        return coords
+
+    def assertCachedMatchesRebuilt(self, msg):
+        coords_cached = self.coords_cached()
+        coords_rebuilt = self.coords_rebuilt()
+
+        self.assertEqual(len(coords_cached), len(coords_rebuilt), msg=msg)
+        for i, (co_a, co_b) in enumerate(zip(coords_cached, coords_rebuilt)):
+            self.assertLessEqual((co_a - co_b).length, EPSILON,
+                                 msg="%s: vertex %d, %r != %r" % (msg, i, co_a, co_b))
+
+    def test_pose_changes(self):
+        self.assertCachedMatchesRebuilt("rest pose")
+        for step in range(1, 6):
+            angle = step * 0.3
+            self.pose_set(angle)
+            self.assertCachedMatchesRebuilt("pose %.1f" % angle)
+
+        # back to a pose used before
+        self.pose_set(0.3)
+        self.assertCachedMatchesRebuilt("pose 0.3 again")
+
+    def test_topology_changes(self):
+        self.pose_set(0.5)
+        self.assertCachedMatchesRebuilt("posed")
+
+        # changes the cache can't be kept for, it has to be rebuilt
+        self.subsurf.levels = 3
+        self.scene.update()
+        self.assertCachedMatchesRebuilt("levels changed")
+
+        self.obj.data.edges[1].crease = 1.0
+        self.obj.data.update()
+        self.scene.update()
+        self.assertCachedMatchesRebuilt("crease changed")
+
+        # and deforming again keeps the rebuilt cache
+        self.pose_set(0.9)
+        self.assertCachedMatchesRebuilt("posed after rebuild")
+
+
+if __name__ == '__main__':
+    import sys
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()